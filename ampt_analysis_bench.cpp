@@ -0,0 +1,495 @@
+// ampt-analysis-bench: cost of AnalysisCore and of the root_interface writers without the transport
+//
+//   ampt-analysis-bench [options]
+//     -m <list>    multiplicities, comma separated (default 100,300,1000,3000,10000,30000,50000)
+//     -n <n>       events per multiplicity (default 1e8/mult^2, between 1 and 1000)
+//     -s <mix>     hadron fractions pi,K,N,Lambda,phi (default 0.70,0.12,0.06,0.02,0.01);
+//                  the remainder are pi0, which the analysis rejects
+//     -v <v2>      elliptic flow of the synthetic events (default 0.05)
+//     -r <file>    replay particles from a stream file (ana/ampt.root, ana/zpc.root, ...);
+//                  hadron trees replace the synthetic hadrons, parton trees the synthetic
+//                  partons; may be given twice
+//     -w <dir>     run the writers in <dir> (default: a temporary directory, removed at the end)
+//     -W           skip the writers
+//     -S <seed>    random seed (default 20030819)
+//
+// Every multiplicity runs AnalysisCore::AnalyzeEvent in hadron and parton mode,
+// and the event header + per-particle writer calls of the five streams exactly
+// as the Fortran output routines make them (init_root_ and the other init_*_root_
+// open real ana/*.root files).  The writers run with the real-time analysis
+// detached, so their rows are the copy, TTree::Fill and index cost only; the
+// generator pays the analysis row on top.  Reported per multiplicity: time per
+// event, per particle and per accepted pair (the analysis loops over all pairs of
+// accepted particles), accepted particles and operator new calls and bytes per
+// event.  Events are made before the clock starts.
+//
+// Synthetic events draw pT from pT exp(-pT/T) with T = 0.3 GeV, eta uniform in
+// |eta| < 4 and phi from 1 + 2 v2 cos(2(phi - psi)) around a random reaction
+// plane; positions come from a Gaussian source elongated out of plane.  Partons
+// are u, d, s (0.4, 0.4, 0.2) and their antiquarks.  Replayed events take the
+// next <mult> particles of the file, wrapping around, so any multiplicity can be
+// built from a small sample.
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <random>
+#include <chrono>
+#include <filesystem>
+#include <new>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <unistd.h>
+
+#include "TFile.h"
+#include "TTree.h"
+#include "analysis_core.h"
+#include "root_interface.h"
+
+using namespace std;
+
+// ===== Allocation counting (every operator new of the process) =====
+// Kept out of line: GCC would otherwise pair the inlined malloc/free with the
+// new/delete expressions of the callers and warn about a mismatch
+static long long g_alloc_calls = 0;
+static long long g_alloc_bytes = 0;
+
+__attribute__((noinline)) void* operator new(size_t n) {
+    g_alloc_calls++;
+    g_alloc_bytes += n;
+    void* p = malloc(n ? n : 1);
+    if (!p) throw bad_alloc();
+    return p;
+}
+void* operator new[](size_t n) { return operator new(n); }
+__attribute__((noinline)) void operator delete(void* p) noexcept { free(p); }
+void operator delete[](void* p) noexcept { operator delete(p); }
+void operator delete(void* p, size_t) noexcept { operator delete(p); }
+void operator delete[](void* p, size_t) noexcept { operator delete(p); }
+
+// One event in the column layout of the writers
+struct BenchEvent {
+    vector<int> pid, istrg0;
+    vector<double> px, py, pz, mass, x, y, z, t, xstrg0, ystrg0;
+    double b;
+
+    void Clear() {
+        pid.clear(); istrg0.clear();
+        px.clear(); py.clear(); pz.clear(); mass.clear();
+        x.clear(); y.clear(); z.clear(); t.clear(); xstrg0.clear(); ystrg0.clear();
+    }
+    void Add(int id, double ppx, double ppy, double ppz, double m,
+             double xx, double yy, double zz, double tt) {
+        pid.push_back(id);
+        px.push_back(ppx); py.push_back(ppy); pz.push_back(ppz); mass.push_back(m);
+        x.push_back(xx); y.push_back(yy); z.push_back(zz); t.push_back(tt);
+        // String of the parton stream: pairs of partons share a string at the parton position
+        istrg0.push_back((int)pid.size() / 2 + 1);
+        xstrg0.push_back(xx);
+        ystrg0.push_back(yy);
+    }
+    int Size() const { return (int)pid.size(); }
+};
+
+// Species drawn by the synthetic generator
+struct Species {
+    int pid;         // positive code; the antiparticle is drawn half of the time if anti
+    bool anti;
+    double mass;
+    double fraction;
+};
+
+// Particles replayed from a stream file
+struct ReplayPool {
+    BenchEvent particles;
+    size_t next = 0;
+};
+
+static vector<Species> HadronSpecies(const vector<double>& mix) {
+    // pi, K, N (p or n), Lambda, phi; the rest pi0
+    vector<Species> s = {{211, true, 0.13957, mix[0]}, {321, true, 0.49368, mix[1]},
+                         {2212, true, 0.93827, mix[2] / 2}, {2112, true, 0.93957, mix[2] / 2},
+                         {3122, true, 1.11568, mix[3]}, {333, false, 1.01946, mix[4]}};
+    double sum = 0;
+    for (auto& sp : s) sum += sp.fraction;
+    s.push_back({111, false, 0.13498, max(0.0, 1 - sum)});
+    return s;
+}
+
+static vector<Species> PartonSpecies() {
+    return {{2, true, 0.0056, 0.4}, {1, true, 0.0099, 0.4}, {3, true, 0.199, 0.2}};
+}
+
+static void MakeSynthetic(mt19937_64& rng, const vector<Species>& species, double v2,
+                          int mult, BenchEvent& evt) {
+    uniform_real_distribution<double> uni(0.0, 1.0);
+    normal_distribution<double> gaus(0.0, 1.0);
+    const double T = 0.3, etaMax = 4.0;
+    double psi = 2 * M_PI * uni(rng);
+    evt.Clear();
+    evt.b = 10 * sqrt(uni(rng));
+
+    vector<double> cumulative;
+    double sum = 0;
+    for (auto& sp : species) cumulative.push_back(sum += sp.fraction);
+
+    for (int i = 0; i < mult; i++) {
+        double u = uni(rng) * sum;
+        size_t k = 0;
+        while (k + 1 < species.size() && u > cumulative[k]) k++;
+        const Species& sp = species[k];
+        int pid = (sp.anti && uni(rng) < 0.5) ? -sp.pid : sp.pid;
+
+        double pt = -T * log(uni(rng) * uni(rng) + 1e-300);
+        double eta = etaMax * (2 * uni(rng) - 1);
+        double phi;
+        do {
+            phi = 2 * M_PI * uni(rng);
+        } while (uni(rng) * (1 + 2 * fabs(v2)) > 1 + 2 * v2 * cos(2 * (phi - psi)));
+
+        // Source 2.5 fm in plane, 3.5 fm out of plane
+        double xr = 2.5 * gaus(rng), yr = 3.5 * gaus(rng);
+        double tt = 1 - 10 * log(uni(rng) + 1e-300);
+        evt.Add(pid, pt * cos(phi), pt * sin(phi), pt * sinh(eta), sp.mass,
+                xr * cos(psi) - yr * sin(psi), xr * sin(psi) + yr * cos(psi), tt * tanh(eta), tt);
+    }
+}
+
+static void MakeReplay(ReplayPool& pool, int mult, BenchEvent& evt) {
+    const BenchEvent& p = pool.particles;
+    evt.Clear();
+    evt.b = 0;
+    for (int i = 0; i < mult; i++) {
+        size_t k = pool.next;
+        pool.next = (pool.next + 1) % p.pid.size();
+        evt.Add(p.pid[k], p.px[k], p.py[k], p.pz[k], p.mass[k], p.x[k], p.y[k], p.z[k], p.t[k]);
+    }
+}
+
+// Load all particles of a stream file; returns false if no known tree or no particles
+static bool LoadReplay(const string& filename, ReplayPool& pool, bool& isHadron) {
+    TFile* f = TFile::Open(filename.c_str(), "READ");
+    if (!f || f->IsZombie()) {
+        cerr << "Error: Cannot open " << filename << endl;
+        delete f;
+        return false;
+    }
+    const char* const names[] = {"ampt", "hadron_before_art", "hadron_before_melting",
+                                 "zpc", "parton_initial"};
+    TTree* tree = nullptr;
+    for (int i = 0; i < 5 && !tree; i++) {
+        tree = (TTree*)f->Get(names[i]);
+        isHadron = (i < 3);
+    }
+    if (!tree) {
+        cerr << "Error: No stream tree in " << filename << endl;
+        f->Close();
+        delete f;
+        return false;
+    }
+
+    int n = 0;
+    vector<int> pid(MAX_PARTICLES);
+    vector<vector<double>> cols(8, vector<double>(MAX_PARTICLES));
+    const char* const colNames[8] = {"px", "py", "pz", "mass", "x", "y", "z", "t"};
+    tree->SetBranchAddress("nParticles", &n);
+    tree->SetBranchAddress("pid", pid.data());
+    for (int k = 0; k < 8; k++) tree->SetBranchAddress(colNames[k], cols[k].data());
+
+    pool.particles.Clear();
+    pool.next = 0;
+    Long64_t nEntries = tree->GetEntries();
+    for (Long64_t e = 0; e < nEntries; e++) {
+        tree->GetEntry(e);
+        for (int i = 0; i < n; i++) {
+            pool.particles.Add(pid[i], cols[0][i], cols[1][i], cols[2][i], cols[3][i],
+                               cols[4][i], cols[5][i], cols[6][i], cols[7][i]);
+        }
+    }
+    cout << "Replay: " << pool.particles.Size() << " particles from " << nEntries << " events of "
+         << filename << ":" << tree->GetName() << " (" << (isHadron ? "hadron" : "parton") << " mode)" << endl;
+    f->Close();
+    delete f;
+    return pool.particles.Size() > 0;
+}
+
+// One row of the result table
+struct BenchRow {
+    double seconds = 0;
+    long long particles = 0;
+    double pairs = 0;
+    long long accepted = 0;
+    long long allocCalls = 0;
+    long long allocBytes = 0;
+};
+
+static void PrintHeader() {
+    printf("%-28s %7s %7s %11s %12s %10s %9s %13s %10s\n", "test", "mult", "events", "ms/event",
+           "ns/particle", "ns/pair", "accepted", "allocs/event", "kB/event");
+}
+
+static void PrintRow(const string& test, int mult, int nev, const BenchRow& r, bool withPairs) {
+    char pairs[32] = "-", accepted[32] = "-";
+    if (withPairs) {
+        if (r.pairs > 0) snprintf(pairs, sizeof(pairs), "%.2f", 1e9 * r.seconds / r.pairs);
+        snprintf(accepted, sizeof(accepted), "%.1f", (double)r.accepted / nev);
+    }
+    printf("%-28s %7d %7d %11.4f %12.2f %10s %9s %13.1f %10.2f\n", test.c_str(), mult, nev,
+           1e3 * r.seconds / nev, 1e9 * r.seconds / max(r.particles, 1LL), pairs, accepted,
+           (double)r.allocCalls / nev, r.allocBytes / 1024.0 / nev);
+}
+
+static BenchRow RunAnalysis(AnalysisCore& core, const vector<BenchEvent>& events) {
+    BenchRow r;
+    long long calls0 = g_alloc_calls, bytes0 = g_alloc_bytes;
+    double pairs = 0;
+    long long accepted = 0;
+    auto t0 = chrono::steady_clock::now();
+    for (size_t e = 0; e < events.size(); e++) {
+        const BenchEvent& evt = events[e];
+        core.AnalyzeEvent((int)e, evt.b, evt.Size(), evt.pid.data(), evt.px.data(), evt.py.data(),
+                          evt.pz.data(), evt.x.data(), evt.y.data(), evt.z.data());
+        double nacc = core.GetLastAccepted();
+        pairs += nacc * (nacc - 1) / 2;
+        accepted += core.GetLastAccepted();
+    }
+    auto t1 = chrono::steady_clock::now();
+    r.seconds = chrono::duration<double>(t1 - t0).count();
+    r.allocCalls = g_alloc_calls - calls0;
+    r.allocBytes = g_alloc_bytes - bytes0;
+    for (auto& evt : events) r.particles += evt.Size();
+    r.pairs = pairs;
+    r.accepted = accepted;
+    return r;
+}
+
+// The writer streams, in SkimStream order
+enum BenchStream { W_AMPT = 0, W_ZPC, W_PARTON_INITIAL, W_HADRON_BEFORE_ART, W_HADRON_BEFORE_MELTING, W_NSTREAMS };
+static const char* const kWriterNames[W_NSTREAMS] = {
+    "ampt", "zpc", "parton-initial", "hadron-before-art", "hadron-before-melting"};
+
+static int g_writer_event = 0;
+
+// Write one event through a stream's Fortran entry points
+static void WriteEvent(int stream, BenchEvent& evt) {
+    int id = ++g_writer_event, n = evt.Size(), zero = 0, miss = 0;
+    double b = evt.b, phiRP = 0;
+    switch (stream) {
+        case W_AMPT:
+            write_ampt_event_header_(&id, &id, &n, &b, &zero, &zero, &zero, &zero, &zero, &zero, &phiRP);
+            break;
+        case W_ZPC:
+            write_zpc_event_header_(&id, &miss, &n, &b, &zero, &zero, &zero, &zero);
+            break;
+        case W_PARTON_INITIAL:
+            write_parton_initial_event_header_(&id, &miss, &n, &b);
+            break;
+        case W_HADRON_BEFORE_ART:
+            write_hadron_before_art_event_header_(&id, &miss, &n, &b, &zero, &zero, &zero, &zero);
+            break;
+        case W_HADRON_BEFORE_MELTING:
+            write_hadron_before_melting_event_header_(&id, &miss, &n, &b, &zero, &zero, &zero, &zero);
+            break;
+    }
+    for (int i = 0; i < n; i++) {
+        int* pid = &evt.pid[i];
+        double *px = &evt.px[i], *py = &evt.py[i], *pz = &evt.pz[i], *m = &evt.mass[i];
+        double *x = &evt.x[i], *y = &evt.y[i], *z = &evt.z[i], *t = &evt.t[i];
+        switch (stream) {
+            case W_AMPT: write_ampt_particle_(pid, px, py, pz, m, x, y, z, t); break;
+            case W_ZPC: write_zpc_particle_(pid, px, py, pz, m, x, y, z, t); break;
+            case W_PARTON_INITIAL:
+                write_parton_initial_particle_(pid, px, py, pz, m, x, y, z, t,
+                                               &evt.istrg0[i], &evt.xstrg0[i], &evt.ystrg0[i]);
+                break;
+            case W_HADRON_BEFORE_ART: write_hadron_before_art_particle_(pid, px, py, pz, m, x, y, z, t); break;
+            case W_HADRON_BEFORE_MELTING: write_hadron_before_melting_particle_(pid, px, py, pz, m, x, y, z, t); break;
+        }
+    }
+}
+
+static BenchRow RunWriter(int stream, vector<BenchEvent>& events) {
+    BenchRow r;
+    long long calls0 = g_alloc_calls, bytes0 = g_alloc_bytes;
+    auto t0 = chrono::steady_clock::now();
+    for (auto& evt : events) WriteEvent(stream, evt);
+    auto t1 = chrono::steady_clock::now();
+    r.seconds = chrono::duration<double>(t1 - t0).count();
+    r.allocCalls = g_alloc_calls - calls0;
+    r.allocBytes = g_alloc_bytes - bytes0;
+    for (auto& evt : events) r.particles += evt.Size();
+    return r;
+}
+
+static void Usage(const char* prog) {
+    cout << "Usage: " << prog << " [options]" << endl;
+    cout << "  -m <list>  multiplicities (default 100,300,1000,3000,10000,30000,50000)" << endl;
+    cout << "  -n <n>     events per multiplicity (default 1e8/mult^2, 1..1000)" << endl;
+    cout << "  -s <mix>   hadron fractions pi,K,N,Lambda,phi (default 0.70,0.12,0.06,0.02,0.01)" << endl;
+    cout << "  -v <v2>    elliptic flow of synthetic events (default 0.05)" << endl;
+    cout << "  -r <file>  replay particles from a stream file (hadron or parton tree)" << endl;
+    cout << "  -w <dir>   directory for the writer outputs (default: temporary)" << endl;
+    cout << "  -W         skip the writers" << endl;
+    cout << "  -S <seed>  random seed (default 20030819)" << endl;
+}
+
+static vector<double> ParseList(const char* arg) {
+    vector<double> values;
+    string s(arg);
+    size_t pos = 0;
+    while (pos <= s.size()) {
+        size_t comma = s.find(',', pos);
+        if (comma == string::npos) comma = s.size();
+        if (comma > pos) values.push_back(atof(s.substr(pos, comma - pos).c_str()));
+        pos = comma + 1;
+    }
+    return values;
+}
+
+int main(int argc, char** argv) {
+    vector<double> mults = {100, 300, 1000, 3000, 10000, 30000, 50000};
+    vector<double> mix = {0.70, 0.12, 0.06, 0.02, 0.01};
+    vector<string> replayFiles;
+    int nevFixed = 0;
+    double v2 = 0.05;
+    string writerDir;
+    bool writers = true;
+    unsigned long long seed = 20030819;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "m:n:s:v:r:w:WS:h")) != -1) {
+        switch (opt) {
+            case 'm': mults = ParseList(optarg); break;
+            case 'n': nevFixed = atoi(optarg); break;
+            case 's': mix = ParseList(optarg); break;
+            case 'v': v2 = atof(optarg); break;
+            case 'r': replayFiles.push_back(optarg); break;
+            case 'w': writerDir = optarg; break;
+            case 'W': writers = false; break;
+            case 'S': seed = strtoull(optarg, nullptr, 10); break;
+            default: Usage(argv[0]); return 1;
+        }
+    }
+    if (mix.size() != 5) {
+        cerr << "Error: -s needs 5 fractions (pi,K,N,Lambda,phi)" << endl;
+        return 1;
+    }
+    for (double m : mults) {
+        if (m < 1 || m > MAX_PARTICLES) {
+            cerr << "Error: multiplicity " << m << " outside 1.." << MAX_PARTICLES << endl;
+            return 1;
+        }
+    }
+
+    ReplayPool replay[2];  // [0] hadrons, [1] partons
+    bool useReplay[2] = {false, false};
+    for (auto& file : replayFiles) {
+        ReplayPool pool;
+        bool isHadron;
+        if (!LoadReplay(file, pool, isHadron)) return 1;
+        int k = isHadron ? 0 : 1;
+        replay[k] = pool;
+        useReplay[k] = true;
+    }
+    vector<Species> hadrons = HadronSpecies(mix);
+    vector<Species> partons = PartonSpecies();
+    mt19937_64 rng(seed);
+
+    AnalysisCore hadronCore, partonCore;
+    hadronCore.Initialize(true, "bench_hadron");
+    partonCore.Initialize(false, "bench_parton");
+    for (AnalysisCore* core : {&hadronCore, &partonCore}) {
+        core->SetProgressInterval(0);
+        core->SetCheckpointInterval(0);
+    }
+
+    // Writers: real output files under <dir>/ana, real-time analysis detached
+    string cwd = filesystem::current_path().string();
+    bool tempDir = false;
+    AnalysisCore* detached[W_NSTREAMS] = {nullptr};
+    if (writers) {
+        if (writerDir.empty()) {
+            char tmpl[] = "/tmp/ampt-analysis-bench-XXXXXX";
+            if (!mkdtemp(tmpl)) {
+                cerr << "Error: Cannot create a temporary directory" << endl;
+                return 1;
+            }
+            writerDir = tmpl;
+            tempDir = true;
+        }
+        filesystem::create_directories(writerDir + "/ana");
+        if (chdir(writerDir.c_str()) != 0) {
+            cerr << "Error: Cannot enter " << writerDir << endl;
+            return 1;
+        }
+        init_root_();
+        init_zpc_root_();
+        init_parton_initial_root_();
+        init_hadron_before_art_root_();
+        init_hadron_before_melting_root_();
+        AnalysisCore** globals[W_NSTREAMS] = {&g_analysis_ampt, &g_analysis_zpc, &g_analysis_parton,
+                                              &g_analysis_hadron_before_art,
+                                              &g_analysis_hadron_before_melting};
+        for (int s = 0; s < W_NSTREAMS; s++) {
+            detached[s] = *globals[s];
+            *globals[s] = nullptr;
+        }
+    }
+
+    cout << endl;
+    PrintHeader();
+    long long writtenParticles[W_NSTREAMS] = {0};
+    for (double m : mults) {
+        int mult = (int)m;
+        int nev = nevFixed > 0 ? nevFixed : (int)min(1000.0, max(1.0, 1e8 / (m * m)));
+
+        vector<BenchEvent> hadronEvents(nev), partonEvents(nev);
+        for (int e = 0; e < nev; e++) {
+            if (useReplay[0]) MakeReplay(replay[0], mult, hadronEvents[e]);
+            else MakeSynthetic(rng, hadrons, v2, mult, hadronEvents[e]);
+            if (useReplay[1]) MakeReplay(replay[1], mult, partonEvents[e]);
+            else MakeSynthetic(rng, partons, v2, mult, partonEvents[e]);
+        }
+
+        PrintRow("analysis_hadron", mult, nev, RunAnalysis(hadronCore, hadronEvents), true);
+        PrintRow("analysis_parton", mult, nev, RunAnalysis(partonCore, partonEvents), true);
+        if (writers) {
+            for (int s = 0; s < W_NSTREAMS; s++) {
+                bool partonStream = (s == W_ZPC || s == W_PARTON_INITIAL);
+                BenchRow r = RunWriter(s, partonStream ? partonEvents : hadronEvents);
+                writtenParticles[s] += r.particles;
+                PrintRow(string("write_") + kWriterNames[s], mult, nev, r, false);
+            }
+        }
+        fflush(stdout);
+    }
+
+    if (writers) {
+        g_analysis_ampt = detached[W_AMPT];
+        g_analysis_zpc = detached[W_ZPC];
+        g_analysis_parton = detached[W_PARTON_INITIAL];
+        g_analysis_hadron_before_art = detached[W_HADRON_BEFORE_ART];
+        g_analysis_hadron_before_melting = detached[W_HADRON_BEFORE_MELTING];
+        finalize_zpc_root_();
+        finalize_parton_initial_root_();
+        finalize_hadron_before_art_root_();
+        finalize_hadron_before_melting_root_();
+        finalize_root_();
+
+        cout << endl << "Output size of the writers (compressed, all multiplicities)" << endl;
+        for (int s = 0; s < W_NSTREAMS; s++) {
+            string file = string("ana/") + kWriterNames[s] + ".root";
+            error_code ec;
+            uintmax_t bytes = filesystem::file_size(file, ec);
+            if (ec || writtenParticles[s] == 0) continue;
+            printf("  %-34s %12ju bytes %8.2f bytes/particle\n", file.c_str(), bytes,
+                   (double)bytes / writtenParticles[s]);
+        }
+        if (chdir(cwd.c_str()) != 0) return 1;
+        if (tempDir) filesystem::remove_all(writerDir);
+    }
+
+    return 0;
+}
@@ -0,0 +1,496 @@
+// ampt-dat2root: convert archived ASCII outputs to the ROOT schema of root_interface.cpp
+//
+//   ampt-dat2root [options] <input.dat>
+//     -o <file>    write the tree (ampt, zpc or parton_initial) to <file>
+//     -a <file>    run AnalysisCore on every event and save the results to <file>
+//     -s <stream>  ampt, zpc or parton_initial (default: from the file name)
+//     -j <n>       parser threads (default: all cores)
+//     -B <MB>      block size handed to one thread (default 64)
+//
+// Understood inputs are the files written by the transport:
+//   ana/ampt.dat                             linana.f, formats 190/191 and 200/201
+//   ana/zpc.dat                              hijing1.383_ampt.f, formats 395 and 210/211
+//   ana/parton-initial-afterPropagation.dat  zpc.f/linana.f, list-directed header and 200/201
+//
+// The file is mmapped and cut into blocks; every thread parses whole events
+// whose header line starts inside its block, using std::from_chars.  Header
+// and particle lines are told apart by their number of fields.  Blocks are
+// processed in waves of one block per thread: the parsed events are then
+// filled into the tree in file order, while -a analyses them inside the
+// parser threads (one AnalysisCore per thread, merged at the end), so -a
+// alone re-analyses an archive without writing a tree.
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <thread>
+#include <memory>
+#include <charconv>
+#include <cstring>
+#include <cstdlib>
+#include <cmath>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "TFile.h"
+#include "TTree.h"
+#include "TH1.h"
+#include "TROOT.h"
+#include "TStopwatch.h"
+#include "analysis_core.h"
+
+using namespace std;
+
+enum DatStream { DAT_AMPT = 0, DAT_ZPC, DAT_PARTON_INITIAL };
+
+// One parsed event, columns as in the ROOT trees
+struct DatEvent {
+    int eventID, runID, miss, nParticles;
+    double impactParameter;
+    int npart1, npart2, nelp, ninp, nelt, ninthj;
+    double phiRP;
+    vector<int> pid;
+    vector<double> px, py, pz, mass, x, y, z, t;
+    vector<int> istrg0;
+    vector<double> xstrg0, ystrg0;
+};
+
+// Result of one block
+struct DatBlock {
+    size_t begin, end;
+    vector<DatEvent> events;
+    long long bad_fields = 0;
+};
+
+static const int MAX_FIELDS = 16;
+
+// Split one line into whitespace separated fields; returns the field count
+static int SplitFields(const char* p, const char* end, const char** fb, const char** fe) {
+    int n = 0;
+    while (p < end) {
+        while (p < end && (*p == ' ' || *p == '\t' || *p == '\r')) p++;
+        if (p >= end) break;
+        const char* s = p;
+        while (p < end && *p != ' ' && *p != '\t' && *p != '\r') p++;
+        if (n < MAX_FIELDS) {
+            fb[n] = s;
+            fe[n] = p;
+        }
+        n++;
+    }
+    return n;
+}
+
+static inline int ToInt(const char* b, const char* e, long long& bad) {
+    int v = 0;
+    if (b < e && *b == '+') b++;
+    if (from_chars(b, e, v).ec != errc()) bad++;
+    return v;
+}
+
+static inline double ToDouble(const char* b, const char* e, long long& bad) {
+    double v = 0;
+    if (b < e && *b == '+') b++;
+    // Fortran writes "********" for values that overflow the field
+    if (from_chars(b, e, v).ec != errc()) {
+        v = NAN;
+        bad++;
+    }
+    return v;
+}
+
+static int ParticleFields(DatStream stream) {
+    return stream == DAT_PARTON_INITIAL ? 12 : 9;
+}
+
+static bool IsHeader(DatStream stream, int nFields) {
+    switch (stream) {
+        case DAT_AMPT: return nFields == 10 || nFields == 11;  // format 190 / 191 (with phiRP)
+        case DAT_ZPC: return nFields == 8;                     // format 395
+        default: return nFields == 3 || nFields == 7;          // zpc.f / linana.f list-directed
+    }
+}
+
+static void ParseHeader(DatStream stream, int n, const char** fb, const char** fe, DatEvent& evt,
+                        long long& bad) {
+    evt.runID = evt.miss = 0;
+    evt.npart1 = evt.npart2 = evt.nelp = evt.ninp = evt.nelt = evt.ninthj = 0;
+    evt.impactParameter = evt.phiRP = 0;
+    evt.eventID = ToInt(fb[0], fe[0], bad);
+    if (stream == DAT_AMPT) {
+        evt.runID = ToInt(fb[1], fe[1], bad);
+        evt.impactParameter = ToDouble(fb[3], fe[3], bad);
+        evt.npart1 = ToInt(fb[4], fe[4], bad);
+        evt.npart2 = ToInt(fb[5], fe[5], bad);
+        evt.nelp = ToInt(fb[6], fe[6], bad);
+        evt.ninp = ToInt(fb[7], fe[7], bad);
+        evt.nelt = ToInt(fb[8], fe[8], bad);
+        evt.ninthj = ToInt(fb[9], fe[9], bad);
+        if (n > 10) evt.phiRP = ToDouble(fb[10], fe[10], bad);
+    } else if (stream == DAT_ZPC) {
+        evt.miss = ToInt(fb[1], fe[1], bad);
+        evt.impactParameter = ToDouble(fb[3], fe[3], bad);
+        evt.nelp = ToInt(fb[4], fe[4], bad);
+        evt.ninp = ToInt(fb[5], fe[5], bad);
+        evt.nelt = ToInt(fb[6], fe[6], bad);
+        evt.ninthj = ToInt(fb[7], fe[7], bad);
+    } else {
+        // The .dat header carries no impact parameter
+        evt.miss = ToInt(fb[1], fe[1], bad);
+    }
+    evt.nParticles = 0;
+    evt.pid.clear();
+    evt.px.clear(); evt.py.clear(); evt.pz.clear(); evt.mass.clear();
+    evt.x.clear(); evt.y.clear(); evt.z.clear(); evt.t.clear();
+    evt.istrg0.clear(); evt.xstrg0.clear(); evt.ystrg0.clear();
+}
+
+static void ParseParticle(DatStream stream, const char** fb, const char** fe, DatEvent& evt,
+                          long long& bad) {
+    evt.pid.push_back(ToInt(fb[0], fe[0], bad));
+    evt.px.push_back(ToDouble(fb[1], fe[1], bad));
+    evt.py.push_back(ToDouble(fb[2], fe[2], bad));
+    evt.pz.push_back(ToDouble(fb[3], fe[3], bad));
+    evt.mass.push_back(ToDouble(fb[4], fe[4], bad));
+    evt.x.push_back(ToDouble(fb[5], fe[5], bad));
+    evt.y.push_back(ToDouble(fb[6], fe[6], bad));
+    evt.z.push_back(ToDouble(fb[7], fe[7], bad));
+    evt.t.push_back(ToDouble(fb[8], fe[8], bad));
+    if (stream == DAT_PARTON_INITIAL) {
+        evt.istrg0.push_back(ToInt(fb[9], fe[9], bad));
+        evt.xstrg0.push_back(ToDouble(fb[10], fe[10], bad));
+        evt.ystrg0.push_back(ToDouble(fb[11], fe[11], bad));
+    }
+    evt.nParticles++;
+}
+
+static void AnalyzeDatEvent(AnalysisCore* analysis, const DatEvent& evt) {
+    if (!analysis || evt.nParticles <= 0) return;
+    analysis->AnalyzeEvent(evt.eventID, evt.impactParameter, evt.nParticles, evt.pid.data(),
+                           evt.px.data(), evt.py.data(), evt.pz.data(),
+                           evt.x.data(), evt.y.data(), evt.z.data());
+}
+
+// Parse the events whose header line starts in [blk.begin, blk.end)
+static void ParseBlock(const char* data, size_t size, DatStream stream, DatBlock& blk,
+                       bool keepEvents, AnalysisCore* analysis) {
+    const char* fb[MAX_FIELDS];
+    const char* fe[MAX_FIELDS];
+    const char* end = data + size;
+
+    // First line starting at or after blk.begin
+    const char* p = data + blk.begin;
+    if (blk.begin > 0 && data[blk.begin - 1] != '\n') {
+        const char* nl = (const char*)memchr(p, '\n', end - p);
+        p = nl ? nl + 1 : end;
+    }
+
+    int pfields = ParticleFields(stream);
+    DatEvent scratch;
+    DatEvent* evt = nullptr;
+    size_t used = 0;
+
+    while (p < end) {
+        const char* nl = (const char*)memchr(p, '\n', end - p);
+        const char* eol = nl ? nl : end;
+        int n = SplitFields(p, eol, fb, fe);
+
+        if (n > 0 && IsHeader(stream, n)) {
+            // The next event belongs to the following block
+            if ((size_t)(p - data) >= blk.end) break;
+            if (evt && !keepEvents) AnalyzeDatEvent(analysis, *evt);
+            if (keepEvents) {
+                if (used == blk.events.size()) blk.events.emplace_back();
+                evt = &blk.events[used++];
+            } else {
+                evt = &scratch;
+            }
+            ParseHeader(stream, n, fb, fe, *evt, blk.bad_fields);
+        } else if (n >= pfields && evt) {
+            ParseParticle(stream, fb, fe, *evt, blk.bad_fields);
+        } else if (n > 0) {
+            // Lines before the first header of a block belong to the previous block
+            if (evt) blk.bad_fields++;
+        }
+        p = eol + 1;
+    }
+
+    if (keepEvents) {
+        blk.events.resize(used);
+        for (const DatEvent& e : blk.events) AnalyzeDatEvent(analysis, e);
+    } else if (evt) {
+        AnalyzeDatEvent(analysis, *evt);
+    }
+}
+
+// Tree with the branch layout of root_interface.cpp, filled from one DatEvent
+class DatTreeWriter {
+private:
+    TFile* file;
+    TTree* tree;
+    DatStream stream;
+    DatEvent cur;
+    int nParticles;
+    vector<int> pid, istrg0;
+    vector<double> px, py, pz, mass, x, y, z, t, xstrg0, ystrg0;
+
+public:
+    DatTreeWriter() : file(nullptr), tree(nullptr), stream(DAT_AMPT), nParticles(0) {}
+
+    bool Open(const string& filename, DatStream s) {
+        stream = s;
+        file = new TFile(filename.c_str(), "RECREATE");
+        if (!file || file->IsZombie()) {
+            cerr << "ERROR: Cannot create ROOT file " << filename << endl;
+            return false;
+        }
+
+        const int maxp = 99999;
+        pid.resize(maxp); istrg0.resize(maxp);
+        px.resize(maxp); py.resize(maxp); pz.resize(maxp); mass.resize(maxp);
+        x.resize(maxp); y.resize(maxp); z.resize(maxp); t.resize(maxp);
+        xstrg0.resize(maxp); ystrg0.resize(maxp);
+
+        if (stream == DAT_AMPT) {
+            tree = new TTree("ampt", "AMPT final hadrons");
+        } else if (stream == DAT_ZPC) {
+            tree = new TTree("zpc", "AMPT zero momentum frame partons");
+        } else {
+            tree = new TTree("parton_initial", "AMPT initial partons after propagation");
+        }
+        tree->SetAutoFlush(50);
+        tree->SetAutoSave(200);
+
+        tree->Branch("eventID", &cur.eventID, "eventID/I");
+        if (stream == DAT_AMPT) {
+            tree->Branch("runID", &cur.runID, "runID/I");
+        } else {
+            tree->Branch("miss", &cur.miss, "miss/I");
+        }
+        tree->Branch("nParticles", &nParticles, "nParticles/I");
+        tree->Branch("impactParameter", &cur.impactParameter, "impactParameter/D");
+        if (stream == DAT_AMPT) {
+            tree->Branch("npart1", &cur.npart1, "npart1/I");
+            tree->Branch("npart2", &cur.npart2, "npart2/I");
+        }
+        if (stream != DAT_PARTON_INITIAL) {
+            tree->Branch("nelp", &cur.nelp, "nelp/I");
+            tree->Branch("ninp", &cur.ninp, "ninp/I");
+            tree->Branch("nelt", &cur.nelt, "nelt/I");
+            tree->Branch("ninthj", &cur.ninthj, "ninthj/I");
+        }
+        if (stream == DAT_AMPT) tree->Branch("phiRP", &cur.phiRP, "phiRP/D");
+
+        tree->Branch("pid", pid.data(), "pid[nParticles]/I");
+        tree->Branch("px", px.data(), "px[nParticles]/D");
+        tree->Branch("py", py.data(), "py[nParticles]/D");
+        tree->Branch("pz", pz.data(), "pz[nParticles]/D");
+        tree->Branch("mass", mass.data(), "mass[nParticles]/D");
+        tree->Branch("x", x.data(), "x[nParticles]/D");
+        tree->Branch("y", y.data(), "y[nParticles]/D");
+        tree->Branch("z", z.data(), "z[nParticles]/D");
+        tree->Branch("t", t.data(), "t[nParticles]/D");
+        if (stream == DAT_PARTON_INITIAL) {
+            tree->Branch("istrg0", istrg0.data(), "istrg0[nParticles]/I");
+            tree->Branch("xstrg0", xstrg0.data(), "xstrg0[nParticles]/D");
+            tree->Branch("ystrg0", ystrg0.data(), "ystrg0[nParticles]/D");
+        }
+        return true;
+    }
+
+    void Fill(const DatEvent& evt) {
+        if (!tree) return;
+        int n = min(evt.nParticles, (int)pid.size());
+        cur.eventID = evt.eventID;
+        cur.runID = evt.runID;
+        cur.miss = evt.miss;
+        cur.impactParameter = evt.impactParameter;
+        cur.npart1 = evt.npart1;
+        cur.npart2 = evt.npart2;
+        cur.nelp = evt.nelp;
+        cur.ninp = evt.ninp;
+        cur.nelt = evt.nelt;
+        cur.ninthj = evt.ninthj;
+        cur.phiRP = evt.phiRP;
+        nParticles = n;
+        size_t bytes = n * sizeof(double);
+        memcpy(pid.data(), evt.pid.data(), n * sizeof(int));
+        memcpy(px.data(), evt.px.data(), bytes);
+        memcpy(py.data(), evt.py.data(), bytes);
+        memcpy(pz.data(), evt.pz.data(), bytes);
+        memcpy(mass.data(), evt.mass.data(), bytes);
+        memcpy(x.data(), evt.x.data(), bytes);
+        memcpy(y.data(), evt.y.data(), bytes);
+        memcpy(z.data(), evt.z.data(), bytes);
+        memcpy(t.data(), evt.t.data(), bytes);
+        if (stream == DAT_PARTON_INITIAL) {
+            memcpy(istrg0.data(), evt.istrg0.data(), n * sizeof(int));
+            memcpy(xstrg0.data(), evt.xstrg0.data(), bytes);
+            memcpy(ystrg0.data(), evt.ystrg0.data(), bytes);
+        }
+        tree->Fill();
+    }
+
+    Long64_t Close() {
+        if (!file) return 0;
+        Long64_t entries = tree ? tree->GetEntries() : 0;
+        file->cd();
+        if (tree) tree->Write();
+        file->Close();
+        delete file;
+        file = nullptr;
+        tree = nullptr;
+        return entries;
+    }
+};
+
+static bool StreamFromName(const string& name, DatStream& stream) {
+    if (name == "ampt") stream = DAT_AMPT;
+    else if (name == "zpc") stream = DAT_ZPC;
+    else if (name == "parton_initial") stream = DAT_PARTON_INITIAL;
+    else return false;
+    return true;
+}
+
+static bool StreamFromFile(const string& path, DatStream& stream) {
+    string base = path.substr(path.find_last_of('/') == string::npos ? 0 : path.find_last_of('/') + 1);
+    if (base.find("parton-initial") != string::npos) stream = DAT_PARTON_INITIAL;
+    else if (base.find("zpc") != string::npos) stream = DAT_ZPC;
+    else if (base.find("ampt") != string::npos) stream = DAT_AMPT;
+    else return false;
+    return true;
+}
+
+static void Usage(const char* prog) {
+    cout << "Usage: " << prog << " [-o tree.root] [-a analysis.root] [-s stream] [-j threads] [-B blockMB] <input.dat>" << endl;
+    cout << "  stream: ampt, zpc, parton_initial (default: from the file name)" << endl;
+    cout << "  at least one of -o / -a is required" << endl;
+}
+
+int main(int argc, char** argv) {
+    string tree_output, analysis_output, stream_name;
+    unsigned int nThreads = thread::hardware_concurrency();
+    size_t block_size = 64ull << 20;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "o:a:s:j:B:h")) != -1) {
+        switch (opt) {
+            case 'o': tree_output = optarg; break;
+            case 'a': analysis_output = optarg; break;
+            case 's': stream_name = optarg; break;
+            case 'j': nThreads = atoi(optarg); break;
+            case 'B': block_size = (size_t)atof(optarg) * (1 << 20); break;
+            default: Usage(argv[0]); return 1;
+        }
+    }
+    if (optind >= argc || (tree_output.empty() && analysis_output.empty())) {
+        Usage(argv[0]);
+        return 1;
+    }
+    if (nThreads == 0) nThreads = 1;
+    if (block_size < (1 << 20)) block_size = 1 << 20;
+    string input = argv[optind];
+
+    DatStream stream;
+    if (!stream_name.empty() ? !StreamFromName(stream_name, stream) : !StreamFromFile(input, stream)) {
+        cerr << "ERROR: Cannot determine the stream of " << input << ", use -s" << endl;
+        return 1;
+    }
+    static const char* stream_names[] = {"ampt", "zpc", "parton_initial"};
+
+    int fd = open(input.c_str(), O_RDONLY);
+    struct stat st;
+    if (fd < 0 || fstat(fd, &st) != 0) {
+        cerr << "ERROR: Cannot open " << input << endl;
+        return 1;
+    }
+    size_t size = st.st_size;
+    const char* data = nullptr;
+    if (size > 0) {
+        data = (const char*)mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data == MAP_FAILED) {
+            cerr << "ERROR: Cannot mmap " << input << endl;
+            return 1;
+        }
+        madvise((void*)data, size, MADV_SEQUENTIAL);
+    }
+
+    TStopwatch timer;
+    timer.Start();
+
+    // Analysis: one instance per thread, histograms kept out of gDirectory
+    bool hadronMode = (stream == DAT_AMPT);
+    string analysis_name = (stream == DAT_PARTON_INITIAL) ? "parton" : stream_names[stream];
+    vector<unique_ptr<AnalysisCore>> analyses;
+    if (!analysis_output.empty()) {
+        ROOT::EnableThreadSafety();
+        TH1::AddDirectory(false);
+        for (unsigned int i = 0; i < nThreads; i++) {
+            analyses.emplace_back(new AnalysisCore());
+            analyses[i]->Initialize(hadronMode, analysis_name + "_thread" + to_string(i));
+            analyses[i]->SetProgressInterval(0);
+            analyses[i]->SetCheckpointInterval(0);
+        }
+    }
+
+    DatTreeWriter writer;
+    bool keepEvents = !tree_output.empty();
+    if (keepEvents && !writer.Open(tree_output, stream)) return 1;
+
+    size_t nBlocks = (size + block_size - 1) / block_size;
+    vector<DatBlock> blocks(nThreads);
+    long long nEvents = 0, nParticles = 0, bad_fields = 0;
+
+    for (size_t wave = 0; wave < nBlocks; wave += nThreads) {
+        unsigned int nActive = min((size_t)nThreads, nBlocks - wave);
+        vector<thread> workers;
+        for (unsigned int i = 0; i < nActive; i++) {
+            DatBlock& blk = blocks[i];
+            blk.begin = (wave + i) * block_size;
+            blk.end = min(size, blk.begin + block_size);
+            blk.bad_fields = 0;
+            AnalysisCore* analysis = analyses.empty() ? nullptr : analyses[i].get();
+            workers.emplace_back(ParseBlock, data, size, stream, ref(blk), keepEvents, analysis);
+        }
+        for (auto& w : workers) w.join();
+
+        // Tree entries keep the order of the file
+        for (unsigned int i = 0; i < nActive; i++) {
+            for (const DatEvent& evt : blocks[i].events) {
+                if (keepEvents) writer.Fill(evt);
+                nEvents++;
+                nParticles += evt.nParticles;
+            }
+            bad_fields += blocks[i].bad_fields;
+        }
+    }
+
+    if (keepEvents) {
+        writer.Close();
+        cout << "Tree " << stream_names[stream] << " written to " << tree_output << endl;
+    }
+
+    if (!analyses.empty()) {
+        AnalysisCore result;
+        result.Initialize(hadronMode, analysis_name);
+        result.SetCheckpointInterval(0);
+        for (auto& a : analyses) result.Merge(*a);
+        result.SaveResults(analysis_output.c_str());
+    }
+
+    timer.Stop();
+    double seconds = max(timer.RealTime(), 1e-9);
+    cout << "Converted " << input << ": " << size / 1e6 << " MB";
+    if (keepEvents) cout << ", " << nEvents << " events, " << nParticles << " particles";
+    cout << " in " << seconds << " s (" << size / 1e6 / seconds << " MB/s, "
+         << nThreads << " threads)" << endl;
+    if (bad_fields > 0) {
+        cout << "Warning: " << bad_fields << " unreadable fields (overflowed Fortran fields are stored as NaN)" << endl;
+    }
+
+    if (data) munmap((void*)data, size);
+    close(fd);
+    return 0;
+}
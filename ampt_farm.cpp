@@ -0,0 +1,627 @@
+// ampt-farm: node-level multi-process driver for AMPT
+//
+// All AMPT state lives in Fortran COMMON blocks, so one ampt process can only
+// simulate one event at a time. ampt-farm keeps N pinned worker slots busy on a
+// node: NEVNT is cut into small chunks, every idle slot pulls the next chunk
+// from a shared queue (dynamic work stealing, so slow central events do not
+// stall the other cores), and each chunk runs as a fresh ampt process over its
+// own range of the global event numbers ("ampt FIRST LAST") with event-indexed
+// seeding (iseedev=1).  Every event is then a function of the master seed and
+// its number only: the events and their eventIDs are those of a single ampt
+// run with the same seed, whatever the chunk size or the number of workers.
+//
+// When a worker exits, the parent merges the files of its chunk directory
+// incrementally into one file per output stream with TFileMerger.  The same
+// merger adds up the AnalysisCore histograms/TProfiles of each chunk, so the
+// node produces exactly one set of *_analysis.root results.
+//
+// A chunk is merged only after its ampt process exited cleanly, so a worker that
+// dies (OOM, signal, preemption of a single core) never leaves half an event in
+// the merged output: the chunk is simply requeued on another slot.
+//
+// The sidecar event indexes of the chunks (ana/<stream>.index.root, see
+// event_index.h) are appended in the same order, each entry shifted by the
+// entries merged before its chunk, and written as <stream>.index.root next to
+// the merged file, so ampt-index-merge and EventIndexReader work on the farm
+// output as on a single run.
+//
+// Usage:
+//   ampt-farm -e <NEVNT> [-n workers] [-c chunk] [-s seed] [-i input.ampt]
+//             [-b ./ampt] [-o farm_out] [-r retries] [-k]
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <deque>
+#include <map>
+#include <memory>
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <cctype>
+#include <csignal>
+
+#include <sched.h>
+#include <unistd.h>
+#include <getopt.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+
+#include "TFile.h"
+#include "TTree.h"
+#include "TNamed.h"
+#include "TFileMerger.h"
+#include "event_index.h"
+
+using namespace std;
+
+// Output files written by one ampt run (root_interface.cpp), merged per stream
+static const char* kStreamFiles[] = {
+    "ampt.root", "zpc.root", "parton-initial.root",
+    "hadron-before-art.root", "hadron-before-melting.root",
+    "ampt_analysis.root", "zpc_analysis.root", "parton-initial_analysis.root",
+    "hadron-before-art_analysis.root", "hadron-before-melting_analysis.root"
+};
+static const int kNStreamFiles = sizeof(kStreamFiles) / sizeof(kStreamFiles[0]);
+
+// Streams with a sidecar index <stream>.index.root next to <stream>.root
+static const char* kIndexStreams[] = {
+    "ampt", "zpc", "parton-initial", "hadron-before-art", "hadron-before-melting"
+};
+static const int kNIndexStreams = sizeof(kIndexStreams) / sizeof(kIndexStreams[0]);
+
+// A value main.f reads from input.ampt that the farm rewrites: its line
+// (1-based) and a word of the comment that line carries in the input format
+struct InputLine {
+    int line;
+    const char* token;
+};
+static const InputLine kLineNEVNT   = {9, "NEVNT"};
+static const InputLine kLineIHJSED  = {31, "ihjsed"};
+static const InputLine kLineNSEED   = {32, "random seed for HIJING"};
+static const InputLine kLineISEEDEV = {58, "event-indexed seeding"};
+static const InputLine kPatchedLines[] = {kLineNEVNT, kLineIHJSED, kLineNSEED, kLineISEEDEV};
+
+struct FarmOptions {
+    int nWorkers = 0;               // 0: one per CPU in the affinity mask
+    int nEvents = 0;
+    int chunkSize = 5;
+    int masterSeed = 13150909;
+    int maxRetries = 2;
+    bool keepChunks = false;
+    string inputFile = "input.ampt";
+    string amptBinary = "./ampt";
+    string outputDir = "farm_out";
+};
+
+struct Chunk {
+    int index;
+    int firstEvent;                 // global number of the first event
+    int nEvents;
+    int attempts;
+};
+
+// Merged sidecar index of one stream: the rows of the merged chunks, with
+// entries counted in the merged tree
+struct MergedIndex {
+    string treeName, species, speciesNames;
+    vector<EventIndexEntry> rows;
+    Long64_t entries = 0;           // entries of the merged stream tree so far
+    bool usable = true;             // false once a chunk had no usable index
+};
+
+struct Slot {
+    int cpu;                        // CPU this slot is pinned to (-1: unpinned)
+    int node;                       // NUMA node of that CPU
+    pid_t pid;                      // running ampt process, 0 when idle
+    Chunk chunk;
+};
+
+static volatile sig_atomic_t g_stop = 0;
+
+static void HandleStop(int) { g_stop = 1; }
+
+// Expand a sysfs cpulist such as "0-3,8-11"
+static vector<int> ParseCpuList(const string& text) {
+    vector<int> cpus;
+    stringstream ss(text);
+    string item;
+    while (getline(ss, item, ',')) {
+        if (item.empty()) continue;
+        size_t dash = item.find('-');
+        int lo = atoi(item.c_str());
+        int hi = (dash == string::npos) ? lo : atoi(item.c_str() + dash + 1);
+        for (int c = lo; c <= hi; c++) cpus.push_back(c);
+    }
+    return cpus;
+}
+
+// Assign CPUs to slots, interleaving NUMA nodes so that N workers spread over
+// all memory controllers.  Only CPUs in our own affinity mask are used, so the
+// farm respects the cgroup/cpuset given by Slurm or Condor.
+static vector<Slot> BuildSlots(int nWorkers) {
+    cpu_set_t allowed;
+    CPU_ZERO(&allowed);
+    sched_getaffinity(0, sizeof(allowed), &allowed);
+
+    vector<vector<int>> nodeCpus;
+    DIR* dir = opendir("/sys/devices/system/node");
+    if (dir) {
+        vector<int> nodeIds;
+        while (dirent* ent = readdir(dir)) {
+            if (strncmp(ent->d_name, "node", 4) == 0 && isdigit(ent->d_name[4])) {
+                nodeIds.push_back(atoi(ent->d_name + 4));
+            }
+        }
+        closedir(dir);
+        sort(nodeIds.begin(), nodeIds.end());
+        for (int id : nodeIds) {
+            ifstream fin("/sys/devices/system/node/node" + to_string(id) + "/cpulist");
+            string line;
+            getline(fin, line);
+            vector<int> cpus;
+            for (int c : ParseCpuList(line)) {
+                if (CPU_ISSET(c, &allowed)) cpus.push_back(c);
+            }
+            if (!cpus.empty()) nodeCpus.push_back(cpus);
+        }
+    }
+    if (nodeCpus.empty()) {
+        vector<int> cpus;
+        for (int c = 0; c < CPU_SETSIZE; c++) {
+            if (CPU_ISSET(c, &allowed)) cpus.push_back(c);
+        }
+        nodeCpus.push_back(cpus);
+    }
+
+    // Round-robin over nodes
+    vector<pair<int, int>> order;  // (cpu, node)
+    size_t maxPerNode = 0;
+    for (auto& v : nodeCpus) maxPerNode = max(maxPerNode, v.size());
+    for (size_t k = 0; k < maxPerNode; k++) {
+        for (size_t n = 0; n < nodeCpus.size(); n++) {
+            if (k < nodeCpus[n].size()) order.push_back(make_pair(nodeCpus[n][k], (int)n));
+        }
+    }
+
+    if (nWorkers <= 0) nWorkers = order.size();
+    vector<Slot> slots(nWorkers);
+    for (int i = 0; i < nWorkers; i++) {
+        slots[i].pid = 0;
+        if (i < (int)order.size()) {
+            slots[i].cpu = order[i].first;
+            slots[i].node = order[i].second;
+        } else {
+            // Oversubscribed: leave the extra slots to the kernel scheduler
+            slots[i].cpu = -1;
+            slots[i].node = -1;
+        }
+    }
+    return slots;
+}
+
+static bool ReadLines(const string& path, vector<string>& lines) {
+    ifstream fin(path);
+    if (!fin) return false;
+    string line;
+    while (getline(fin, line)) lines.push_back(line);
+    return true;
+}
+
+// Replace the leading value of an input.ampt line, keeping the "! comment"
+static string ReplaceValue(const string& line, const string& value) {
+    size_t start = line.find_first_not_of(" \t");
+    if (start == string::npos) return value;
+    size_t end = line.find_first_of(" \t!", start);
+    if (end == string::npos) return value;
+    return value + line.substr(end);
+}
+
+static string ChunkDir(const FarmOptions& opt, int index) {
+    char buf[64];
+    snprintf(buf, sizeof(buf), "/chunks/chunk_%05d", index);
+    return opt.outputDir + buf;
+}
+
+// The chunk input: template with the master seed and event-indexed seeding;
+// the ZPC seed of the template is kept
+static bool WriteChunkInput(const FarmOptions& opt, const vector<string>& tmpl,
+                            const Chunk& chunk, const string& dir) {
+    vector<string> lines = tmpl;
+    if ((int)lines.size() < kLineISEEDEV.line) return false;
+    auto set = [&](const InputLine& l, const string& value) {
+        lines[l.line - 1] = ReplaceValue(lines[l.line - 1], value);
+    };
+    set(kLineNEVNT, to_string(chunk.nEvents));
+    set(kLineIHJSED, "0");
+    set(kLineNSEED, to_string(opt.masterSeed));
+    set(kLineISEEDEV, "1");
+
+    ofstream fout(dir + "/input.ampt");
+    if (!fout) return false;
+    for (auto& l : lines) fout << l << "\n";
+    return true;
+}
+
+static void RemoveTree(const string& path) {
+    string cmd = "rm -rf '" + path + "'";
+    if (system(cmd.c_str()) != 0) {
+        cerr << "Warning: cannot remove " << path << endl;
+    }
+}
+
+// Fork one ampt process for the events of a chunk, pinned to the slot's CPU
+static pid_t LaunchChunk(const FarmOptions& opt, const vector<string>& tmpl, Slot& slot) {
+    string dir = ChunkDir(opt, slot.chunk.index);
+    RemoveTree(dir);  // leftovers of a failed attempt
+    string cmd = "mkdir -p '" + dir + "/ana'";
+    if (system(cmd.c_str()) != 0) return -1;
+    if (!WriteChunkInput(opt, tmpl, slot.chunk, dir)) return -1;
+
+    string binary = opt.amptBinary;
+    if (binary[0] != '/') {
+        char cwd[4096];
+        if (getcwd(cwd, sizeof(cwd))) binary = string(cwd) + "/" + binary;
+    }
+
+    pid_t pid = fork();
+    if (pid != 0) return pid;
+
+    // ---- child ----
+    if (slot.cpu >= 0) {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(slot.cpu, &set);
+        // First-touch allocation then keeps the COMMON blocks on the local node
+        sched_setaffinity(0, sizeof(set), &set);
+    }
+    if (chdir(dir.c_str()) != 0) _exit(127);
+
+    // main.f reads a runtime seed from stdin even with ihjsed=0
+    string seedFile = "nseed_runtime";
+    {
+        ofstream fs(seedFile);
+        fs << opt.masterSeed << "\n";
+    }
+    int in = open(seedFile.c_str(), O_RDONLY);
+    int out = open("nohup.out", O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (in >= 0) dup2(in, 0);
+    if (out >= 0) { dup2(out, 1); dup2(out, 2); }
+
+    string first = to_string(slot.chunk.firstEvent);
+    string last = to_string(slot.chunk.firstEvent + slot.chunk.nEvents);
+    execl(binary.c_str(), binary.c_str(), first.c_str(), last.c_str(), (char*)nullptr);
+    _exit(127);
+}
+
+// Entries of the final-hadron tree of a finished chunk (-1 if unreadable)
+static Long64_t ChunkEntries(const string& dir) {
+    TFile* f = TFile::Open((dir + "/ana/ampt.root").c_str());
+    if (!f || f->IsZombie()) {
+        delete f;
+        return -1;
+    }
+    TTree* t = (TTree*)f->Get("ampt");
+    Long64_t n = t ? t->GetEntries() : -1;
+    f->Close();
+    delete f;
+    return n;
+}
+
+// Append the sidecar index of a merged chunk.  The rows must match the data
+// tree of the chunk one to one, or the merged index is dropped (with a warning)
+static void AppendChunkIndex(const string& dir, const char* stream, MergedIndex& idx) {
+    string data = dir + "/ana/" + stream + ".root";
+    if (!idx.usable || access(data.c_str(), R_OK) != 0) return;
+    string indexFile = dir + "/ana/" + stream + ".index.root";
+    string problem;
+    TFile* f = TFile::Open(indexFile.c_str());
+    TTree* t = (f && !f->IsZombie()) ? (TTree*)f->Get("event_index") : nullptr;
+    TNamed* tn = t ? (TNamed*)f->Get("tree_name") : nullptr;
+    TNamed* sp = t ? (TNamed*)f->Get("species") : nullptr;
+    TNamed* spn = t ? (TNamed*)f->Get("species_names") : nullptr;
+    Long64_t dataEntries = -1;
+    if (!t || !tn || !sp) {
+        problem = "no event index";
+    } else if (!idx.treeName.empty() && idx.treeName != tn->GetTitle()) {
+        problem = string("index of a different tree (") + tn->GetTitle() + ")";
+    } else {
+        TFile* d = TFile::Open(data.c_str());
+        TTree* dt = (d && !d->IsZombie()) ? (TTree*)d->Get(tn->GetTitle()) : nullptr;
+        dataEntries = dt ? dt->GetEntries() : -1;
+        if (d) d->Close();
+        delete d;
+        if (dataEntries != t->GetEntries()) problem = "index rows do not match the tree entries";
+    }
+    if (!problem.empty()) {
+        cerr << "Warning: " << indexFile << ": " << problem << ", " << stream
+             << ".index.root will not be written" << endl;
+        idx.usable = false;
+        idx.rows.clear();
+    } else {
+        if (idx.treeName.empty()) {
+            idx.treeName = tn->GetTitle();
+            idx.species = sp->GetTitle();
+            idx.speciesNames = spn ? spn->GetTitle() : "";
+        }
+        EventIndexEntry row;
+        SetIndexBranchAddresses(t, row, false);
+        for (Long64_t i = 0; i < t->GetEntries(); i++) {
+            t->GetEntry(i);
+            row.fileID = -1;
+            row.entry += idx.entries;
+            idx.rows.push_back(row);
+        }
+        idx.entries += dataEntries;
+    }
+    if (f) f->Close();
+    delete f;
+}
+
+// Write a merged index in the sidecar format of EventIndexWriter
+static void WriteMergedIndex(const string& path, const MergedIndex& idx) {
+    TFile* out = new TFile(path.c_str(), "RECREATE");
+    if (!out || out->IsZombie()) {
+        cerr << "Warning: cannot create " << path << endl;
+        delete out;
+        return;
+    }
+    TNamed("tree_name", idx.treeName.c_str()).Write();
+    TNamed("species", idx.species.c_str()).Write();
+    TNamed("species_names", idx.speciesNames.c_str()).Write();
+
+    EventIndexEntry row;
+    TTree* t = new TTree("event_index", ("Event index of " + idx.treeName).c_str());
+    t->Branch("eventID", &row.eventID, "eventID/I");
+    t->Branch("runID", &row.runID, "runID/I");
+    t->Branch("entry", &row.entry, "entry/L");
+    t->Branch("impactParameter", &row.impactParameter, "impactParameter/D");
+    t->Branch("npart1", &row.npart1, "npart1/I");
+    t->Branch("npart2", &row.npart2, "npart2/I");
+    t->Branch("nParticles", &row.nParticles, "nParticles/I");
+    t->Branch("nSpecies", &row.nSpecies, "nSpecies/I");
+    t->Branch("nAccepted", row.nAccepted, "nAccepted[nSpecies]/I");
+    for (const auto& r : idx.rows) {
+        row = r;
+        t->Fill();
+    }
+    t->Write();
+    out->Close();
+    delete out;
+}
+
+int main(int argc, char** argv) {
+    FarmOptions opt;
+    int c;
+    while ((c = getopt(argc, argv, "n:e:c:s:i:b:o:r:kh")) != -1) {
+        switch (c) {
+            case 'n': opt.nWorkers = atoi(optarg); break;
+            case 'e': opt.nEvents = atoi(optarg); break;
+            case 'c': opt.chunkSize = atoi(optarg); break;
+            case 's': opt.masterSeed = atoi(optarg); break;
+            case 'i': opt.inputFile = optarg; break;
+            case 'b': opt.amptBinary = optarg; break;
+            case 'o': opt.outputDir = optarg; break;
+            case 'r': opt.maxRetries = atoi(optarg); break;
+            case 'k': opt.keepChunks = true; break;
+            default:
+                cout << "Usage: " << argv[0] << " -e <NEVNT> [options]" << endl;
+                cout << "  -n <workers>   worker processes (default: all allowed CPUs)" << endl;
+                cout << "  -c <events>    events per chunk (default: 5)" << endl;
+                cout << "  -s <seed>      HIJING seed of the run (default: 13150909)" << endl;
+                cout << "  -i <file>      input.ampt template (default: input.ampt)" << endl;
+                cout << "  -b <binary>    ampt executable (default: ./ampt)" << endl;
+                cout << "  -o <dir>       merged output directory (default: farm_out)" << endl;
+                cout << "  -r <n>         retries per chunk after a worker dies (default: 2)" << endl;
+                cout << "  -k             keep per-chunk work directories" << endl;
+                return c == 'h' ? 0 : 1;
+        }
+    }
+    if (opt.nEvents <= 0 || opt.chunkSize <= 0) {
+        cerr << "Error: -e <NEVNT> and a positive chunk size are required" << endl;
+        return 1;
+    }
+    // main.f uses NSEED=2*NSEED+1, which must stay inside INTEGER*4
+    if (opt.masterSeed <= 0 || opt.masterSeed > 1073741823) {
+        cerr << "Error: the seed must be between 1 and 1073741823" << endl;
+        return 1;
+    }
+
+    vector<string> tmpl;
+    if (!ReadLines(opt.inputFile, tmpl)) {
+        cerr << "Error: cannot read input template " << opt.inputFile << endl;
+        return 1;
+    }
+    // Every rewritten line must be the one of the current input format, or the
+    // chunks would run with a value in the wrong place
+    for (const InputLine& l : kPatchedLines) {
+        if ((int)tmpl.size() < l.line || tmpl[l.line - 1].find(l.token) == string::npos) {
+            cerr << "Error: line " << l.line << " of " << opt.inputFile << " is not the \""
+                 << l.token << "\" line of input.ampt, start from input.ampt or "
+                 << "slurm_jobs/templates" << endl;
+            return 1;
+        }
+    }
+
+    string cmd = "mkdir -p '" + opt.outputDir + "/chunks'";
+    if (system(cmd.c_str()) != 0) {
+        cerr << "Error: cannot create " << opt.outputDir << endl;
+        return 1;
+    }
+
+    signal(SIGINT, HandleStop);
+    signal(SIGTERM, HandleStop);
+
+    // Work queue: chunk i holds events i*chunk+1 ... (i+1)*chunk
+    deque<Chunk> queue;
+    int nChunks = (opt.nEvents + opt.chunkSize - 1) / opt.chunkSize;
+    for (int i = 0; i < nChunks; i++) {
+        Chunk ch;
+        ch.index = i;
+        ch.firstEvent = 1 + i * opt.chunkSize;
+        ch.nEvents = min(opt.chunkSize, opt.nEvents - i * opt.chunkSize);
+        ch.attempts = 0;
+        queue.push_back(ch);
+    }
+
+    vector<Slot> slots = BuildSlots(opt.nWorkers);
+    cout << "ampt-farm: " << opt.nEvents << " events in " << nChunks << " chunks on "
+         << slots.size() << " workers" << endl;
+    for (size_t i = 0; i < slots.size(); i++) {
+        cout << "  worker " << i << ": cpu " << slots[i].cpu << ", node " << slots[i].node << endl;
+    }
+
+    // One incremental merger per output file
+    vector<unique_ptr<TFileMerger>> mergers(kNStreamFiles);
+    vector<bool> mergerOpen(kNStreamFiles, false);
+    vector<MergedIndex> indexes(kNIndexStreams);
+
+    // Manifest of merged chunks, written next to the merged trees
+    Int_t m_chunk, m_firstEvent, m_nEvents, m_attempts, m_cpu;
+    Long64_t m_firstEntry;
+    Long64_t mergedEntries = 0;
+    int mergedEvents = 0;
+    vector<Chunk> merged;
+    vector<pair<Long64_t, int>> mergedInfo;  // (firstEntry, cpu)
+
+    int running = 0, failed = 0;
+    // A chunk that could not be started or whose worker died goes back to the
+    // queue until it has used its retries
+    auto requeue = [&](const Chunk& ch) {
+        if (ch.attempts <= opt.maxRetries) {
+            queue.push_front(ch);
+        } else {
+            cerr << "Error: chunk " << ch.index << " abandoned after "
+                 << ch.attempts << " attempts" << endl;
+            failed++;
+        }
+    };
+    while ((!queue.empty() || running > 0) && !g_stop) {
+        // Hand chunks to idle slots
+        for (auto& slot : slots) {
+            if (slot.pid != 0 || queue.empty()) continue;
+            slot.chunk = queue.front();
+            queue.pop_front();
+            slot.chunk.attempts++;
+            pid_t pid = LaunchChunk(opt, tmpl, slot);
+            if (pid < 0) {
+                cerr << "Warning: cannot start chunk " << slot.chunk.index
+                     << " (attempt " << slot.chunk.attempts << ")" << endl;
+                requeue(slot.chunk);
+                continue;
+            }
+            slot.pid = pid;
+            running++;
+        }
+        if (running == 0) break;
+
+        int status = 0;
+        pid_t done = waitpid(-1, &status, 0);
+        if (done < 0) continue;  // interrupted by a signal
+
+        for (auto& slot : slots) {
+            if (slot.pid != done) continue;
+            slot.pid = 0;
+            running--;
+
+            Chunk ch = slot.chunk;
+            string dir = ChunkDir(opt, ch.index);
+            bool ok = WIFEXITED(status) && WEXITSTATUS(status) == 0;
+            Long64_t entries = ok ? ChunkEntries(dir) : -1;
+            if (entries < 0) ok = false;
+
+            if (!ok) {
+                cerr << "Warning: chunk " << ch.index << " failed on cpu " << slot.cpu
+                     << " (attempt " << ch.attempts << ")" << endl;
+                requeue(ch);
+                break;
+            }
+
+            // Merge the files of the finished chunk into the merged outputs
+            for (int s = 0; s < kNStreamFiles; s++) {
+                string src = dir + "/ana/" + kStreamFiles[s];
+                if (access(src.c_str(), R_OK) != 0) continue;
+                if (!mergerOpen[s]) {
+                    mergers[s].reset(new TFileMerger(kFALSE, kFALSE));
+                    mergers[s]->SetPrintLevel(0);
+                    mergers[s]->OutputFile((opt.outputDir + "/" + kStreamFiles[s]).c_str(), "RECREATE");
+                    mergerOpen[s] = true;
+                }
+                mergers[s]->AddFile(src.c_str(), kFALSE);
+                mergers[s]->PartialMerge(TFileMerger::kAll | TFileMerger::kIncremental);
+            }
+            for (int s = 0; s < kNIndexStreams; s++) {
+                AppendChunkIndex(dir, kIndexStreams[s], indexes[s]);
+            }
+
+            merged.push_back(ch);
+            mergedInfo.push_back(make_pair(mergedEntries, slot.cpu));
+            mergedEntries += entries;
+            mergedEvents += ch.nEvents;
+            cout << "ampt-farm: chunk " << ch.index << " merged (" << ch.nEvents << " events, "
+                 << entries << " ampt entries, " << merged.size() << "/" << nChunks << " chunks)"
+                 << endl;
+
+            if (!opt.keepChunks) RemoveTree(dir);
+            break;
+        }
+    }
+
+    if (g_stop) {
+        cerr << "ampt-farm: stop requested, terminating workers" << endl;
+        for (auto& slot : slots) {
+            if (slot.pid != 0) kill(slot.pid, SIGTERM);
+        }
+        for (auto& slot : slots) {
+            if (slot.pid != 0) waitpid(slot.pid, nullptr, 0);
+        }
+    }
+
+    // Closing the mergers finalizes the merged files
+    for (int s = 0; s < kNStreamFiles; s++) mergers[s].reset();
+    for (int s = 0; s < kNIndexStreams; s++) {
+        if (indexes[s].usable && !indexes[s].treeName.empty()) {
+            WriteMergedIndex(opt.outputDir + "/" + kIndexStreams[s] + ".index.root", indexes[s]);
+        }
+    }
+
+    // Record which chunk produced which entries and events
+    string amptOut = opt.outputDir + "/ampt.root";
+    if (!merged.empty() && access(amptOut.c_str(), W_OK) == 0) {
+        TFile* f = new TFile(amptOut.c_str(), "UPDATE");
+        if (f && !f->IsZombie()) {
+            TTree* manifest = new TTree("farm_chunks", "ampt-farm chunk manifest");
+            manifest->Branch("chunk", &m_chunk, "chunk/I");
+            manifest->Branch("firstEvent", &m_firstEvent, "firstEvent/I");
+            manifest->Branch("nEvents", &m_nEvents, "nEvents/I");
+            manifest->Branch("attempts", &m_attempts, "attempts/I");
+            manifest->Branch("cpu", &m_cpu, "cpu/I");
+            manifest->Branch("firstEntry", &m_firstEntry, "firstEntry/L");
+            for (size_t i = 0; i < merged.size(); i++) {
+                m_chunk = merged[i].index;
+                m_firstEvent = merged[i].firstEvent;
+                m_nEvents = merged[i].nEvents;
+                m_attempts = merged[i].attempts;
+                m_firstEntry = mergedInfo[i].first;
+                m_cpu = mergedInfo[i].second;
+                manifest->Fill();
+            }
+            manifest->Write();
+            f->Close();
+        }
+        delete f;
+    }
+
+    cout << "ampt-farm: " << merged.size() << "/" << nChunks << " chunks, " << mergedEvents
+         << " events (" << mergedEntries << " ampt entries) merged into " << opt.outputDir << endl;
+    if (failed > 0 || (int)merged.size() != nChunks) {
+        cerr << "ampt-farm: " << (nChunks - (int)merged.size()) << " chunks missing" << endl;
+        return 2;
+    }
+    return 0;
+}
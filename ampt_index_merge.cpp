@@ -0,0 +1,184 @@
+// ampt-index-merge: build a campaign-level event index from per-file sidecars
+//
+//   ampt-index-merge <campaign_index.root> <x.index.root | files.list> ...
+//       merge sidecar indexes into one index sorted by impactParameter
+//
+//   ampt-index-merge --query <campaign_index.root> <bMin> <bMax> [npartMin npartMax]
+//       print the per-file entry ranges of the selected events
+//
+// The campaign index stores the data file of every row in index_files, so the
+// reader API in event_index.h can turn a query straight into a TEntryList.
+
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <cstdlib>
+
+#include "TFile.h"
+#include "TTree.h"
+#include "TNamed.h"
+#include "event_index.h"
+
+using namespace std;
+
+static void ExpandInputs(int argc, char** argv, int first, vector<string>& inputs) {
+    for (int i = first; i < argc; i++) {
+        string arg = argv[i];
+        if (arg.find(".list") != string::npos) {
+            ifstream fin(arg);
+            string line;
+            while (getline(fin, line)) {
+                if (!line.empty()) inputs.push_back(line);
+            }
+        } else {
+            inputs.push_back(arg);
+        }
+    }
+}
+
+static int Query(int argc, char** argv) {
+    if (argc < 5) {
+        cout << "Usage: " << argv[0] << " --query <campaign_index.root> <bMin> <bMax> [npartMin npartMax]" << endl;
+        return 1;
+    }
+    EventIndexReader reader;
+    if (!reader.Open(argv[2])) return 1;
+
+    EventQuery q;
+    q.bMin = atof(argv[3]);
+    q.bMax = atof(argv[4]);
+    if (argc > 6) {
+        q.npartMin = atoi(argv[5]);
+        q.npartMax = atoi(argv[6]);
+    }
+
+    auto ranges = reader.SelectRanges(q);
+    Long64_t total = 0;
+    for (auto& fr : ranges) {
+        cout << fr.first << ":";
+        for (auto& r : fr.second) {
+            cout << " [" << r.first << "," << r.second << ")";
+            total += r.second - r.first;
+        }
+        cout << endl;
+    }
+    cout << "Selected " << total << " of " << reader.GetNEvents() << " events in "
+         << ranges.size() << " files" << endl;
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    if (argc > 1 && string(argv[1]) == "--query") return Query(argc, argv);
+    if (argc < 3) {
+        cout << "Usage: " << argv[0] << " <campaign_index.root> <index files | .list> ..." << endl;
+        cout << "       " << argv[0] << " --query <campaign_index.root> <bMin> <bMax> [npartMin npartMax]" << endl;
+        return 1;
+    }
+
+    string output = argv[1];
+    vector<string> inputs;
+    ExpandInputs(argc, argv, 2, inputs);
+
+    string tree_name, species, species_names;
+    vector<EventIndexEntry> rows;
+    vector<string> files;
+
+    for (const string& input : inputs) {
+        TFile* f = TFile::Open(input.c_str());
+        if (!f || f->IsZombie()) {
+            cerr << "Warning: cannot open " << input << ", skipped" << endl;
+            delete f;
+            continue;
+        }
+        TTree* t = (TTree*)f->Get("event_index");
+        TNamed* tn = (TNamed*)f->Get("tree_name");
+        TNamed* sp = (TNamed*)f->Get("species");
+        TNamed* spn = (TNamed*)f->Get("species_names");
+        if (!t || !tn || !sp) {
+            cerr << "Warning: " << input << " is not an event index, skipped" << endl;
+            f->Close();
+            delete f;
+            continue;
+        }
+        if (tree_name.empty()) {
+            tree_name = tn->GetTitle();
+            species = sp->GetTitle();
+            species_names = spn ? spn->GetTitle() : "";
+        } else if (tree_name != tn->GetTitle() || species != sp->GetTitle()) {
+            cerr << "Warning: " << input << " indexes a different stream ("
+                 << tn->GetTitle() << "), skipped" << endl;
+            f->Close();
+            delete f;
+            continue;
+        }
+
+        int fileID = files.size();
+        files.push_back(IndexDataFile(input));
+
+        EventIndexEntry row;
+        SetIndexBranchAddresses(t, row, false);
+        for (Long64_t i = 0; i < t->GetEntries(); i++) {
+            t->GetEntry(i);
+            row.fileID = fileID;
+            rows.push_back(row);
+        }
+        f->Close();
+        delete f;
+    }
+
+    if (files.empty()) {
+        cerr << "Error: no usable index files" << endl;
+        return 1;
+    }
+
+    stable_sort(rows.begin(), rows.end(), [](const EventIndexEntry& a, const EventIndexEntry& b) {
+        return a.impactParameter < b.impactParameter;
+    });
+
+    TFile* out = new TFile(output.c_str(), "RECREATE");
+    if (!out || out->IsZombie()) {
+        cerr << "Error: cannot create " << output << endl;
+        return 1;
+    }
+    TNamed("tree_name", tree_name.c_str()).Write();
+    TNamed("species", species.c_str()).Write();
+    TNamed("species_names", species_names.c_str()).Write();
+
+    Int_t fileID;
+    char path[4096];
+    TTree* ft = new TTree("index_files", "Data files of the campaign index");
+    ft->Branch("fileID", &fileID, "fileID/I");
+    ft->Branch("path", path, "path/C");
+    for (size_t i = 0; i < files.size(); i++) {
+        fileID = i;
+        snprintf(path, sizeof(path), "%s", files[i].c_str());
+        ft->Fill();
+    }
+    ft->Write();
+
+    EventIndexEntry row;
+    TTree* t = new TTree("event_index", ("Campaign event index of " + tree_name).c_str());
+    t->Branch("fileID", &row.fileID, "fileID/I");
+    t->Branch("eventID", &row.eventID, "eventID/I");
+    t->Branch("runID", &row.runID, "runID/I");
+    t->Branch("entry", &row.entry, "entry/L");
+    t->Branch("impactParameter", &row.impactParameter, "impactParameter/D");
+    t->Branch("npart1", &row.npart1, "npart1/I");
+    t->Branch("npart2", &row.npart2, "npart2/I");
+    t->Branch("nParticles", &row.nParticles, "nParticles/I");
+    t->Branch("nSpecies", &row.nSpecies, "nSpecies/I");
+    t->Branch("nAccepted", row.nAccepted, "nAccepted[nSpecies]/I");
+    for (const auto& r : rows) {
+        row = r;
+        t->Fill();
+    }
+    t->Write();
+    out->Close();
+    delete out;
+
+    cout << "Campaign index " << output << ": " << rows.size() << " events from "
+         << files.size() << " files (" << tree_name << ")" << endl;
+    return 0;
+}
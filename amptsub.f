@@ -225,7 +225,7 @@ c      OPEN (89, FILE = 'ana/decay_rec.dat', STATUS = 'UNKNOWN')
 
 c.....error choice of initialization
       PRINT *, 'IAPAR2(1) must be 1, 2, or 3'
-      STOP
+      STOP 1
 
 c.....to use default initial conditions generated by the cascade,
 c.....or to read in initial conditions.
@@ -505,6 +505,8 @@ c.....particle record for many test particle runs.
       SUBROUTINE ARINI2(K)
 
       PARAMETER (MAXSTR=150001,MAXR=1)
+      COMMON /AMPCAP/ NSTRCP, NPTNCP
+cc      SAVE /AMPCAP/
       COMMON /ARPRNT/ ARPAR1(100), IAPAR2(50), ARINT1(100), IAINT2(50)
 cc      SAVE /ARPRNT/
       COMMON /ARPRC/ ITYPAR(MAXSTR),
@@ -554,13 +556,14 @@ c         dpp1(I,K)=1.
 
 c     initialize final time of each particle to ntmax*dt except for 
 c     decay daughters, which have values given by tfdcy() and >(ntmax*dt):
-      do 1002 ip=1,MAXSTR
+      call strgrw(MULTI1(K))
+      do 1002 ip=1,NSTRCP
          tfdcy(ip)=NTMAX*DT
          tft(ip)=NTMAX*DT
  1002 continue
 c
       do 1004 irun=1,MAXR
-         do 1003 ip=1,MAXSTR
+         do 1003 ip=1,NSTRCP
             tfdpi(ip,irun)=NTMAX*DT
  1003    continue
  1004 continue
@@ -568,6 +571,122 @@ c
       RETURN
       END
 
+c-----------------------------------------------------------------------
+
+c.....subroutine to set the active sizes NSTRCP (MAXSTR arrays) and
+c.....NPTNCP (MAXPTN arrays) for the run.  The arrays are static, so
+c.....only their pages that are written become resident; the loops
+c.....that reset them every event stop at the active size, which with
+c.....IARSIZ=1 is estimated from the collision system with a factor 3
+c.....margin and grown by STRGRW/zpc ftime when an event needs more.
+c.....The static limits MAXSTR/MAXPTN cannot grow; a system whose
+c.....estimate exceeds them gets a warning here, and an event that
+c.....exceeds them stops with an error in STRGRW/ftime.
+
+      SUBROUTINE ARSIZE(IARSIZ, EFRM, FRAME, IAP, IAT)
+
+      PARAMETER (MAXSTR=150001, MAXPTN=400001, NCAPMN=10000)
+      CHARACTER FRAME*8
+      COMMON /AMPCAP/ NSTRCP, NPTNCP
+cc      SAVE /AMPCAP/
+      SAVE   
+
+      IF (IARSIZ .NE. 1) THEN
+         NSTRCP = MAXSTR
+         NPTNCP = MAXPTN
+         RETURN
+      END IF
+c.....about 30 partons (20 hadrons) per nucleon in central Au+Au at
+c.....200 GeV, rising slowly with the energy:
+      ECM = EFRM
+      IF (FRAME .NE. 'CMS') ECM = SQRT(2. * 0.938 * EFRM)
+      EST = 30. * (IAP + IAT) * MAX(1., (ECM / 200.) ** 0.3)
+      IF (EST .GT. MAXSTR .OR. EST .GT. MAXPTN) WRITE (6, *)
+     &     'warning: about ', NINT(EST), ' particles per event ',
+     &     'expected, above MAXSTR=', MAXSTR, ' or MAXPTN=', MAXPTN,
+     &     '; raise them in the sources if events stop'
+      NCAP = MAX(NCAPMN, NINT(3. * MIN(EST, 1.E6)))
+      NSTRCP = MIN(MAXSTR, NCAP)
+      NPTNCP = MIN(MAXPTN, NCAP)
+      WRITE (6, *) 'active array sizes (MAXSTR, MAXPTN): ',
+     &     NSTRCP, NPTNCP
+
+      RETURN
+      END
+
+c-----------------------------------------------------------------------
+
+c.....subroutine to keep NSTRCP at least twice the number N of
+c.....particles in use; the newly used part gets the values the
+c.....per-event reset loops give it.  Until then it still holds zero,
+c.....as nothing beyond NSTRCP is ever written.  N above the static
+c.....limit MAXSTR stops the run with an error.
+
+      SUBROUTINE STRGRW(N)
+
+      PARAMETER (MAXSTR=150001, MAXR=1)
+      COMMON /AMPCAP/ NSTRCP, NPTNCP
+cc      SAVE /AMPCAP/
+      COMMON /ARPRNT/ ARPAR1(100), IAPAR2(50), ARINT1(100), IAINT2(50)
+cc      SAVE /ARPRNT/
+      COMMON /HH/ PROPER(MAXSTR)
+cc      SAVE /HH/
+      COMMON /PE/ PROPI(MAXSTR,MAXR)
+cc      SAVE /PE/
+      COMMON/tdecay/tfdcy(MAXSTR),tfdpi(MAXSTR,MAXR),tft(MAXSTR)
+cc      SAVE /tdecay/
+      COMMON/hbt/lblast(MAXSTR),xlast(4,MAXSTR),plast(4,MAXSTR),nlast
+cc      SAVE /hbt/
+      common/input1/ MASSPR,MASSTA,ISEED,IAVOID,DT
+cc      SAVE /input1/
+      COMMON /INPUT2/ ILAB, MANYB, NTMAX, ICOLL, INSYS, IPOT, MODE, 
+     &     IMOMEN, NFREQ, ICFLOW, ICRHO, ICOU, KPOTEN, KMUL
+cc      SAVE /INPUT2/
+      SAVE   
+
+      IF (N .GT. MAXSTR) THEN
+         WRITE (6, *) 'error: ', N, ' particles in the event exceed ',
+     &        'the static array size MAXSTR=', MAXSTR,
+     &        '; raise MAXSTR in the sources and rebuild'
+         STOP 1
+      END IF
+      IF (2 * N .LE. NSTRCP .OR. NSTRCP .GE. MAXSTR) RETURN
+      NEW = MIN(MAXSTR, MAX(2 * N, 2 * NSTRCP))
+      DO 1002 I = NSTRCP + 1, NEW
+         tfdcy(I) = NTMAX * DT
+         tft(I) = NTMAX * DT
+         lblast(I) = 999
+         IF (IAPAR2(1) .NE. 1) PROPER(I) = 1.
+         DO 1001 IRUN = 1, MAXR
+            tfdpi(I, IRUN) = NTMAX * DT
+            PROPI(I, IRUN) = 1.
+ 1001    CONTINUE
+ 1002 CONTINUE
+      WRITE (6, *) 'active MAXSTR array size grown: ', NSTRCP, NEW
+      NSTRCP = NEW
+
+      RETURN
+      END
+
+c-----------------------------------------------------------------------
+
+c.....called by ART right after NNN, the meson count of the time step,
+c.....is incremented and before entry NNN is filled: after the step the
+c.....MASSPR+MASSTA baryons and NNN mesons are relabelled into the
+c.....first MASSPR+MASSTA+NNN entries (MAXR=1, a single run).  DECAY2
+c.....also fills NNN+1, which the factor 2 in STRGRW covers.
+
+      SUBROUTINE ARTGRW(NNN)
+
+      common/input1/ MASSPR,MASSTA,ISEED,IAVOID,DT
+cc      SAVE /input1/
+      SAVE
+
+      call strgrw(MASSPR + MASSTA + NNN)
+
+      RETURN
+      END
+
 c=======================================================================
 
 c.....function to convert PDG flavor code into ART flavor code.
@@ -4913,6 +5032,8 @@ clin-6/06/02 test local freezeout:
      &     xmfrz(MAXPTN), 
      &     tfrz(302), ifrz(MAXPTN), idfrz(MAXPTN), itlast
 cc      SAVE /frzprc/
+      COMMON /AMPCAP/ NSTRCP, NPTNCP
+cc      SAVE /AMPCAP/
       SAVE   
 
 clin-6/06/02 test local freezeout for string melting,
@@ -4933,7 +5054,8 @@ c     use space-time values at local freezeout saved in /frzprc/:
       endif
 clin-6/06/02-end
 
-      DO 1002 I = 1, MAXSTR
+      call strgrw(NSG)
+      DO 1002 I = 1, NSTRCP
          ATAUI(I) = 0d0
          ZT1(I) = 0d0
          ZT2(I) = 0d0
@@ -5028,7 +5150,23 @@ c
 
 clin-10/01/03 random number generator for f77:
       function RANART(NSEED)
+      PARAMETER (NRBUF=1024)
+      DOUBLE PRECISION RNGB
+      COMMON /RNGBK/ IRNGBK
+cc      SAVE /RNGBK/
+      COMMON /RNGBUF/ RNGB(NRBUF,3), KRNG(3)
+cc      SAVE /RNGBUF/
       SAVE   
+c     counter-based backend (see RNGINI), stream 1:
+      if(IRNGBK.eq.1) then
+         if(KRNG(1).ge.NRBUF) then
+            call rng_fill(1, RNGB(1,1), NRBUF)
+            KRNG(1)=0
+         endif
+         KRNG(1)=KRNG(1)+1
+         ranart=RNGB(KRNG(1),1)
+         return
+      endif
 clin-4/2008 ran(nseed) is renamed to avoid conflict with system functions:
 c      ran=rand()
 clin-12/2018 exclude the endpoints in order to avoid crash 
@@ -5042,6 +5180,241 @@ c      ranart=rlu(0)
       return
       end
 
+c.....subroutine to select the random number backend of RANART (stream 1),
+c.....RLU (stream 2) and ZPC ran1 (stream 3): IRNG=0 the original
+c.....generators (default), IRNG=1 the Philox4x32-10 counter-based
+c.....generator of rng_philox.cpp keyed by the HIJING, JETSET and ZPC
+c.....seeds.  The functions then take their numbers from a buffer of
+c.....NRBUF numbers per stream, refilled a whole block at a time.
+
+      SUBROUTINE RNGINI(IRNG)
+
+      PARAMETER (NRBUF=1024)
+      DOUBLE PRECISION RNGB
+      COMMON /RNGBK/ IRNGBK
+cc      SAVE /RNGBK/
+      COMMON /RNGBUF/ RNGB(NRBUF,3), KRNG(3)
+cc      SAVE /RNGBUF/
+      COMMON/RNDF77/NSEED
+cc      SAVE /RNDF77/
+      COMMON/LUDATR/MRLU(6),RRLU(100)
+cc      SAVE /LUDATR/
+      common /rndm3/ iseedp
+cc      SAVE /rndm3/
+      SAVE   
+
+      IRNGBK = IRNG
+      IF (IRNGBK .NE. 1) RETURN
+      call rng_seed(1, NSEED)
+      call rng_seed(2, MRLU(1))
+      call rng_seed(3, iseedp)
+      DO 1001 IS = 1, 3
+         KRNG(IS) = NRBUF
+ 1001 CONTINUE
+
+      RETURN
+      END
+
+c.....subroutine to restart all generators at event IEVT for event-indexed
+c.....seeding (iseedev=1): the generators are reseeded by STGSED, and the
+c.....JETSET record /LUJETS/, from which HIJING reads entries left by the
+c.....previous event, is cleared.  Event IEVT then does not depend on
+c.....earlier events.
+
+      SUBROUTINE EVTSED(MASTER, MZPC, IEVT)
+
+      COMMON/LUJETS/N,K(9000,5),P(9000,5),V(9000,5)
+cc      SAVE /LUJETS/
+      SAVE
+
+      N = 0
+      DO 1003 J = 1, 5
+         DO 1002 I = 1, 9000
+            K(I,J) = 0
+            P(I,J) = 0.
+            V(I,J) = 0.
+ 1002    CONTINUE
+ 1003 CONTINUE
+      CALL STGSED(MASTER, MZPC, IEVT, 0)
+
+      RETURN
+      END
+
+c.....subroutine to restart the generators at stage ISTAGE of event IEVT
+c.....(0 at the start of the event, EVTSED; 1 and 2 after HIJING and ZPC
+c.....for the stage caches, stgcache.f): the seeds of RANART, RLU, ZPC
+c.....ran1 and the random_number of the coalescence are hashed from the
+c.....master seeds MASTER (HIJING) and MZPC (ZPC), IEVT and ISTAGE by
+c.....rng_stgseed in rng_philox.cpp.  The ZPC flag iff that flips the
+c.....sign of the scattering angle at every collision is reset as well.
+
+      SUBROUTINE STGSED(MASTER, MZPC, IEVT, ISTAGE)
+
+      PARAMETER (MAXRSD=64)
+      DOUBLE PRECISION ran1, dummy
+      DIMENSION ISEEDS(4), IRNSED(MAXRSD)
+      COMMON /RNGBK/ IRNGBK
+cc      SAVE /RNGBK/
+      COMMON/RNDF77/NSEED
+cc      SAVE /RNDF77/
+      COMMON/LUDATR/MRLU(6),RRLU(100)
+cc      SAVE /LUDATR/
+      common /rndm3/ iseedp
+cc      SAVE /rndm3/
+      common /rndm2/ iff
+cc      SAVE /rndm2/
+      SAVE
+
+      iff = -1
+      call rng_stgseed(MASTER, MZPC, IEVT, ISTAGE, ISEEDS)
+      NSEED = ISEEDS(1)
+      CALL SRAND(NSEED)
+c     MRLU(2)=0 makes RLU rebuild its lagged table from MRLU(1):
+      MRLU(1) = ISEEDS(2)
+      MRLU(2) = 0
+c     restart ran1 the way INIZPC does (ran1(-iseed), then irused-1=1 call):
+      iseedp = ISEEDS(3)
+      isedng = -iseedp
+      dummy = ran1(isedng)
+      iseed2 = 2
+      dummy = ran1(iseed2)
+      call random_seed(size=NRNSED)
+      IF (NRNSED .LE. MAXRSD) THEN
+         ISTATE = ISEEDS(4)
+         DO 1001 I = 1, NRNSED
+            ISTATE = MOD(69069 * MOD(ISTATE, 31104) + 1, 2147483647)
+            IRNSED(I) = ISTATE + I
+ 1001    CONTINUE
+         call random_seed(put=IRNSED(1:NRNSED))
+      ENDIF
+      CALL RNGINI(IRNGBK)
+
+      RETURN
+      END
+
+c.....subroutine to write a restart checkpoint after event J (ickpt in
+c.....input.ampt).  With event-indexed seeding (EVTSED) event J+1 does
+c.....not depend on events 1..J, so the transport state at the boundary
+c.....is J itself and only the outputs written so far are recorded:
+c.....ckpt_root_save (root_interface.cpp) saves the ROOT tree entry
+c.....counts, skim counters and AnalysisCore histograms in
+c.....ana/ckpt/state_J.root, then the size of every open ana*/ file goes
+c.....into the manifest ana/ckpt/ampt.ckpt.  The manifest is written to a
+c.....temporary file and renamed, and the previous state file is removed
+c.....only after that, so an interruption at any point leaves a complete
+c.....checkpoint.  KEY holds the run settings a restart has to match.
+      SUBROUTINE CKPSAV(J, KEY)
+
+      PARAMETER (MAXCKU=99)
+      DIMENSION KEY(6), IUNIT(MAXCKU)
+      INTEGER*8 ISIZE(MAXCKU)
+      CHARACTER*80 FNAME(MAXCKU)
+      CHARACTER*9 ACT
+      LOGICAL LOPEN
+      SAVE
+
+      NU = 0
+      DO 1001 IU = 7, MAXCKU
+         INQUIRE (UNIT=IU, OPENED=LOPEN, NAME=FNAME(NU+1), ACTION=ACT)
+         IF (.NOT. LOPEN) GOTO 1001
+         IF (FNAME(NU+1)(1:3) .NE. 'ana') GOTO 1001
+c     inputs (a replayed stage cache) are left alone
+         IF (ACT .EQ. 'READ') GOTO 1001
+         NU = NU + 1
+         IUNIT(NU) = IU
+         call flush(IU)
+         INQUIRE (UNIT=IU, SIZE=ISIZE(NU))
+ 1001 CONTINUE
+      call ckpt_root_save(J, ISTAT)
+      IF (ISTAT .NE. 0) THEN
+         WRITE (6, *) 'checkpoint after event ', J, ' failed'
+         RETURN
+      ENDIF
+      OPEN (89, FILE = 'ana/ckpt/ampt.ckpt.tmp', STATUS = 'UNKNOWN')
+      WRITE (89, *) J, (KEY(I), I = 1, 6)
+      WRITE (89, *) NU
+      DO 1002 I = 1, NU
+         WRITE (89, 101) IUNIT(I), ISIZE(I), TRIM(FNAME(I))
+ 1002 CONTINUE
+      CLOSE (89)
+      call rename('ana/ckpt/ampt.ckpt.tmp', 'ana/ckpt/ampt.ckpt')
+      call ckpt_root_done(J)
+      WRITE (6, *) 'checkpoint after event ', J
+ 101  FORMAT (I4, I20, 1X, A)
+
+      RETURN
+      END
+
+c.....subroutine to resume a run from ana/ckpt/ampt.ckpt ("ampt -r").
+c.....JCK returns the event of the checkpoint, or 0 if there is none and
+c.....the run starts from the beginning.  The settings KEY must be those
+c.....of the checkpointed run.  Each output file of the manifest is cut
+c.....back to its size at the checkpoint and connected for appending;
+c.....the OPEN statements of the initialization then find the unit
+c.....connected to the same file and leave it as it is.
+      SUBROUTINE CKPRST(KEY, JCK)
+
+      DIMENSION KEY(6), KEYCK(6)
+      INTEGER*8 ISIZE
+      CHARACTER*80 FNAME
+      CHARACTER*1 C
+      LOGICAL LEXIST
+      SAVE
+
+      JCK = 0
+      INQUIRE (FILE = 'ana/ckpt/ampt.ckpt', EXIST = LEXIST)
+      IF (.NOT. LEXIST) THEN
+         WRITE (6, *) 'no checkpoint in ana/ckpt, ',
+     1        'starting from the first event'
+         RETURN
+      ENDIF
+      OPEN (89, FILE = 'ana/ckpt/ampt.ckpt', STATUS = 'OLD')
+      READ (89, *) J, (KEYCK(I), I = 1, 6)
+      DO 1001 I = 1, 6
+         IF (KEYCK(I) .NE. KEY(I)) THEN
+            WRITE (6, *) 'the checkpoint is from another run (events,',
+     1           ' seeds, irngbk or isoft differ)'
+            STOP 1
+         ENDIF
+ 1001 CONTINUE
+      READ (89, *) NU
+      DO 1002 I = 1, NU
+         READ (89, 101) IU, ISIZE, FNAME
+         OPEN (IU, FILE = FNAME, ACCESS = 'STREAM',
+     1        FORM = 'UNFORMATTED', STATUS = 'OLD', ERR = 200)
+         IF (ISIZE .GT. 0) READ (IU, POS = ISIZE, ERR = 200) C
+         ENDFILE (IU)
+         CLOSE (IU)
+         OPEN (IU, FILE = FNAME, STATUS = 'UNKNOWN',
+     1        POSITION = 'APPEND')
+ 1002 CONTINUE
+      CLOSE (89)
+      JCK = J
+      WRITE (6, *) 'restarting after the checkpoint of event ', J
+ 101  FORMAT (I4, I20, 1X, A)
+
+      RETURN
+ 200  WRITE (6, *) 'cannot restore ', TRIM(FNAME),
+     1     ' from the checkpoint'
+      STOP 1
+      END
+
+c.....subroutine to remove the checkpoint of a run that has completed
+      SUBROUTINE CKPEND
+
+      LOGICAL LEXIST
+      SAVE
+
+      INQUIRE (FILE = 'ana/ckpt/ampt.ckpt', EXIST = LEXIST)
+      IF (LEXIST) THEN
+         OPEN (89, FILE = 'ana/ckpt/ampt.ckpt', STATUS = 'OLD')
+         CLOSE (89, STATUS = 'DELETE')
+      ENDIF
+      call ckpt_root_end
+
+      RETURN
+      END
+
 clin-3/2009
 c     Initialize hadron weights; 
 c     Can add initial hadrons before the hadron cascade starts (but after ZPC).
@@ -5,6 +5,7 @@
 #include <algorithm>
 #include "TMath.h"
 #include "TString.h"
+#include "TParameter.h"
 
 using namespace std;
 
@@ -15,7 +16,8 @@ AnalysisCore* g_analysis_parton = nullptr;
 AnalysisCore* g_analysis_hadron_before_art = nullptr;
 AnalysisCore* g_analysis_hadron_before_melting = nullptr;
 
-AnalysisCore::AnalysisCore() : processed_events(0), isHadronMode(true) {
+AnalysisCore::AnalysisCore() : processed_events(0), last_accepted(0), isHadronMode(true),
+                               progress_interval(10), checkpoint_interval(50) {
     p_delta_momentum = nullptr;
     p_gamma_momentum = nullptr;
     p_delta_spatial = nullptr;
@@ -199,15 +201,22 @@ bool AnalysisCore::AcceptParticle(int pid, double px, double py, double pz) {
 }
 
 void AnalysisCore::AnalyzeEvent(int eventID, double impactParameter, int nParticles,
-                               int* pid, double* px, double* py, double* pz,
-                               double* x, double* y, double* z) {
+                               const int* pid, const double* px, const double* py, const double* pz,
+                               const double* x, const double* y, const double* z) {
     // 移除所有中心度判断和多重数统计
     
     // 收集接受的粒子并填充单粒子直方图
     vector<int> accepted_indices;
+    last_accepted_species.assign(pid_codes.size(), 0);
     for (int i = 0; i < nParticles; i++) {
         if (AcceptParticle(pid[i], px[i], py[i], pz[i])) {
             accepted_indices.push_back(i);
+            for (size_t k = 0; k < pid_codes.size(); k++) {
+                if (pid_codes[k] == pid[i]) {
+                    last_accepted_species[k]++;
+                    break;
+                }
+            }
             
             // 填充单粒子直方图
             double pt = sqrt(px[i]*px[i] + py[i]*py[i]);
@@ -225,6 +234,7 @@ void AnalysisCore::AnalyzeEvent(int eventID, double impactParameter, int nPartic
     
     // 两粒子关联分析
     int nAccepted = accepted_indices.size();
+    last_accepted = nAccepted;
     for (int i = 0; i < nAccepted; i++) {
         int idx_i = accepted_indices[i];
         
@@ -300,16 +310,48 @@ void AnalysisCore::AnalyzeEvent(int eventID, double impactParameter, int nPartic
     processed_events++;
     
     // 定期输出进度
-    if (processed_events % 10 == 0) {
+    if (progress_interval > 0 && processed_events % progress_interval == 0) {
         cout << "Analysis: Processed " << processed_events << " events" << endl;
     }
     
     // 定期保存checkpoint
-    if (processed_events % 50 == 0) {
+    if (checkpoint_interval > 0 && processed_events % checkpoint_interval == 0) {
         SaveCheckpoint();
     }
 }
 
+void AnalysisCore::Merge(const AnalysisCore& other) {
+    // 两个实例以相同模式Initialize，直方图结构一致，逐个相加
+    p_delta_momentum->Add(other.p_delta_momentum);
+    p_gamma_momentum->Add(other.p_gamma_momentum);
+    p_delta_spatial->Add(other.p_delta_spatial);
+    p_gamma_spatial->Add(other.p_gamma_spatial);
+    
+    for (auto& pair : map_h1_angCorr_momentum_pidpair) {
+        auto it = other.map_h1_angCorr_momentum_pidpair.find(pair.first);
+        if (it != other.map_h1_angCorr_momentum_pidpair.end()) pair.second->Add(it->second);
+    }
+    for (auto& pair : map_h1_angCorr_spatial_pidpair) {
+        auto it = other.map_h1_angCorr_spatial_pidpair.find(pair.first);
+        if (it != other.map_h1_angCorr_spatial_pidpair.end()) pair.second->Add(it->second);
+    }
+    
+    for (auto& pair : map_h1_pt_pid) {
+        auto it = other.map_h1_pt_pid.find(pair.first);
+        if (it != other.map_h1_pt_pid.end()) pair.second->Add(it->second);
+    }
+    for (auto& pair : map_h1_phi_pid) {
+        auto it = other.map_h1_phi_pid.find(pair.first);
+        if (it != other.map_h1_phi_pid.end()) pair.second->Add(it->second);
+    }
+    for (auto& pair : map_p_v2_pid) {
+        auto it = other.map_p_v2_pid.find(pair.first);
+        if (it != other.map_p_v2_pid.end()) pair.second->Add(it->second);
+    }
+    
+    processed_events += other.processed_events;
+}
+
 void AnalysisCore::SaveResults(const char* filename) {
     TFile* f = new TFile(filename, "RECREATE");
     
@@ -346,6 +388,55 @@ void AnalysisCore::SaveResults(const char* filename) {
     cout << "Total events processed: " << processed_events << endl;
 }
 
+void AnalysisCore::SaveState(TDirectory* dir) const {
+    dir->WriteTObject(p_delta_momentum);
+    dir->WriteTObject(p_gamma_momentum);
+    dir->WriteTObject(p_delta_spatial);
+    dir->WriteTObject(p_gamma_spatial);
+    for (auto& pair : map_h1_angCorr_momentum_pidpair) dir->WriteTObject(pair.second);
+    for (auto& pair : map_h1_angCorr_spatial_pidpair) dir->WriteTObject(pair.second);
+    for (auto& pair : map_h1_pt_pid) dir->WriteTObject(pair.second);
+    for (auto& pair : map_h1_phi_pid) dir->WriteTObject(pair.second);
+    for (auto& pair : map_p_v2_pid) dir->WriteTObject(pair.second);
+    TParameter<int> n("processed_events", processed_events);
+    dir->WriteTObject(&n);
+}
+
+bool AnalysisCore::LoadState(TDirectory* dir) {
+    // 按名字取回保存的直方图，清空当前内容后加上（结构由Initialize保证一致）
+    bool ok = true;
+    auto load = [&](TH1* h) {
+        TH1* saved = dynamic_cast<TH1*>(dir->Get(h->GetName()));
+        if (!saved) {
+            ok = false;
+            return;
+        }
+        h->Reset();
+        h->Add(saved);
+        delete saved;
+    };
+    load(p_delta_momentum);
+    load(p_gamma_momentum);
+    load(p_delta_spatial);
+    load(p_gamma_spatial);
+    for (auto& pair : map_h1_angCorr_momentum_pidpair) load(pair.second);
+    for (auto& pair : map_h1_angCorr_spatial_pidpair) load(pair.second);
+    for (auto& pair : map_h1_pt_pid) load(pair.second);
+    for (auto& pair : map_h1_phi_pid) load(pair.second);
+    for (auto& pair : map_p_v2_pid) load(pair.second);
+    
+    TParameter<int>* n = dynamic_cast<TParameter<int>*>(dir->Get("processed_events"));
+    if (n) {
+        processed_events = n->GetVal();
+        delete n;
+    } else {
+        ok = false;
+    }
+    
+    if (!ok) cerr << "ERROR: Incomplete analysis state for " << analysis_name << endl;
+    return ok;
+}
+
 void AnalysisCore::InitializeParticleHistograms() {
     // 为每种粒子类型创建pt、phi和v2直方图
     for (size_t i = 0; i < pid_codes.size(); i++) {
@@ -370,7 +461,11 @@ void AnalysisCore::InitializeParticleHistograms() {
 }
 
 void AnalysisCore::SaveCheckpoint() {
-    const char* checkpoint_file = isHadronMode ? 
+    if (!checkpoint_file.empty()) {
+        SaveResults(checkpoint_file.c_str());
+        return;
+    }
+    const char* default_file = isHadronMode ? 
         "ana/analysis_checkpoint_hadron.root" : "ana/analysis_checkpoint_parton.root";
-    SaveResults(checkpoint_file);
+    SaveResults(default_file);
 }
\ No newline at end of file
@@ -16,6 +16,8 @@ class AnalysisCore {
 private:
     // 事件统计
     int processed_events;
+    int last_accepted;  // 最近一个事件中被接受的粒子数
+    std::vector<int> last_accepted_species;  // 按pid_codes顺序的接受粒子数
     
     // 基础直方图 - 移除中心度相关
     
@@ -45,6 +47,11 @@ private:
     // 分析名称
     std::string analysis_name;
     
+    // checkpoint文件（为空时使用默认的 ana/analysis_checkpoint_*.root）
+    std::string checkpoint_file;
+    int progress_interval;
+    int checkpoint_interval;
+    
     // 初始化分粒子直方图的辅助函数
     void InitializeParticleHistograms();
     
@@ -65,16 +72,31 @@ public:
     void AnalyzeEvent(int eventID, 
                      double impactParameter,
                      int nParticles,
-                     int* pid,
-                     double* px, double* py, double* pz,
-                     double* x, double* y, double* z);
+                     const int* pid,
+                     const double* px, const double* py, const double* pz,
+                     const double* x, const double* y, const double* z);
+    
+    // 合并另一个实例的结果（同粒子类型，用于多线程离线分析的每slot实例）
+    void Merge(const AnalysisCore& other);
     
     // 保存结果
     void SaveResults(const char* filename);
     void SaveCheckpoint();
+    void SetCheckpointFile(const std::string& filename) { checkpoint_file = filename; }
+    // 进度输出/checkpoint的事件间隔，0表示关闭
+    void SetProgressInterval(int n) { progress_interval = n; }
+    void SetCheckpointInterval(int n) { checkpoint_interval = n; }
+    
+    // 续跑checkpoint（input.ampt中的ickpt）：全部累加量写入dir / 从dir恢复
+    void SaveState(TDirectory* dir) const;
+    bool LoadState(TDirectory* dir);
     
     // 获取统计信息
     int GetProcessedEvents() const { return processed_events; }
+    int GetLastAccepted() const { return last_accepted; }
+    const std::vector<int>& GetLastAcceptedPerSpecies() const { return last_accepted_species; }
+    const std::vector<int>& GetSpeciesCodes() const { return pid_codes; }
+    const std::vector<std::string>& GetSpeciesNames() const { return pid_names; }
 };
 
 // 全局分析对象（每种数据流一个）
@@ -0,0 +1,154 @@
+#ifndef ANALYSIS_FORMATS_H
+#define ANALYSIS_FORMATS_H
+
+// Branch layouts of the ROOT trees the offline analyzers understand
+//
+// Shared by legacy/analysisAll_flexible.cxx and ampt-analysis-mt so that both
+// accept exactly the same inputs.  Header-only; each analyzer is a single
+// translation unit.
+
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <map>
+#include "TFile.h"
+
+// ROOT file format configuration
+struct ROOTFormat {
+    std::string tree_name;
+    std::string nParticles_branch;
+    std::string impactParameter_branch;
+    std::string pid_branch;
+    std::string px_branch, py_branch, pz_branch;
+    std::string x_branch, y_branch, z_branch;
+    
+    // Data types and array sizes
+    bool use_double_precision = true;
+    int max_particles = 99999;
+    
+    // Additional branches (optional)
+    std::string eventID_branch = "";
+    std::string runID_branch = "";
+    
+    void print() const {
+        std::cout << "ROOT Format Configuration:" << std::endl;
+        std::cout << "  Tree name: " << tree_name << std::endl;
+        std::cout << "  nParticles: " << nParticles_branch << std::endl;
+        std::cout << "  impactParameter: " << impactParameter_branch << std::endl;
+        std::cout << "  PID: " << pid_branch << std::endl;
+        std::cout << "  Momentum: " << px_branch << ", " << py_branch << ", " << pz_branch << std::endl;
+        std::cout << "  Position: " << x_branch << ", " << y_branch << ", " << z_branch << std::endl;
+        std::cout << "  Max particles: " << max_particles << std::endl;
+        std::cout << "  Double precision: " << (use_double_precision ? "Yes" : "No") << std::endl;
+    }
+};
+
+// Predefined formats for different AMPT outputs
+static std::map<std::string, ROOTFormat> predefined_formats = {
+    {"ampt", {
+        "ampt",                    // tree_name
+        "nParticles",             // nParticles_branch
+        "impactParameter",        // impactParameter_branch
+        "pid",                    // pid_branch
+        "px", "py", "pz",        // momentum branches
+        "x", "y", "z",           // position branches
+        true, 99999,             // double precision, max particles
+        "eventID", "runID"       // optional branches
+    }},
+    {"hadron_before_art", {
+        "hadron_before_art",
+        "nParticles",
+        "impactParameter", 
+        "pid",
+        "px", "py", "pz",
+        "x", "y", "z",
+        true, 99999,
+        "eventID", ""
+        // Note: also contains miss, nelp, ninp, nelt, ninthj, mass, t branches
+        // but we only need the essential ones for analysis
+    }},
+    {"hadron_before_melting", {
+        "hadron_before_melting",
+        "nParticles",
+        "impactParameter",
+        "pid", 
+        "px", "py", "pz",
+        "x", "y", "z",
+        true, 99999,
+        "eventID", ""
+        // Note: also contains miss, nelp, ninp, nelt, ninthj, mass, t branches
+        // but we only need the essential ones for analysis
+    }},
+    {"zpc", {
+        "zpc",
+        "nParticles",
+        "impactParameter",
+        "pid",
+        "px", "py", "pz",
+        "x", "y", "z",
+        true, 99999,
+        "eventID", ""
+        // Note: ZPC parton data after cascade
+    }},
+    {"parton_initial", {
+        "parton_initial",
+        "nParticles",
+        "impactParameter",  // older files may lack it: ampt-analysis-mt then uses b = 0
+        "pid",
+        "px", "py", "pz",
+        "x", "y", "z",
+        true, 99999,
+        "eventID", ""
+        // Note: also contains istrg0, xstrg0, ystrg0 string info branches
+    }},
+    {"legacy_format", {
+        "AMPT",
+        "Event.multi",
+        "Event.impactpar",
+        "ID",
+        "Px", "Py", "Pz",
+        "X", "Y", "Z",
+        false, 99999,
+        "", ""
+    }}
+};
+
+// Auto-detect ROOT format from file
+inline ROOTFormat DetectFormat(const std::string& filename) {
+    std::string test_file = filename;
+    
+    // If it's a list file, get the first file
+    if (filename.find(".list") != std::string::npos) {
+        std::ifstream fin(filename);
+        std::getline(fin, test_file);
+        fin.close();
+    }
+    
+    TFile* f = TFile::Open(test_file.c_str());
+    if (!f || f->IsZombie()) {
+        std::cout << "Warning: Cannot open file " << test_file << ", using default format" << std::endl;
+        return predefined_formats["ampt"];
+    }
+    
+    // Check which tree exists and return corresponding format
+    for (auto& pair : predefined_formats) {
+        if (f->Get(pair.second.tree_name.c_str())) {
+            std::cout << "Auto-detected format: " << pair.first << std::endl;
+            f->Close();
+            return pair.second;
+        }
+    }
+    
+    f->Close();
+    std::cout << "Warning: No matching format found, using default" << std::endl;
+    return predefined_formats["ampt"];
+}
+
+inline void ShowFormats() {
+    std::cout << "Available predefined formats:" << std::endl;
+    for (auto& pair : predefined_formats) {
+        std::cout << "  " << pair.first << ": " << pair.second.tree_name << std::endl;
+    }
+}
+
+#endif // ANALYSIS_FORMATS_H
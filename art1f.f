@@ -283,6 +283,8 @@ cc      SAVE /resdcy/
       COMMON/RNDF77/NSEED
 cc      SAVE /RNDF77/
       COMMON/FTMAX/ftsv(MAXSTR),ftsvt(MAXSTR, MAXR)
+      COMMON /AMPCAP/ NSTRCP, NPTNCP
+cc      SAVE /AMPCAP/
       COMMON /dpert/dpertt(MAXSTR,MAXR),dpertp(MAXSTR),dplast(MAXSTR),
      1     dpdcy(MAXSTR),dpdpi(MAXSTR,MAXR),dpt(MAXSTR, MAXR),
      2     dpp1(MAXSTR,MAXR),dppion(MAXSTR,MAXR)
@@ -304,7 +306,7 @@ clin-4/2008 zet() expanded to avoid out-of-bound errors:
      4     0.,0.,0.,0.,-1./
 
       nlast=0
-      do 1002 i=1,MAXSTR
+      do 1002 i=1,NSTRCP
          ftsv(i)=0.
          do 1101 irun=1,maxr
             ftsvt(i,irun)=0.
@@ -540,7 +542,7 @@ clin 51      RCNNE  = 0
 *       ========================================================       *
 cbz11/16/98
       IF (IAPAR2(1) .NE. 1) THEN
-         DO 1016 I = 1, MAXSTR
+         DO 1016 I = 1, NSTRCP
             DO 1015 J = 1, 3
                R(J, I) = 0.
                P(J, I) = 0.
@@ -563,7 +565,7 @@ c         NPI = 1
             NPI(J) = 1
  1017    CONTINUE
          DO 1019 I = 1, MAXR
-            DO 1018 J = 1, MAXSTR
+            DO 1018 J = 1, NSTRCP
                RT(1, J, I) = 0.
                RT(2, J, I) = 0.
                RT(3, J, I) = 0.
@@ -1205,6 +1207,7 @@ c     that leads to loss of hadrons inside ART due to finite accuracy
 c     [which results in (ct-dt) + dt != ct exactly]:
 c     &           FT1(NP1, IRUN) .GT. (CT - DT) .AND. 
                NP = NP + 1
+               call strgrw(IA + NP)
                UDT = (CT - FT1(NP1, IRUN)) / EE1(NP1, IRUN)
 clin-10/28/03 since all unformed hadrons at time ct are read in at nt=ntmax-1, 
 c     their positions should not be propagated to time ct:
@@ -1627,6 +1630,8 @@ cc      SAVE /resdcy/
 cc      SAVE /RNDF77/
       COMMON/FTMAX/ftsv(MAXSTR),ftsvt(MAXSTR, MAXR)
       dimension ftpisv(MAXSTR,MAXR),fttemp(MAXSTR)
+      COMMON /AMPCAP/ NSTRCP, NPTNCP
+cc      SAVE /AMPCAP/
       common /dpi/em2,lb2
       common/phidcy/iphidcy,pttrig,ntrig,maxmiss,ipi0dcy
 clin-5/2008:
@@ -1635,6 +1640,14 @@ clin-5/2008:
       COMMON /dpert/dpertt(MAXSTR,MAXR),dpertp(MAXSTR),dplast(MAXSTR),
      1     dpdcy(MAXSTR),dpdpi(MAXSTR,MAXR),dpt(MAXSTR, MAXR),
      2     dpp1(MAXSTR,MAXR),dppion(MAXSTR,MAXR)
+      PARAMETER (NAHASH=32768)
+      COMMON /artgrd/ ighead(NAHASH),igstmp(NAHASH),ignext(MAXSTR),
+     1     igmark(MAXSTR),icand(MAXSTR),idlist(MAXSTR),ndlist,
+     2     nstamp,igmsum,ignp
+cc      SAVE /artgrd/
+      INTEGER*8 NWORK
+      COMMON /WRKCNT/ NWORK(12)
+cc      SAVE /WRKCNT/
 c
       real zet(-45:45)
       SAVE   
@@ -1710,13 +1723,18 @@ c      ESBIN=0.04
  1001    CONTINUE
  1002 CONTINUE
 c sp 12/19/00
+      NPALL = 0
+      DO 1099 IRUN = 1, NUM
+         NPALL = NPALL + MASSR(IRUN)
+ 1099 CONTINUE
+      call strgrw(NPALL)
       DO 1004 i =1,NUM
-         DO 1003 j =1,MAXSTR
+         DO 1003 j =1,NSTRCP
             PROPI(j,i) = 1.
  1003    CONTINUE
  1004 CONTINUE
       
-      do 1102 i=1,maxstr
+      do 1102 i=1,NSTRCP
          fttemp(i)=0.
          do 1101 irun=1,maxr
             ftpisv(i,irun)=0.
@@ -1737,6 +1755,8 @@ cbz11/17/98end
       DO 1000 IRUN = 1,NUM
          NNN=0
          MSUM=MSUM+MASSR(IRUN-1)
+c     bin the particles of this run for the pair search below:
+         if(nt.ne.ntmax) call artgbd(MSUM,MASSR(IRUN))
 *     LOOP OVER ALL PSEUDOPARTICLES 1 IN THE SAME RUN
          J10=2
          IF(NT.EQ.NTMAX)J10=1
@@ -1917,6 +1937,7 @@ c                call a1decay(idecay,i1,nnn,iseed,rhomp)
 * FOR N*(1440)
              elseif(iabs(LB1).EQ.10.OR.iabs(LB1).EQ.11) THEN
                 NNN=NNN+1
+                call artgrw(NNN)
                 LDECAY=LDECAY+1
                 PNSTAR=1.
                 IF(E(I1).GT.1.22)PNSTAR=0.6
@@ -1927,10 +1948,12 @@ c                call a1decay(idecay,i1,nnn,iseed,rhomp)
 * (2) DECAY TO TWO PIONS + NUCLEON
                    CALL DECAY2(idecay,I1,NNN,ISEED,wid,nt)
                    NNN=NNN+1
+                   call artgrw(NNN)
                 ENDIF
 c for N*(1535) decay
              elseif(iabs(LB1).eq.12.or.iabs(LB1).eq.13) then
                 NNN=NNN+1
+                call artgrw(NNN)
                 CALL DECAY(idecay,I1,NNN,ISEED,wid,nt)
                 LDECAY=LDECAY+1
              endif
@@ -2020,7 +2043,25 @@ c 1        if(nt.eq.ntmax)go to 800
           Y1 = R(2,I1)
           Z1 = R(3,I1)
 c
-           DO 600 J2 = 1,J1-1
+c     only particles in the neighbouring grid cells (and deuterons) can
+c     pass the dr0max cut below; they are returned in ascending order
+c     so the collision sequence is the same as looping over 1,J1-1:
+c           DO 600 J2 = 1,J1-1
+          call artgnb(J1,X1,Y1,Z1,ncand)
+          NWORK(5)=NWORK(5)+ncand
+          idnb=0
+          if(iabs(LB(I1)).eq.42) idnb=1
+c     the trip count allows for the list growing below, JC stops at ncand:
+           DO 600 JC = 1,J1-1
+c     particle 1 has just become a deuteron: widen the rest of its list
+            if(idnb.eq.0.and.iabs(LB(I1)).eq.42) then
+               idnb=1
+               nold=ncand
+               call artgwd(J1,X1,Y1,Z1,JC,ncand)
+               NWORK(5)=NWORK(5)+ncand-nold
+            endif
+            if(JC.gt.ncand) goto 798
+            J2 = icand(JC)
             I2  = J2 + MSUM
 * IF I2 IS A MESON BEING ABSORBED, THEN GO OUT OF THE LOOP
             IF(E(I2).EQ.0.) GO TO 600
@@ -2287,6 +2328,8 @@ clin-7/26/03 improve speed
      1         Ifirst,PCX,PCY,PCZ,
      2         x1,y1,z1,px1,py1,pz1,em1,x2,y2,z2,px2,py2,pz2,em2)
           if(Ifirst.eq.-1) goto 400
+c     work counters (wrkcnt.f): the pair is within range
+          call wrkart(0,i1,i2)
 
          ISS=NINT(SRT/ESBIN)
 clin-4/2008 use last bin if ISS is out of EKAON's upper bound of 2000:
@@ -4382,6 +4425,9 @@ c            if(iblock.ne.0) then
 c               write(10,*) nt,i1,i2,iblock,x1,z1,x2,z2
 c            endif
 
+c     work counters: did the pair within range collide?  (a pair left
+c     with GO TO 600/800 is counted by the next WRKART call instead)
+          call wrkart(1,i1,i2)
   600     CONTINUE
 
 clin-4/2012 option of pi0 decays:
@@ -4406,6 +4452,8 @@ c          endif
 clin-4/2012 option of pi0 decays-end
 
   800   CONTINUE
+c     work counters: a pair still pending after the last particle
+        call wrkart(1,i1,i2)
 * RELABLE MESONS LEFT IN THIS RUN EXCLUDING THOSE BEING CREATED DURING
 * THIS TIME STEP AND COUNT THE TOTAL NO. OF PARTICLES IN THIS RUN
 * note that the first mass=mta+mpr particles are baryons
@@ -4418,6 +4466,7 @@ c        IF(E(N).GT.0.)THEN
         IF(E(N) .GT. 0. .OR. LB(N) .GT. 5000)THEN
 cbz11/25/98end
         NNN=NNN+1
+        call artgrw(NNN)
         RPION(1,NNN,IRUN)=R(1,N)
         RPION(2,NNN,IRUN)=R(2,N)
         RPION(3,NNN,IRUN)=R(3,N)
@@ -4540,6 +4589,209 @@ c
       RETURN
       END
 
+****************************************
+c     Spatial hash grid for the RELCOL pair search.  The particles of
+c     one run are binned into cubic cells of side 5.01 fm, just above
+c     the 5 fm maximum pair distance, so a particle can only collide
+c     with particles in the 27 neighbouring cells.  Deuterons reach
+c     10 fm and are also kept in the list idlist.  Cells are hashed
+c     into NAHASH buckets, each a linked list in ascending index.
+      SUBROUTINE ARTGBD(MSUM,NP)
+      PARAMETER (MAXSTR=150001,NAHASH=32768)
+      COMMON   /AA/  R(3,MAXSTR)
+cc      SAVE /AA/
+      COMMON   /EE/  ID(MAXSTR),LB(MAXSTR)
+cc      SAVE /EE/
+      COMMON /artgrd/ ighead(NAHASH),igstmp(NAHASH),ignext(MAXSTR),
+     1     igmark(MAXSTR),icand(MAXSTR),idlist(MAXSTR),ndlist,
+     2     nstamp,igmsum,ignp
+cc      SAVE /artgrd/
+      SAVE   
+c
+      igmsum=MSUM
+      ignp=NP
+      nstamp=0
+      ndlist=0
+      DO 10 IB = 1, NAHASH
+         ighead(IB)=0
+         igstmp(IB)=0
+ 10   CONTINUE
+c     insert in descending order so that each bucket is ascending:
+      DO 20 J = NP, 1, -1
+         I=J+MSUM
+         igmark(J)=0
+         call artgcl(R(1,I),R(2,I),R(3,I),icx,icy,icz)
+         IB=mod(icx*31+icy*1021+icz*32749,NAHASH)+1
+         ignext(J)=ighead(IB)
+         ighead(IB)=J
+         if(iabs(LB(I)).eq.42) then
+            ndlist=ndlist+1
+            idlist(ndlist)=J
+         endif
+ 20   CONTINUE
+      RETURN
+      END
+
+****************************************
+c     Grid cell of a position, clamped to +-4000 cells (offset to >0):
+      SUBROUTINE ARTGCL(X,Y,Z,ICX,ICY,ICZ)
+      PARAMETER (CELL=5.01,CMAX=4000.)
+      ICX=int(min(max(X/CELL,-CMAX),CMAX)+4096.)
+      ICY=int(min(max(Y/CELL,-CMAX),CMAX)+4096.)
+      ICZ=int(min(max(Z/CELL,-CMAX),CMAX)+4096.)
+      RETURN
+      END
+
+****************************************
+c     Candidates J2<J1 for particle 1 at (X1,Y1,Z1): the particles in the
+c     neighbouring cells (two cells out if particle 1 is a deuteron)
+c     plus all deuterons, sorted into ascending order in icand(1:NCAND).
+c     If particle 1 becomes a deuteron during its pairs, RELCOL widens the
+c     rest of the list with ARTGWD.
+      SUBROUTINE ARTGNB(J1,X1,Y1,Z1,NCAND)
+      PARAMETER (MAXSTR=150001,NAHASH=32768)
+      COMMON   /EE/  ID(MAXSTR),LB(MAXSTR)
+cc      SAVE /EE/
+      COMMON /artgrd/ ighead(NAHASH),igstmp(NAHASH),ignext(MAXSTR),
+     1     igmark(MAXSTR),icand(MAXSTR),idlist(MAXSTR),ndlist,
+     2     nstamp,igmsum,ignp
+cc      SAVE /artgrd/
+      SAVE   
+c
+      NCAND=0
+      nstamp=nstamp+1
+      NR=1
+      if(iabs(LB(J1+igmsum)).eq.42) NR=2
+      call artgcl(X1,Y1,Z1,icx,icy,icz)
+      DO 32 KX = icx-NR, icx+NR
+         DO 31 KY = icy-NR, icy+NR
+            DO 30 KZ = icz-NR, icz+NR
+               IB=mod(KX*31+KY*1021+KZ*32749,NAHASH)+1
+               if(igstmp(IB).eq.nstamp) goto 30
+               igstmp(IB)=nstamp
+               J=ighead(IB)
+ 20            if(J.gt.0.and.J.lt.J1) then
+                  if(igmark(J).ne.nstamp) then
+                     igmark(J)=nstamp
+                     NCAND=NCAND+1
+                     icand(NCAND)=J
+                  endif
+                  J=ignext(J)
+                  goto 20
+               endif
+ 30         CONTINUE
+ 31      CONTINUE
+ 32   CONTINUE
+      DO 40 K = 1, ndlist
+         J=idlist(K)
+         if(J.lt.J1.and.igmark(J).ne.nstamp) then
+            igmark(J)=nstamp
+            NCAND=NCAND+1
+            icand(NCAND)=J
+         endif
+ 40   CONTINUE
+c     in dense regions rebuild the list from the marks instead of sorting:
+      if(NCAND*16.gt.J1) then
+         NCAND=0
+         DO 50 J = 1, J1-1
+            if(igmark(J).eq.nstamp) then
+               NCAND=NCAND+1
+               icand(NCAND)=J
+            endif
+ 50      CONTINUE
+      else
+         call artgst(icand,NCAND)
+      endif
+      RETURN
+      END
+
+****************************************
+c     Particle 1 has become a deuteron while its candidates were being
+c     processed: replace icand(JC:NCAND) by the candidates after
+c     icand(JC-1) within the deuteron range of ARTGNB.
+      SUBROUTINE ARTGWD(J1,X1,Y1,Z1,JC,NCAND)
+      PARAMETER (MAXSTR=150001,NAHASH=32768)
+      COMMON /artgrd/ ighead(NAHASH),igstmp(NAHASH),ignext(MAXSTR),
+     1     igmark(MAXSTR),icand(MAXSTR),idlist(MAXSTR),ndlist,
+     2     nstamp,igmsum,ignp
+cc      SAVE /artgrd/
+      SAVE   
+c
+      JPREV=0
+      if(JC.gt.1) JPREV=icand(JC-1)
+      call artgnb(J1,X1,Y1,Z1,N)
+      K0=1
+ 10   if(K0.le.N) then
+         if(icand(K0).le.JPREV) then
+            K0=K0+1
+            goto 10
+         endif
+      endif
+c     K0 >= JC: the wider list holds every candidate already processed
+      DO 20 K = K0, N
+         icand(JC+K-K0)=icand(K)
+ 20   CONTINUE
+      NCAND=JC-1+N-K0+1
+      RETURN
+      END
+
+****************************************
+c     Add particle I, which has just become a deuteron, to the deuteron
+c     list of the current grid:
+      SUBROUTINE ARTGDT(I)
+      PARAMETER (MAXSTR=150001,NAHASH=32768)
+      COMMON /artgrd/ ighead(NAHASH),igstmp(NAHASH),ignext(MAXSTR),
+     1     igmark(MAXSTR),icand(MAXSTR),idlist(MAXSTR),ndlist,
+     2     nstamp,igmsum,ignp
+cc      SAVE /artgrd/
+      SAVE   
+c
+      J=I-igmsum
+      if(J.lt.1.or.J.gt.ignp.or.ndlist.ge.MAXSTR) return
+      ndlist=ndlist+1
+      idlist(ndlist)=J
+      RETURN
+      END
+
+****************************************
+c     Heapsort of the integer array IA(1:N) into ascending order:
+      SUBROUTINE ARTGST(IA,N)
+      DIMENSION IA(N)
+c
+      if(N.lt.2) return
+      L=N/2+1
+      IR=N
+ 10   if(L.gt.1) then
+         L=L-1
+         IT=IA(L)
+      else
+         IT=IA(IR)
+         IA(IR)=IA(1)
+         IR=IR-1
+         if(IR.eq.1) then
+            IA(1)=IT
+            return
+         endif
+      endif
+      I=L
+      J=L+L
+ 20   if(J.le.IR) then
+         if(J.lt.IR) then
+            if(IA(J).lt.IA(J+1)) J=J+1
+         endif
+         if(IT.lt.IA(J)) then
+            IA(I)=IA(J)
+            I=J
+            J=J+J
+         else
+            J=IR+1
+         endif
+         goto 20
+      endif
+      IA(I)=IT
+      goto 10
+      END
+
 clin-9/2012: use double precision for S in CMS(): to avoid crash 
 c     (segmentation fault due to s<0, which happened at high energies 
 c     such as LHC with large NTMAX for two almost-comoving hadrons
@@ -5505,6 +5757,7 @@ C       if(icou1.lt.0)return
        CALL ROTATE(PX,PY,PZ,PX4,PY4,PZ4)
        CALL ROTATE(PX,PY,PZ,PPX,PPY,PPZ)
                 NNN=NNN+1
+                call artgrw(NNN)
 * DETERMINE THE CHARGE STATES OF PARTICLES IN THE FINAL STATE
 * (1) FOR P+P
               XDIR=RANART(NSEED)
@@ -5755,6 +6008,7 @@ c
               if(idpert.eq.1.and.ipert1.eq.1.and.npertd.ge.1) then
 cccc  Perturbative production for idpert=1:
                  nnn=nnn+1
+                 call artgrw(NNN)
                  PPION(1,NNN,IRUN)=pxi1
                  PPION(2,NNN,IRUN)=pyi1
                  PPION(3,NNN,IRUN)=pzi1
@@ -5804,6 +6058,8 @@ c     For the regular deuteron:
                  p(2,i2)=pyi1
                  p(3,i2)=pzi1
                  lb(i2)=lbd
+c     the new deuteron reaches 10 fm in the RELCOL pair search:
+                 call artgdt(i2)
                  lb2=lb(i2)
                  E(i2)=xmd
                  EtI2=E(I2)
@@ -5812,6 +6068,7 @@ c     For idpert=2: create the perturbative deuterons:
                  if(idpert.eq.2.and.idloop.eq.ndloop) then
                     do ipertd=1,npertd
                        nnn=nnn+1
+                       call artgrw(NNN)
                        PPION(1,NNN,IRUN)=ppd(1,ipertd)
                        PPION(2,NNN,IRUN)=ppd(2,ipertd)
                        PPION(3,NNN,IRUN)=ppd(3,ipertd)
@@ -5839,6 +6096,7 @@ csp11/21/01 phi production
                 LB(I1) = 1 + int(2 * RANART(NSEED))
                 LB(I2) = 1 + int(2 * RANART(NSEED))
               nnn=nnn+1
+              call artgrw(NNN)
                 LPION(NNN,IRUN)=29
                 EPION(NNN,IRUN)=APHI
                 iblock = 222
@@ -5852,6 +6110,7 @@ c
               pz2=p(3,i2)
 * DETERMINE THE CHARGE STATES OF PARTICLES IN THE FINAL STATE
               nnn=nnn+1
+              call artgrw(NNN)
                 LPION(NNN,IRUN)=23
                 EPION(NNN,IRUN)=Aka
               if(srt.le.2.63)then
@@ -6025,6 +6284,7 @@ C       if(icou1.lt.0)return
        CALL ROTATE(PX,PY,PZ,PX4,PY4,PZ4)
        CALL ROTATE(PX,PY,PZ,PPX,PPY,PPZ)
                 NNN=NNN+1
+                call artgrw(NNN)
               arho=amrho
 * DETERMINE THE CHARGE STATES OF PARTICLES IN THE FINAL STATE
 * (1) FOR P+P
@@ -6250,6 +6510,7 @@ C       if(icou1.lt.0)return
        CALL ROTATE(PX,PY,PZ,PX4,PY4,PZ4)
        CALL ROTATE(PX,PY,PZ,PPX,PPY,PPZ)
                 NNN=NNN+1
+                call artgrw(NNN)
               arho=amrho
 * DETERMINE THE CHARGE STATES OF PARTICLES IN THE FINAL STATE
 * (1) FOR P+P
@@ -6402,6 +6663,7 @@ C       if(icou1.lt.0)return
        CALL ROTATE(PX,PY,PZ,PX4,PY4,PZ4)
        CALL ROTATE(PX,PY,PZ,PPX,PPY,PPZ)
                 NNN=NNN+1
+                call artgrw(NNN)
               aomega=0.782
 * DETERMINE THE CHARGE STATES OF PARTICLES IN THE FINAL STATE
 * (1) FOR P+P
@@ -7743,6 +8005,7 @@ csp11/21/01 phi production
                 LB(I1) = 1 + int(2 * RANART(NSEED))
                 LB(I2) = 1 + int(2 * RANART(NSEED))
               nnn=nnn+1
+              call artgrw(NNN)
                 LPION(NNN,IRUN)=29
                 EPION(NNN,IRUN)=APHI
                 iblock = 222
@@ -7756,6 +8019,7 @@ c
               pz2=p(3,i2)
 * DETERMINE THE CHARGE STATES OF PARTICLES IN THE FINAL STATE
               nnn=nnn+1
+              call artgrw(NNN)
                 LPION(NNN,IRUN)=23
                 EPION(NNN,IRUN)=Aka
               if(srt.le.2.63)then
@@ -7974,6 +8238,7 @@ c
               if(idpert.eq.1.and.ipert1.eq.1.and.npertd.ge.1) then
 cccc  Perturbative production for idpert=1:
                  nnn=nnn+1
+                 call artgrw(NNN)
                  PPION(1,NNN,IRUN)=pxi1
                  PPION(2,NNN,IRUN)=pyi1
                  PPION(3,NNN,IRUN)=pzi1
@@ -8023,6 +8288,8 @@ c     For the regular deuteron:
                  p(2,i2)=pyi1
                  p(3,i2)=pzi1
                  lb(i2)=lbd
+c     the new deuteron reaches 10 fm in the RELCOL pair search:
+                 call artgdt(i2)
                  lb2=lb(i2)
                  E(i2)=xmd
                  EtI2=E(I2)
@@ -8031,6 +8298,7 @@ c     For idpert=2: create the perturbative deuterons:
                  if(idpert.eq.2.and.idloop.eq.ndloop) then
                     do ipertd=1,npertd
                        nnn=nnn+1
+                       call artgrw(NNN)
                        PPION(1,NNN,IRUN)=ppd(1,ipertd)
                        PPION(2,NNN,IRUN)=ppd(2,ipertd)
                        PPION(3,NNN,IRUN)=ppd(3,ipertd)
@@ -9049,6 +9317,7 @@ csp11/21/01 phi production
                 LB(I1) = 1 + int(2 * RANART(NSEED))
                 LB(I2) = 1 + int(2 * RANART(NSEED))
               nnn=nnn+1
+              call artgrw(NNN)
                 LPION(NNN,IRUN)=29
                 EPION(NNN,IRUN)=APHI
                 iblock = 222
@@ -9060,6 +9329,7 @@ csp11/21/01 phi production
               pz2=p(3,i2)
 * DETERMINE THE CHARGE STATES OF PARTICLES IN THE FINAL STATE
               nnn=nnn+1
+              call artgrw(NNN)
                 LPION(NNN,IRUN)=23
                 EPION(NNN,IRUN)=Aka
               if(srt.le.2.63)then
@@ -9264,6 +9534,7 @@ c
               if(idpert.eq.1.and.ipert1.eq.1.and.npertd.ge.1) then
 cccc  Perturbative production for idpert=1:
                  nnn=nnn+1
+                 call artgrw(NNN)
                  PPION(1,NNN,IRUN)=pxi1
                  PPION(2,NNN,IRUN)=pyi1
                  PPION(3,NNN,IRUN)=pzi1
@@ -9313,6 +9584,8 @@ c     For the regular deuteron:
                  p(2,i2)=pyi1
                  p(3,i2)=pzi1
                  lb(i2)=lbd
+c     the new deuteron reaches 10 fm in the RELCOL pair search:
+                 call artgdt(i2)
                  lb2=lb(i2)
                  E(i2)=xmd
                  EtI2=E(I2)
@@ -9321,6 +9594,7 @@ c     For idpert=2: create the perturbative deuterons:
                  if(idpert.eq.2.and.idloop.eq.ndloop) then
                     do ipertd=1,npertd
                        nnn=nnn+1
+                       call artgrw(NNN)
                        PPION(1,NNN,IRUN)=ppd(1,ipertd)
                        PPION(2,NNN,IRUN)=ppd(2,ipertd)
                        PPION(3,NNN,IRUN)=ppd(3,ipertd)
@@ -9537,30 +9811,21 @@ c          R(3,I) = R(3,I) / GAMMA + Z0
       dimension pxl(-maxx:maxx,-maxx:maxx,-maxz:maxz),
      1          pyl(-maxx:maxx,-maxx:maxx,-maxz:maxz),
      2          pzl(-maxx:maxx,-maxx:maxx,-maxz:maxz)
+* compact view of the particles inside the mesh, see artdens.f
+      dimension ixs(maxstr),iys(maxstr),izs(maxstr),knd(maxstr),
+     1          pxs(maxstr),pys(maxstr),pzs(maxstr),ets(maxstr)
       COMMON  /AA/      R(3,MAXSTR)
 cc      SAVE /AA/
       COMMON  /BB/      P(3,MAXSTR)
 cc      SAVE /BB/
       COMMON  /CC/      E(MAXSTR)
 cc      SAVE /CC/
-      COMMON  /DD/      RHO(-MAXX:MAXX,-MAXX:MAXX,-MAXZ:MAXZ),
-     &                     RHOP(-MAXX:MAXX,-MAXX:MAXX,-MAXZ:MAXZ),
-     &                     RHON(-MAXX:MAXX,-MAXX:MAXX,-MAXZ:MAXZ)
-cc      SAVE /DD/
-      COMMON  /DDpi/    piRHO(-MAXX:MAXX,-MAXX:MAXX,-MAXZ:MAXZ)
-cc      SAVE /DDpi/
       COMMON  /EE/      ID(MAXSTR),LB(MAXSTR)
 cc      SAVE /EE/
       common  /ss/  inout(20)
 cc      SAVE /ss/
       COMMON  /RR/  MASSR(0:MAXR)
 cc      SAVE /RR/
-      common  /tt/  PEL(-maxx:maxx,-maxx:maxx,-maxz:maxz)
-     &,rxy(-maxx:maxx,-maxx:maxx,-maxz:maxz)
-cc      SAVE /tt/
-      common  /bbb/ bxx(-maxx:maxx,-maxx:maxx,-maxz:maxz),
-     &byy(-maxx:maxx,-maxx:maxx,-maxz:maxz),
-     &bzz(-maxx:maxx,-maxx:maxx,-maxz:maxz)
 *
       real zet(-45:45)
       SAVE   
@@ -9576,29 +9841,12 @@ cc      SAVE /tt/
      2     -1.,0.,1.,0.,-1.,0.,1.,0.,0.,1.,
      3     0.,0.,0.,0.,0.,0.,0.,0.,0.,-1.,
      4     0.,0.,0.,0.,-1./
-
-      DO 300 IZ = -MAXZ,MAXZ
-        DO 200 IY = -MAXX,MAXX
-          DO 100 IX = -MAXX,MAXX
-            RHO(IX,IY,IZ) = 0.0
-            RHOn(IX,IY,IZ) = 0.0
-            RHOp(IX,IY,IZ) = 0.0
-            piRHO(IX,IY,IZ) = 0.0
-           pxl(ix,iy,iz) = 0.0
-           pyl(ix,iy,iz) = 0.0
-           pzl(ix,iy,iz) = 0.0
-           pel(ix,iy,iz) = 0.0
-           bxx(ix,iy,iz) = 0.0
-           byy(ix,iy,iz) = 0.0
-           bzz(ix,iy,iz) = 0.0
-  100     CONTINUE
-  200   CONTINUE
-  300 CONTINUE
 *
       NESC  = 0
       BIG   = 1.0 / ( 3.0 * FLOAT(NUM) )
       SMALL = 1.0 / ( 9.0 * FLOAT(NUM) )
 *
+      NP=0
       MSUM=0
       DO 400 IRUN = 1,NUM
       MSUM=MSUM+MASSR(IRUN-1)
@@ -9612,153 +9860,30 @@ cc      SAVE /tt/
      &      IZ .LE. -MAXZ .OR. IZ .GE. MAXZ )    THEN
           NESC = NESC + 1
         ELSE
-c
+          NP=NP+1
+          IXS(NP)=IX
+          IYS(NP)=IY
+          IZS(NP)=IZ
 csp01/04/02 include baryon density
-          if(j.gt.mass)go to 30
-c         if( (lb(i).eq.1.or.lb(i).eq.2) .or.
-c    &    (lb(i).ge.6.and.lb(i).le.17) )then                       
-* (1) baryon density
-          RHO(IX,  IY,  IZ  ) = RHO(IX,  IY,  IZ  ) + BIG
-          RHO(IX+1,IY,  IZ  ) = RHO(IX+1,IY,  IZ  ) + SMALL
-          RHO(IX-1,IY,  IZ  ) = RHO(IX-1,IY,  IZ  ) + SMALL
-          RHO(IX,  IY+1,IZ  ) = RHO(IX,  IY+1,IZ  ) + SMALL
-          RHO(IX,  IY-1,IZ  ) = RHO(IX,  IY-1,IZ  ) + SMALL
-          RHO(IX,  IY,  IZ+1) = RHO(IX,  IY,  IZ+1) + SMALL
-          RHO(IX,  IY,  IZ-1) = RHO(IX,  IY,  IZ-1) + SMALL
-* (2) CALCULATE THE PROTON DENSITY
-         IF(ZET(LB(I)).NE.0)THEN
-          RHOP(IX,  IY,  IZ  ) = RHOP(IX,  IY,  IZ  ) + BIG
-          RHOP(IX+1,IY,  IZ  ) = RHOP(IX+1,IY,  IZ  ) + SMALL
-          RHOP(IX-1,IY,  IZ  ) = RHOP(IX-1,IY,  IZ  ) + SMALL
-          RHOP(IX,  IY+1,IZ  ) = RHOP(IX,  IY+1,IZ  ) + SMALL
-          RHOP(IX,  IY-1,IZ  ) = RHOP(IX,  IY-1,IZ  ) + SMALL
-          RHOP(IX,  IY,  IZ+1) = RHOP(IX,  IY,  IZ+1) + SMALL
-          RHOP(IX,  IY,  IZ-1) = RHOP(IX,  IY,  IZ-1) + SMALL
-         go to 40
-         ENDIF
-* (3) CALCULATE THE NEUTRON DENSITY
-         IF(ZET(LB(I)).EQ.0)THEN
-          RHON(IX,  IY,  IZ  ) = RHON(IX,  IY,  IZ  ) + BIG
-          RHON(IX+1,IY,  IZ  ) = RHON(IX+1,IY,  IZ  ) + SMALL
-          RHON(IX-1,IY,  IZ  ) = RHON(IX-1,IY,  IZ  ) + SMALL
-          RHON(IX,  IY+1,IZ  ) = RHON(IX,  IY+1,IZ  ) + SMALL
-          RHON(IX,  IY-1,IZ  ) = RHON(IX,  IY-1,IZ  ) + SMALL
-          RHON(IX,  IY,  IZ+1) = RHON(IX,  IY,  IZ+1) + SMALL
-          RHON(IX,  IY,  IZ-1) = RHON(IX,  IY,  IZ-1) + SMALL
-         go to 40
-          END IF
-c           else    !! sp01/04/02
-* (4) meson density       
-30              piRHO(IX,  IY,  IZ  ) = piRHO(IX,  IY,  IZ  ) + BIG
-          piRHO(IX+1,IY,  IZ  ) = piRHO(IX+1,IY,  IZ  ) + SMALL
-          piRHO(IX-1,IY,  IZ  ) = piRHO(IX-1,IY,  IZ  ) + SMALL
-          piRHO(IX,  IY+1,IZ  ) = piRHO(IX,  IY+1,IZ  ) + SMALL
-          piRHO(IX,  IY-1,IZ  ) = piRHO(IX,  IY-1,IZ  ) + SMALL
-          piRHO(IX,  IY,  IZ+1) = piRHO(IX,  IY,  IZ+1) + SMALL
-          piRHO(IX,  IY,  IZ-1) = piRHO(IX,  IY,  IZ-1) + SMALL
-c           endif    !! sp01/04/02
-* to calculate the Gamma factor in each cell
-*(1) PX
-40       pxl(ix,iy,iz)=pxl(ix,iy,iz)+p(1,I)*BIG
-       pxl(ix+1,iy,iz)=pxl(ix+1,iy,iz)+p(1,I)*SMALL
-       pxl(ix-1,iy,iz)=pxl(ix-1,iy,iz)+p(1,I)*SMALL
-       pxl(ix,iy+1,iz)=pxl(ix,iy+1,iz)+p(1,I)*SMALL
-       pxl(ix,iy-1,iz)=pxl(ix,iy-1,iz)+p(1,I)*SMALL
-       pxl(ix,iy,iz+1)=pxl(ix,iy,iz+1)+p(1,I)*SMALL
-       pxl(ix,iy,iz-1)=pxl(ix,iy,iz-1)+p(1,I)*SMALL
-*(2) PY
-       pYl(ix,iy,iz)=pYl(ix,iy,iz)+p(2,I)*BIG
-       pYl(ix+1,iy,iz)=pYl(ix+1,iy,iz)+p(2,I)*SMALL
-       pYl(ix-1,iy,iz)=pYl(ix-1,iy,iz)+p(2,I)*SMALL
-       pYl(ix,iy+1,iz)=pYl(ix,iy+1,iz)+p(2,I)*SMALL
-       pYl(ix,iy-1,iz)=pYl(ix,iy-1,iz)+p(2,I)*SMALL
-       pYl(ix,iy,iz+1)=pYl(ix,iy,iz+1)+p(2,I)*SMALL
-       pYl(ix,iy,iz-1)=pYl(ix,iy,iz-1)+p(2,I)*SMALL
-* (3) PZ
-       pZl(ix,iy,iz)=pZl(ix,iy,iz)+p(3,I)*BIG
-       pZl(ix+1,iy,iz)=pZl(ix+1,iy,iz)+p(3,I)*SMALL
-       pZl(ix-1,iy,iz)=pZl(ix-1,iy,iz)+p(3,I)*SMALL
-       pZl(ix,iy+1,iz)=pZl(ix,iy+1,iz)+p(3,I)*SMALL
-       pZl(ix,iy-1,iz)=pZl(ix,iy-1,iz)+p(3,I)*SMALL
-       pZl(ix,iy,iz+1)=pZl(ix,iy,iz+1)+p(3,I)*SMALL
-       pZl(ix,iy,iz-1)=pZl(ix,iy,iz-1)+p(3,I)*SMALL
-* (4) ENERGY
-       pel(ix,iy,iz)=pel(ix,iy,iz)
-     1     +sqrt(e(I)**2+p(1,i)**2+p(2,I)**2+p(3,I)**2)*BIG
-       pel(ix+1,iy,iz)=pel(ix+1,iy,iz)
-     1     +sqrt(e(I)**2+p(1,i)**2+p(2,I)**2+p(3,I)**2)*SMALL
-       pel(ix-1,iy,iz)=pel(ix-1,iy,iz)
-     1     +sqrt(e(I)**2+p(1,i)**2+p(2,I)**2+p(3,I)**2)*SMALL
-       pel(ix,iy+1,iz)=pel(ix,iy+1,iz)
-     1     +sqrt(e(I)**2+p(1,i)**2+p(2,I)**2+p(3,I)**2)*SMALL
-       pel(ix,iy-1,iz)=pel(ix,iy-1,iz)
-     1     +sqrt(e(I)**2+p(1,i)**2+p(2,I)**2+p(3,I)**2)*SMALL
-       pel(ix,iy,iz+1)=pel(ix,iy,iz+1)
-     1     +sqrt(e(I)**2+p(1,i)**2+p(2,I)**2+p(3,I)**2)*SMALL
-       pel(ix,iy,iz-1)=pel(ix,iy,iz-1)
-     1     +sqrt(e(I)**2+p(1,i)**2+p(2,I)**2+p(3,I)**2)*SMALL
+* (1) baryon with charge (proton density), (2) neutral baryon
+* (neutron density), (3) meson density
+          if(j.gt.mass)then
+          KND(NP)=3
+          ELSEIF(ZET(LB(I)).NE.0)THEN
+          KND(NP)=1
+          ELSE
+          KND(NP)=2
+          ENDIF
+* momentum and energy for the Gamma factor in each cell
+          PXS(NP)=p(1,I)
+          PYS(NP)=p(2,I)
+          PZS(NP)=p(3,I)
+          ETS(NP)=sqrt(e(I)**2+p(1,i)**2+p(2,I)**2+p(3,I)**2)
         END IF
   400 CONTINUE
 *
-      DO 301 IZ = -MAXZ,MAXZ
-        DO 201 IY = -MAXX,MAXX
-          DO 101 IX = -MAXX,MAXX
-      IF((RHO(IX,IY,IZ).EQ.0).OR.(PEL(IX,IY,IZ).EQ.0))
-     1GO TO 101
-      SMASS2=PEL(IX,IY,IZ)**2-PXL(IX,IY,IZ)**2
-     1-PYL(IX,IY,IZ)**2-PZL(IX,IY,IZ)**2
-       IF(SMASS2.LE.0)SMASS2=1.E-06
-       SMASS=SQRT(SMASS2)
-           IF(SMASS.EQ.0.)SMASS=1.e-06
-           GAMMA=PEL(IX,IY,IZ)/SMASS
-           if(gamma.eq.0)go to 101
-       bxx(ix,iy,iz)=pxl(ix,iy,iz)/pel(ix,iy,iz)                  
-       byy(ix,iy,iz)=pyl(ix,iy,iz)/pel(ix,iy,iz)       
-       bzz(ix,iy,iz)=pzl(ix,iy,iz)/pel(ix,iy,iz)                  
-            RHO(IX,IY,IZ) = RHO(IX,IY,IZ)/GAMMA
-            RHOn(IX,IY,IZ) = RHOn(IX,IY,IZ)/GAMMA
-            RHOp(IX,IY,IZ) = RHOp(IX,IY,IZ)/GAMMA
-            piRHO(IX,IY,IZ) = piRHO(IX,IY,IZ)/GAMMA
-            pEL(IX,IY,IZ) = pEL(IX,IY,IZ)/(GAMMA**2)
-           rho0=0.163
-           IF(IPOT.EQ.0)THEN
-           U=0
-           GO TO 70
-           ENDIF
-           IF(IPOT.EQ.1.or.ipot.eq.6)THEN
-           A=-0.1236
-           B=0.0704
-           S=2
-           GO TO 60
-           ENDIF
-           IF(IPOT.EQ.2.or.ipot.eq.7)THEN
-           A=-0.218
-           B=0.164
-           S=4./3.
-           ENDIF
-           IF(IPOT.EQ.3)THEN
-           a=-0.3581
-           b=0.3048
-           S=1.167
-           GO TO 60
-           ENDIF
-           IF(IPOT.EQ.4)THEN
-           denr=rho(ix,iy,iz)/rho0         
-           b=0.3048
-           S=1.167
-           if(denr.le.4.or.denr.gt.7)then
-           a=-0.3581
-           else
-           a=-b*denr**(1./6.)-2.*0.036/3.*denr**(-0.333)
-           endif
-           GO TO 60
-           ENDIF
-60           U = 0.5*A*RHO(IX,IY,IZ)**2/RHO0 
-     1        + B/(1+S) * (RHO(IX,IY,IZ)/RHO0)**S*RHO(IX,IY,IZ)  
-70           PEL(IX,IY,IZ)=PEL(IX,IY,IZ)+U
-  101     CONTINUE
-  201   CONTINUE
-  301 CONTINUE
+      CALL DENSMP(IPOT,NP,IXS,IYS,IZS,KND,PXS,PYS,PZS,ETS,
+     &     BIG,SMALL,PXL,PYL,PZL)
       RETURN
       END
 
@@ -10199,7 +10324,11 @@ cc      SAVE /INPUT2/
      1     dpdcy(MAXSTR),dpdpi(MAXSTR,MAXR),dpt(MAXSTR, MAXR),
      2     dpp1(MAXSTR,MAXR),dppion(MAXSTR,MAXR)
 cc      SAVE /RNDF77/
+      INTEGER*8 NWORK
+      COMMON /WRKCNT/ NWORK(12)
+cc      SAVE /WRKCNT/
       SAVE   
+        NWORK(12)=NWORK(12)+1
         lbanti=LB(I)
 c
         DM=E(I)
@@ -10519,8 +10648,12 @@ cc      SAVE /PC/
 cc      SAVE /PD/
       COMMON/RNDF77/NSEED
 cc      SAVE /RNDF77/
+      INTEGER*8 NWORK
+      COMMON /WRKCNT/ NWORK(12)
+cc      SAVE /WRKCNT/
       SAVE   
 
+        NWORK(12)=NWORK(12)+1
         lbanti=LB(I)
 c
         DM=E(I)
@@ -21844,6 +21977,7 @@ c           write(*,*)lb1,lb2,lbpp1,empp1,proper(idp),brpp
 c          endif
 c
                NNN=NNN+1
+               call artgrw(NNN)
                PROPI(NNN,IRUN)= proper(idp)*brpp
                LPION(NNN,IRUN)= lbpp1
                EPION(NNN,IRUN)= empp1
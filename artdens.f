@@ -0,0 +1,308 @@
+c=======================================================================
+c     artdens.f - Parallel mesh deposit for the ART mean field
+c
+c     DENS (art1f.f) packs the particles inside the mesh into a compact
+c     view: cell, kind (1 baryon with charge, 2 neutral baryon,
+c     3 meson), momentum and energy.  DENSMP then
+c       - clears the box of cells filled by the previous call, all
+c         other cells are still zero,
+c       - deposits the 7-point stencil in slabs of z planes, one slab
+c         per OpenMP thread,
+c       - applies the gamma factor and the potential energy plane by
+c         plane.
+c     Each slab walks the particles in their original order and keeps
+c     the stencil points that fall in its planes, so every cell adds
+c     its contributions in the order of the serial loop: the meshes
+c     are bit for bit the same for any number of threads.
+c     Every slab reads the plane of every particle, one compare per
+c     particle against the 4 to 8 array updates per stencil point; in
+c     central Au+Au at 200 GeV (IPOT=3, 150 calls) the largest of 8
+c     slabs reads 232k particles and deposits 252k of the 1.62M points,
+c     so the scan does not limit the scaling.
+c=======================================================================
+
+      SUBROUTINE DENSMP(IPOT,NP,IXS,IYS,IZS,KND,PXS,PYS,PZS,ETS,
+     &     BIG,SMALL,PXL,PYL,PZL)
+c
+c     Fill the meshes from the NP particles of the compact view
+c
+      PARAMETER (MAXX=20, MAXZ=24, MAXSLB=64)
+      DIMENSION IXS(NP),IYS(NP),IZS(NP),KND(NP),
+     &     PXS(NP),PYS(NP),PZS(NP),ETS(NP)
+      dimension pxl(-maxx:maxx,-maxx:maxx,-maxz:maxz),
+     1          pyl(-maxx:maxx,-maxx:maxx,-maxz:maxz),
+     2          pzl(-maxx:maxx,-maxx:maxx,-maxz:maxz)
+      COMMON  /DD/      RHO(-MAXX:MAXX,-MAXX:MAXX,-MAXZ:MAXZ),
+     &                     RHOP(-MAXX:MAXX,-MAXX:MAXX,-MAXZ:MAXZ),
+     &                     RHON(-MAXX:MAXX,-MAXX:MAXX,-MAXZ:MAXZ)
+cc      SAVE /DD/
+      COMMON  /DDpi/    piRHO(-MAXX:MAXX,-MAXX:MAXX,-MAXZ:MAXZ)
+cc      SAVE /DDpi/
+      common  /tt/  PEL(-maxx:maxx,-maxx:maxx,-maxz:maxz)
+     &,rxy(-maxx:maxx,-maxx:maxx,-maxz:maxz)
+cc      SAVE /tt/
+      common  /bbb/ bxx(-maxx:maxx,-maxx:maxx,-maxz:maxz),
+     &byy(-maxx:maxx,-maxx:maxx,-maxz:maxz),
+     &bzz(-maxx:maxx,-maxx:maxx,-maxz:maxz)
+cc      SAVE /bbb/
+      DIMENSION NZ(-MAXZ:MAXZ), IZB(0:MAXSLB)
+c$    integer omp_get_max_threads
+c     box filled by the previous call, empty before the first one
+      SAVE IX0,IX1,IY0,IY1,IZ0,IZ1
+      DATA IX0,IX1,IY0,IY1,IZ0,IZ1 /0,-1,0,-1,0,-1/
+
+c$omp parallel do private(ix,iy)
+      DO 300 IZ = IZ0,IZ1
+        DO 200 IY = IY0,IY1
+          DO 100 IX = IX0,IX1
+            RHO(IX,IY,IZ) = 0.0
+            RHOn(IX,IY,IZ) = 0.0
+            RHOp(IX,IY,IZ) = 0.0
+            piRHO(IX,IY,IZ) = 0.0
+           pxl(ix,iy,iz) = 0.0
+           pyl(ix,iy,iz) = 0.0
+           pzl(ix,iy,iz) = 0.0
+           pel(ix,iy,iz) = 0.0
+           bxx(ix,iy,iz) = 0.0
+           byy(ix,iy,iz) = 0.0
+           bzz(ix,iy,iz) = 0.0
+  100     CONTINUE
+  200   CONTINUE
+  300 CONTINUE
+c$omp end parallel do
+
+c     new box: the particle cells and their stencil neighbours
+      IX0 = 0
+      IX1 = -1
+      IY0 = 0
+      IY1 = -1
+      IZ0 = 0
+      IZ1 = -1
+      IF (NP .EQ. 0) RETURN
+      DO 400 IZ = -MAXZ,MAXZ
+         NZ(IZ) = 0
+  400 CONTINUE
+      IX0 = MAXX
+      IX1 = -MAXX
+      IY0 = MAXX
+      IY1 = -MAXX
+      IZ0 = MAXZ
+      IZ1 = -MAXZ
+      DO 410 I = 1,NP
+         IX0 = MIN(IX0,IXS(I))
+         IX1 = MAX(IX1,IXS(I))
+         IY0 = MIN(IY0,IYS(I))
+         IY1 = MAX(IY1,IYS(I))
+         IZ0 = MIN(IZ0,IZS(I))
+         IZ1 = MAX(IZ1,IZS(I))
+         NZ(IZS(I)) = NZ(IZS(I)) + 1
+  410 CONTINUE
+      IX0 = IX0 - 1
+      IX1 = IX1 + 1
+      IY0 = IY0 - 1
+      IY1 = IY1 + 1
+      IZ0 = IZ0 - 1
+      IZ1 = IZ1 + 1
+
+c     slabs with about the same number of particles; IZB(K) is the
+c     last plane of slab K
+      NSL = 1
+c$    NSL = omp_get_max_threads()
+      NSL = MAX(1, MIN(NSL, MAXSLB, IZ1-IZ0+1))
+      IZB(0) = IZ0 - 1
+      K = 1
+      NC = 0
+      DO 420 IZ = IZ0,IZ1-1
+         NC = NC + NZ(IZ)
+         IF (K .LT. NSL .AND. NC*NSL .GE. K*NP) THEN
+            IZB(K) = IZ
+            K = K + 1
+         ENDIF
+  420 CONTINUE
+      DO 430 KK = K,NSL
+         IZB(KK) = IZ1
+  430 CONTINUE
+
+c     slabs write disjoint planes
+c$omp parallel do schedule(dynamic,1)
+      DO 500 K = 1,NSL
+         CALL DENSDP(IZB(K-1)+1,IZB(K),NP,IXS,IYS,IZS,KND,
+     &        PXS,PYS,PZS,ETS,BIG,SMALL,PXL,PYL,PZL)
+  500 CONTINUE
+c$omp end parallel do
+
+c$omp parallel do schedule(dynamic,1)
+      DO 600 IZ = IZ0,IZ1
+         CALL DENSSW(IPOT,IZ,IX0,IX1,IY0,IY1,PXL,PYL,PZL)
+  600 CONTINUE
+c$omp end parallel do
+      RETURN
+      END
+
+c-----------------------------------------------------------------------
+      SUBROUTINE DENSDP(JZ0,JZ1,NP,IXS,IYS,IZS,KND,PXS,PYS,PZS,ETS,
+     &     BIG,SMALL,PXL,PYL,PZL)
+c
+c     Stencil points of all particles on the planes JZ0..JZ1, in
+c     particle order.  Called from inside a parallel region: no SAVE,
+c     writes only planes JZ0..JZ1.
+c
+      PARAMETER (MAXX=20, MAXZ=24)
+      DIMENSION IXS(NP),IYS(NP),IZS(NP),KND(NP),
+     &     PXS(NP),PYS(NP),PZS(NP),ETS(NP)
+      dimension pxl(-maxx:maxx,-maxx:maxx,-maxz:maxz),
+     1          pyl(-maxx:maxx,-maxx:maxx,-maxz:maxz),
+     2          pzl(-maxx:maxx,-maxx:maxx,-maxz:maxz)
+      COMMON  /DD/      RHO(-MAXX:MAXX,-MAXX:MAXX,-MAXZ:MAXZ),
+     &                     RHOP(-MAXX:MAXX,-MAXX:MAXX,-MAXZ:MAXZ),
+     &                     RHON(-MAXX:MAXX,-MAXX:MAXX,-MAXZ:MAXZ)
+cc      SAVE /DD/
+      COMMON  /DDpi/    piRHO(-MAXX:MAXX,-MAXX:MAXX,-MAXZ:MAXZ)
+cc      SAVE /DDpi/
+      common  /tt/  PEL(-maxx:maxx,-maxx:maxx,-maxz:maxz)
+     &,rxy(-maxx:maxx,-maxx:maxx,-maxz:maxz)
+cc      SAVE /tt/
+      DIMENSION KDX(7), KDY(7), KDZ(7), JX(7), JY(7), JZ(7), W(7)
+c     centre (weight BIG), then the six neighbours (weight SMALL)
+      DATA KDX / 0, 1,-1, 0, 0, 0, 0/
+      DATA KDY / 0, 0, 0, 1,-1, 0, 0/
+      DATA KDZ / 0, 0, 0, 0, 0, 1,-1/
+
+      DO 200 I = 1,NP
+         IZ = IZS(I)
+         IF (IZ .LT. JZ0-1 .OR. IZ .GT. JZ1+1) GO TO 200
+c     stencil points of particle I inside the slab
+         NL = 0
+         DO 100 L = 1,7
+            IF (IZ+KDZ(L) .LT. JZ0 .OR. IZ+KDZ(L) .GT. JZ1) GO TO 100
+            NL = NL + 1
+            JX(NL) = IXS(I) + KDX(L)
+            JY(NL) = IYS(I) + KDY(L)
+            JZ(NL) = IZ + KDZ(L)
+            W(NL) = SMALL
+            IF (L .EQ. 1) W(NL) = BIG
+  100    CONTINUE
+         IF (KND(I) .EQ. 3) THEN
+            DO 110 N = 1,NL
+               MX = JX(N)
+               MY = JY(N)
+               MZ = JZ(N)
+               piRHO(MX,MY,MZ) = piRHO(MX,MY,MZ) + W(N)
+  110       CONTINUE
+         ELSE IF (KND(I) .EQ. 1) THEN
+            DO 120 N = 1,NL
+               MX = JX(N)
+               MY = JY(N)
+               MZ = JZ(N)
+               RHO(MX,MY,MZ) = RHO(MX,MY,MZ) + W(N)
+               RHOP(MX,MY,MZ) = RHOP(MX,MY,MZ) + W(N)
+  120       CONTINUE
+         ELSE
+            DO 130 N = 1,NL
+               MX = JX(N)
+               MY = JY(N)
+               MZ = JZ(N)
+               RHO(MX,MY,MZ) = RHO(MX,MY,MZ) + W(N)
+               RHON(MX,MY,MZ) = RHON(MX,MY,MZ) + W(N)
+  130       CONTINUE
+         ENDIF
+         DO 140 N = 1,NL
+            MX = JX(N)
+            MY = JY(N)
+            MZ = JZ(N)
+            pxl(MX,MY,MZ) = pxl(MX,MY,MZ) + PXS(I)*W(N)
+            pyl(MX,MY,MZ) = pyl(MX,MY,MZ) + PYS(I)*W(N)
+            pzl(MX,MY,MZ) = pzl(MX,MY,MZ) + PZS(I)*W(N)
+            pel(MX,MY,MZ) = pel(MX,MY,MZ) + ETS(I)*W(N)
+  140    CONTINUE
+  200 CONTINUE
+      RETURN
+      END
+
+c-----------------------------------------------------------------------
+      SUBROUTINE DENSSW(IPOT,IZ,JX0,JX1,JY0,JY1,PXL,PYL,PZL)
+c
+c     Gamma factor, velocity and potential energy of the cells of
+c     plane IZ, as at the end of the original DENS.  No SAVE.
+c
+      PARAMETER (MAXX=20, MAXZ=24)
+      dimension pxl(-maxx:maxx,-maxx:maxx,-maxz:maxz),
+     1          pyl(-maxx:maxx,-maxx:maxx,-maxz:maxz),
+     2          pzl(-maxx:maxx,-maxx:maxx,-maxz:maxz)
+      COMMON  /DD/      RHO(-MAXX:MAXX,-MAXX:MAXX,-MAXZ:MAXZ),
+     &                     RHOP(-MAXX:MAXX,-MAXX:MAXX,-MAXZ:MAXZ),
+     &                     RHON(-MAXX:MAXX,-MAXX:MAXX,-MAXZ:MAXZ)
+cc      SAVE /DD/
+      COMMON  /DDpi/    piRHO(-MAXX:MAXX,-MAXX:MAXX,-MAXZ:MAXZ)
+cc      SAVE /DDpi/
+      common  /tt/  PEL(-maxx:maxx,-maxx:maxx,-maxz:maxz)
+     &,rxy(-maxx:maxx,-maxx:maxx,-maxz:maxz)
+cc      SAVE /tt/
+      common  /bbb/ bxx(-maxx:maxx,-maxx:maxx,-maxz:maxz),
+     &byy(-maxx:maxx,-maxx:maxx,-maxz:maxz),
+     &bzz(-maxx:maxx,-maxx:maxx,-maxz:maxz)
+cc      SAVE /bbb/
+
+c     the original kept A, B, S static, zero for other IPOT values
+      A = 0.
+      B = 0.
+      S = 0.
+        DO 201 IY = JY0,JY1
+          DO 101 IX = JX0,JX1
+      IF((RHO(IX,IY,IZ).EQ.0).OR.(PEL(IX,IY,IZ).EQ.0))
+     1GO TO 101
+      SMASS2=PEL(IX,IY,IZ)**2-PXL(IX,IY,IZ)**2
+     1-PYL(IX,IY,IZ)**2-PZL(IX,IY,IZ)**2
+       IF(SMASS2.LE.0)SMASS2=1.E-06
+       SMASS=SQRT(SMASS2)
+           IF(SMASS.EQ.0.)SMASS=1.e-06
+           GAMMA=PEL(IX,IY,IZ)/SMASS
+           if(gamma.eq.0)go to 101
+       bxx(ix,iy,iz)=pxl(ix,iy,iz)/pel(ix,iy,iz)
+       byy(ix,iy,iz)=pyl(ix,iy,iz)/pel(ix,iy,iz)
+       bzz(ix,iy,iz)=pzl(ix,iy,iz)/pel(ix,iy,iz)
+            RHO(IX,IY,IZ) = RHO(IX,IY,IZ)/GAMMA
+            RHOn(IX,IY,IZ) = RHOn(IX,IY,IZ)/GAMMA
+            RHOp(IX,IY,IZ) = RHOp(IX,IY,IZ)/GAMMA
+            piRHO(IX,IY,IZ) = piRHO(IX,IY,IZ)/GAMMA
+            pEL(IX,IY,IZ) = pEL(IX,IY,IZ)/(GAMMA**2)
+           rho0=0.163
+           IF(IPOT.EQ.0)THEN
+           U=0
+           GO TO 70
+           ENDIF
+           IF(IPOT.EQ.1.or.ipot.eq.6)THEN
+           A=-0.1236
+           B=0.0704
+           S=2
+           GO TO 60
+           ENDIF
+           IF(IPOT.EQ.2.or.ipot.eq.7)THEN
+           A=-0.218
+           B=0.164
+           S=4./3.
+           ENDIF
+           IF(IPOT.EQ.3)THEN
+           a=-0.3581
+           b=0.3048
+           S=1.167
+           GO TO 60
+           ENDIF
+           IF(IPOT.EQ.4)THEN
+           denr=rho(ix,iy,iz)/rho0
+           b=0.3048
+           S=1.167
+           if(denr.le.4.or.denr.gt.7)then
+           a=-0.3581
+           else
+           a=-b*denr**(1./6.)-2.*0.036/3.*denr**(-0.333)
+           endif
+           GO TO 60
+           ENDIF
+60           U = 0.5*A*RHO(IX,IY,IZ)**2/RHO0
+     1        + B/(1+S) * (RHO(IX,IY,IZ)/RHO0)**S*RHO(IX,IY,IZ)
+70           PEL(IX,IY,IZ)=PEL(IX,IY,IZ)+U
+  101     CONTINUE
+  201   CONTINUE
+      RETURN
+      END
@@ -0,0 +1,212 @@
+#include "batch.h"
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <filesystem>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+
+using namespace std;
+
+// Exit status of a configuration process whose system differs from its group's
+static const int BATCH_OTHER_SYSTEM = 3;
+
+enum BatchStatus { BATCH_PENDING = 0, BATCH_DONE, BATCH_FAILED };
+
+// One configuration: absolute run directory, and its state shared between the
+// processes (status, group number, wall time)
+struct BatchConfig {
+    string dir;
+};
+struct BatchState {
+    int status;
+    int group;
+    double seconds;
+};
+
+static vector<BatchConfig> g_configs;
+static BatchState* g_state = nullptr;  // MAP_SHARED, one per configuration
+static int g_leader = -1;              // configuration that set up the current group
+static int g_group = 0;                // number of the current group, from 1
+static vector<double> g_group_key;
+
+// Run directory and input file of each line: "<dir> [input file]"
+static bool ParseList(const string& list) {
+    ifstream in(list);
+    if (!in) {
+        cerr << "ERROR: Cannot open batch list " << list << endl;
+        return false;
+    }
+    string line;
+    while (getline(in, line)) {
+        size_t hash = line.find('#');
+        if (hash != string::npos) line.erase(hash);
+        istringstream fields(line);
+        string dir, input;
+        if (!(fields >> dir)) continue;
+        fields >> input;
+
+        error_code ec;
+        filesystem::create_directories(filesystem::path(dir) / "ana", ec);
+        if (ec) {
+            cerr << "ERROR: Cannot create " << dir << "/ana: " << ec.message() << endl;
+            return false;
+        }
+        filesystem::path target = filesystem::path(dir) / "input.ampt";
+        error_code same;
+        if (!input.empty() && !filesystem::equivalent(input, target, same)) {
+            filesystem::copy_file(input, target, filesystem::copy_options::overwrite_existing, ec);
+            if (ec) {
+                cerr << "ERROR: Cannot copy " << input << " to " << target.string() << ": "
+                     << ec.message() << endl;
+                return false;
+            }
+        }
+        if (!filesystem::exists(target)) {
+            cerr << "ERROR: " << target.string() << " does not exist" << endl;
+            return false;
+        }
+        g_configs.push_back({filesystem::absolute(dir).lexically_normal().string()});
+    }
+    if (g_configs.empty()) {
+        cerr << "ERROR: No configurations in " << list << endl;
+        return false;
+    }
+    return true;
+}
+
+static int NextPending() {
+    for (size_t i = 0; i < g_configs.size(); i++) {
+        if (g_state[i].status == BATCH_PENDING) return (int)i;
+    }
+    return -1;
+}
+
+static void EnterRunDirectory(int i) {
+    if (chdir(g_configs[i].dir.c_str()) != 0) {
+        cerr << "ERROR: Cannot enter " << g_configs[i].dir << endl;
+        exit(1);
+    }
+}
+
+// A configuration counts as done only if it exited with status 0 and left a
+// non-empty ana/ampt.dat: some error paths of the Fortran code end in a bare
+// STOP, which exits with status 0
+static bool HasOutput(int i) {
+    error_code ec;
+    auto size = filesystem::file_size(filesystem::path(g_configs[i].dir) / "ana" / "ampt.dat", ec);
+    return !ec && size > 0;
+}
+
+extern "C" {
+
+void batch_open_(const char* list, size_t len) {
+    string name(list, len);
+    name.erase(name.find_last_not_of(' ') + 1);
+    if (!ParseList(name)) exit(1);
+
+    size_t bytes = g_configs.size() * sizeof(BatchState);
+    void* shared = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (shared == MAP_FAILED) {
+        perror("batch: mmap");
+        exit(1);
+    }
+    g_state = (BatchState*)shared;
+    for (size_t i = 0; i < g_configs.size(); i++) g_state[i] = {BATCH_PENDING, 0, 0.0};
+    cout << "batch: " << g_configs.size() << " configurations from " << name << endl;
+
+    // One group process per system, each set up from its first pending configuration
+    int ngroups = 0;
+    for (int leader = NextPending(); leader >= 0; leader = NextPending()) {
+        ngroups++;
+        fflush(nullptr);
+        pid_t pid = fork();
+        if (pid < 0) {
+            perror("batch: fork");
+            exit(1);
+        }
+        if (pid == 0) {
+            g_leader = leader;
+            g_group = ngroups;
+            EnterRunDirectory(leader);
+            return;
+        }
+        int wstatus;
+        waitpid(pid, &wstatus, 0);
+        // A group that died before running its own configuration must not come back
+        if (g_state[leader].status == BATCH_PENDING) {
+            g_state[leader].status = BATCH_FAILED;
+            g_state[leader].group = ngroups;
+        }
+    }
+
+    int nfailed = 0;
+    cout << endl << "batch summary" << endl;
+    for (size_t i = 0; i < g_configs.size(); i++) {
+        const BatchState& s = g_state[i];
+        if (s.status == BATCH_FAILED) nfailed++;
+        printf("  %-8s %9.1f s  group %-3d %s\n", s.status == BATCH_DONE ? "done" : "FAILED",
+               s.seconds, s.group, g_configs[i].dir.c_str());
+    }
+    printf("batch: %zu configurations, %d HIJING setups, %d failed\n", g_configs.size(),
+           ngroups, nfailed);
+    fflush(nullptr);
+    exit(nfailed > 0 ? 1 : 0);
+}
+
+void batch_fork_(const double* key, const int* nkey) {
+    g_group_key.assign(key, key + *nkey);
+    cout << "batch: group " << g_group << " set up from " << g_configs[g_leader].dir << endl;
+
+    for (size_t i = g_leader; i < g_configs.size(); i++) {
+        if (g_state[i].status != BATCH_PENDING) continue;
+        auto t0 = chrono::steady_clock::now();
+        fflush(nullptr);
+        pid_t pid = fork();
+        if (pid < 0) {
+            perror("batch: fork");
+            exit(1);
+        }
+        if (pid == 0) {
+            EnterRunDirectory((int)i);
+            int fd = open("ampt.log", O_WRONLY | O_CREAT | O_TRUNC, 0644);
+            if (fd >= 0) {
+                dup2(fd, 1);
+                dup2(fd, 2);
+                close(fd);
+            }
+            return;
+        }
+        int wstatus;
+        waitpid(pid, &wstatus, 0);
+        int code = WIFEXITED(wstatus) ? WEXITSTATUS(wstatus) : -1;
+        if (code == BATCH_OTHER_SYSTEM && (int)i != g_leader) continue;
+        bool done = (code == 0) && HasOutput((int)i);
+        g_state[i].status = done ? BATCH_DONE : BATCH_FAILED;
+        g_state[i].group = g_group;
+        g_state[i].seconds = chrono::duration<double>(chrono::steady_clock::now() - t0).count();
+        printf("batch: %s %s (%.1f s)\n", g_configs[i].dir.c_str(),
+               done ? "done" : (code == 0 ? "FAILED, no ana/ampt.dat, see its ampt.log"
+                                          : "FAILED, see its ampt.log"),
+               g_state[i].seconds);
+        fflush(stdout);
+    }
+    exit(0);
+}
+
+void batch_check_(const double* key, const int* nkey) {
+    if (*nkey == (int)g_group_key.size() && equal(g_group_key.begin(), g_group_key.end(), key)) return;
+    cout << "batch: system differs from " << g_configs[g_leader].dir
+         << ", left for a later group" << endl;
+    exit(BATCH_OTHER_SYSTEM);
+}
+
+} // extern "C"
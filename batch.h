@@ -0,0 +1,42 @@
+#ifndef BATCH_H
+#define BATCH_H
+
+// Batch mode of ampt: "ampt -b <list>" runs many configurations in one job
+//
+// Every line of <list> names a run directory and, optionally, an input file
+// that is copied there as input.ampt ("#" starts a comment).  Each directory
+// gets its own ana/ and ampt.log.  Configurations of the same system share
+// the HIJING setup: main.f reads the input of the first pending
+// configuration, runs ARSIZE and HIJSET (Woods-Saxon tables, cross sections,
+// HIFUN integrations) once, and each configuration then runs in a process
+// forked from that state.  It starts from exactly the tables and COMMON
+// blocks a standalone ampt has after HIJSET and re-reads everything
+// downstream (ARTSET, ZPC, coalescence, seeds, ...) from its own input.ampt.
+// A configuration with a different system key (energy, frame, nuclei, Lund
+// and HIJING parameters, iarsiz, and the seeds and random number backend,
+// since HIJSET integrates the jet cross sections with VEGAS; see main.f)
+// leaves its process at once and starts the next group.  Forking rather than
+// resetting the COMMON blocks in place keeps every run identical to a
+// standalone one: HIJSET alone rescales PARJ(2) and PARJ(21) each time it is
+// called, and the generators continue from where HIJSET left them.
+//
+// A configuration has failed if its process exits with a non-zero status or
+// leaves no (or an empty) ana/ampt.dat.
+// The HIJING seed on stdin is read once and used by every configuration.
+// Configurations run one after the other; ampt-farm spreads events over cores.
+
+#include <cstddef>
+
+extern "C" {
+    // Parse the list and prepare the run directories.  Returns in the process
+    // of the first configuration of each group, in its run directory, and
+    // exits once every configuration has run (status 1 if any failed)
+    void batch_open_(const char* list, size_t len);
+    // Group process after HIJSET: run every pending configuration in a forked
+    // process; returns in those processes, in their run directory
+    void batch_fork_(const double* key, const int* nkey);
+    // Configuration process: leave (for a later group) unless key is the group's
+    void batch_check_(const double* key, const int* nkey);
+}
+
+#endif // BATCH_H
@@ -0,0 +1,63 @@
+#!/bin/bash
+# bench_compare.sh - 将 bench_suite.sh 的结果与基线比较，标出性能回退
+#
+# 用法: ./bench_compare.sh <基线.tsv> <结果.tsv> [容差%]
+#   容差默认 10 (或环境变量 BENCH_TOL)。
+#
+# evps* (每秒事件数) 越大越好，其余指标 (wall_s analysis_ms peak_rss_mb
+# bytes_*) 越小越好；events 只检查是否一致。变差超过容差的指标标记为
+# REGRESSION，变好超过容差的标记为 improved，只在一边出现的指标标记为
+# new 或 missing。有回退时返回 1，可直接用于 CI。
+# 基准时间受机器和负载影响，基线应在同一台机器上由 make bench-baseline
+# 生成。
+
+if [ $# -lt 2 ]; then
+    echo "用法: $0 <基线.tsv> <结果.tsv> [容差%]"
+    exit 2
+fi
+BASE=$1
+NEW=$2
+TOL=${3:-${BENCH_TOL:-10}}
+
+for f in "$BASE" "$NEW"; do
+    if [ ! -f "$f" ]; then
+        echo "错误: 找不到 $f"
+        exit 2
+    fi
+done
+
+awk -F'\t' -v tol=$TOL '
+    FNR == NR { base[$1 "\t" $2] = $3; next }
+    {
+        key = $1 "\t" $2
+        seen[key] = 1
+        if (!(key in base)) { row($1, $2, "-", $3, "-", "new"); next }
+        b = base[key]; v = $3
+        if ($2 == "events") {
+            row($1, $2, b, v, "-", (b == v ? "ok" : "differs"))
+            next
+        }
+        if (b == 0) { row($1, $2, b, v, "-", "ok"); next }
+        change = 100 * (v - b) / b
+        # 正数表示变好
+        better = ($2 ~ /^evps/) ? change : -change
+        status = "ok"
+        if (better < -tol) { status = "REGRESSION"; nreg++ }
+        else if (better > tol) status = "improved"
+        row($1, $2, b, v, sprintf("%+.1f%%", change), status)
+    }
+    END {
+        for (key in base)
+            if (!(key in seen)) {
+                split(key, k, "\t")
+                row(k[1], k[2], base[key], "-", "-", "missing")
+            }
+        printf "\n容差 %s%%: %d 个指标回退\n", tol, nreg
+        exit (nreg > 0)
+    }
+    function row(cfg, metric, b, v, change, status) {
+        if (!header++)
+            printf "%-12s %-28s %14s %14s %9s  %s\n", "config", "metric", "baseline",
+                   "current", "change", "status"
+        printf "%-12s %-28s %14s %14s %9s  %s\n", cfg, metric, b, v, change, status
+    }' "$BASE" "$NEW"
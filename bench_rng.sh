@@ -0,0 +1,93 @@
+#!/bin/bash
+# bench_rng.sh - 原随机数发生器 (irngbk=0) 与 Philox 计数器后端 (irngbk=1) 的开销对比
+#
+# 用法: ./bench_rng.sh [系统...]      系统: pp200 auau200 pbpb5020 (默认 pp200 auau200)
+# 环境变量:
+#   AMPT_BIN    ampt 可执行文件 (默认 ./ampt)
+#   BENCH_BIN   随机数微基准 (默认 ./ampt-rng-bench, make ampt-rng-bench)
+#   NRAND       微基准中每个发生器抽取的随机数个数 (默认 10000000)
+#   NEV         每个配置的事件数 (默认 pp200:200, auau200:3, pbpb5020:1)
+#   SEED        HIJING 运行时随机数种子 (默认 20030819)
+#   KEEP=1      保留临时运行目录
+#
+# 第一部分: RANART、RLU、ZPC ran1 每个随机数的 CPU 时间 (ns)。
+# 第二部分: 相同输入和种子下两种后端各运行一次完整事件，输出每个事件的
+# 墙钟时间和平均末态粒子数。两种后端的随机数序列不同，事件本身不一致，
+# 只在统计意义上可比，因此应使用足够多的事件。
+
+AMPT_BIN=${AMPT_BIN:-./ampt}
+BENCH_BIN=${BENCH_BIN:-./ampt-rng-bench}
+SEED=${SEED:-20030819}
+BASE_INPUT=input.ampt
+
+for b in "$AMPT_BIN" "$BENCH_BIN"; do
+    if [ ! -x "$b" ]; then
+        echo "错误: 找不到 $b，请先 make $(basename $b)"
+        exit 1
+    fi
+done
+AMPT_BIN=$(cd "$(dirname "$AMPT_BIN")" && pwd)/$(basename "$AMPT_BIN")
+
+SYSTEMS="$*"
+[ -z "$SYSTEMS" ] && SYSTEMS="pp200 auau200"
+
+# 生成一个配置的 input.ampt: <系统> <irngbk> <输出文件>
+make_input() {
+    local sys=$1 rng=$2 out=$3
+    local efrm proj targ a z nev bmax parj41
+    case $sys in
+        pp200)    efrm=200;  proj=P; targ=P; a=1;   z=1;  nev=${NEV:-200}; bmax=8.;  parj41=0.55 ;;
+        auau200)  efrm=200;  proj=A; targ=A; a=197; z=79; nev=${NEV:-3};   bmax=3.;  parj41=0.55 ;;
+        pbpb5020) efrm=5020; proj=A; targ=A; a=208; z=82; nev=${NEV:-1};   bmax=3.;  parj41=0.30 ;;
+        *) echo "未知系统: $sys"; return 1 ;;
+    esac
+    awk -v efrm=$efrm -v proj=$proj -v targ=$targ -v a=$a -v z=$z \
+        -v nev=$nev -v bmax=$bmax -v parj41=$parj41 -v rng=$rng '
+        NR==1  { print efrm "\t\t! EFRM"; next }
+        NR==3  { printf "%-16s! PROJ\n", proj; next }
+        NR==4  { printf "%-16s! TARG\n", targ; next }
+        NR==5 || NR==7 { print a "\t\t! A"; next }
+        NR==6 || NR==8 { print z "\t\t! Z"; next }
+        NR==9  { print nev "\t\t! NEVNT"; next }
+        NR==10 { print "0.\t\t! BMIN"; next }
+        NR==11 { print bmax "\t\t! BMAX"; next }
+        NR==15 { print parj41 "\t\t! PARJ(41)"; next }
+        /random number backend/ { print rng "\t\t! random number backend"; next }
+        { print }' $BASE_INPUT > $out
+}
+
+echo "== 随机数生成开销 =="
+$BENCH_BIN ${NRAND:-10000000} || exit 1
+
+echo
+echo "== 完整事件时间 =="
+printf "%-10s %8s %8s %10s %12s %12s %8s\n" \
+    system irngbk events wall_s ms_per_evt mult_per_evt ratio
+for sys in $SYSTEMS; do
+    base_ms=""
+    for rng in 0 1; do
+        dir=$(mktemp -d /tmp/bench_rng_${sys}_${rng}_XXXX)
+        mkdir -p $dir/ana
+        make_input $sys $rng $dir/input.ampt || exit 1
+        t0=$(date +%s.%N)
+        ( cd $dir && echo $SEED | $AMPT_BIN > ampt.log 2>&1 )
+        t1=$(date +%s.%N)
+        if [ ! -s $dir/ana/ampt.dat ]; then
+            echo "错误: $sys irngbk=$rng 运行失败，见 $dir/ampt.log"
+            continue
+        fi
+        # ampt.dat 事件头: 事件号 测试号 粒子数 ...
+        read nev mult <<< "$(awk 'NF == 11 { n++; m += $3 }
+            END { printf "%d %.1f\n", n, (n > 0 ? m / n : 0) }' $dir/ana/ampt.dat)"
+        ms=$(awk -v a=$t0 -v b=$t1 -v n=$nev 'BEGIN { printf "%.1f", (b - a) * 1000 / n }')
+        if [ $rng -eq 0 ]; then
+            base_ms=$ms
+            ratio=1.00
+        else
+            ratio=$(awk -v a=$ms -v b=$base_ms 'BEGIN { printf "%.2f", (b > 0 ? a / b : 0) }')
+        fi
+        printf "%-10s %8s %8d %10.2f %12s %12s %8s\n" \
+            $sys $rng $nev $(awk -v a=$t0 -v b=$t1 'BEGIN { print b - a }') $ms $mult $ratio
+        [ -z "$KEEP" ] && rm -rf $dir
+    done
+done
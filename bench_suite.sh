@@ -0,0 +1,126 @@
+#!/bin/bash
+# bench_suite.sh - 固定种子的参考配置端到端基准 (make bench)
+#
+# 用法: ./bench_suite.sh [配置...]
+#   配置: pp200 auau200 auau200sm pbpb5020sm (默认全部)
+#     pp200       p+p 200 GeV，默认 AMPT (isoft=1)
+#     auau200     Au+Au 200 GeV，默认 AMPT (isoft=1)
+#     auau200sm   Au+Au 200 GeV，弦熔化 (isoft=4)
+#     pbpb5020sm  Pb+Pb 5.02 TeV，弦熔化 (isoft=4)
+# 环境变量:
+#   AMPT_BIN    ampt 可执行文件 (默认 ./ampt)
+#   NEV         每个配置的事件数 (默认 pp200:50, auau200:2, auau200sm:2, pbpb5020sm:1)
+#   SEED        HIJING 随机数种子 (默认 20030819)
+#   ZPC_SEED    ZPC 随机数种子 (默认 8)
+#   BENCH_OUT   结果文件 (默认 bench_results.tsv)
+#   KEEP=1      保留临时运行目录
+#
+# 每个配置的 input.ampt 由固定模板 slurm_jobs/templates/input.ampt.template
+# 生成 (与工作目录中的 input.ampt 无关)，第 31-33 行写为 ihjsed=0、SEED 和
+# ZPC_SEED，因此同一 SEED 的结果可重复。每个配置在临时目录中以
+# AMPT_TIMING=1 运行一次，从运行结束时打印的阶段计时表 (stage_timer.h) 读取各阶段
+# 总时间和峰值内存，从 ana/ 下各 ROOT 流的文件大小得到每个事件的输出
+# 字节数。结果写成制表符分隔的三列 "配置 指标 数值"：
+#   events             事件数
+#   wall_s             墙钟时间
+#   evps               每秒事件数 (整个运行)
+#   evps_<阶段>        每秒事件数，只计该阶段时间 (hijing zpc coal art ...)
+#   analysis_ms        每个事件的 AnalysisCore 时间 (ms，五个流合计)
+#   peak_rss_mb        峰值常驻内存 (MB)
+#   bytes_<流>         每个事件的输出字节数 (ampt zpc parton_initial
+#                      hadron_before_art hadron_before_melting)
+# 与基线比较见 bench_compare.sh。
+
+AMPT_BIN=${AMPT_BIN:-./ampt}
+SEED=${SEED:-20030819}
+ZPC_SEED=${ZPC_SEED:-8}
+BENCH_OUT=${BENCH_OUT:-bench_results.tsv}
+TEMPLATE=$(cd "$(dirname "$0")" && pwd)/slurm_jobs/templates/input.ampt.template
+
+if [ ! -x "$AMPT_BIN" ]; then
+    echo "错误: 找不到 $AMPT_BIN，请先 make"
+    exit 1
+fi
+AMPT_BIN=$(cd "$(dirname "$AMPT_BIN")" && pwd)/$(basename "$AMPT_BIN")
+if [ ! -f "$TEMPLATE" ]; then
+    echo "错误: 找不到模板 $TEMPLATE"
+    exit 1
+fi
+
+CONFIGS="$*"
+[ -z "$CONFIGS" ] && CONFIGS="pp200 auau200 auau200sm pbpb5020sm"
+
+# 生成一个配置的 input.ampt: <配置> <输出文件>
+make_input() {
+    local cfg=$1 out=$2
+    local efrm proj targ a z nev bmax parj41 isoft
+    case $cfg in
+        pp200)      efrm=200;  proj=P; targ=P; a=1;   z=1;  nev=${NEV:-50}; bmax=8.; parj41=0.55; isoft=1 ;;
+        auau200)    efrm=200;  proj=A; targ=A; a=197; z=79; nev=${NEV:-2};  bmax=3.; parj41=0.55; isoft=1 ;;
+        auau200sm)  efrm=200;  proj=A; targ=A; a=197; z=79; nev=${NEV:-2};  bmax=3.; parj41=0.55; isoft=4 ;;
+        pbpb5020sm) efrm=5020; proj=A; targ=A; a=208; z=82; nev=${NEV:-1};  bmax=3.; parj41=0.30; isoft=4 ;;
+        *) echo "未知配置: $cfg"; return 1 ;;
+    esac
+    sed -e "s/{ENERGY}/$efrm/" \
+        -e "s/{IAP}/$a/" -e "s/{IZP}/$z/" -e "s/{IAT}/$a/" -e "s/{IZT}/$z/" \
+        -e "s/{NEVNT}/$nev/" -e "s/{BMIN}/0./" -e "s/{BMAX}/$bmax/" \
+        -e "s/{ISOFT}/$isoft/" -e "s/{ICOAL_METHOD}/1/" -e "s/{ISHLF}/0/" \
+        -e "s/{HIJING_SEED}/$SEED/" -e "s/{ZPC_SEED}/$ZPC_SEED/" $TEMPLATE |
+    awk -v proj=$proj -v targ=$targ -v parj41=$parj41 '
+        NR==3  { printf "%-16s! PROJ\n", proj; next }
+        NR==4  { printf "%-16s! TARG\n", targ; next }
+        NR==15 { print parj41 "\t\t! PARJ(41)"; next }
+        NR==31 { print "0\t\t! ihjsed: HIJING seed from the next line"; next }
+        { print }' > $out
+}
+
+# 一个配置的全部指标，输出 "指标 数值" 行: <运行目录> <墙钟秒>
+collect() {
+    local dir=$1 wall=$2
+    # 阶段计时表: "Stage timing of N events" 到 "Transport work" 之间
+    awk -v wall=$wall '
+        /^Stage timing of/ { n = $4; intable = 1; next }
+        /^Transport work/ || /^Hardware counters/ { intable = 0 }
+        /^Peak RSS/ { printf "peak_rss_mb %s\n", $3 }
+        intable && $1 != "stage" && NF >= 8 { t[$1] = $2 }
+        END {
+            if (n == 0) exit 1
+            printf "events %d\n", n
+            printf "wall_s %.3f\n", wall
+            printf "evps %.4f\n", (wall > 0 ? n / wall : 0)
+            split("hijing getnp zpc coal arini art write fill analysis", st, " ")
+            for (i = 1; i <= 9; i++)
+                if (t[st[i]] > 0) printf "evps_%s %.4f\n", st[i], n / t[st[i]]
+            printf "analysis_ms %.3f\n", 1000 * t["analysis"] / n
+        }' $dir/ampt.log || return 1
+    local n=$(awk '/^Stage timing of/ { print $4 }' $dir/ampt.log)
+    local stream file
+    for stream in ampt zpc parton-initial hadron-before-art hadron-before-melting; do
+        file=$dir/ana/$stream.root
+        [ -f $file ] || continue
+        echo "bytes_$(echo $stream | tr - _) $(( $(wc -c < $file) / n ))"
+    done
+}
+
+: > $BENCH_OUT
+printf "%-12s %8s %10s %10s %12s %12s\n" config events wall_s evps analysis_ms peak_rss_mb
+for cfg in $CONFIGS; do
+    dir=$(mktemp -d /tmp/bench_suite_${cfg}_XXXX)
+    mkdir -p $dir/ana
+    make_input $cfg $dir/input.ampt || exit 1
+    t0=$(date +%s.%N)
+    # ihjsed=0: 标准输入的种子不被使用
+    ( cd $dir && echo 0 | AMPT_TIMING=1 $AMPT_BIN > ampt.log 2>&1 )
+    t1=$(date +%s.%N)
+    wall=$(awk -v a=$t0 -v b=$t1 'BEGIN { printf "%.3f", b - a }')
+    if ! collect $dir $wall > $dir/metrics; then
+        echo "错误: $cfg 运行失败或没有阶段计时表，见 $dir/ampt.log"
+        continue
+    fi
+    awk -v c=$cfg '{ printf "%s\t%s\t%s\n", c, $1, $2 }' $dir/metrics >> $BENCH_OUT
+    awk -v c=$cfg '{ m[$1] = $2 }
+        END { printf "%-12s %8s %10s %10s %12s %12s\n", c, m["events"], m["wall_s"],
+              m["evps"], m["analysis_ms"], m["peak_rss_mb"] }' $dir/metrics
+    [ -z "$KEEP" ] && rm -rf $dir
+done
+echo "结果: $BENCH_OUT"
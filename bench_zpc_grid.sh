@@ -0,0 +1,121 @@
+#!/bin/bash
+# bench_zpc_grid.sh - ZPC 固定网格 (izgrid=0) 与密度自适应网格 (izgrid=1) 的碰撞速率对比
+#
+# 用法: ./bench_zpc_grid.sh [系统...]      系统: pp200 auau200 pbpb5020 (默认全部)
+# 环境变量:
+#   AMPT_BIN   ampt 可执行文件 (默认 ./ampt)
+#   NEV        每个配置的事件数 (默认 pp200:200, auau200:3, pbpb5020:1)
+#   SEED       HIJING 随机数种子 (默认 20030819)
+#   ZPC_SEED   ZPC 随机数种子 (默认 8)
+#   AMPT_REF   参考 ampt 可执行文件 (可选)，例如由 ZPC 仍使用链表单元格的旧提交
+#              编译，以 izgrid=0 多运行一行 "ref" 作为加速比的基准
+#   KEEP=1     保留临时运行目录
+#
+# 输入由固定模板 slurm_jobs/templates/input.ampt.template 生成 (弦熔化，
+# 第 31-33 行为 ihjsed=0、SEED 和 ZPC_SEED)，与工作目录中的 input.ampt 无关。
+# 每个配置以相同的输入和种子各运行一次 (AMPT_TIMING=1，zpc.res 才记录
+# ZPC CPU 时间)，从 ana/zpc.res 读取每个事件的碰撞数和 ZPC CPU 时间，输出
+# collisions/sec 及相对第一行的加速比，并检查各行的 ana/zpc.dat 是否一致。
+
+AMPT_BIN=${AMPT_BIN:-./ampt}
+SEED=${SEED:-20030819}
+ZPC_SEED=${ZPC_SEED:-8}
+TEMPLATE=$(cd "$(dirname "$0")" && pwd)/slurm_jobs/templates/input.ampt.template
+
+if [ ! -x "$AMPT_BIN" ]; then
+    echo "错误: 找不到 $AMPT_BIN，请先 make"
+    exit 1
+fi
+AMPT_BIN=$(cd "$(dirname "$AMPT_BIN")" && pwd)/$(basename "$AMPT_BIN")
+if [ ! -f "$TEMPLATE" ]; then
+    echo "错误: 找不到模板 $TEMPLATE"
+    exit 1
+fi
+if [ -n "$AMPT_REF" ]; then
+    if [ ! -x "$AMPT_REF" ]; then
+        echo "错误: 找不到 $AMPT_REF"
+        exit 1
+    fi
+    AMPT_REF=$(cd "$(dirname "$AMPT_REF")" && pwd)/$(basename "$AMPT_REF")
+fi
+
+SYSTEMS="$*"
+[ -z "$SYSTEMS" ] && SYSTEMS="pp200 auau200 pbpb5020"
+
+# 生成一个配置的 input.ampt: <系统> <izgrid> <输出文件>
+make_input() {
+    local sys=$1 grid=$2 out=$3
+    local efrm proj targ a z nev bmax parj41
+    case $sys in
+        pp200)    efrm=200;  proj=P; targ=P; a=1;   z=1;  nev=${NEV:-200}; bmax=8.;  parj41=0.55 ;;
+        auau200)  efrm=200;  proj=A; targ=A; a=197; z=79; nev=${NEV:-3};   bmax=3.;  parj41=0.55 ;;
+        pbpb5020) efrm=5020; proj=A; targ=A; a=208; z=82; nev=${NEV:-1};   bmax=3.;  parj41=0.30 ;;
+        *) echo "未知系统: $sys"; return 1 ;;
+    esac
+    sed -e "s/{ENERGY}/$efrm/" \
+        -e "s/{IAP}/$a/" -e "s/{IZP}/$z/" -e "s/{IAT}/$a/" -e "s/{IZT}/$z/" \
+        -e "s/{NEVNT}/$nev/" -e "s/{BMIN}/0./" -e "s/{BMAX}/$bmax/" \
+        -e "s/{ISOFT}/4/" -e "s/{ICOAL_METHOD}/1/" -e "s/{ISHLF}/0/" \
+        -e "s/{HIJING_SEED}/$SEED/" -e "s/{ZPC_SEED}/$ZPC_SEED/" $TEMPLATE |
+    awk -v proj=$proj -v targ=$targ -v parj41=$parj41 -v grid=$grid '
+        NR==3  { printf "%-16s! PROJ\n", proj; next }
+        NR==4  { printf "%-16s! TARG\n", targ; next }
+        NR==15 { print parj41 "\t\t! PARJ(41)"; next }
+        NR==31 { print "0\t\t! ihjsed: HIJING seed from the next line"; next }
+        NR==53 { print grid "\t\t! ZPC cell grid"; next }
+        { print }' > $out
+}
+
+# 运行一次，输出 "碰撞数 CPU秒": <目录> <可执行文件>
+run_one() {
+    local dir=$1 bin=$2
+    # ihjsed=0: 标准输入的种子不被使用
+    ( cd $dir && echo 0 | AMPT_TIMING=1 $bin > ampt.log 2>&1 )
+    if [ ! -f $dir/ana/zpc.res ]; then
+        echo "0 0"
+        return
+    fi
+    awk '/collisions between particles/ { c += $NF }
+         /cpu time in zpc/ { t += $NF }
+         END { printf "%d %.3f\n", c, t }' $dir/ana/zpc.res
+}
+
+printf "%-10s %8s %12s %10s %12s %10s %12s %8s %s\n" \
+    system grid collisions cpu_s coll_per_s cell_x cell_z speedup zpc.dat
+ROWS="0 1"
+[ -n "$AMPT_REF" ] && ROWS="ref 0 1"
+for sys in $SYSTEMS; do
+    base_rate=""
+    base_dir=""
+    dirs=""
+    for row in $ROWS; do
+        bin=$AMPT_BIN
+        grid=$row
+        [ $row = ref ] && bin=$AMPT_REF && grid=0
+        dir=$(mktemp -d /tmp/bench_zpc_${sys}_${row}_XXXX)
+        dirs="$dirs $dir"
+        mkdir -p $dir/ana
+        make_input $sys $grid $dir/input.ampt || exit 1
+        read coll cpu <<< "$(run_one $dir $bin)"
+        if [ "$coll" = 0 ]; then
+            echo "错误: $sys $row 运行失败，见 $dir/ampt.log"
+            continue
+        fi
+        # 固定网格不记录单元格大小
+        sizes=$(grep "cell sizes" $dir/ana/zpc.res | tail -1 | awk '{print $(NF-2), $NF}')
+        [ -z "$sizes" ] && sizes="1.500 0.700"
+        rate=$(awk -v c=$coll -v t=$cpu 'BEGIN { printf "%.0f", (t > 0 ? c / t : 0) }')
+        if [ -z "$base_dir" ]; then
+            base_rate=$rate
+            base_dir=$dir
+            speedup=1.00
+            same=-
+        else
+            speedup=$(awk -v a=$rate -v b=$base_rate 'BEGIN { printf "%.2f", (b > 0 ? a / b : 0) }')
+            cmp -s $dir/ana/zpc.dat $base_dir/ana/zpc.dat && same=same || same=differs
+        fi
+        printf "%-10s %8s %12d %10.2f %12d %10.3f %12.3f %8s %s\n" \
+            $sys $row $coll $cpu $rate $sizes $speedup $same
+    done
+    [ -z "$KEEP" ] && rm -rf $dirs
+done
@@ -0,0 +1,106 @@
+#include "checkpoint.h"
+#include <iostream>
+#include <cstdio>
+#include <vector>
+#include "TKey.h"
+#include "TSystem.h"
+
+using namespace std;
+
+string CheckpointStateFile(int event) {
+    return string(CKPT_DIR) + "/state_" + to_string(event) + ".root";
+}
+
+void CheckpointTree(TTree* tree) {
+    if (!tree || !tree->GetDirectory()) return;
+    TDirectory* saved = gDirectory;
+    tree->GetDirectory()->cd();
+    tree->AutoSave("SaveSelf;FlushBaskets");
+    if (saved) saved->cd();
+}
+
+// Old files moved aside by RestoreTree in this run
+static vector<string> g_parked;
+
+// Where RestoreTree keeps the old file while copying from it
+static string ParkedFile(const string& filename) {
+    size_t slash = filename.find_last_of('/');
+    return string(CKPT_DIR) + "/" +
+           (slash == string::npos ? filename : filename.substr(slash + 1));
+}
+
+TTree* RestoreTree(const string& filename, const string& treeName,
+                   Long64_t entries, TFile*& file) {
+    file = nullptr;
+    string parked = ParkedFile(filename);
+    // A parked file left by an interrupted restart is the one to copy from
+    if (gSystem->AccessPathName(parked.c_str()) &&
+        rename(filename.c_str(), parked.c_str()) != 0) {
+        cerr << "ERROR: Cannot move " << filename << " to " << parked << endl;
+        return nullptr;
+    }
+
+    TFile* src = TFile::Open(parked.c_str(), "READ");
+    if (!src || src->IsZombie()) {
+        cerr << "ERROR: Cannot open " << parked << endl;
+        delete src;
+        return nullptr;
+    }
+    // Smallest recovery point that covers the checkpoint
+    TTree* best = nullptr;
+    TIter next(src->GetListOfKeys());
+    while (TKey* key = (TKey*)next()) {
+        if (treeName != key->GetName()) continue;
+        TTree* t = dynamic_cast<TTree*>(key->ReadObj());
+        if (!t) continue;
+        if (t->GetEntries() >= entries && (!best || t->GetEntries() < best->GetEntries())) {
+            delete best;
+            best = t;
+        } else {
+            delete t;
+        }
+    }
+    if (!best) {
+        cerr << "ERROR: " << parked << " has no " << treeName << " tree with "
+             << entries << " entries" << endl;
+        src->Close();
+        delete src;
+        return nullptr;
+    }
+
+    file = new TFile(filename.c_str(), "RECREATE");
+    if (file->IsZombie()) {
+        cerr << "ERROR: Cannot create " << filename << endl;
+        delete file;
+        file = nullptr;
+        src->Close();
+        delete src;
+        return nullptr;
+    }
+    file->cd();
+    TTree* tree = best->CloneTree(entries);
+    tree->AutoSave("SaveSelf;FlushBaskets");
+    src->Close();
+    delete src;
+    file->cd();
+
+    // Kept until the restarted run commits a checkpoint of its own
+    g_parked.push_back(parked);
+    cout << "Restored " << filename << ": " << tree->GetEntries() << " entries of "
+         << treeName << endl;
+    return tree;
+}
+
+void RemoveParkedFiles() {
+    for (const string& parked : g_parked) remove(parked.c_str());
+    g_parked.clear();
+}
+
+void BindBranch(TTree* tree, bool restored, const char* name, void* address,
+                const char* leaflist) {
+    if (restored) {
+        tree->SetBranchAddress(name, address);
+    } else {
+        tree->Branch(name, address, leaflist);
+    }
+}
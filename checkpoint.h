@@ -0,0 +1,52 @@
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+// Restart checkpoints of the ROOT outputs (ickpt in input.ampt, "ampt -r")
+//
+// Every ickpt events CKPSAV (amptsub.f) calls ckpt_root_save_, which makes
+// each output tree and sidecar index recoverable at its current entry count
+// (TTree::AutoSave with FlushBaskets) and writes those counts, the skim
+// counters and the AnalysisCore histograms to ana/ckpt/state_<event>.root.
+// The Fortran manifest ana/ckpt/ampt.ckpt, committed afterwards, names the
+// event whose state file is complete.
+//
+// On restart RestoreTree moves the old output file into ana/ckpt/ and copies
+// the first <entries> entries of its tree into a new file at the original
+// path, which the writers then keep filling.  Any recovery point with at
+// least that many entries will do, so neither a later AutoSave nor a crash
+// halfway through one gets in the way.  The moved file is kept until the
+// restarted run commits its next checkpoint (or ends); if the restart itself
+// is interrupted before that, the next one copies from the moved file again.
+//
+// Checkpoints require iseedev=1: with per-event seeds the events after the
+// restart point are the same as in an uninterrupted run.
+
+#include <string>
+#include "TFile.h"
+#include "TTree.h"
+
+// Checkpoint files: manifest (Fortran), state files, parked outputs
+const char* const CKPT_DIR = "ana/ckpt";
+
+// ana/ckpt/state_<event>.root
+std::string CheckpointStateFile(int event);
+
+// Make the tree recoverable at its current entry count
+void CheckpointTree(TTree* tree);
+
+// Reopen filename with the first `entries` entries of treeName for appending.
+// Returns the tree in the new file (current directory on return), or nullptr
+// with file = nullptr if no recovery point of the old file covers `entries`
+TTree* RestoreTree(const std::string& filename, const std::string& treeName,
+                   Long64_t entries, TFile*& file);
+
+// Delete the old files moved aside by RestoreTree, once a checkpoint of the
+// restarted run (or its end) no longer needs them
+void RemoveParkedFiles();
+
+// Create the leaf-list branch of a new tree, or attach the address to the
+// existing branch of a restored one
+void BindBranch(TTree* tree, bool restored, const char* name, void* address,
+                const char* leaflist);
+
+#endif // CHECKPOINT_H
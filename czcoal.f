@@ -81,7 +81,7 @@ c     Method 1: Classic sequential coalescence (original coales)
 c-----------------------------------------------------------------------
       SUBROUTINE CZCOAL_CLASSIC()
 c
-      PARAMETER (MAXSTR=150001)
+      PARAMETER (MAXSTR=150001, MAXPTN=400001, NGMAX=40)
       implicit double precision (a-h, o-z)
       DOUBLE PRECISION  gxp,gyp,gzp,ftp,pxp,pyp,pzp,pep,pmp
       DOUBLE PRECISION  drlocl,dplocl
@@ -100,11 +100,23 @@ c
       common /loclco/gxp(3),gyp(3),gzp(3),ftp(3),
      1     pxp(3),pyp(3),pzp(3),pep(3),pmp(3)
       COMMON/HJJET2/NSG
+      common /czcgrd/ icgrid
+      common /czindx/ cgx(MAXPTN),cgy(MAXPTN),cge(MAXPTN),
+     1     xglo,yglo,eglo,rgdx,rgdy,rgde,ngd,nstamp,ncand,
+     2     igcel(MAXPTN),ignext(MAXPTN),igprev(MAXPTN),
+     3     igmark(MAXPTN),icand(MAXPTN),ighead(NGMAX**3)
       SAVE
 c
       do 1001 ISG=1, NSG
          IOVER(ISG)=0
  1001 continue
+c     index the strings for the partner searches:
+      if(icgrid.eq.1) then
+         do ISG=1,NSG
+            call czcoal_grid_str(ISG)
+         enddo
+         call czcoal_grid_build(NSG)
+      endif
 C1     meson q coalesce with all available qbar:
       do 150 ISG=1,NSG
          if(NJSGS(ISG).ne.2.or.IOVER(ISG).eq.1) goto 150
@@ -131,7 +143,9 @@ c     dp0^2 defined as (p1+p2)^2-(m1+m2)^2:
          dp0=dsqrt(2*(pep(1)*pep(2)-pxp(1)*pxp(2)
      &        -pyp(1)*pyp(2)-pzp(1)*pzp(2)-pmp(1)*pmp(2)))
 c
-         do 120 JSG=1,NSG
+         call czcoal_cands(1,ISG,1,0)
+         do 120 KC=1,ncand
+            JSG=icand(KC)
 c     skip default or unavailable antiquarks:
             if(JSG.eq.ISG.or.IOVER(JSG).eq.1) goto 120
             if(NJSGS(JSG).eq.2) then
@@ -169,10 +183,14 @@ c     q_isg coalesces with qbar_jsg:
                   dp0=dplocl
                   dr0=drlocl
                   call czcoal_exchge(isg,2,jsg,ip)
+                  call czcoal_cands_exch(isg,jsg)
                endif
  100        continue
  120     continue
-         if(dp0.le.dpcoal.and.dr0.le.drcoal) IOVER(ISG)=1
+         if(dp0.le.dpcoal.and.dr0.le.drcoal) then
+            IOVER(ISG)=1
+            if(icgrid.eq.1) call czcoal_grid_del(ISG)
+         endif
  150  continue
 c
 C2     meson qbar coalesce with all available q:
@@ -195,7 +213,9 @@ C     DETERMINE CURRENT RELATIVE DISTANCE AND MOMENTUM:
          dp0=dsqrt(2*(pep(1)*pep(2)-pxp(1)*pxp(2)
      &        -pyp(1)*pyp(2)-pzp(1)*pzp(2)-pmp(1)*pmp(2)))
 c
-         do 220 JSG=1,NSG
+         call czcoal_cands(2,ISG,1,0)
+         do 220 KC=1,ncand
+            JSG=icand(KC)
             if(JSG.eq.ISG.or.IOVER(JSG).eq.1) goto 220
             if(NJSGS(JSG).eq.2) then
                ipmin=1
@@ -232,10 +252,14 @@ c     qbar_isg coalesces with q_jsg:
                   dp0=dplocl
                   dr0=drlocl
                   call czcoal_exchge(isg,1,jsg,ip)
+                  call czcoal_cands_exch(isg,jsg)
                endif
  200        continue
  220     continue
-         if(dp0.le.dpcoal.and.dr0.le.drcoal) IOVER(ISG)=1
+         if(dp0.le.dpcoal.and.dr0.le.drcoal) then
+            IOVER(ISG)=1
+            if(icgrid.eq.1) call czcoal_grid_del(ISG)
+         endif
  250  continue
 c
 C3     baryon q (antibaryon qbar) coalesce with all available q (qbar):
@@ -273,7 +297,9 @@ c
          dp1(3)=dsqrt(2*(pep(1)*pep(2)-pxp(1)*pxp(2)
      &        -pyp(1)*pyp(2)-pzp(1)*pzp(2)-pmp(1)*pmp(2)))
 c
-         do 320 JSG=1,NSG
+         call czcoal_cands(3,ISG,1,0)
+         do 320 KC=1,ncand
+            JSG=icand(KC)
             if(JSG.eq.ISG.or.IOVER(JSG).eq.1) goto 320
             if(NJSGS(JSG).eq.2) then
                if(ibaryn.gt.0) then
@@ -327,12 +353,15 @@ c     q_isg may coalesce with q_jsg for a baryon:
                   dp1(ipi)=dplocl
                   dr1(ipi)=drlocl
                   call czcoal_exchge(isg,ipi,jsg,ip)
+                  call czcoal_cands_exch(isg,jsg)
                endif
  300        continue
  320     continue
          if((dp1(2).le.dpcoal.and.dr1(2).le.drcoal)
-     1        .and.(dp1(3).le.dpcoal.and.dr1(3).le.drcoal))
-     2        IOVER(ISG)=1
+     1        .and.(dp1(3).le.dpcoal.and.dr1(3).le.drcoal)) then
+            IOVER(ISG)=1
+            if(icgrid.eq.1) call czcoal_grid_del(ISG)
+         endif
  350  continue
 c
       RETURN
@@ -500,7 +529,7 @@ c     newHF B/M competition coalescence algorithm (simplified)
 c     Adapted from newHF coales subroutine
 c
       implicit double precision (a-h, o-z)
-      PARAMETER (MAXSTR=150001, MAXPTN=400001, drbig=1d9)
+      PARAMETER (MAXSTR=150001, MAXPTN=400001, drbig=1d9, NGMAX=40)
       DOUBLE PRECISION  gxp,gyp,gzp,ftp,pxp,pyp,pzp,pep,pmp
       INTEGER  K1SGS,K2SGS,NJSGS,NSG,ITYP5
       DOUBLE PRECISION  GX5, GY5, GZ5, FT5, PX5, PY5, PZ5, E5, XMASS5
@@ -526,6 +555,12 @@ c
       common /para7/ ioscar,nsmm0,nsmb0,nsmab0,nsmm1,nsmb1,nsmab1
       common /czcoal_params/dpcoal,drcoal,ecritl,drbmRatio,
      1     mesonBaryonRatio,icoal_method
+      common /czcgrd/ icgrid
+      common /czbmdm/ nbmdom
+      common /czindx/ cgx(MAXPTN),cgy(MAXPTN),cge(MAXPTN),
+     1     xglo,yglo,eglo,rgdx,rgdy,rgde,ngd,nstamp,ncand,
+     2     igcel(MAXPTN),ignext(MAXPTN),igprev(MAXPTN),
+     3     igmark(MAXPTN),icand(MAXPTN),ighead(NGMAX**3)
       SAVE
 
 c     Initialize
@@ -540,11 +575,40 @@ c     Initialize
 c     First sort partons by freeze-out time
       call czcoal_parORD()
 
+c     Hadrons formed inside the space-time rapidity slabs come first,
+c     the loop below pairs the remaining partons
+      if(nbmdom.ge.2) call czcoal_bmdom_run(nq,nqbar,isg,IOVER)
+
+c     Index the partons for the partner searches
+      if(icgrid.eq.1) then
+         do ip=1,mul
+            cgx(ip)=gx5(ip)
+            cgy(ip)=gy5(ip)
+            cge(ip)=czcoal_etas(ft5(ip),gz5(ip))
+         enddo
+         call czcoal_grid_build(mul)
+         do ip=1,mul
+            if(IOVER(ip).eq.1) call czcoal_grid_del(ip)
+         enddo
+      endif
+
 c     Main loop over partons
       do 350 ip1=1,mul-1
 c        Skip used partons
          if(IOVER(ip1).eq.1) goto 350
          IOVER(ip1)=1
+         if(icgrid.eq.1) call czcoal_grid_del(ip1)
+
+c        Candidate partners: at least one antiquark (quark) and two
+c        more quarks (antiquarks) for a quark (antiquark), if left
+         if(ITYP5(ip1).gt.0) then
+            nopp=nqbar
+            nsame=nq-1
+         else
+            nopp=nq
+            nsame=nqbar-1
+         endif
+         call czcoal_cands(4,ip1,min(1,nopp),min(2,max(0,nsame)))
 
 
 c        Load first parton data
@@ -563,7 +627,8 @@ c        Load first parton data
 
 c        Find best meson partner
          ip2m=0
-         do 120 ip2=ip1+1,mul
+         do 120 kc=1,ncand
+            ip2=icand(kc)
             if(IOVER(ip2).eq.1) goto 120
 c           Check if opposite charge (meson condition)
             if((ITYP5(ip1)*ITYP5(ip2)).ge.0) goto 120
@@ -597,7 +662,8 @@ c           Update best meson candidate
 
 c        Find best baryon partners
          ip2b0=0
-         do 130 ip2=ip1+1,mul
+         do 130 kc=1,ncand
+            ip2=icand(kc)
             if(IOVER(ip2).eq.1) goto 130
 c           Check if same charge (baryon condition)
             if((ITYP5(ip1)*ITYP5(ip2)).lt.0) goto 130
@@ -646,7 +712,8 @@ c           Find third baryon partner and compete with meson
 
             drAvg0=drbig
             ip3b0=0
-            do 140 ip3=ip1+1,mul
+            do 140 kc=1,ncand
+               ip3=icand(kc)
                if(IOVER(ip3).eq.1.or.(ITYP5(ip1)*ITYP5(ip3)).lt.0
      1            .or.ip3.eq.ip2b0) goto 140
 
@@ -693,6 +760,7 @@ c        Form hadron
          if(npmb.eq.2) then
 c           Form meson
             IOVER(ip2m)=1
+            if(icgrid.eq.1) call czcoal_grid_del(ip2m)
             call czcoal_setPtoH(isg,npmb,ip1,ip2m,0)
             nsmm1=nsmm1+1
             nq=nq-1
@@ -701,6 +769,10 @@ c           Form meson
 c           Form baryon
             IOVER(ip2b0)=1
             IOVER(ip3b0)=1
+            if(icgrid.eq.1) then
+               call czcoal_grid_del(ip2b0)
+               call czcoal_grid_del(ip3b0)
+            endif
             call czcoal_setPtoH(isg,npmb,ip1,ip2b0,ip3b0)
             if(ITYP5(ip1).gt.0) then
                nsmb1=nsmb1+1
@@ -1187,6 +1259,7 @@ c     Initialize
       nmeson = 0
       nbaryon = 0
       nantibaryon = 0
+      call czcoal_rand_index(IORDER)
 
 c     Main coalescence loop - process in random order
       do ip=1,MUL
@@ -1426,35 +1499,32 @@ c-----------------------------------------------------------------------
       SUBROUTINE czcoal_find_meson_partner(ip1, IORDER, IUSED,
      1     ip2, found_partner)
 c
-c     Find partner for meson formation
+c     Find partner for meson formation: the first unused parton of
+c     opposite charge in the shuffled order
 c
       PARAMETER (MAXPTN=400001)
       implicit double precision (a-h, o-z)
       INTEGER IORDER(*), IUSED(*), ip1, ip2, ITYP5
+      INTEGER czcoal_rand_next
       logical found_partner
       COMMON /prec2/GX5(MAXPTN),GY5(MAXPTN),GZ5(MAXPTN),FT5(MAXPTN),
      &     PX5(MAXPTN), PY5(MAXPTN), PZ5(MAXPTN), E5(MAXPTN),
      &     XMASS5(MAXPTN), ITYP5(MAXPTN)
-      COMMON /PARA1/ MUL
+      common /czrlst/ lrq(MAXPTN),lnx(MAXPTN+1),nrq,nrl
       SAVE
 
       found_partner = .false.
       ip2 = 0
 
 c     Look for opposite charge partner in random order
-      do i=1,MUL
-         if(IUSED(IORDER(i)).eq.1) goto 10
-         if(IORDER(i).eq.ip1) goto 10
-
-c        Check if opposite charge (meson condition)
-         if((ITYP5(ip1)*ITYP5(IORDER(i))).lt.0) then
-            ip2 = IORDER(i)
-            found_partner = .true.
-            return
-         endif
-
- 10      continue
-      enddo
+      if(ITYP5(ip1).gt.0) then
+         k=czcoal_rand_next(nrq+1, nrl, IUSED)
+         if(k.le.nrl) ip2 = lrq(k)
+      elseif(ITYP5(ip1).lt.0) then
+         k=czcoal_rand_next(1, nrq, IUSED)
+         if(k.le.nrq) ip2 = lrq(k)
+      endif
+      found_partner = (ip2.ne.0)
 
       return
       end
@@ -1463,16 +1533,18 @@ c-----------------------------------------------------------------------
       SUBROUTINE czcoal_find_baryon_partners(ip1, IORDER, IUSED,
      1     ip2, ip3, found_partner)
 c
-c     Find two partners for baryon formation
+c     Find two partners for baryon formation: the first two unused
+c     partons of the same charge in the shuffled order
 c
       PARAMETER (MAXPTN=400001)
       implicit double precision (a-h, o-z)
       INTEGER IORDER(*), IUSED(*), ip1, ip2, ip3, ITYP5
+      INTEGER czcoal_rand_next
       logical found_partner
       COMMON /prec2/GX5(MAXPTN),GY5(MAXPTN),GZ5(MAXPTN),FT5(MAXPTN),
      &     PX5(MAXPTN), PY5(MAXPTN), PZ5(MAXPTN), E5(MAXPTN),
      &     XMASS5(MAXPTN), ITYP5(MAXPTN)
-      COMMON /PARA1/ MUL
+      common /czrlst/ lrq(MAXPTN),lnx(MAXPTN+1),nrq,nrl
       SAVE
 
       found_partner = .false.
@@ -1480,23 +1552,873 @@ c
       ip3 = 0
 
 c     Look for two same-charge partners
+      if(ITYP5(ip1).gt.0) then
+         kmin=1
+         kmax=nrq
+      elseif(ITYP5(ip1).lt.0) then
+         kmin=nrq+1
+         kmax=nrl
+      else
+         return
+      endif
+      k=czcoal_rand_next(kmin, kmax, IUSED)
+      if(k.gt.kmax) return
+      ip2 = lrq(k)
+      k=czcoal_rand_next(k+1, kmax, IUSED)
+      if(k.gt.kmax) return
+      ip3 = lrq(k)
+      found_partner = .true.
+
+      return
+      end
+
+c-----------------------------------------------------------------------
+      SUBROUTINE czcoal_rand_index(IORDER)
+c
+c     Quarks (1..nrq) and antiquarks (nrq+1..nrl) in the shuffled
+c     order, with skip pointers over used partons for the searches
+c
+      PARAMETER (MAXPTN=400001)
+      implicit double precision (a-h, o-z)
+      INTEGER IORDER(*), ITYP5
+      COMMON /prec2/GX5(MAXPTN),GY5(MAXPTN),GZ5(MAXPTN),FT5(MAXPTN),
+     &     PX5(MAXPTN), PY5(MAXPTN), PZ5(MAXPTN), E5(MAXPTN),
+     &     XMASS5(MAXPTN), ITYP5(MAXPTN)
+      COMMON /PARA1/ MUL
+      common /czrlst/ lrq(MAXPTN),lnx(MAXPTN+1),nrq,nrl
+      SAVE
+
+      nrq = 0
       do i=1,MUL
-         if(IUSED(IORDER(i)).eq.1) goto 20
-         if(IORDER(i).eq.ip1) goto 20
+         if(ITYP5(IORDER(i)).gt.0) then
+            nrq = nrq + 1
+            lrq(nrq) = IORDER(i)
+         endif
+      enddo
+      nrl = nrq
+      do i=1,MUL
+         if(ITYP5(IORDER(i)).lt.0) then
+            nrl = nrl + 1
+            lrq(nrl) = IORDER(i)
+         endif
+      enddo
+      do k=1,nrl+1
+         lnx(k) = k
+      enddo
 
-c        Check if same charge (baryon condition)
-         if((ITYP5(ip1)*ITYP5(IORDER(i))).gt.0) then
-            if(ip2.eq.0) then
-               ip2 = IORDER(i)
+      return
+      end
+
+c-----------------------------------------------------------------------
+      INTEGER FUNCTION czcoal_rand_next(kmin, kmax, IUSED)
+c
+c     First list position in kmin..kmax holding an unused parton
+c     (kmax+1 if none); used partons never become unused again, so
+c     the skip pointers are shortened along the way
+c
+      PARAMETER (MAXPTN=400001)
+      implicit double precision (a-h, o-z)
+      INTEGER IUSED(*)
+      common /czrlst/ lrq(MAXPTN),lnx(MAXPTN+1),nrq,nrl
+      SAVE
+
+      k = kmin
+ 10   if(k.le.kmax) then
+         if(IUSED(lrq(k)).eq.1) then
+            if(lnx(k).eq.k) lnx(k) = k + 1
+            k = lnx(k)
+            goto 10
+         endif
+      endif
+      kend = min(k, kmax + 1)
+c     point every visited position directly at the result:
+      j = kmin
+ 20   if(j.lt.kend) then
+         jn = lnx(j)
+         lnx(j) = kend
+         j = jn
+         goto 20
+      endif
+      czcoal_rand_next = kend
+
+      return
+      end
+
+c-----------------------------------------------------------------------
+c     Phase-space grid for the partner searches (ICGRID=1)
+c-----------------------------------------------------------------------
+c     Items (strings for the classic method, partons for B/M
+c     competition) are binned on a grid in (x, y, eta_s) of their
+c     freeze-out points.  czcoal_cands visits shells of cells around
+c     the reference item until enough partners of the wanted kind are
+c     found, then one more shell, and returns them in ascending order;
+c     the callers apply the usual distance cuts and tie-breaking to
+c     this candidate list.  With ICGRID=0 the list holds all items.
+c-----------------------------------------------------------------------
+      SUBROUTINE czcoal_grid_build(n)
+c
+c     Bin items 1..n at the coordinates cgx, cgy, cge
+c
+      implicit double precision (a-h, o-z)
+      PARAMETER (MAXPTN=400001, NGMAX=40)
+      common /czindx/ cgx(MAXPTN),cgy(MAXPTN),cge(MAXPTN),
+     1     xglo,yglo,eglo,rgdx,rgdy,rgde,ngd,nstamp,ncand,
+     2     igcel(MAXPTN),ignext(MAXPTN),igprev(MAXPTN),
+     3     igmark(MAXPTN),icand(MAXPTN),ighead(NGMAX**3)
+      SAVE
+
+      xghi=-1d30
+      yghi=-1d30
+      eghi=-1d30
+      xglo=1d30
+      yglo=1d30
+      eglo=1d30
+      do i=1,n
+         xglo=min(xglo,cgx(i))
+         xghi=max(xghi,cgx(i))
+         yglo=min(yglo,cgy(i))
+         yghi=max(yghi,cgy(i))
+         eglo=min(eglo,cge(i))
+         eghi=max(eghi,cge(i))
+      enddo
+c     about two items per cell:
+      ngd=int((dble(max(n,1))/2d0)**(1d0/3d0))
+      ngd=max(1,min(NGMAX,ngd))
+      rgdx=dble(ngd)/max(xghi-xglo,1d-6)
+      rgdy=dble(ngd)/max(yghi-yglo,1d-6)
+      rgde=dble(ngd)/max(eghi-eglo,1d-6)
+      do ic=1,ngd**3
+         ighead(ic)=0
+      enddo
+      nstamp=0
+      do i=1,n
+         igmark(i)=0
+         igcel(i)=0
+         call czcoal_grid_move(i)
+      enddo
+
+      return
+      end
+
+c-----------------------------------------------------------------------
+      SUBROUTINE czcoal_grid_cell(x,y,e,ix,iy,iz)
+c
+c     Grid cell (0..ngd-1 in each direction) of a point
+c
+      implicit double precision (a-h, o-z)
+      PARAMETER (MAXPTN=400001, NGMAX=40)
+      common /czindx/ cgx(MAXPTN),cgy(MAXPTN),cge(MAXPTN),
+     1     xglo,yglo,eglo,rgdx,rgdy,rgde,ngd,nstamp,ncand,
+     2     igcel(MAXPTN),ignext(MAXPTN),igprev(MAXPTN),
+     3     igmark(MAXPTN),icand(MAXPTN),ighead(NGMAX**3)
+      SAVE
+
+      ix=max(0,min(ngd-1,int(max(0d0,(x-xglo)*rgdx))))
+      iy=max(0,min(ngd-1,int(max(0d0,(y-yglo)*rgdy))))
+      iz=max(0,min(ngd-1,int(max(0d0,(e-eglo)*rgde))))
+
+      return
+      end
+
+c-----------------------------------------------------------------------
+      SUBROUTINE czcoal_grid_move(i)
+c
+c     (Re)insert item i at its current coordinates
+c
+      implicit double precision (a-h, o-z)
+      PARAMETER (MAXPTN=400001, NGMAX=40)
+      common /czindx/ cgx(MAXPTN),cgy(MAXPTN),cge(MAXPTN),
+     1     xglo,yglo,eglo,rgdx,rgdy,rgde,ngd,nstamp,ncand,
+     2     igcel(MAXPTN),ignext(MAXPTN),igprev(MAXPTN),
+     3     igmark(MAXPTN),icand(MAXPTN),ighead(NGMAX**3)
+      SAVE
+
+      call czcoal_grid_cell(cgx(i),cgy(i),cge(i),ix,iy,iz)
+      ic=ix+ngd*(iy+ngd*iz)+1
+      if(ic.eq.igcel(i)) return
+      call czcoal_grid_del(i)
+      igcel(i)=ic
+      igprev(i)=0
+      ignext(i)=ighead(ic)
+      if(ighead(ic).gt.0) igprev(ighead(ic))=i
+      ighead(ic)=i
+
+      return
+      end
+
+c-----------------------------------------------------------------------
+      SUBROUTINE czcoal_grid_del(i)
+c
+c     Remove item i (e.g. a used parton) from the grid
+c
+      implicit double precision (a-h, o-z)
+      PARAMETER (MAXPTN=400001, NGMAX=40)
+      common /czindx/ cgx(MAXPTN),cgy(MAXPTN),cge(MAXPTN),
+     1     xglo,yglo,eglo,rgdx,rgdy,rgde,ngd,nstamp,ncand,
+     2     igcel(MAXPTN),ignext(MAXPTN),igprev(MAXPTN),
+     3     igmark(MAXPTN),icand(MAXPTN),ighead(NGMAX**3)
+      SAVE
+
+      ic=igcel(i)
+      if(ic.eq.0) return
+      if(igprev(i).gt.0) then
+         ignext(igprev(i))=ignext(i)
+      else
+         ighead(ic)=ignext(i)
+      endif
+      if(ignext(i).gt.0) igprev(ignext(i))=igprev(i)
+      igcel(i)=0
+
+      return
+      end
+
+c-----------------------------------------------------------------------
+      SUBROUTINE czcoal_grid_str(isg)
+c
+c     Grid coordinates of string isg: centroid of its partons
+c
+      PARAMETER (MAXSTR=150001, MAXPTN=400001, NGMAX=40)
+      implicit double precision (a-h, o-z)
+      INTEGER  K1SGS,K2SGS,NJSGS
+      COMMON/SOFT/PXSGS(MAXSTR,3),PYSGS(MAXSTR,3),PZSGS(MAXSTR,3),
+     &     PESGS(MAXSTR,3),PMSGS(MAXSTR,3),GXSGS(MAXSTR,3),
+     &     GYSGS(MAXSTR,3),GZSGS(MAXSTR,3),FTSGS(MAXSTR,3),
+     &     K1SGS(MAXSTR,3),K2SGS(MAXSTR,3),NJSGS(MAXSTR)
+      common /czindx/ cgx(MAXPTN),cgy(MAXPTN),cge(MAXPTN),
+     1     xglo,yglo,eglo,rgdx,rgdy,rgde,ngd,nstamp,ncand,
+     2     igcel(MAXPTN),ignext(MAXPTN),igprev(MAXPTN),
+     3     igmark(MAXPTN),icand(MAXPTN),ighead(NGMAX**3)
+      SAVE
+
+      cgx(isg)=0d0
+      cgy(isg)=0d0
+      cge(isg)=0d0
+      np=max(NJSGS(isg),1)
+      do ip=1,NJSGS(isg)
+         cgx(isg)=cgx(isg)+GXSGS(isg,ip)/np
+         cgy(isg)=cgy(isg)+GYSGS(isg,ip)/np
+         cge(isg)=cge(isg)
+     1        +czcoal_etas(FTSGS(isg,ip),GZSGS(isg,ip))/np
+      enddo
+
+      return
+      end
+
+c-----------------------------------------------------------------------
+      SUBROUTINE czcoal_cands_exch(isg,jsg)
+c
+c     Move strings isg and jsg on the grid after a parton exchange
+c
+      implicit double precision (a-h, o-z)
+      common /czcgrd/ icgrid
+      SAVE
+
+      if(icgrid.ne.1) return
+      call czcoal_grid_str(isg)
+      call czcoal_grid_move(isg)
+      call czcoal_grid_str(jsg)
+      call czcoal_grid_move(jsg)
+
+      return
+      end
+
+c-----------------------------------------------------------------------
+      DOUBLE PRECISION FUNCTION czcoal_etas(t,z)
+c
+c     Space-time rapidity, kept finite outside the light cone
+c
+      implicit double precision (a-h, o-z)
+
+      czcoal_etas=0.5d0*dlog(max(t+z,1d-6)/max(t-z,1d-6))
+
+      return
+      end
+
+c-----------------------------------------------------------------------
+      INTEGER FUNCTION czcoal_grid_kind(imode,iref,j)
+c
+c     Kind of partner item j is for item iref: 0 none, 1 or 2
+c     imode 1-3: classic meson q, meson qbar and baryon searches
+c     imode 4:   B/M competition (1 opposite, 2 same charge)
+c
+      PARAMETER (MAXSTR=150001, MAXPTN=400001)
+      implicit double precision (a-h, o-z)
+      INTEGER  K1SGS,K2SGS,NJSGS,ITYP5
+      COMMON/SOFT/PXSGS(MAXSTR,3),PYSGS(MAXSTR,3),PZSGS(MAXSTR,3),
+     &     PESGS(MAXSTR,3),PMSGS(MAXSTR,3),GXSGS(MAXSTR,3),
+     &     GYSGS(MAXSTR,3),GZSGS(MAXSTR,3),FTSGS(MAXSTR,3),
+     &     K1SGS(MAXSTR,3),K2SGS(MAXSTR,3),NJSGS(MAXSTR)
+      COMMON /prec2/GX5(MAXPTN),GY5(MAXPTN),GZ5(MAXPTN),FT5(MAXPTN),
+     &     PX5(MAXPTN), PY5(MAXPTN), PZ5(MAXPTN), E5(MAXPTN),
+     &     XMASS5(MAXPTN), ITYP5(MAXPTN)
+      SAVE
+
+      czcoal_grid_kind=0
+      if(j.eq.iref) return
+      if(imode.eq.4) then
+         if(j.lt.iref) return
+         if((ITYP5(iref)*ITYP5(j)).lt.0) then
+            czcoal_grid_kind=1
+         else
+            czcoal_grid_kind=2
+         endif
+      elseif(NJSGS(j).eq.2) then
+         czcoal_grid_kind=1
+      elseif(NJSGS(j).eq.3) then
+         if(imode.eq.1.and.K2SGS(j,1).lt.0) czcoal_grid_kind=1
+         if(imode.eq.2.and.K2SGS(j,1).gt.0) czcoal_grid_kind=1
+         if(imode.eq.3.and.(K2SGS(iref,1)*K2SGS(j,1)).gt.0)
+     1        czcoal_grid_kind=1
+      endif
+
+      return
+      end
+
+c-----------------------------------------------------------------------
+      SUBROUTINE czcoal_cands(imode,iref,need1,need2)
+c
+c     Candidate partners of item iref into icand(1:ncand), ascending.
+c     With the grid: stop one shell after need1 partners of kind 1 and
+c     need2 of kind 2 have been seen (or when the grid is exhausted).
+c
+      implicit double precision (a-h, o-z)
+      PARAMETER (MAXSTR=150001, MAXPTN=400001, NGMAX=40)
+      INTEGER  czcoal_grid_kind
+      COMMON/HJJET2/NSG
+      COMMON /PARA1/ MUL
+      common /czcgrd/ icgrid
+      common /czindx/ cgx(MAXPTN),cgy(MAXPTN),cge(MAXPTN),
+     1     xglo,yglo,eglo,rgdx,rgdy,rgde,ngd,nstamp,ncand,
+     2     igcel(MAXPTN),ignext(MAXPTN),igprev(MAXPTN),
+     3     igmark(MAXPTN),icand(MAXPTN),ighead(NGMAX**3)
+      INTEGER*8 NWORK
+      COMMON /WRKCNT/ NWORK(12)
+      SAVE
+
+      ncand=0
+      if(icgrid.ne.1) then
+         if(imode.eq.4) then
+            do j=iref+1,MUL
+               ncand=ncand+1
+               icand(ncand)=j
+            enddo
+         else
+            do j=1,NSG
+               ncand=ncand+1
+               icand(ncand)=j
+            enddo
+         endif
+         NWORK(4)=NWORK(4)+ncand
+         return
+      endif
+
+      nstamp=nstamp+1
+      call czcoal_grid_cell(cgx(iref),cgy(iref),cge(iref),jx,jy,jz)
+      n1=0
+      n2=0
+      iextra=0
+      do 50 ir=0,ngd
+c     the shell ir: cells with max(|dx|,|dy|,|dz|)=ir inside the grid
+         do 40 kx=max(0,jx-ir),min(ngd-1,jx+ir)
+            do 40 ky=max(0,jy-ir),min(ngd-1,jy+ir)
+               if(abs(kx-jx).eq.ir.or.abs(ky-jy).eq.ir) then
+                  kzmin=max(0,jz-ir)
+                  kzmax=min(ngd-1,jz+ir)
+                  kzstp=1
+               else
+                  kzmin=jz-ir
+                  kzmax=jz+ir
+                  kzstp=max(2*ir,1)
+               endif
+               do 30 kz=kzmin,kzmax,kzstp
+                  if(kz.lt.0.or.kz.ge.ngd) goto 30
+                  j=ighead(kx+ngd*(ky+ngd*kz)+1)
+ 20               if(j.gt.0) then
+                     if(igmark(j).ne.nstamp) then
+                        igmark(j)=nstamp
+                        kind=czcoal_grid_kind(imode,iref,j)
+                        if(kind.gt.0) then
+                           ncand=ncand+1
+                           icand(ncand)=j
+                           if(kind.eq.1) n1=n1+1
+                           if(kind.eq.2) n2=n2+1
+                        endif
+                     endif
+                     j=ignext(j)
+                     goto 20
+                  endif
+ 30            continue
+ 40      continue
+         if(n1.ge.need1.and.n2.ge.need2) iextra=iextra+1
+         if(iextra.eq.2) goto 60
+ 50   continue
+ 60   call czcoal_isort(icand,ncand)
+c     work counters (wrkcnt.f):
+      NWORK(4)=NWORK(4)+ncand
+
+      return
+      end
+
+c-----------------------------------------------------------------------
+      SUBROUTINE czcoal_isort(ia,n)
+c
+c     Heapsort of the integer array ia(1:n) into ascending order
+c
+      implicit double precision (a-h, o-z)
+      INTEGER ia(*)
+
+      if(n.lt.2) return
+      l=n/2+1
+      ir=n
+ 10   if(l.gt.1) then
+         l=l-1
+         it=ia(l)
+      else
+         it=ia(ir)
+         ia(ir)=ia(1)
+         ir=ir-1
+         if(ir.eq.1) then
+            ia(1)=it
+            return
+         endif
+      endif
+      i=l
+      j=l+l
+ 20   if(j.le.ir) then
+         if(j.lt.ir) then
+            if(ia(j).lt.ia(j+1)) j=j+1
+         endif
+         if(it.lt.ia(j)) then
+            ia(i)=ia(j)
+            i=j
+            j=j+j
+         else
+            j=ir+1
+         endif
+         goto 20
+      endif
+      ia(i)=it
+      goto 10
+      end
+
+c-----------------------------------------------------------------------
+c     Domain-parallel B/M competition (NBMDOM>=2)
+c-----------------------------------------------------------------------
+c     The partons are split into NBMDOM slabs of space-time rapidity
+c     with equal numbers of partons.  A parton whose longitudinal
+c     distance tau*|eta_s-eta_b| to a slab boundary eta_b is below
+c     drhalo*max(1,drbmRatio) lies in the halo and is left out; the
+c     others compete as in czcoal_bmcomp_core, but only with partons
+c     of their own slab, one slab per OpenMP thread.  The hadrons are
+c     then stored slab by slab, and the serial loop of
+c     czcoal_bmcomp_core pairs the halo partons and anything a slab
+c     could not place.  The result depends on NBMDOM but not on the
+c     number of threads.
+c-----------------------------------------------------------------------
+      SUBROUTINE czcoal_bmdom_run(nq,nqbar,isg,IOVER)
+c
+c     Run the slabs and store their hadrons from isg+1 on
+c
+      implicit double precision (a-h, o-z)
+      PARAMETER (MAXPTN=400001, MAXDOM=64, drhalo=2d0, minpdm=50)
+      DOUBLE PRECISION  GX5, GY5, GZ5, FT5, PX5, PY5, PZ5, E5, XMASS5
+      double precision  dpcoal,drcoal,ecritl,drbmRatio,mesonBaryonRatio
+      integer nq,nqbar,nsmm1,nsmb1,nsmab1
+      DIMENSION IOVER(MAXPTN)
+      COMMON /prec2/GX5(MAXPTN),GY5(MAXPTN),GZ5(MAXPTN),FT5(MAXPTN),
+     &     PX5(MAXPTN), PY5(MAXPTN), PZ5(MAXPTN), E5(MAXPTN),
+     &     XMASS5(MAXPTN), ITYP5(MAXPTN)
+      COMMON /PARA1/ MUL
+      common /para7/ ioscar,nsmm0,nsmb0,nsmab0,nsmm1,nsmb1,nsmab1
+      common /czcoal_params/dpcoal,drcoal,ecritl,drbmRatio,
+     1     mesonBaryonRatio,icoal_method
+      common /czbmdm/ nbmdom
+      common /czdomw/ deta(MAXPTN),dsrt(MAXPTN),etab(MAXDOM),
+     1     ldom(MAXPTN),ldlist(MAXPTN),kdom(MAXDOM+1),nhdom(MAXDOM),
+     2     ihdom(3,MAXPTN)
+      INTEGER*8 NWORK
+      COMMON /WRKCNT/ NWORK(12)
+      DIMENSION npdom(MAXDOM)
+      SAVE
+
+c     at least minpdm partons per slab, otherwise run serial
+      nd=min(nbmdom,MAXDOM,mul/minpdm)
+      if(nd.lt.2) return
+
+c     slab boundaries at the eta_s quantiles
+      do i=1,mul
+         deta(i)=czcoal_etas(ft5(i),gz5(i))
+         dsrt(i)=deta(i)
+      enddo
+      call czcoal_dsort(dsrt,mul)
+      do id=1,nd-1
+         etab(id)=dsrt((id*mul)/nd)
+      enddo
+
+c     slab of each parton, 0 in the halo
+      dhalo=drhalo*max(1d0,drbmRatio)
+      do id=1,nd+1
+         kdom(id)=0
+      enddo
+      do i=1,mul
+         id=1
+ 10      if(id.lt.nd) then
+            if(deta(i).ge.etab(id)) then
+               id=id+1
+               goto 10
+            endif
+         endif
+         tau=dsqrt(max(ft5(i)**2-gz5(i)**2,0d0))
+         if(id.gt.1) then
+            if(tau*(deta(i)-etab(id-1)).lt.dhalo) id=0
+         endif
+         if(id.gt.0.and.id.lt.nd) then
+            if(tau*(etab(id)-deta(i)).lt.dhalo) id=0
+         endif
+         ldom(i)=id
+         if(id.gt.0) kdom(id+1)=kdom(id+1)+1
+      enddo
+
+c     partons of each slab in ascending (freeze-out) order
+      kdom(1)=1
+      do id=1,nd
+         kdom(id+1)=kdom(id+1)+kdom(id)
+         nhdom(id)=kdom(id)
+      enddo
+      do i=1,mul
+         id=ldom(i)
+         if(id.gt.0) then
+            ldlist(nhdom(id))=i
+            nhdom(id)=nhdom(id)+1
+         endif
+      enddo
+
+c     Slabs touch disjoint parts of IOVER and ihdom
+c$omp parallel do schedule(dynamic,1)
+      do id=1,nd
+         call czcoal_bmdom_one(kdom(id),kdom(id+1)-1,ldlist,IOVER,
+     1        nhdom(id),ihdom,npdom(id))
+      enddo
+c$omp end parallel do
+      do id=1,nd
+         NWORK(4)=NWORK(4)+npdom(id)
+      enddo
+
+c     Store the hadrons in slab order
+      do id=1,nd
+         do k=kdom(id),kdom(id)+nhdom(id)-1
+            ip1=ihdom(1,k)
+            isg=isg+1
+            if(ihdom(3,k).eq.0) then
+               call czcoal_setPtoH(isg,2,ip1,ihdom(2,k),0)
+               nsmm1=nsmm1+1
+               nq=nq-1
+               nqbar=nqbar-1
+            else
+               call czcoal_setPtoH(isg,3,ip1,ihdom(2,k),ihdom(3,k))
+               if(ITYP5(ip1).gt.0) then
+                  nsmb1=nsmb1+1
+                  nq=nq-3
+               else
+                  nsmab1=nsmab1+1
+                  nqbar=nqbar-3
+               endif
+            endif
+         enddo
+      enddo
+
+      return
+      end
+
+c-----------------------------------------------------------------------
+      SUBROUTINE czcoal_bmdom_one(klo,khi,ldlist,IOVER,nhad,ihad,
+     1     npair)
+c
+c     B/M competition among the partons ldlist(klo:khi) of one slab;
+c     hadron k is returned in ihad(1:3,klo+k-1), ihad(3,.)=0 for a
+c     meson, and the partner candidates examined in npair.  Called
+c     from inside a parallel region: no SAVE, no common blocks
+c     written, thread-safe distance functions only.
+c
+      implicit double precision (a-h, o-z)
+      PARAMETER (MAXPTN=400001, drbig=1d9)
+      DOUBLE PRECISION  GX5, GY5, GZ5, FT5, PX5, PY5, PZ5, E5, XMASS5
+      double precision  dpcoal,drcoal,ecritl,drbmRatio,mesonBaryonRatio
+      DIMENSION ldlist(*),IOVER(MAXPTN),ihad(3,*)
+      COMMON /prec2/GX5(MAXPTN),GY5(MAXPTN),GZ5(MAXPTN),FT5(MAXPTN),
+     &     PX5(MAXPTN), PY5(MAXPTN), PZ5(MAXPTN), E5(MAXPTN),
+     &     XMASS5(MAXPTN), ITYP5(MAXPTN)
+      common /czcoal_params/dpcoal,drcoal,ecritl,drbmRatio,
+     1     mesonBaryonRatio,icoal_method
+
+      nql=0
+      nqbl=0
+      do k=klo,khi
+         if(ITYP5(ldlist(k)).gt.0) then
+            nql=nql+1
+         else
+            nqbl=nqbl+1
+         endif
+      enddo
+
+      nhad=0
+      npair=0
+      do 350 k1=klo,khi-1
+         ip1=ldlist(k1)
+         if(IOVER(ip1).eq.1) goto 350
+         npair=npair+(khi-k1)
+         dr0m=drbig
+         dr0b1=drbig
+
+c        Best meson partner
+         ip2m=0
+         do 120 k=k1+1,khi
+            ip2=ldlist(k)
+            if(IOVER(ip2).eq.1) goto 120
+            if((ITYP5(ip1)*ITYP5(ip2)).ge.0) goto 120
+            dp0=dsqrt(2*(e5(ip1)*e5(ip2)-px5(ip1)*px5(ip2)
+     &           -py5(ip1)*py5(ip2)-pz5(ip1)*pz5(ip2)
+     &           -xmass5(ip1)*xmass5(ip2)))
+            if(dp0.gt.dpcoal) goto 120
+            dr0=czcoal_bmdr2(ip1,ip2)
+            if(dr0.lt.dr0m) then
+               dr0m=dr0
+               ip2m=ip2
+            endif
+ 120     continue
+
+c        Best 2nd baryon partner
+         ip2b0=0
+         do 130 k=k1+1,khi
+            ip2=ldlist(k)
+            if(IOVER(ip2).eq.1) goto 130
+            if((ITYP5(ip1)*ITYP5(ip2)).lt.0) goto 130
+            dr0=czcoal_bmdr2(ip1,ip2)
+            if(dr0.lt.dr0b1) then
+               dr0b1=dr0
+               ip2b0=ip2
+            endif
+ 130     continue
+
+c        Decision as in czcoal_bmcomp_core with the slab counts;
+c        npmb=0 leaves ip1 to the serial loop
+         ip3b0=0
+         if(ITYP5(ip1).gt.0.and.nql.eq.2.and.nqbl.gt.0) then
+            npmb=2
+         elseif(ip2b0.eq.0) then
+            npmb=2
+         else
+            drAvg0=drbig
+            do 140 k=k1+1,khi
+               ip3=ldlist(k)
+               if(IOVER(ip3).eq.1.or.(ITYP5(ip1)*ITYP5(ip3)).lt.0
+     1            .or.ip3.eq.ip2b0) goto 140
+               drAvg=czcoal_bmdr3(ip1,ip2b0,ip3)
+               if(drAvg.lt.drAvg0) then
+                  drAvg0=drAvg
+                  ip3b0=ip3
+               endif
+ 140        continue
+            if(drAvg0.lt.drbig.and.dr0m.lt.drbig.and.ip2m.ne.0) then
+               if(drAvg0.lt.(drbmRatio*dr0m)) then
+                  npmb=3
+               else
+                  npmb=2
+               endif
+            elseif(drAvg0.lt.drbig.and.ip3b0.ne.0) then
+               npmb=3
             else
-               ip3 = IORDER(i)
-               found_partner = .true.
-               return
+               npmb=2
             endif
          endif
+         if(npmb.eq.2.and.ip2m.eq.0) goto 350
 
- 20      continue
+         nhad=nhad+1
+         k=klo+nhad-1
+         ihad(1,k)=ip1
+         IOVER(ip1)=1
+         if(npmb.eq.2) then
+            ihad(2,k)=ip2m
+            ihad(3,k)=0
+            IOVER(ip2m)=1
+            nql=nql-1
+            nqbl=nqbl-1
+         else
+            ihad(2,k)=ip2b0
+            ihad(3,k)=ip3b0
+            IOVER(ip2b0)=1
+            IOVER(ip3b0)=1
+            if(ITYP5(ip1).gt.0) then
+               nql=nql-3
+            else
+               nqbl=nqbl-3
+            endif
+         endif
+ 350  continue
+
+      return
+      end
+
+c-----------------------------------------------------------------------
+      DOUBLE PRECISION FUNCTION czcoal_bmdr2(i1,i2)
+c
+c     Thread-safe czcoal_locldr_bmcomp(2,1,2) for partons i1, i2
+c
+      implicit double precision (a-h, o-z)
+      PARAMETER (MAXPTN=400001)
+      DOUBLE PRECISION  GX5, GY5, GZ5, FT5, PX5, PY5, PZ5, E5, XMASS5
+      COMMON /prec2/GX5(MAXPTN),GY5(MAXPTN),GZ5(MAXPTN),FT5(MAXPTN),
+     &     PX5(MAXPTN), PY5(MAXPTN), PZ5(MAXPTN), E5(MAXPTN),
+     &     XMASS5(MAXPTN), ITYP5(MAXPTN)
+
+      etot=e5(i1)+e5(i2)
+      bex=(px5(i1)+px5(i2))/etot
+      bey=(py5(i1)+py5(i2))/etot
+      bez=(pz5(i1)+pz5(i2))/etot
+      call czcoal_boost(ft5(i1),gx5(i1),gy5(i1),gz5(i1),bex,bey,bez,
+     1     t1,x1,y1,z1)
+      call czcoal_boost(e5(i1),px5(i1),py5(i1),pz5(i1),bex,bey,bez,
+     1     e1,q1x,q1y,q1z)
+      call czcoal_boost(ft5(i2),gx5(i2),gy5(i2),gz5(i2),bex,bey,bez,
+     1     t2,x2,y2,z2)
+      call czcoal_boost(e5(i2),px5(i2),py5(i2),pz5(i2),bex,bey,bez,
+     1     e2,q2x,q2y,q2z)
+
+c     propagate the earlier one to the later freeze-out time
+      if(t1.ge.t2) then
+         dt0=t1-t2
+         x2=x2+q2x/e2*dt0
+         y2=y2+q2y/e2*dt0
+         z2=z2+q2z/e2*dt0
+      else
+         dt0=t2-t1
+         x1=x1+q1x/e1*dt0
+         y1=y1+q1y/e1*dt0
+         z1=z1+q1z/e1*dt0
+      endif
+      czcoal_bmdr2=dsqrt((x1-x2)**2+(y1-y2)**2+(z1-z2)**2)
+
+      return
+      end
+
+c-----------------------------------------------------------------------
+      DOUBLE PRECISION FUNCTION czcoal_bmdr3(i1,i2,i3)
+c
+c     Thread-safe czcoal_locldr_bmcomp(3,0,0): mean pair distance
+c     of partons i1, i2, i3 in their rest frame
+c
+      implicit double precision (a-h, o-z)
+      PARAMETER (MAXPTN=400001)
+      DOUBLE PRECISION  GX5, GY5, GZ5, FT5, PX5, PY5, PZ5, E5, XMASS5
+      dimension ip(3),t(3),x(3),y(3),z(3),e(3),qx(3),qy(3),qz(3)
+      COMMON /prec2/GX5(MAXPTN),GY5(MAXPTN),GZ5(MAXPTN),FT5(MAXPTN),
+     &     PX5(MAXPTN), PY5(MAXPTN), PZ5(MAXPTN), E5(MAXPTN),
+     &     XMASS5(MAXPTN), ITYP5(MAXPTN)
+
+      ip(1)=i1
+      ip(2)=i2
+      ip(3)=i3
+      etot=e5(i1)+e5(i2)+e5(i3)
+      bex=(px5(i1)+px5(i2)+px5(i3))/etot
+      bey=(py5(i1)+py5(i2)+py5(i3))/etot
+      bez=(pz5(i1)+pz5(i2)+pz5(i3))/etot
+      do j=1,3
+         i=ip(j)
+         call czcoal_boost(ft5(i),gx5(i),gy5(i),gz5(i),bex,bey,bez,
+     1        t(j),x(j),y(j),z(j))
+         call czcoal_boost(e5(i),px5(i),py5(i),pz5(i),bex,bey,bez,
+     1        e(j),qx(j),qy(j),qz(j))
+      enddo
+      ft0fom=max(t(1),t(2),t(3))
+      do j=1,3
+         dt0=ft0fom-t(j)
+         x(j)=x(j)+qx(j)/e(j)*dt0
+         y(j)=y(j)+qy(j)/e(j)*dt0
+         z(j)=z(j)+qz(j)/e(j)*dt0
       enddo
+      drlo1=dsqrt((x(1)-x(2))**2+(y(1)-y(2))**2+(z(1)-z(2))**2)
+      drlo2=dsqrt((x(1)-x(3))**2+(y(1)-y(3))**2+(z(1)-z(3))**2)
+      drlo3=dsqrt((x(2)-x(3))**2+(y(2)-y(3))**2+(z(2)-z(3))**2)
+      czcoal_bmdr3=(drlo1+drlo2+drlo3)/3d0
+
+      return
+      end
+
+c-----------------------------------------------------------------------
+      SUBROUTINE czcoal_boost(energy,px,py,pz,bex,bey,bez,
+     1     enew,pxn,pyn,pzn)
+c
+c     lorenz (zpc.f) with the result in the arguments instead of /lor/
+c
+      implicit double precision (a-h, o-z)
+
+      beta2 = bex ** 2 + bey ** 2 + bez ** 2
+      if (beta2 .eq. 0d0) then
+         enew = energy
+         pxn = px
+         pyn = py
+         pzn = pz
+      else
+         if (beta2 .gt. 0.999999999999999d0) then
+            beta2 = 0.999999999999999d0
+         end if
+         gam = 1.d0 / dsqrt(1.d0 - beta2)
+         enew = gam * (energy - bex * px - bey * py - bez * pz)
+         pxn = - gam * bex * energy + (1.d0 
+     &        + (gam - 1.d0) * bex ** 2 / beta2) * px
+     &        + (gam - 1.d0) * bex * bey/beta2 * py
+     &        + (gam - 1.d0) * bex * bez/beta2 * pz     
+         pyn = - gam * bey * energy 
+     &        + (gam - 1.d0) * bex * bey / beta2 * px
+     &        + (1.d0 + (gam - 1.d0) * bey ** 2 / beta2) * py
+     &        + (gam - 1.d0) * bey * bez / beta2 * pz         
+         pzn = - gam * bez * energy
+     &        +  (gam - 1.d0) * bex * bez / beta2 * px
+     &        + (gam - 1.d0) * bey * bez / beta2 * py
+     &        + (1.d0 + (gam - 1.d0) * bez ** 2 / beta2) * pz    
+      endif
 
       return
       end
+
+c-----------------------------------------------------------------------
+      SUBROUTINE czcoal_dsort(a,n)
+c
+c     Heapsort of the array a(1:n) into ascending order
+c
+      implicit double precision (a-h, o-z)
+      DOUBLE PRECISION a(*)
+
+      if(n.lt.2) return
+      l=n/2+1
+      ir=n
+ 10   if(l.gt.1) then
+         l=l-1
+         at=a(l)
+      else
+         at=a(ir)
+         a(ir)=a(1)
+         ir=ir-1
+         if(ir.eq.1) then
+            a(1)=at
+            return
+         endif
+      endif
+      i=l
+      j=l+l
+ 20   if(j.le.ir) then
+         if(j.lt.ir) then
+            if(a(j).lt.a(j+1)) j=j+1
+         endif
+         if(at.lt.a(j)) then
+            a(i)=a(j)
+            i=j
+            j=j+j
+         else
+            j=ir+1
+         endif
+         goto 20
+      endif
+      a(i)=at
+      goto 10
+      end
@@ -0,0 +1,232 @@
+#include "event_index.h"
+#include <iostream>
+#include <sstream>
+#include <algorithm>
+#include <cstdlib>
+#include "TNamed.h"
+#include "checkpoint.h"
+
+using namespace std;
+
+// ===== helpers =====
+string IndexDataFile(const string& indexFile) {
+    size_t slash = indexFile.find_last_of('/');
+    size_t pos = indexFile.find(".index", slash == string::npos ? 0 : slash);
+    if (pos == string::npos) return indexFile;
+    return indexFile.substr(0, pos) + indexFile.substr(pos + 6);
+}
+
+void SetIndexBranchAddresses(TTree* tree, EventIndexEntry& row, bool withFileID) {
+    if (withFileID) tree->SetBranchAddress("fileID", &row.fileID);
+    tree->SetBranchAddress("eventID", &row.eventID);
+    tree->SetBranchAddress("runID", &row.runID);
+    tree->SetBranchAddress("entry", &row.entry);
+    tree->SetBranchAddress("impactParameter", &row.impactParameter);
+    tree->SetBranchAddress("npart1", &row.npart1);
+    tree->SetBranchAddress("npart2", &row.npart2);
+    tree->SetBranchAddress("nParticles", &row.nParticles);
+    tree->SetBranchAddress("nSpecies", &row.nSpecies);
+    tree->SetBranchAddress("nAccepted", row.nAccepted);
+}
+
+static string JoinCodes(const vector<int>& codes) {
+    stringstream ss;
+    for (size_t i = 0; i < codes.size(); i++) {
+        if (i) ss << ",";
+        ss << codes[i];
+    }
+    return ss.str();
+}
+
+static vector<int> SplitCodes(const string& text) {
+    vector<int> codes;
+    stringstream ss(text);
+    string item;
+    while (getline(ss, item, ',')) {
+        if (!item.empty()) codes.push_back(atoi(item.c_str()));
+    }
+    return codes;
+}
+
+// ===== EventIndexWriter =====
+EventIndexWriter::EventIndexWriter() : file(nullptr), tree(nullptr) {}
+
+EventIndexWriter::~EventIndexWriter() {
+    Close();
+}
+
+bool EventIndexWriter::Open(const string& filename, const string& treeName,
+                            const vector<int>& speciesCodes, const vector<string>& speciesNames,
+                            Long64_t restoreEntries) {
+    TDirectory* saved = gDirectory;
+    bool restored = (restoreEntries >= 0);
+    if (restored) {
+        tree = RestoreTree(filename, "event_index", restoreEntries, file);
+    } else {
+        file = new TFile(filename.c_str(), "RECREATE");
+    }
+    if (!file || file->IsZombie()) {
+        std::cerr << "ERROR: Cannot create index file " << filename << std::endl;
+        delete file;
+        file = nullptr;
+        if (saved) saved->cd();
+        return false;
+    }
+
+    // The restored copy holds only the tree; overwrite so a key never gains a second cycle
+    TNamed("tree_name", treeName.c_str()).Write(nullptr, TObject::kOverwrite);
+    TNamed("species", JoinCodes(speciesCodes).c_str()).Write(nullptr, TObject::kOverwrite);
+    string names;
+    for (size_t i = 0; i < speciesNames.size(); i++) names += (i ? "," : "") + speciesNames[i];
+    TNamed("species_names", names.c_str()).Write(nullptr, TObject::kOverwrite);
+
+    if (restored) {
+        SetIndexBranchAddresses(tree, row, false);
+    } else {
+        tree = new TTree("event_index", ("Event index of " + treeName).c_str());
+        tree->Branch("eventID", &row.eventID, "eventID/I");
+        tree->Branch("runID", &row.runID, "runID/I");
+        tree->Branch("entry", &row.entry, "entry/L");
+        tree->Branch("impactParameter", &row.impactParameter, "impactParameter/D");
+        tree->Branch("npart1", &row.npart1, "npart1/I");
+        tree->Branch("npart2", &row.npart2, "npart2/I");
+        tree->Branch("nParticles", &row.nParticles, "nParticles/I");
+        tree->Branch("nSpecies", &row.nSpecies, "nSpecies/I");
+        tree->Branch("nAccepted", row.nAccepted, "nAccepted[nSpecies]/I");
+    }
+
+    // Keep the data trees' directory current for the Fortran writers
+    if (saved) saved->cd();
+    return true;
+}
+
+void EventIndexWriter::Fill(const EventIndexEntry& entry) {
+    if (!tree) return;
+    row = entry;
+    tree->Fill();
+}
+
+void EventIndexWriter::Checkpoint() {
+    CheckpointTree(tree);
+}
+
+void EventIndexWriter::Close() {
+    if (!file) return;
+    TDirectory* saved = gDirectory;
+    bool savedIsIndex = (saved == file);
+    file->cd();
+    tree->Write();
+    file->Close();
+    delete file;
+    file = nullptr;
+    tree = nullptr;
+    if (saved && !savedIsIndex) saved->cd();
+}
+
+// ===== EventIndexReader =====
+bool EventIndexReader::Open(const string& indexFile) {
+    TFile* f = TFile::Open(indexFile.c_str());
+    if (!f || f->IsZombie()) {
+        cerr << "ERROR: Cannot open index " << indexFile << endl;
+        delete f;
+        return false;
+    }
+    TTree* t = (TTree*)f->Get("event_index");
+    if (!t) {
+        cerr << "ERROR: " << indexFile << " has no event_index tree" << endl;
+        f->Close();
+        delete f;
+        return false;
+    }
+    TNamed* tn = (TNamed*)f->Get("tree_name");
+    TNamed* sp = (TNamed*)f->Get("species");
+    tree_name = tn ? tn->GetTitle() : "ampt";
+    species_codes = sp ? SplitCodes(sp->GetTitle()) : vector<int>();
+
+    // Campaign index: file table in index_files; sidecar: the matching data file
+    files.clear();
+    TTree* ft = (TTree*)f->Get("index_files");
+    bool campaign = (ft != nullptr);
+    if (campaign) {
+        Int_t fileID;
+        char path[4096];
+        ft->SetBranchAddress("fileID", &fileID);
+        ft->SetBranchAddress("path", path);
+        for (Long64_t i = 0; i < ft->GetEntries(); i++) {
+            ft->GetEntry(i);
+            if ((int)files.size() <= fileID) files.resize(fileID + 1);
+            files[fileID] = path;
+        }
+    } else {
+        files.push_back(IndexDataFile(indexFile));
+    }
+
+    EventIndexEntry row;
+    SetIndexBranchAddresses(t, row, campaign);
+    rows.clear();
+    rows.reserve(t->GetEntries());
+    for (Long64_t i = 0; i < t->GetEntries(); i++) {
+        t->GetEntry(i);
+        if (!campaign) row.fileID = 0;
+        rows.push_back(row);
+    }
+    f->Close();
+    delete f;
+
+    stable_sort(rows.begin(), rows.end(), [](const EventIndexEntry& a, const EventIndexEntry& b) {
+        return a.impactParameter < b.impactParameter;
+    });
+    return true;
+}
+
+vector<EventIndexEntry> EventIndexReader::Select(const EventQuery& q) const {
+    vector<EventIndexEntry> out;
+    // b window by binary search on the sorted index, other cuts on the slice
+    auto first = lower_bound(rows.begin(), rows.end(), q.bMin,
+                             [](const EventIndexEntry& e, double b) { return e.impactParameter < b; });
+    for (auto it = first; it != rows.end() && it->impactParameter < q.bMax; ++it) {
+        int npart = it->npart1 + it->npart2;
+        if (npart < q.npartMin || npart > q.npartMax) continue;
+        if (it->nParticles < q.nParticlesMin || it->nParticles > q.nParticlesMax) continue;
+        bool ok = true;
+        for (auto& req : q.minAccepted) {
+            if (req.first < 0 || req.first >= it->nSpecies || it->nAccepted[req.first] < req.second) {
+                ok = false;
+                break;
+            }
+        }
+        if (ok) out.push_back(*it);
+    }
+    // Read order: file by file, entries ascending (sequential basket access)
+    sort(out.begin(), out.end(), [](const EventIndexEntry& a, const EventIndexEntry& b) {
+        return a.fileID != b.fileID ? a.fileID < b.fileID : a.entry < b.entry;
+    });
+    return out;
+}
+
+TEntryList* EventIndexReader::SelectEntryList(const EventQuery& q) const {
+    vector<EventIndexEntry> sel = Select(q);
+    TEntryList* list = new TEntryList("index_selection", "Events selected from the event index");
+    list->SetDirectory(nullptr);
+    size_t i = 0;
+    while (i < sel.size()) {
+        int fileID = sel[i].fileID;
+        TEntryList sub("", "", tree_name.c_str(), files[fileID].c_str());
+        for (; i < sel.size() && sel[i].fileID == fileID; i++) sub.Enter(sel[i].entry);
+        list->Add(&sub);
+    }
+    return list;
+}
+
+map<string, vector<pair<Long64_t, Long64_t>>> EventIndexReader::SelectRanges(const EventQuery& q) const {
+    map<string, vector<pair<Long64_t, Long64_t>>> ranges;
+    for (const auto& e : Select(q)) {
+        auto& v = ranges[files[e.fileID]];
+        if (!v.empty() && v.back().second == e.entry) {
+            v.back().second++;
+        } else {
+            v.push_back(make_pair(e.entry, e.entry + 1));
+        }
+    }
+    return ranges;
+}
@@ -0,0 +1,104 @@
+#ifndef EVENT_INDEX_H
+#define EVENT_INDEX_H
+
+// Sidecar event index for fast cross-file event selection
+//
+// Every ROOT writer in root_interface.cpp emits, next to ana/<stream>.root, a
+// small ana/<stream>.index.root holding one row per filled tree entry:
+// eventID, runID, entry, impactParameter, npart1, npart2, nParticles and the
+// AnalysisCore accepted multiplicity per species.  The data file belonging to
+// an index is found by dropping ".index" from its name, which survives the
+// "_jobN" renaming done by the Slurm/Condor scripts
+// (ampt.index_job7.root -> ampt_job7.root).
+//
+// ampt-index-merge combines the sidecars of a campaign into one index sorted
+// by impactParameter; EventIndexReader answers queries on it and returns a
+// TEntryList (for TChain::SetEntryList) or per-file entry ranges, so that a
+// selective read only touches the baskets of the selected entries.
+
+#include <string>
+#include <vector>
+#include <map>
+#include <utility>
+#include "TFile.h"
+#include "TTree.h"
+#include "TEntryList.h"
+
+const int INDEX_MAX_SPECIES = 16;
+
+// One row of the (per-file or campaign) index
+struct EventIndexEntry {
+    Int_t fileID;        // campaign index only (-1 in sidecars)
+    Int_t eventID;
+    Int_t runID;
+    Long64_t entry;
+    Double_t impactParameter;
+    Int_t npart1, npart2;
+    Int_t nParticles;
+    Int_t nSpecies;
+    Int_t nAccepted[INDEX_MAX_SPECIES];
+};
+
+// Writes the sidecar index of one output tree
+class EventIndexWriter {
+private:
+    TFile* file;
+    TTree* tree;
+    EventIndexEntry row;
+
+public:
+    EventIndexWriter();
+    ~EventIndexWriter();
+
+    // restoreEntries >= 0: continue an index of that many rows (checkpoint.h)
+    bool Open(const std::string& filename, const std::string& treeName,
+              const std::vector<int>& speciesCodes, const std::vector<std::string>& speciesNames,
+              Long64_t restoreEntries = -1);
+    void Fill(const EventIndexEntry& entry);
+    // Make the index recoverable at its current row count
+    void Checkpoint();
+    Long64_t GetEntries() const { return tree ? tree->GetEntries() : 0; }
+    void Close();
+};
+
+// Event selection on the index; unset limits are open
+struct EventQuery {
+    double bMin = -1e30, bMax = 1e30;            // impactParameter in [bMin, bMax)
+    int npartMin = -1, npartMax = 1 << 30;       // npart1 + npart2 in [min, max]
+    int nParticlesMin = -1, nParticlesMax = 1 << 30;
+    std::vector<std::pair<int, int>> minAccepted;  // (species index, minimum count)
+};
+
+// Reader API for a campaign index (or a single sidecar)
+class EventIndexReader {
+private:
+    std::string tree_name;
+    std::vector<std::string> files;
+    std::vector<int> species_codes;
+    std::vector<EventIndexEntry> rows;  // sorted by impactParameter
+
+public:
+    bool Open(const std::string& indexFile);
+
+    // Entries matching the query, ordered by (file, entry)
+    std::vector<EventIndexEntry> Select(const EventQuery& q) const;
+
+    // TEntryList with one sub-list per data file, for TChain::SetEntryList
+    TEntryList* SelectEntryList(const EventQuery& q) const;
+
+    // Contiguous [first, last) entry ranges per data file
+    std::map<std::string, std::vector<std::pair<Long64_t, Long64_t>>> SelectRanges(const EventQuery& q) const;
+
+    const std::string& GetTreeName() const { return tree_name; }
+    const std::vector<std::string>& GetFiles() const { return files; }
+    const std::vector<int>& GetSpeciesCodes() const { return species_codes; }
+    size_t GetNEvents() const { return rows.size(); }
+};
+
+// Data file that a sidecar index describes ("x.index_job3.root" -> "x_job3.root")
+std::string IndexDataFile(const std::string& indexFile);
+
+// Attach the index row branches of a sidecar or campaign tree
+void SetIndexBranchAddresses(TTree* tree, EventIndexEntry& row, bool withFileID);
+
+#endif // EVENT_INDEX_H
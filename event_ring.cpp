@@ -0,0 +1,379 @@
+#include "event_ring.h"
+#include <iostream>
+#include <fstream>
+#include <cstring>
+#include <cstdlib>
+#include <algorithm>
+#include <new>
+#include <cerrno>
+#include <csignal>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+using namespace std;
+
+static size_t AlignUp(size_t n) { return (n + 63) & ~size_t(63); }
+
+static size_t SlotBytes(uint32_t maxParticles) {
+    size_t bytes = AlignUp(sizeof(EventSlotHeader));
+    bytes += AlignUp(sizeof(int32_t) * maxParticles);
+    bytes += 8 * AlignUp(sizeof(double) * maxParticles);
+    return bytes;
+}
+
+EventSlotColumns EventRingSlot(void* base, uint32_t nSlots, uint32_t maxParticles,
+                               uint64_t slotBytes, uint64_t seq) {
+    char* p = static_cast<char*>(base) + AlignUp(sizeof(EventRingHeader))
+              + (seq % nSlots) * slotBytes;
+    size_t dcol = AlignUp(sizeof(double) * maxParticles);
+
+    EventSlotColumns c;
+    c.header = reinterpret_cast<EventSlotHeader*>(p);
+    p += AlignUp(sizeof(EventSlotHeader));
+    c.pid = reinterpret_cast<int32_t*>(p);
+    p += AlignUp(sizeof(int32_t) * maxParticles);
+    c.px   = reinterpret_cast<double*>(p); p += dcol;
+    c.py   = reinterpret_cast<double*>(p); p += dcol;
+    c.pz   = reinterpret_cast<double*>(p); p += dcol;
+    c.mass = reinterpret_cast<double*>(p); p += dcol;
+    c.x    = reinterpret_cast<double*>(p); p += dcol;
+    c.y    = reinterpret_cast<double*>(p); p += dcol;
+    c.z    = reinterpret_cast<double*>(p); p += dcol;
+    c.t    = reinterpret_cast<double*>(p);
+    return c;
+}
+
+// ===== Publisher =====
+EventRingPublisher::EventRingPublisher()
+    : base(nullptr), mapped_bytes(0), header(nullptr), truncated_events(0) {}
+
+EventRingPublisher::~EventRingPublisher() {
+    Close();
+}
+
+bool EventRingPublisher::Create(const string& name, const string& stream,
+                                uint32_t nSlots, uint32_t maxParticles) {
+    if (nSlots == 0 || maxParticles == 0) return false;
+    shm_name = name;
+
+    uint64_t slotBytes = SlotBytes(maxParticles);
+    mapped_bytes = AlignUp(sizeof(EventRingHeader)) + nSlots * slotBytes;
+
+    // Start from a fresh segment so stale consumers of an older run detach
+    shm_unlink(name.c_str());
+    int fd = shm_open(name.c_str(), O_CREAT | O_RDWR, 0644);
+    if (fd < 0) {
+        cerr << "WARNING: Cannot create shared memory ring " << name << endl;
+        return false;
+    }
+    if (ftruncate(fd, mapped_bytes) != 0) {
+        cerr << "WARNING: Cannot size shared memory ring " << name << endl;
+        close(fd);
+        shm_unlink(name.c_str());
+        return false;
+    }
+    base = mmap(nullptr, mapped_bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (base == MAP_FAILED) {
+        base = nullptr;
+        shm_unlink(name.c_str());
+        return false;
+    }
+
+    header = new (base) EventRingHeader;
+    header->nSlots = nSlots;
+    header->maxParticles = maxParticles;
+    header->slotBytes = slotBytes;
+    header->writeSeq.store(0, memory_order_relaxed);
+    header->closed.store(0, memory_order_relaxed);
+    header->publisherPid = getpid();
+    memset(header->stream, 0, sizeof(header->stream));
+    strncpy(header->stream, stream.c_str(), sizeof(header->stream) - 1);
+    for (uint32_t i = 0; i < nSlots; i++) {
+        EventSlotColumns c = EventRingSlot(base, nSlots, maxParticles, slotBytes, i);
+        new (c.header) EventSlotHeader;
+        c.header->seq.store(0, memory_order_relaxed);
+    }
+    header->version = EVENT_RING_VERSION;
+    // magic last: consumers only trust a fully initialised header
+    atomic_thread_fence(memory_order_release);
+    header->magic = EVENT_RING_MAGIC;
+
+    cout << "Event ring " << name << " created (" << nSlots << " slots, "
+         << maxParticles << " particles/slot)" << endl;
+    return true;
+}
+
+void EventRingPublisher::Publish(const EventSlotHeader& evt, int nParticles,
+                                 const int* pid, const double* px, const double* py, const double* pz,
+                                 const double* mass, const double* x, const double* y, const double* z,
+                                 const double* t) {
+    if (!header) return;
+
+    uint64_t seq = header->writeSeq.load(memory_order_relaxed);
+    EventSlotColumns c = EventRingSlot(base, header->nSlots, header->maxParticles,
+                                       header->slotBytes, seq);
+
+    int n = nParticles;
+    if (n > (int)header->maxParticles) {
+        n = header->maxParticles;
+        truncated_events++;
+    }
+
+    // Odd sequence number: slot is being rewritten
+    c.header->seq.store(2 * seq + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+
+    c.header->eventID = evt.eventID;
+    c.header->runID = evt.runID;
+    c.header->nParticles = n;
+    c.header->npart1 = evt.npart1;
+    c.header->npart2 = evt.npart2;
+    c.header->nelp = evt.nelp;
+    c.header->ninp = evt.ninp;
+    c.header->nelt = evt.nelt;
+    c.header->ninthj = evt.ninthj;
+    c.header->miss = evt.miss;
+    c.header->impactParameter = evt.impactParameter;
+    c.header->phiRP = evt.phiRP;
+
+    memcpy(c.pid, pid, sizeof(int32_t) * n);
+    memcpy(c.px, px, sizeof(double) * n);
+    memcpy(c.py, py, sizeof(double) * n);
+    memcpy(c.pz, pz, sizeof(double) * n);
+    memcpy(c.mass, mass, sizeof(double) * n);
+    memcpy(c.x, x, sizeof(double) * n);
+    memcpy(c.y, y, sizeof(double) * n);
+    memcpy(c.z, z, sizeof(double) * n);
+    memcpy(c.t, t, sizeof(double) * n);
+
+    c.header->seq.store(2 * seq + 2, memory_order_release);
+    header->writeSeq.store(seq + 1, memory_order_release);
+}
+
+void EventRingPublisher::Close() {
+    if (!header) return;
+    header->closed.store(1, memory_order_release);
+    if (truncated_events > 0) {
+        cerr << "WARNING: " << truncated_events << " events truncated to "
+             << header->maxParticles << " particles in ring " << shm_name << endl;
+    }
+    munmap(base, mapped_bytes);
+    // Attached consumers keep their mapping; new ones can no longer attach
+    shm_unlink(shm_name.c_str());
+    base = nullptr;
+    header = nullptr;
+}
+
+uint64_t EventRingPublisher::GetPublished() const {
+    return header ? header->writeSeq.load(memory_order_relaxed) : 0;
+}
+
+// ===== Consumer =====
+EventRingConsumer::EventRingConsumer()
+    : base(nullptr), mapped_bytes(0), header(nullptr), read_seq(0), overruns(0) {}
+
+EventRingConsumer::~EventRingConsumer() {
+    if (base) munmap(base, mapped_bytes);
+}
+
+bool EventRingConsumer::Attach(const string& name, bool fromStart) {
+    shm_name = name;
+    int fd = shm_open(name.c_str(), O_RDONLY, 0);
+    if (fd < 0) return false;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size < (off_t)sizeof(EventRingHeader)) {
+        close(fd);
+        return false;
+    }
+    mapped_bytes = st.st_size;
+    base = mmap(nullptr, mapped_bytes, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (base == MAP_FAILED) {
+        base = nullptr;
+        return false;
+    }
+
+    header = static_cast<EventRingHeader*>(base);
+    atomic_thread_fence(memory_order_acquire);
+    if (header->magic != EVENT_RING_MAGIC || header->version != EVENT_RING_VERSION) {
+        cerr << "ERROR: " << name << " is not an AMPT event ring" << endl;
+        munmap(base, mapped_bytes);
+        base = nullptr;
+        header = nullptr;
+        return false;
+    }
+
+    uint64_t w = header->writeSeq.load(memory_order_acquire);
+    if (fromStart) {
+        read_seq = (w > header->nSlots) ? w - header->nSlots : 0;
+    } else {
+        read_seq = w;
+    }
+    return true;
+}
+
+// A generator that was killed or crashed never sets closed.  It is gone once
+// its pid no longer exists or is a zombie its parent has not reaped yet.
+static bool PublisherGone(const EventRingHeader* header) {
+    pid_t pid = header->publisherPid;
+    if (kill(pid, 0) != 0) return errno == ESRCH;
+    ifstream stat("/proc/" + to_string(pid) + "/stat");
+    string line;
+    if (!getline(stat, line)) return false;
+    size_t paren = line.rfind(')');
+    return paren != string::npos && paren + 2 < line.size() && line[paren + 2] == 'Z';
+}
+
+bool EventRingConsumer::NextView(EventView& view, bool* finished) {
+    if (finished) *finished = false;
+    if (!header) {
+        if (finished) *finished = true;
+        return false;
+    }
+
+    uint64_t w = header->writeSeq.load(memory_order_acquire);
+    if (read_seq >= w) {
+        // Events published just before the close (or the crash) still count
+        if (finished && (header->closed.load(memory_order_acquire) || PublisherGone(header)) &&
+            read_seq >= header->writeSeq.load(memory_order_acquire)) {
+            *finished = true;
+        }
+        return false;
+    }
+    // Lapped by the generator: the oldest slots were already reused
+    if (w - read_seq > header->nSlots) {
+        overruns += (w - header->nSlots) - read_seq;
+        read_seq = w - header->nSlots;
+    }
+
+    EventSlotColumns c = EventRingSlot(base, header->nSlots, header->maxParticles,
+                                       header->slotBytes, read_seq);
+    uint64_t expected = 2 * read_seq + 2;
+    uint64_t s1 = c.header->seq.load(memory_order_acquire);
+    if (s1 != expected) {
+        // Overwritten while we looked at it, retry from the new position next call
+        overruns++;
+        read_seq++;
+        return false;
+    }
+
+    view.seq = read_seq;
+    view.header = c.header;
+    // nParticles is bounded here, the rest of the slot is checked on release
+    view.nParticles = min(max(c.header->nParticles, 0), (int32_t)header->maxParticles);
+    view.pid = c.pid;
+    view.px = c.px;
+    view.py = c.py;
+    view.pz = c.pz;
+    view.mass = c.mass;
+    view.x = c.x;
+    view.y = c.y;
+    view.z = c.z;
+    view.t = c.t;
+    return true;
+}
+
+bool EventRingConsumer::ReleaseView(const EventView& view) {
+    atomic_thread_fence(memory_order_acquire);
+    uint64_t s2 = view.header->seq.load(memory_order_relaxed);
+    read_seq = view.seq + 1;
+    if (s2 != 2 * view.seq + 2) {
+        overruns++;
+        return false;
+    }
+    return true;
+}
+
+bool EventRingConsumer::Next(EventRecord& rec, bool* finished) {
+    EventView v;
+    if (!NextView(v, finished)) return false;
+
+    int n = v.nParticles;
+    rec.seq = v.seq;
+    rec.header.eventID = v.header->eventID;
+    rec.header.runID = v.header->runID;
+    rec.header.nParticles = n;
+    rec.header.npart1 = v.header->npart1;
+    rec.header.npart2 = v.header->npart2;
+    rec.header.nelp = v.header->nelp;
+    rec.header.ninp = v.header->ninp;
+    rec.header.nelt = v.header->nelt;
+    rec.header.ninthj = v.header->ninthj;
+    rec.header.miss = v.header->miss;
+    rec.header.impactParameter = v.header->impactParameter;
+    rec.header.phiRP = v.header->phiRP;
+    rec.pid.assign(v.pid, v.pid + n);
+    rec.px.assign(v.px, v.px + n);
+    rec.py.assign(v.py, v.py + n);
+    rec.pz.assign(v.pz, v.pz + n);
+    rec.mass.assign(v.mass, v.mass + n);
+    rec.x.assign(v.x, v.x + n);
+    rec.y.assign(v.y, v.y + n);
+    rec.z.assign(v.z, v.z + n);
+    rec.t.assign(v.t, v.t + n);
+
+    return ReleaseView(v);
+}
+
+bool EventRingConsumer::WaitNext(EventRecord& rec, int pollMicroseconds) {
+    bool finished = false;
+    while (true) {
+        if (Next(rec, &finished)) return true;
+        if (finished) return false;
+        usleep(pollMicroseconds);
+    }
+}
+
+string EventRingConsumer::GetStream() const {
+    return header ? string(header->stream) : string();
+}
+
+// ===== Generator-side C interface =====
+static EventRingPublisher* g_rings[RING_NSTREAMS] = {nullptr};
+static const char* kRingStreamNames[RING_NSTREAMS] = {
+    "ampt", "zpc", "parton_initial", "hadron_before_art", "hadron_before_melting"
+};
+
+void event_ring_init() {
+    const char* prefix = getenv("AMPT_SHM_RING");
+    if (!prefix || !*prefix) return;
+
+    uint32_t nSlots = 8;
+    uint32_t maxParticles = 99999;
+    if (const char* s = getenv("AMPT_SHM_SLOTS")) nSlots = max(1, atoi(s));
+    if (const char* s = getenv("AMPT_SHM_MAXP")) maxParticles = max(1, atoi(s));
+
+    string base = prefix;
+    if (base[0] != '/') base = "/" + base;
+    for (int i = 0; i < RING_NSTREAMS; i++) {
+        g_rings[i] = new EventRingPublisher();
+        if (!g_rings[i]->Create(base + "_" + kRingStreamNames[i], kRingStreamNames[i],
+                                nSlots, maxParticles)) {
+            delete g_rings[i];
+            g_rings[i] = nullptr;
+        }
+    }
+}
+
+void event_ring_publish(int stream, const EventSlotHeader& evt, int nParticles,
+                        const int* pid, const double* px, const double* py, const double* pz,
+                        const double* mass, const double* x, const double* y, const double* z,
+                        const double* t) {
+    if (stream < 0 || stream >= RING_NSTREAMS || !g_rings[stream]) return;
+    g_rings[stream]->Publish(evt, nParticles, pid, px, py, pz, mass, x, y, z, t);
+}
+
+void event_ring_finalize() {
+    for (int i = 0; i < RING_NSTREAMS; i++) {
+        if (!g_rings[i]) continue;
+        cout << "Event ring " << kRingStreamNames[i] << ": "
+             << g_rings[i]->GetPublished() << " events published" << endl;
+        g_rings[i]->Close();
+        delete g_rings[i];
+        g_rings[i] = nullptr;
+    }
+}
@@ -0,0 +1,171 @@
+#ifndef EVENT_RING_H
+#define EVENT_RING_H
+
+// POSIX shared-memory event ring for out-of-process online analysis
+//
+// root_interface.cpp optionally publishes every completed event of each data
+// stream into a ring named "<prefix>_<stream>" (e.g. /ampt_ampt, /ampt_zpc).
+// Consumers (ampt-ring-consumer, or any program linking event_ring.o) attach
+// to the ring and read events at memory bandwidth without touching the disk.
+//
+// Memory layout of one ring:
+//   [EventRingHeader][slot 0]...[slot nSlots-1]
+//   slot = [EventSlotHeader][pid[maxParticles]][px]...[t]   (SoA columns)
+//
+// Each slot is protected by a sequence number (seqlock): odd while the
+// generator writes it, 2*(eventSeq+1) once event eventSeq is complete.  The
+// generator never waits for consumers; a consumer that falls more than nSlots
+// events behind skips ahead and counts the lost events as overruns.  Next
+// copies an event out of its slot; NextView/ReleaseView read it in place and
+// tell afterwards whether the generator overwrote it meanwhile.
+//
+// The header carries the generator's pid, so a consumer also stops when the
+// generator died without closing the ring (same pid namespace assumed).
+//
+// Enable in ampt with:  AMPT_SHM_RING=<prefix>  (e.g. AMPT_SHM_RING=/ampt)
+// Optional:             AMPT_SHM_SLOTS (default 8), AMPT_SHM_MAXP (default 99999)
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+const uint32_t EVENT_RING_MAGIC = 0x414d5054;  // "AMPT"
+const uint32_t EVENT_RING_VERSION = 2;
+
+struct EventRingHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t nSlots;
+    uint32_t maxParticles;
+    uint64_t slotBytes;
+    std::atomic<uint64_t> writeSeq;   // number of events published so far
+    std::atomic<uint32_t> closed;     // set by the generator at finalize
+    int32_t publisherPid;             // generator process
+    char stream[32];
+};
+
+struct EventSlotHeader {
+    std::atomic<uint64_t> seq;
+    int32_t eventID;
+    int32_t runID;
+    int32_t nParticles;
+    int32_t npart1, npart2;
+    int32_t nelp, ninp, nelt, ninthj;
+    int32_t miss;
+    double impactParameter;
+    double phiRP;
+};
+
+// Event header plus particle columns as seen by a consumer
+struct EventRecord {
+    uint64_t seq;
+    EventSlotHeader header;
+    std::vector<int32_t> pid;
+    std::vector<double> px, py, pz, mass, x, y, z, t;
+};
+
+// An event read in place: header and columns point into its slot and are
+// only valid if ReleaseView returns true afterwards
+struct EventView {
+    uint64_t seq;
+    const EventSlotHeader* header;
+    int nParticles;
+    const int32_t* pid;
+    const double *px, *py, *pz, *mass, *x, *y, *z, *t;
+};
+
+// Pointers into the SoA columns of one slot
+struct EventSlotColumns {
+    EventSlotHeader* header;
+    int32_t* pid;
+    double *px, *py, *pz, *mass, *x, *y, *z, *t;
+};
+
+class EventRingPublisher {
+private:
+    std::string shm_name;
+    void* base;
+    size_t mapped_bytes;
+    EventRingHeader* header;
+    uint64_t truncated_events;
+
+public:
+    EventRingPublisher();
+    ~EventRingPublisher();
+
+    // Create (or recreate) the ring; returns false if shared memory is unavailable
+    bool Create(const std::string& name, const std::string& stream,
+                uint32_t nSlots, uint32_t maxParticles);
+
+    // Publish one event; particles beyond maxParticles are dropped and counted
+    void Publish(const EventSlotHeader& evt, int nParticles,
+                 const int* pid, const double* px, const double* py, const double* pz,
+                 const double* mass, const double* x, const double* y, const double* z,
+                 const double* t);
+
+    // Mark the ring closed so consumers can exit after draining it
+    void Close();
+
+    bool IsOpen() const { return header != nullptr; }
+    uint64_t GetPublished() const;
+};
+
+class EventRingConsumer {
+private:
+    std::string shm_name;
+    void* base;
+    size_t mapped_bytes;
+    EventRingHeader* header;
+    uint64_t read_seq;
+    uint64_t overruns;
+
+public:
+    EventRingConsumer();
+    ~EventRingConsumer();
+
+    // Attach to an existing ring; fromStart=false skips events already in the ring
+    bool Attach(const std::string& name, bool fromStart = true);
+
+    // Copy the next complete event into rec.  Returns false if none is ready
+    // yet; *finished becomes true once the ring is closed and fully drained,
+    // or the generator is gone.
+    bool Next(EventRecord& rec, bool* finished = nullptr);
+
+    // Zero-copy variant: point view at the next complete event without copying
+    // (same return values as Next).  Every successful NextView must be followed
+    // by ReleaseView, which returns false if the generator overwrote the slot
+    // while it was read; anything derived from the view must then be dropped.
+    bool NextView(EventView& view, bool* finished = nullptr);
+    bool ReleaseView(const EventView& view);
+
+    // Blocking variant: polls until an event arrives or the ring is finished
+    bool WaitNext(EventRecord& rec, int pollMicroseconds = 1000);
+
+    std::string GetStream() const;
+    uint64_t GetOverruns() const { return overruns; }
+    uint64_t GetReadSeq() const { return read_seq; }
+};
+
+// Shared by publisher and consumer
+EventSlotColumns EventRingSlot(void* base, uint32_t nSlots, uint32_t maxParticles,
+                               uint64_t slotBytes, uint64_t seq);
+
+// C interface used by root_interface.cpp (stream ids follow the 5 data streams)
+enum EventRingStream {
+    RING_AMPT = 0,
+    RING_ZPC,
+    RING_PARTON_INITIAL,
+    RING_HADRON_BEFORE_ART,
+    RING_HADRON_BEFORE_MELTING,
+    RING_NSTREAMS
+};
+
+void event_ring_init();
+void event_ring_publish(int stream, const EventSlotHeader& evt, int nParticles,
+                        const int* pid, const double* px, const double* py, const double* pz,
+                        const double* mass, const double* x, const double* y, const double* z,
+                        const double* t);
+void event_ring_finalize();
+
+#endif // EVENT_RING_H
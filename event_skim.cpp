@@ -0,0 +1,443 @@
+#include "event_skim.h"
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <cmath>
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+
+using namespace std;
+
+EventSkim* g_event_skim = nullptr;
+
+static const char* kSkimStreamNames[SKIM_NSTREAMS] = {
+    "ampt", "zpc", "parton_initial", "hadron_before_art", "hadron_before_melting"
+};
+
+struct VarName {
+    const char* name;
+    int var;
+    bool particle;
+};
+
+static const VarName kVarNames[] = {
+    {"impactParameter", EventSkim::V_B, false},
+    {"b", EventSkim::V_B, false},
+    {"nParticles", EventSkim::V_NPARTICLES, false},
+    {"npart1", EventSkim::V_NPART1, false},
+    {"npart2", EventSkim::V_NPART2, false},
+    {"nAccepted", EventSkim::V_NACCEPTED, false},
+    {"px", EventSkim::V_PX, true},
+    {"py", EventSkim::V_PY, true},
+    {"pz", EventSkim::V_PZ, true},
+    {"pt", EventSkim::V_PT, true},
+    {"p", EventSkim::V_P, true},
+    {"eta", EventSkim::V_ETA, true},
+    {"rap", EventSkim::V_RAP, true},
+    {"phi", EventSkim::V_PHI, true},
+    {"mass", EventSkim::V_MASS, true},
+    {"x", EventSkim::V_X, true},
+    {"y", EventSkim::V_Y, true},
+    {"z", EventSkim::V_Z, true},
+    {"t", EventSkim::V_T, true},
+    {"r", EventSkim::V_R, true},
+};
+
+// Bits of Selection::need: derived particle quantities that must be computed
+static const uint32_t NEED_PT  = 1u << 0;
+static const uint32_t NEED_P   = 1u << 1;
+static const uint32_t NEED_ETA = 1u << 2;
+static const uint32_t NEED_RAP = 1u << 3;
+static const uint32_t NEED_PHI = 1u << 4;
+static const uint32_t NEED_R   = 1u << 5;
+
+static uint32_t NeedBits(int var) {
+    switch (var) {
+        case EventSkim::V_PT:  return NEED_PT;
+        case EventSkim::V_P:   return NEED_P;
+        case EventSkim::V_ETA: return NEED_P | NEED_ETA;
+        case EventSkim::V_RAP: return NEED_P | NEED_RAP;
+        case EventSkim::V_PHI: return NEED_PHI;
+        case EventSkim::V_R:   return NEED_R;
+        default:               return 0;
+    }
+}
+
+// Branch-free comparison: every operator is evaluated and masked by op
+static inline bool Compare(int op, double v, double c) {
+    return ((op == EventSkim::OP_LT) & (v < c)) |
+           ((op == EventSkim::OP_LE) & (v <= c)) |
+           ((op == EventSkim::OP_GT) & (v > c)) |
+           ((op == EventSkim::OP_GE) & (v >= c)) |
+           ((op == EventSkim::OP_EQ) & (v == c)) |
+           ((op == EventSkim::OP_NE) & (v != c));
+}
+
+static inline bool EvalCuts(const vector<EventSkim::Cut>& cuts, const double* vals) {
+    bool keep = true;
+    for (const auto& cut : cuts) {
+        double v = vals[cut.var];
+        v = cut.use_abs ? fabs(v) : v;
+        keep &= Compare(cut.op, v, cut.value);
+    }
+    return keep;
+}
+
+// ===== Tokenizer for selection expressions =====
+struct Token {
+    enum Type { IDENT, NUMBER, OP, LPAREN, RPAREN, LBRACE, RBRACE, COMMA, AND, END } type;
+    string text;
+    double number;
+};
+
+static bool Tokenize(const string& expr, vector<Token>& tokens, string& error) {
+    size_t i = 0;
+    while (i < expr.size()) {
+        char c = expr[i];
+        if (isspace((unsigned char)c)) { i++; continue; }
+        Token tok;
+        tok.number = 0;
+        if (isalpha((unsigned char)c) || c == '_') {
+            size_t j = i;
+            while (j < expr.size() && (isalnum((unsigned char)expr[j]) || expr[j] == '_')) j++;
+            tok.type = Token::IDENT;
+            tok.text = expr.substr(i, j - i);
+            i = j;
+        } else if (isdigit((unsigned char)c) || c == '.' ||
+                   ((c == '-' || c == '+') && i + 1 < expr.size() &&
+                    (isdigit((unsigned char)expr[i + 1]) || expr[i + 1] == '.'))) {
+            char* end = nullptr;
+            tok.type = Token::NUMBER;
+            tok.number = strtod(expr.c_str() + i, &end);
+            size_t j = end - expr.c_str();
+            // Fortran-style exponents such as 1d6
+            if (j < expr.size() && (expr[j] == 'd' || expr[j] == 'D')) {
+                char* end2 = nullptr;
+                long e = strtol(expr.c_str() + j + 1, &end2, 10);
+                tok.number *= pow(10.0, (double)e);
+                j = end2 - expr.c_str();
+            }
+            tok.text = expr.substr(i, j - i);
+            i = j;
+        } else if (c == '&' && i + 1 < expr.size() && expr[i + 1] == '&') {
+            tok.type = Token::AND;
+            tok.text = "&&";
+            i += 2;
+        } else if (c == '<' || c == '>' || c == '=' || c == '!') {
+            tok.type = Token::OP;
+            if (i + 1 < expr.size() && expr[i + 1] == '=') {
+                tok.text = expr.substr(i, 2);
+                i += 2;
+            } else {
+                tok.text = string(1, c);
+                i++;
+            }
+            if (tok.text == "=" || tok.text == "!") {
+                error = "unknown operator '" + tok.text + "'";
+                return false;
+            }
+        } else if (c == '(') { tok.type = Token::LPAREN; tok.text = "("; i++; }
+        else if (c == ')') { tok.type = Token::RPAREN; tok.text = ")"; i++; }
+        else if (c == '{') { tok.type = Token::LBRACE; tok.text = "{"; i++; }
+        else if (c == '}') { tok.type = Token::RBRACE; tok.text = "}"; i++; }
+        else if (c == ',') { tok.type = Token::COMMA; tok.text = ","; i++; }
+        else {
+            error = string("unexpected character '") + c + "'";
+            return false;
+        }
+        tokens.push_back(tok);
+    }
+    Token end;
+    end.type = Token::END;
+    end.number = 0;
+    tokens.push_back(end);
+    return true;
+}
+
+static int ParseOp(const string& text) {
+    if (text == "<") return EventSkim::OP_LT;
+    if (text == "<=") return EventSkim::OP_LE;
+    if (text == ">") return EventSkim::OP_GT;
+    if (text == ">=") return EventSkim::OP_GE;
+    if (text == "==") return EventSkim::OP_EQ;
+    return EventSkim::OP_NE;
+}
+
+// ===== EventSkim =====
+EventSkim::EventSkim() : enabled(false) {
+    memset(counters, 0, sizeof(counters));
+}
+
+bool EventSkim::CompileExpression(const string& expr, bool particleLevel, Selection& sel,
+                                  string& error) {
+    vector<Token> tok;
+    if (!Tokenize(expr, tok, error)) return false;
+
+    size_t k = 0;
+    while (true) {
+        if (tok[k].type != Token::IDENT) {
+            error = "expected a variable near '" + tok[k].text + "'";
+            return false;
+        }
+
+        // pid in {a, b, ...}
+        if (tok[k].text == "pid") {
+            if (!particleLevel) {
+                error = "pid can only be used in particle selections";
+                return false;
+            }
+            if (tok[k + 1].type != Token::IDENT || tok[k + 1].text != "in" ||
+                tok[k + 2].type != Token::LBRACE) {
+                error = "expected 'pid in {...}'";
+                return false;
+            }
+            k += 3;
+            vector<int> pids;
+            while (tok[k].type == Token::NUMBER) {
+                pids.push_back((int)tok[k].number);
+                k++;
+                if (tok[k].type == Token::COMMA) k++;
+            }
+            if (tok[k].type != Token::RBRACE || pids.empty()) {
+                error = "malformed pid list";
+                return false;
+            }
+            k++;
+            // Several pid lists are ANDed: keep the intersection
+            sort(pids.begin(), pids.end());
+            pids.erase(unique(pids.begin(), pids.end()), pids.end());
+            if (sel.pid_set.empty()) {
+                sel.pid_set = pids;
+            } else {
+                vector<int> both;
+                set_intersection(sel.pid_set.begin(), sel.pid_set.end(),
+                                 pids.begin(), pids.end(), back_inserter(both));
+                sel.pid_set = both.empty() ? vector<int>(1, 0x7fffffff) : both;
+            }
+        } else {
+            bool use_abs = false;
+            string name = tok[k].text;
+            if (name == "abs") {
+                if (tok[k + 1].type != Token::LPAREN || tok[k + 2].type != Token::IDENT ||
+                    tok[k + 3].type != Token::RPAREN) {
+                    error = "expected abs(variable)";
+                    return false;
+                }
+                use_abs = true;
+                name = tok[k + 2].text;
+                k += 4;
+            } else {
+                k++;
+            }
+
+            int var = -1;
+            bool isParticleVar = false;
+            for (const auto& vn : kVarNames) {
+                if (name == vn.name) {
+                    var = vn.var;
+                    isParticleVar = vn.particle;
+                    break;
+                }
+            }
+            if (var < 0) {
+                error = "unknown variable '" + name + "'";
+                return false;
+            }
+            if (isParticleVar != particleLevel) {
+                error = "variable '" + name + "' is not available in " +
+                        (particleLevel ? "particle" : "event") + " selections";
+                return false;
+            }
+            if (tok[k].type != Token::OP || tok[k + 1].type != Token::NUMBER) {
+                error = "expected '<op> <number>' after '" + name + "'";
+                return false;
+            }
+            Cut cut;
+            cut.var = var;
+            cut.op = ParseOp(tok[k].text);
+            cut.use_abs = use_abs;
+            cut.value = tok[k + 1].number;
+            sel.cuts.push_back(cut);
+            sel.need |= NeedBits(var);
+            k += 2;
+        }
+
+        if (tok[k].type == Token::END) break;
+        if (tok[k].type != Token::AND) {
+            error = "only '&&' is supported between cuts, found '" + tok[k].text + "'";
+            return false;
+        }
+        k++;
+    }
+
+    // Bitmap for the common PDG range, binary search only for exotic codes
+    sel.pid_bits.assign((2 * PID_BITMAP_RANGE + 1 + 63) / 64, 0);
+    for (int pid : sel.pid_set) {
+        if (abs(pid) <= PID_BITMAP_RANGE) {
+            int bit = pid + PID_BITMAP_RANGE;
+            sel.pid_bits[bit >> 6] |= (uint64_t(1) << (bit & 63));
+        }
+    }
+    sel.active = true;
+    return true;
+}
+
+bool EventSkim::ParseLine(const string& raw, int lineno) {
+    string line = raw.substr(0, raw.find('#'));
+    stringstream ss(line);
+    string stream, level;
+    if (!(ss >> stream)) return true;  // blank or comment
+    if (!(ss >> level)) {
+        cerr << "ERROR: skim line " << lineno << ": missing level (event/particle)" << endl;
+        return false;
+    }
+    string expr;
+    getline(ss, expr);
+
+    bool particleLevel;
+    if (level == "event") particleLevel = false;
+    else if (level == "particle") particleLevel = true;
+    else {
+        cerr << "ERROR: skim line " << lineno << ": unknown level '" << level << "'" << endl;
+        return false;
+    }
+
+    for (int s = 0; s < SKIM_NSTREAMS; s++) {
+        if (stream != "*" && stream != kSkimStreamNames[s]) continue;
+        Selection& sel = particleLevel ? particle_sel[s] : event_sel[s];
+        string error;
+        if (!CompileExpression(expr, particleLevel, sel, error)) {
+            cerr << "ERROR: skim line " << lineno << ": " << error << endl;
+            return false;
+        }
+        if (stream != "*") return true;
+    }
+    if (stream != "*") {
+        cerr << "ERROR: skim line " << lineno << ": unknown stream '" << stream << "'" << endl;
+        return false;
+    }
+    return true;
+}
+
+bool EventSkim::Load(const string& filename) {
+    ifstream fin(filename);
+    if (!fin) {
+        cerr << "ERROR: Cannot open skim file " << filename << endl;
+        return false;
+    }
+    string line;
+    int lineno = 0;
+    bool ok = true;
+    config_text.clear();
+    while (getline(fin, line)) {
+        lineno++;
+        config_text += line + "\n";
+        if (!ParseLine(line, lineno)) ok = false;
+    }
+    if (!ok) {
+        cerr << "ERROR: Skim disabled because of errors in " << filename << endl;
+        for (int s = 0; s < SKIM_NSTREAMS; s++) {
+            event_sel[s] = Selection();
+            particle_sel[s] = Selection();
+        }
+        enabled = false;
+        return false;
+    }
+    enabled = true;
+    cout << "Write-time skim loaded from " << filename << endl;
+    return true;
+}
+
+bool EventSkim::PidAccepted(const Selection& sel, int pid) const {
+    if (sel.pid_set.empty()) return true;
+    if (abs(pid) <= PID_BITMAP_RANGE) {
+        int bit = pid + PID_BITMAP_RANGE;
+        return (sel.pid_bits[bit >> 6] >> (bit & 63)) & 1;
+    }
+    return binary_search(sel.pid_set.begin(), sel.pid_set.end(), pid);
+}
+
+bool EventSkim::Apply(int stream, const SkimEventVars& evt, int& nParticles, SkimColumns& cols) {
+    SkimCounters& cnt = counters[stream];
+    cnt.events_seen++;
+    cnt.particles_seen += nParticles;
+    if (!enabled) return true;
+
+    const Selection& esel = event_sel[stream];
+    if (esel.active) {
+        double vals[V_NVARS] = {0};
+        vals[V_B] = evt.impactParameter;
+        vals[V_NPARTICLES] = evt.nParticles;
+        vals[V_NPART1] = evt.npart1;
+        vals[V_NPART2] = evt.npart2;
+        vals[V_NACCEPTED] = evt.nAccepted;
+        if (!EvalCuts(esel.cuts, vals)) {
+            cnt.events_dropped++;
+            cnt.particles_dropped += nParticles;
+            return false;
+        }
+    }
+
+    const Selection& psel = particle_sel[stream];
+    if (!psel.active) return true;
+
+    const uint32_t need = psel.need;
+    int kept = 0;
+    for (int i = 0; i < nParticles; i++) {
+        double vals[V_NVARS];
+        vals[V_PX] = cols.px[i];
+        vals[V_PY] = cols.py[i];
+        vals[V_PZ] = cols.pz[i];
+        vals[V_MASS] = cols.mass[i];
+        vals[V_X] = cols.x[i];
+        vals[V_Y] = cols.y[i];
+        vals[V_Z] = cols.z[i];
+        vals[V_T] = cols.t[i];
+        double pt2 = cols.px[i] * cols.px[i] + cols.py[i] * cols.py[i];
+        if (need & NEED_PT) vals[V_PT] = sqrt(pt2);
+        if (need & NEED_P) vals[V_P] = sqrt(pt2 + cols.pz[i] * cols.pz[i]);
+        // same pseudorapidity definition as AnalysisCore::AcceptParticle
+        if (need & NEED_ETA) vals[V_ETA] = 0.5 * log((vals[V_P] + cols.pz[i]) / (vals[V_P] - cols.pz[i] + 1e-10));
+        if (need & NEED_RAP) {
+            double e = sqrt(vals[V_P] * vals[V_P] + cols.mass[i] * cols.mass[i]);
+            vals[V_RAP] = 0.5 * log((e + cols.pz[i]) / (e - cols.pz[i] + 1e-10));
+        }
+        if (need & NEED_PHI) vals[V_PHI] = atan2(cols.py[i], cols.px[i]);
+        if (need & NEED_R) vals[V_R] = sqrt(cols.x[i] * cols.x[i] + cols.y[i] * cols.y[i]);
+
+        bool keep = PidAccepted(psel, cols.pid[i]) & EvalCuts(psel.cuts, vals);
+
+        // Stable in-place compaction: always copy, advance only when kept
+        cols.pid[kept] = cols.pid[i];
+        cols.px[kept] = cols.px[i];
+        cols.py[kept] = cols.py[i];
+        cols.pz[kept] = cols.pz[i];
+        cols.mass[kept] = cols.mass[i];
+        cols.x[kept] = cols.x[i];
+        cols.y[kept] = cols.y[i];
+        cols.z[kept] = cols.z[i];
+        cols.t[kept] = cols.t[i];
+        if (cols.extra_i) cols.extra_i[kept] = cols.extra_i[i];
+        if (cols.extra_d1) cols.extra_d1[kept] = cols.extra_d1[i];
+        if (cols.extra_d2) cols.extra_d2[kept] = cols.extra_d2[i];
+        kept += keep;
+    }
+
+    cnt.particles_dropped += nParticles - kept;
+    nParticles = kept;
+    return true;
+}
+
+void EventSkim::PrintSummary() const {
+    if (!enabled) return;
+    cout << "Write-time skim summary:" << endl;
+    for (int s = 0; s < SKIM_NSTREAMS; s++) {
+        const SkimCounters& c = counters[s];
+        if (c.events_seen == 0) continue;
+        cout << "  " << kSkimStreamNames[s] << ": events dropped " << c.events_dropped
+             << "/" << c.events_seen << ", particles dropped " << c.particles_dropped
+             << "/" << c.particles_seen << endl;
+    }
+}
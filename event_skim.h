@@ -0,0 +1,127 @@
+#ifndef EVENT_SKIM_H
+#define EVENT_SKIM_H
+
+// Write-time event and particle skimming for the ROOT writers
+//
+// A skim file (AMPT_SKIM=<file>) holds one selection per line:
+//
+//   # stream   level     expression (conjunction of cuts joined by &&)
+//   ampt       event     impactParameter >= 7.65 && impactParameter < 8.83
+//   ampt       event     nAccepted > 20
+//   ampt       particle  pid in {211,-211,321,-321,2212,-2212} && pt > 0.15 && abs(eta) < 1.5
+//   zpc        particle  pid in {1,-1,2,-2,3,-3}
+//   *          event     nParticles > 0
+//
+// stream is ampt, zpc, parton_initial, hadron_before_art, hadron_before_melting
+// or * (all streams); several lines for the same stream and level are ANDed.
+//
+// Event variables:    impactParameter (or b), nParticles, npart1, npart2, nAccepted
+//                     (nAccepted = particles accepted by the stream's AnalysisCore)
+// Particle variables: pid, px, py, pz, pt, p, eta, rap, phi, mass, x, y, z, t, r
+// Operators:          <  <=  >  >=  ==  !=   abs(var)   pid in {a,b,...}
+//
+// Each selection is parsed once into a flat table of cuts and evaluated per
+// event without early exits; the particle filter compacts the columns in place
+// before TTree::Fill.  AnalysisCore always runs before the skim and therefore
+// still sees every event.
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+enum SkimStream {
+    SKIM_AMPT = 0,
+    SKIM_ZPC,
+    SKIM_PARTON_INITIAL,
+    SKIM_HADRON_BEFORE_ART,
+    SKIM_HADRON_BEFORE_MELTING,
+    SKIM_NSTREAMS
+};
+
+// Event-level inputs of the event predicate
+struct SkimEventVars {
+    double impactParameter;
+    int nParticles;
+    int npart1, npart2;
+    int nAccepted;
+};
+
+// Particle columns the particle filter compacts in place (extra_* may be null)
+struct SkimColumns {
+    int* pid;
+    double *px, *py, *pz, *mass, *x, *y, *z, *t;
+    int* extra_i;
+    double *extra_d1, *extra_d2;
+};
+
+struct SkimCounters {
+    long long events_seen;
+    long long events_dropped;
+    long long particles_seen;
+    long long particles_dropped;
+};
+
+class EventSkim {
+public:
+    enum Var {
+        // event variables
+        V_B = 0, V_NPARTICLES, V_NPART1, V_NPART2, V_NACCEPTED,
+        // particle variables
+        V_PX, V_PY, V_PZ, V_PT, V_P, V_ETA, V_RAP, V_PHI, V_MASS, V_X, V_Y, V_Z, V_T, V_R,
+        V_NVARS
+    };
+    enum Op { OP_LT = 0, OP_LE, OP_GT, OP_GE, OP_EQ, OP_NE };
+
+    struct Cut {
+        int var;
+        int op;
+        bool use_abs;
+        double value;
+    };
+
+    // Compiled selection for one stream and level
+    struct Selection {
+        std::vector<Cut> cuts;
+        std::vector<int> pid_set;        // sorted, empty = any pid
+        std::vector<uint64_t> pid_bits;  // bitmap for |pid| <= PID_BITMAP_RANGE
+        bool active = false;
+        uint32_t need = 0;               // bit mask of derived particle variables used
+    };
+
+    static const int PID_BITMAP_RANGE = 10000;
+
+private:
+    Selection event_sel[SKIM_NSTREAMS];
+    Selection particle_sel[SKIM_NSTREAMS];
+    SkimCounters counters[SKIM_NSTREAMS];
+    std::string config_text;
+    bool enabled;
+
+    bool ParseLine(const std::string& line, int lineno);
+    bool CompileExpression(const std::string& expr, bool particleLevel, Selection& sel,
+                           std::string& error);
+    bool PidAccepted(const Selection& sel, int pid) const;
+
+public:
+    EventSkim();
+
+    // Load and compile a skim file; returns false (and disables skimming) on errors
+    bool Load(const std::string& filename);
+
+    bool IsEnabled() const { return enabled; }
+    bool HasEventSelection(int stream) const { return event_sel[stream].active; }
+
+    // Apply event predicate and particle filter; returns true if the event is
+    // kept, in which case nParticles is updated to the number of kept particles
+    bool Apply(int stream, const SkimEventVars& evt, int& nParticles, SkimColumns& cols);
+
+    const SkimCounters& GetCounters(int stream) const { return counters[stream]; }
+    void SetCounters(int stream, const SkimCounters& c) { counters[stream] = c; }  // restart
+    const std::string& GetConfigText() const { return config_text; }
+    void PrintSummary() const;
+};
+
+// Global skim (created by init_root_ when AMPT_SKIM is set)
+extern EventSkim* g_event_skim;
+
+#endif // EVENT_SKIM_H
@@ -276,6 +276,8 @@ ccbz11/11/98end
 cbz1/25/99
         COMMON /PARA1/ MUL
 cc      SAVE /PARA1/
+        COMMON /AMPCAP/ NSTRCP, NPTNCP
+cc      SAVE /AMPCAP/
         COMMON /prec1/GX0(MAXPTN),GY0(MAXPTN),GZ0(MAXPTN),FT0(MAXPTN),
      &     PX0(MAXPTN), PY0(MAXPTN), PZ0(MAXPTN), E0(MAXPTN),
      &     XMASS0(MAXPTN), ITYP0(MAXPTN)
@@ -339,8 +341,23 @@ clin-8/2015:
      2       xstrg(MAXPTN),ystrg(MAXPTN),istrg0(MAXPTN),istrg(MAXPTN)
 clin-9/2018:
         COMMON /debug1/ JPhrd, JThrd, iremiss, imiss2
+c     stage caches (stgcache.f):
+        COMMON /STGCAC/ ISTCMD(2)
+cc      SAVE /STGCAC/
         SAVE   
 
+c     replay of a stage cache: the event starts after HIJING or ZPC
+        IF(ISTCMD(1).EQ.2.OR.ISTCMD(2).EQ.2) THEN
+           IF(ISTCMD(2).EQ.2) THEN
+              CALL STCGET(2)
+           ELSE
+              CALL STCGET(1)
+           ENDIF
+           BB=HINT1(19)
+           HINT1(20)=phiRP
+           GO TO 566
+        ENDIF
+
         BMAX=MIN(BMAX0,HIPR1(34)+HIPR1(35))
         BMIN=MIN(BMIN0,BMAX)
         IF(IHNT2(1).LE.1 .AND. IHNT2(3).LE.1) THEN
@@ -818,6 +835,7 @@ C********perform jet quenching for jets with PT>HIPR1(11)**********
         ENDIF
 
 clin*****4/09/01-soft1, default way of treating strings:
+ 566    CONTINUE
         if(isoft.eq.1) then
 clin-4/16/01 allow fragmentation:
            isflag=1
@@ -943,7 +961,9 @@ cbz2/4/99end
 clin-6/2009:
         if(ioscar.eq.3) WRITE (95, *) IAEVT, mul
 c.....call ZPC for parton cascade
+        call TIMER_BEGIN(3)
         CALL ZPCMN
+        call TIMER_END(3)
 
 c     write out parton and wounded nucleon information to ana/zpc1.mom:
 clin-6/2009:
@@ -1167,7 +1187,9 @@ cbz2/4/99end
 clin-6/2009:
         if(ioscar.eq.3) WRITE (95, *) IAEVT, mul
 c.....call ZPC for parton cascade
+        call TIMER_BEGIN(3)
         CALL ZPCMN
+        call TIMER_END(3)
 cbz3/19/99
 clin-6/2009:
 c        WRITE (14, 395) ITEST, MUL, bimp, NELP,NINP,NELT,NINTHJ
@@ -1327,6 +1349,8 @@ cbz2/4/99end
 clin-4/19/01-soft3, fragment strings, then convert hadrons to partons 
 c     and input to ZPC:
         elseif(isoft.eq.3.or.isoft.eq.4.or.isoft.eq.5) then
+        IF(ISTCMD(2).EQ.2) GO TO 567
+        IF(ISTCMD(1).EQ.2) GO TO 568
 clin-4/24/01 normal fragmentation first:
         isflag=0
 c        write(99,*) 'IAEVT,NSG,NDR=',IAEVT,NSG,NDR
@@ -1558,9 +1582,12 @@ clin-6/2009
          call embedHighPt
 c
         CALL HJANA1
+        IF(ISTCMD(1).EQ.1) CALL STCPUT(1)
+ 568    CONTINUE
 
 clin-2024 save hadrons before string melting (before ZPC):
         if(isoft.eq.4.or.isoft.eq.5) then
+           call TIMER_BEGIN(7)
 c           Write to dat file (traditional output)
            WRITE(98,*) IAEVT, MISS, NATT, bimp, NELP,NINP,NELT,NINTHJ
 c           Write to ROOT file (online conversion)
@@ -1588,6 +1615,7 @@ c                 Write to ROOT file
      2                GXAR(ihad),GYAR(ihad),GZAR(ihad),FTAR(ihad))
               endif
            enddo
+           call TIMER_END(7)
         endif
 
 clin-4/19/01 convert hadrons to partons for ZPC (with GX0 given):
@@ -1678,7 +1706,12 @@ clin-6/2009:
         if(ioscar.eq.3) WRITE (95, *) IAEVT, mul
 
 c.....call ZPC for parton cascade
+        call TIMER_BEGIN(3)
         CALL ZPCMN
+        call TIMER_END(3)
+        IF(ISTCMD(2).EQ.1) CALL STCPUT(2)
+ 567    CONTINUE
+        call TIMER_BEGIN(7)
 clin-6/2009:
 c        WRITE (14, 395) ITEST, MUL, bimp, NELP,NINP,NELT,NINTHJ
         WRITE (14, 395) IAEVT, MISS, MUL, bimp, NELP,NINP,NELT,NINTHJ
@@ -1707,6 +1740,7 @@ c           Write to ROOT file
      1          XMASS5(I), GX5(I), GY5(I), GZ5(I), FT5(I))
 c
  1016   CONTINUE
+        call TIMER_END(7)
 c 511    FORMAT(1X, 3F10.4, I6, 2F10.4)
 c 512    FORMAT(I6,4(1X,F10.3),1X,I6,1X,I3,1X,F10.3)
 c 513    FORMAT(1X, 4F10.4)
@@ -1716,7 +1750,8 @@ c        call frztm(1,1)
 
 clin  save data after ZPC for fragmentation purpose:
 c.....transfer data back from ZPC to HIJING
-        DO 1018 I = 1, MAXSTR
+        call strgrw(max(NSG, MUL))
+        DO 1018 I = 1, NSTRCP
            DO 1017 J = 1, 3
               K1SGS(I, J) = 0
               K2SGS(I, J) = 0
@@ -1774,7 +1809,9 @@ clin-4/30/01 convert partons to hadrons after ZPC:
         if(isoft.eq.3.or.isoft.eq.4.or.isoft.eq.5) then
            NATT=0
            EATT=0.
+           call TIMER_BEGIN(4)
            call ptoh
+           call TIMER_END(4)
            do 1006 I=1,nnozpc
               NATT=NATT+1
               KATT(NATT,1)=ITYPN(I)
@@ -2058,9 +2095,12 @@ c     Skip energy check for random coalescence method (icoal_method=3)
      &        WRITE(6,*) 'Energy not conserved, repeat the event'
 c                call lulist(1)
          write(6,*) 'violated:EATT(GeV),NATT,B(fm)=',EATT,NATT,bimp
-         GO TO 50
-        ENDIF
+c     a replayed event cannot be repeated, its start is the cache's
+         IF(ISTCMD(1).NE.2.AND.ISTCMD(2).NE.2) GO TO 50
+         write(6,*) 'kept (stage cache replay)'
+        ELSE
         write(6,*) 'satisfied:EATT(GeV),NATT,B(fm)=',EATT,NATT,bimp
+        ENDIF
         write(6,*) ' '
 c
 clin-4/2012 write out initial transverse positions of initial nucleons:
@@ -4868,12 +4868,27 @@ C*********************************************************************
     
 C...Purpose: to generate random numbers uniformly distributed between   
 C...0 and 1, excluding the endpoints.   
+      PARAMETER (NRBUF=1024)
+      DOUBLE PRECISION RNGB
       COMMON/LUDATR/MRLU(6),RRLU(100)   
       SAVE /LUDATR/ 
+      COMMON/RNGBK/IRNGBK
+      COMMON/RNGBUF/RNGB(NRBUF,3),KRNG(3)
       EQUIVALENCE (MRLU1,MRLU(1)),(MRLU2,MRLU(2)),(MRLU3,MRLU(3)),  
      &(MRLU4,MRLU(4)),(MRLU5,MRLU(5)),(MRLU6,MRLU(6)),  
      &(RRLU98,RRLU(98)),(RRLU99,RRLU(99)),(RRLU00,RRLU(100))    
     
+C...Counter-based backend (see RNGINI in amptsub.f), stream 2.
+      IF(IRNGBK.EQ.1) THEN
+        IF(KRNG(2).GE.NRBUF) THEN
+          CALL RNG_FILL(2,RNGB(1,2),NRBUF)
+          KRNG(2)=0
+        ENDIF
+        KRNG(2)=KRNG(2)+1
+        RLU=RNGB(KRNG(2),2)
+        RETURN
+      ENDIF
+    
 C...Initialize generation from given seed.  
       IF(MRLU2.EQ.0) THEN   
         IJ=MOD(MRLU1/30082,31329)   
@@ -16,6 +16,10 @@
 #include "TMath.h"
 #include "TRandom3.h"
 #include "TStopwatch.h"
+#include "TEnv.h"
+
+// ROOTFormat, predefined_formats, DetectFormat, ShowFormats
+#include "../analysis_formats.h"
 
 using namespace std;
 
@@ -30,142 +34,70 @@ vector<int> vec_pdg_hadron = {211, -211, 321, -321, 2212, -2212, 2112, -2112, 33
 vector<string> vec_pid_quark = {"u", "ubar", "d", "dbar", "s", "sbar"};
 vector<int> vec_pdg_quark = {2, -2, 1, -1, 3, -3};
 
-// ROOT file format configuration
-struct ROOTFormat {
-    string tree_name;
-    string nParticles_branch;
-    string impactParameter_branch;
-    string pid_branch;
-    string px_branch, py_branch, pz_branch;
-    string x_branch, y_branch, z_branch;
-    
-    // Data types and array sizes
-    bool use_double_precision = true;
-    int max_particles = 99999;
-    
-    // Additional branches (optional)
-    string eventID_branch = "";
-    string runID_branch = "";
-    
-    void print() const {
-        cout << "ROOT Format Configuration:" << endl;
-        cout << "  Tree name: " << tree_name << endl;
-        cout << "  nParticles: " << nParticles_branch << endl;
-        cout << "  impactParameter: " << impactParameter_branch << endl;
-        cout << "  PID: " << pid_branch << endl;
-        cout << "  Momentum: " << px_branch << ", " << py_branch << ", " << pz_branch << endl;
-        cout << "  Position: " << x_branch << ", " << y_branch << ", " << z_branch << endl;
-        cout << "  Max particles: " << max_particles << endl;
-        cout << "  Double precision: " << (use_double_precision ? "Yes" : "No") << endl;
-    }
-};
+// Event class for mixing
 
-// Predefined formats for different AMPT outputs
-map<string, ROOTFormat> predefined_formats = {
-    {"ampt", {
-        "ampt",                    // tree_name
-        "nParticles",             // nParticles_branch
-        "impactParameter",        // impactParameter_branch
-        "pid",                    // pid_branch
-        "px", "py", "pz",        // momentum branches
-        "x", "y", "z",           // position branches
-        true, 99999,             // double precision, max particles
-        "eventID", "runID"       // optional branches
-    }},
-    {"hadron_before_art", {
-        "hadron_before_art",
-        "nParticles",
-        "impactParameter", 
-        "pid",
-        "px", "py", "pz",
-        "x", "y", "z",
-        true, 99999,
-        "eventID", ""
-        // Note: also contains miss, nelp, ninp, nelt, ninthj, mass, t branches
-        // but we only need the essential ones for analysis
-    }},
-    {"hadron_before_melting", {
-        "hadron_before_melting",
-        "nParticles",
-        "impactParameter",
-        "pid", 
-        "px", "py", "pz",
-        "x", "y", "z",
-        true, 99999,
-        "eventID", ""
-        // Note: also contains miss, nelp, ninp, nelt, ninthj, mass, t branches
-        // but we only need the essential ones for analysis
-    }},
-    {"zpc", {
-        "zpc",
-        "nParticles",
-        "impactParameter",
-        "pid",
-        "px", "py", "pz",
-        "x", "y", "z",
-        true, 99999,
-        "eventID", ""
-        // Note: ZPC parton data after cascade
-    }},
-    {"parton_initial", {
-        "parton_initial",
-        "nParticles",
-        "impactParameter",  // Note: may not have this branch, will be handled
-        "pid",
-        "px", "py", "pz",
-        "x", "y", "z",
-        true, 99999,
-        "eventID", ""
-        // Note: also contains istrg0, xstrg0, ystrg0 string info branches
-    }},
-    {"legacy_format", {
-        "AMPT",
-        "Event.multi",
-        "Event.impactpar",
-        "ID",
-        "Px", "Py", "Pz",
-        "X", "Y", "Z",
-        false, 99999,
-        "", ""
-    }}
+// Contiguous read-only view of one particle column of the current entry
+template <typename T>
+struct ColumnSpan {
+    const T* data;
+    int size;
+    
+    const T& operator[](int i) const { return data[i]; }
+    const T* begin() const { return data; }
+    const T* end() const { return data + size; }
 };
 
-// Event class for mixing
+// How AMPTDataReader reads the chain
+enum ReaderMode {
+    READER_FULL,    // original behaviour: every branch is read
+    READER_PRUNED   // only the analysis columns, TTreeCache with async prefetch
+};
 
 // Data reader class - handles different ROOT formats
 class AMPTDataReader {
 private:
     ROOTFormat format;
+    ReaderMode mode;
+    Long64_t cache_size;
     TChain* chain;
     
-    // Branch variables - using void* for flexibility
+    // Branch variables
     Int_t nParticles;
     Double_t impactParameter_d;
     Float_t impactParameter_f;
     
-    // Particle arrays - double precision
+    // Particle arrays - double precision; for float trees these hold the
+    // columns widened once per entry in GetEntry()
     Int_t* pid_d;
     Double_t* px_d; Double_t* py_d; Double_t* pz_d;
     Double_t* x_d; Double_t* y_d; Double_t* z_d;
     
     // Particle arrays - single precision (for legacy format)
-    Int_t* pid_f;
     Float_t* px_f; Float_t* py_f; Float_t* pz_f;
     Float_t* x_f; Float_t* y_f; Float_t* z_f;
     
+    vector<string> RequiredBranches() const {
+        return {format.nParticles_branch, format.impactParameter_branch, format.pid_branch,
+                format.px_branch, format.py_branch, format.pz_branch,
+                format.x_branch, format.y_branch, format.z_branch};
+    }
+    
+    ColumnSpan<Double_t> Span(const Double_t* column) const { return {column, nParticles}; }
+    
 public:
-    AMPTDataReader(const ROOTFormat& fmt) : format(fmt), chain(nullptr) {
+    AMPTDataReader(const ROOTFormat& fmt, ReaderMode m = READER_PRUNED, Long64_t cacheSize = 64 * 1024 * 1024)
+        : format(fmt), mode(m), cache_size(cacheSize), chain(nullptr), nParticles(0),
+          impactParameter_d(0), impactParameter_f(0),
+          px_f(nullptr), py_f(nullptr), pz_f(nullptr), x_f(nullptr), y_f(nullptr), z_f(nullptr) {
         // Allocate arrays
-        if (format.use_double_precision) {
-            pid_d = new Int_t[format.max_particles];
-            px_d = new Double_t[format.max_particles];
-            py_d = new Double_t[format.max_particles];
-            pz_d = new Double_t[format.max_particles];
-            x_d = new Double_t[format.max_particles];
-            y_d = new Double_t[format.max_particles];
-            z_d = new Double_t[format.max_particles];
-        } else {
-            pid_f = new Int_t[format.max_particles];
+        pid_d = new Int_t[format.max_particles];
+        px_d = new Double_t[format.max_particles];
+        py_d = new Double_t[format.max_particles];
+        pz_d = new Double_t[format.max_particles];
+        x_d = new Double_t[format.max_particles];
+        y_d = new Double_t[format.max_particles];
+        z_d = new Double_t[format.max_particles];
+        if (!format.use_double_precision) {
             px_f = new Float_t[format.max_particles];
             py_f = new Float_t[format.max_particles];
             pz_f = new Float_t[format.max_particles];
@@ -176,17 +108,17 @@ public:
     }
     
     ~AMPTDataReader() {
-        if (format.use_double_precision) {
-            delete[] pid_d; delete[] px_d; delete[] py_d; delete[] pz_d;
-            delete[] x_d; delete[] y_d; delete[] z_d;
-        } else {
-            delete[] pid_f; delete[] px_f; delete[] py_f; delete[] pz_f;
-            delete[] x_f; delete[] y_f; delete[] z_f;
-        }
+        delete[] pid_d; delete[] px_d; delete[] py_d; delete[] pz_d;
+        delete[] x_d; delete[] y_d; delete[] z_d;
+        delete[] px_f; delete[] py_f; delete[] pz_f;
+        delete[] x_f; delete[] y_f; delete[] z_f;
         if (chain) delete chain;
     }
     
     bool Initialize(const string& input) {
+        // Asynchronous prefetching has to be switched on before files are opened
+        if (mode == READER_PRUNED) gEnv->SetValue("TFile.AsyncPrefetching", 1);
+        
         chain = new TChain(format.tree_name.c_str());
         
         // Add files to chain
@@ -210,12 +142,26 @@ public:
         
         cout << "Loaded " << chain->GetEntries() << " events from " << format.tree_name << endl;
         
+        if (mode == READER_PRUNED) {
+            // Unused columns (mass, t, nelp, string info, ...) are never read
+            chain->SetBranchStatus("*", 0);
+            for (const string& b : RequiredBranches()) chain->SetBranchStatus(b.c_str(), 1);
+            
+            // The chain re-creates the cache for each file it opens; the branch
+            // set is known, so no learning phase is needed
+            chain->SetCacheSize(cache_size);
+            for (const string& b : RequiredBranches()) chain->AddBranchToCache(b.c_str(), true);
+            chain->StopCacheLearningPhase();
+            cout << "Reader: " << RequiredBranches().size() << " branches enabled, "
+                 << cache_size / (1024 * 1024) << " MB TTreeCache, async prefetch on" << endl;
+        }
+        
         // Set branch addresses
         chain->SetBranchAddress(format.nParticles_branch.c_str(), &nParticles);
+        chain->SetBranchAddress(format.pid_branch.c_str(), pid_d);
         
         if (format.use_double_precision) {
             chain->SetBranchAddress(format.impactParameter_branch.c_str(), &impactParameter_d);
-            chain->SetBranchAddress(format.pid_branch.c_str(), pid_d);
             chain->SetBranchAddress(format.px_branch.c_str(), px_d);
             chain->SetBranchAddress(format.py_branch.c_str(), py_d);
             chain->SetBranchAddress(format.pz_branch.c_str(), pz_d);
@@ -224,7 +170,6 @@ public:
             chain->SetBranchAddress(format.z_branch.c_str(), z_d);
         } else {
             chain->SetBranchAddress(format.impactParameter_branch.c_str(), &impactParameter_f);
-            chain->SetBranchAddress(format.pid_branch.c_str(), pid_f);
             chain->SetBranchAddress(format.px_branch.c_str(), px_f);
             chain->SetBranchAddress(format.py_branch.c_str(), py_f);
             chain->SetBranchAddress(format.pz_branch.c_str(), pz_f);
@@ -238,34 +183,39 @@ public:
     
     Long64_t GetEntries() const { return chain ? chain->GetEntries() : 0; }
     
-    void GetEntry(Long64_t entry) { if (chain) chain->GetEntry(entry); }
+    void GetEntry(Long64_t entry) {
+        if (!chain) return;
+        chain->GetEntry(entry);
+        
+        // Widen float trees once here instead of in every accessor call
+        if (!format.use_double_precision) {
+            impactParameter_d = impactParameter_f;
+            for (int i = 0; i < nParticles; i++) {
+                px_d[i] = px_f[i]; py_d[i] = py_f[i]; pz_d[i] = pz_f[i];
+                x_d[i] = x_f[i]; y_d[i] = y_f[i]; z_d[i] = z_f[i];
+            }
+        }
+    }
     
     // Unified data access interface
     int GetNParticles() const { return nParticles; }
     
-    double GetImpactParameter() const { 
-        return format.use_double_precision ? impactParameter_d : impactParameter_f; 
-    }
+    double GetImpactParameter() const { return impactParameter_d; }
     
-    int GetPID(int i) const { 
-        return format.use_double_precision ? pid_d[i] : pid_f[i]; 
-    }
+    // Typed column spans of the current entry
+    ColumnSpan<Int_t> GetPIDs() const { return {pid_d, nParticles}; }
+    ColumnSpan<Double_t> GetPx() const { return Span(px_d); }
+    ColumnSpan<Double_t> GetPy() const { return Span(py_d); }
+    ColumnSpan<Double_t> GetPz() const { return Span(pz_d); }
+    ColumnSpan<Double_t> GetX() const { return Span(x_d); }
+    ColumnSpan<Double_t> GetY() const { return Span(y_d); }
+    ColumnSpan<Double_t> GetZ() const { return Span(z_d); }
     
-    TVector3 GetMomentum(int i) const {
-        if (format.use_double_precision) {
-            return TVector3(px_d[i], py_d[i], pz_d[i]);
-        } else {
-            return TVector3(px_f[i], py_f[i], pz_f[i]);
-        }
-    }
+    int GetPID(int i) const { return pid_d[i]; }
     
-    TVector3 GetPosition(int i) const {
-        if (format.use_double_precision) {
-            return TVector3(x_d[i], y_d[i], z_d[i]);
-        } else {
-            return TVector3(x_f[i], y_f[i], z_f[i]);
-        }
-    }
+    TVector3 GetMomentum(int i) const { return TVector3(px_d[i], py_d[i], pz_d[i]); }
+    
+    TVector3 GetPosition(int i) const { return TVector3(x_d[i], y_d[i], z_d[i]); }
 };
 
 // Function declarations
@@ -274,53 +224,14 @@ float range_delta_phi(float dphi);
 float range_phi(float phi);
 bool isTrackAccepted(int pid, float pT, float eta, float phi);
 bool isQuarkAccepted(int pid, float pT, float eta, float phi);
-ROOTFormat DetectFormat(const string& filename);
-void ShowFormats();
 bool IsHadronData(const string& tree_name);
 bool IsQuarkData(const string& tree_name);
 
-// Auto-detect ROOT format from file
-ROOTFormat DetectFormat(const string& filename) {
-    string test_file = filename;
-    
-    // If it's a list file, get the first file
-    if (filename.find(".list") != string::npos) {
-        ifstream fin(filename);
-        getline(fin, test_file);
-        fin.close();
-    }
-    
-    TFile* f = TFile::Open(test_file.c_str());
-    if (!f || f->IsZombie()) {
-        cout << "Warning: Cannot open file " << test_file << ", using default format" << endl;
-        return predefined_formats["ampt"];
-    }
-    
-    // Check which tree exists and return corresponding format
-    for (auto& pair : predefined_formats) {
-        if (f->Get(pair.second.tree_name.c_str())) {
-            cout << "Auto-detected format: " << pair.first << endl;
-            f->Close();
-            return pair.second;
-        }
-    }
-    
-    f->Close();
-    cout << "Warning: No matching format found, using default" << endl;
-    return predefined_formats["ampt"];
-}
-
-void ShowFormats() {
-    cout << "Available predefined formats:" << endl;
-    for (auto& pair : predefined_formats) {
-        cout << "  " << pair.first << ": " << pair.second.tree_name << endl;
-    }
-}
-
 int main(int argc, char** argv) {
     if (argc < 3) {
-        cout << "Usage: " << argv[0] << " <input.root|.list> <output.root> [format]" << endl;
+        cout << "Usage: " << argv[0] << " <input.root|.list> <output.root> [format] [reader]" << endl;
         cout << "  format: auto (default), ampt, hadron_before_art, hadron_before_melting, legacy_format" << endl;
+        cout << "  reader: pruned (default, only analysis branches + TTreeCache), full" << endl;
         cout << endl;
         ShowFormats();
         return 1;
@@ -332,6 +243,7 @@ int main(int argc, char** argv) {
     string inputFile = argv[1];
     string outputFile = argv[2];
     string format_name = (argc > 3) ? argv[3] : "auto";
+    string reader_mode = (argc > 4) ? argv[4] : "pruned";
     
     // Determine format
     ROOTFormat format;
@@ -355,7 +267,7 @@ int main(int argc, char** argv) {
     cout << "Data type: " << (isHadron ? "Hadron" : isQuark ? "Quark/Parton" : "Unknown") << endl;
     
     // Initialize data reader
-    AMPTDataReader reader(format);
+    AMPTDataReader reader(format, reader_mode == "full" ? READER_FULL : READER_PRUNED);
     if (!reader.Initialize(inputFile)) {
         cout << "Error: Failed to initialize data reader" << endl;
         return 1;
@@ -473,10 +385,14 @@ int main(int argc, char** argv) {
         vector<int> pid_trks;
         vector<TVector3> p3_trks, x3_trks;
         
+        ColumnSpan<Int_t> pids = reader.GetPIDs();
+        ColumnSpan<Double_t> px = reader.GetPx(), py = reader.GetPy(), pz = reader.GetPz();
+        ColumnSpan<Double_t> x = reader.GetX(), y = reader.GetY(), z = reader.GetZ();
+        
         for (int iTrk = 0; iTrk < nParticles; iTrk++) {
-            int pdg = reader.GetPID(iTrk);
-            TVector3 p3 = reader.GetMomentum(iTrk);
-            TVector3 x3 = reader.GetPosition(iTrk);
+            int pdg = pids[iTrk];
+            TVector3 p3(px[iTrk], py[iTrk], pz[iTrk]);
+            TVector3 x3(x[iTrk], y[iTrk], z[iTrk]);
             
             float pT = p3.Pt();
             float eta = p3.Eta();
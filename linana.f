@@ -184,6 +184,8 @@ c     1 NELP,NINP,NELT,NINTHJ
 clin-2/2012:
 c         write(16,190) IAEVT,IARUN,nlast-ndpert,bimp,npart1,npart2,
 c     1 NELP,NINP,NELT,NINTHJ
+c     stage timing (stage_timer.h): 7 = output writes
+         call TIMER_BEGIN(7)
 c        Write to dat file (traditional output)
          write(16,191) IAEVT,IARUN,nlast-ndpert,bimp,npart1,npart2,
      1 NELP,NINP,NELT,NINTHJ,phiRP
@@ -281,6 +283,7 @@ c           Write to ROOT file
                endif
             endif
  1007    continue
+         call TIMER_END(7)
          if(ioscar.eq.1) call hoscar
       endif
  190  format(3(i7),f10.4,5x,6(i4))
@@ -1449,7 +1452,11 @@ cc      SAVE /tdecay/
      2       dpp1(MAXSTR,MAXR),dppion(MAXSTR,MAXR)
 cc      SAVE /RNDF77/
         common/phidcy/iphidcy,pttrig,ntrig,maxmiss,ipi0dcy
+        INTEGER*8 NWORK
+        COMMON /WRKCNT/ NWORK(12)
+cc      SAVE /WRKCNT/
         SAVE   
+        NWORK(12)=NWORK(12)+1
         irun=idecay
 clin-4/2012 for option of pi0 decay:
         if(nt.eq.ntmax.and.ipi0dcy.eq.1
@@ -8,6 +8,11 @@ c
       integer icoal_method
       CHARACTER FRAME*8, PROJ*8, TARG*8
       character*25 amptvn
+      character*16 argevt
+      character*256 batlst
+      dimension ickkey(6)
+      double precision stgkey(41)
+      double precision hjkey(24)
       COMMON /ARPRC/ ITYPAR(MAXSTR),
      &     GXAR(MAXSTR), GYAR(MAXSTR), GZAR(MAXSTR), FTAR(MAXSTR),
      &     PXAR(MAXSTR), PYAR(MAXSTR), PZAR(MAXSTR), PEAR(MAXSTR),
@@ -23,6 +28,10 @@ c     reshuffle initial quark momentum (added 2024):
       COMMON /ARPRNT/ ARPAR1(100), IAPAR2(50), ARINT1(100), IAINT2(50)
       COMMON /AROUT/ IOUT
       COMMON /AREVT/ IAEVT, IARUN, MISS
+      COMMON /PARA1/ MUL
+c     transport work counters of the event (wrkcnt.f):
+      INTEGER*8 NWORK
+      COMMON /WRKCNT/ NWORK(12)
       COMMON /smearz/smearp,smearh
       COMMON/RNDF77/NSEED
       common/anim/nevent,isoft,isflag,izpc
@@ -52,11 +61,35 @@ clin-7/2009:
       common/cmsflag/dshadow,ishadow
 clin-2/2012 allow random orientation of reaction plane:
       common /phiHJ/iphirp,phiRP
+c     ZPC cell grid: fixed (0) or density-adaptive per event (1):
+      common /zpcgrd/ izgrid
+c     coalescence partner search: all partons (0) or phase-space grid (1):
+      common /czcgrd/ icgrid
+c     B/M competition: serial (0) or in NBMDOM parallel eta_s slabs:
+      common /czbmdm/ nbmdom
 
       EXTERNAL HIDATA, PYDATA, LUDATA, ARDATA, PPBDAT, zpcbdt
       SAVE   
 c****************
-      OPEN (24, FILE = 'input.ampt', STATUS = 'UNKNOWN')
+c     batch mode "ampt -b LIST" (batch.cpp): the configurations of LIST
+c     run in processes forked after one ARSIZE and HIJSET per system,
+c     each in its own run directory with the HIJING seed read here:
+      ibatch=0
+      ibgrp=0
+      if(iargc().ge.1) then
+         call getarg(1,argevt)
+         if(argevt.eq.'-b') then
+            if(iargc().lt.2) goto 112
+            ibatch=1
+         endif
+      endif
+      if(ibatch.eq.1) then
+         call getarg(2,batlst)
+         READ (*, *) nseedr
+         call flush(6)
+         CALL BATCH_OPEN(batlst)
+      endif
+ 10   OPEN (24, FILE = 'input.ampt', STATUS = 'UNKNOWN')
       OPEN (12, FILE = 'ana/version', STATUS = 'UNKNOWN')
       READ (24, *) EFRM
 c     format-read characters (for ALPHA compilers):
@@ -107,7 +140,7 @@ c     validate coalescence parameters:
       if(icoal_method.lt.1.or.icoal_method.gt.3) then
          write(6,*) 'Invalid coalescence method:',icoal_method
          write(6,*) 'Valid: 1=classic, 2=BM_competition, 3=random'
-         stop
+         stop 1
       endif
       if(drbmRatio.lt.0.0.or.drbmRatio.gt.2.0) then
          write(6,*) 'Warning: drbmRatio out of typical range:',drbmRatio
@@ -145,9 +178,93 @@ c     reshuffle initial quark momentum option (added 2024):
       IF(ISHLF.gt.0) THEN
         write(6,*) 'Reshuffle initial momentum ON with ISHLF=',ISHLF
       ENDIF
-c
-      CLOSE (24)
+c     options added after ISHLF, each 0 by default; an older input.ampt
+c     ends before them and keeps the defaults of the missing ones:
+      izgrid=0
+      icgrid=0
+      nbmdom=0
+      iarsiz=0
+      irngbk=0
+      iseedev=0
+      ickpt=0
+      ipcach=0
+      ihcach=0
+c     ZPC cell grid option:
+      READ (24, *, err=113, end=113) izgrid
+c     coalescence partner search option:
+      READ (24, *, err=113, end=113) icgrid
+c     B/M competition domains:
+      READ (24, *, err=113, end=113) nbmdom
+c     transport array sizes: full MAXSTR/MAXPTN (0) or from the system (1):
+      READ (24, *, err=113, end=113) iarsiz
+c     random number backend: legacy generators (0) or Philox (1):
+      READ (24, *, err=113, end=113) irngbk
+c     event-indexed seeding: off (0) or seeds from (NSEED, event) (1):
+      READ (24, *, err=113, end=113) iseedev
+c     restart checkpoint every ickpt events (0: off):
+      READ (24, *, err=113, end=113) ickpt
+c     parton cache after ZPC: off (0), record (1) or replay (2):
+      READ (24, *, err=113, end=113) ipcach
+c     HIJING cache: off (0), record (1) or replay (2):
+      READ (24, *, err=113, end=113) ihcach
+      goto 114
+ 113  write(6,*) 'input.ampt ends before the options added after ',
+     1     'ISHLF, the missing ones are 0'
+ 114  CLOSE (24)
  111  format(a8)
+c
+c     batch mode: the system key holds every input of ARSIZE and HIJSET,
+c     including the seeds of the VEGAS integration of the jet cross
+c     sections; the first configuration of a group sets them up and
+c     forks a process per configuration, which re-reads its own input:
+      if(ibatch.eq.1) then
+         hjkey(1)=EFRM
+         hjkey(2)=2
+         if(FRAME.eq.'CMS') hjkey(2)=0
+         if(FRAME.eq.'LAB') hjkey(2)=1
+         hjkey(3)=0
+         hjkey(4)=0
+         do 15 ic=1,4
+            hjkey(3)=hjkey(3)+ichar(PROJ(ic:ic))*256d0**(ic-1)
+            hjkey(4)=hjkey(4)+ichar(TARG(ic:ic))*256d0**(ic-1)
+ 15      continue
+         hjkey(5)=IAP
+         hjkey(6)=IZP
+         hjkey(7)=IAT
+         hjkey(8)=IZT
+         hjkey(9)=PARJ(41)
+         hjkey(10)=PARJ(42)
+         hjkey(11)=ipop
+         hjkey(12)=PARJ(5)
+         hjkey(13)=IHPR2(6)
+         hjkey(14)=IHPR2(4)
+         hjkey(15)=HIPR1(14)
+         hjkey(16)=HIPR1(8)
+         hjkey(17)=IHPR2(2)
+         hjkey(18)=IHPR2(5)
+         hjkey(19)=ishadow
+         hjkey(20)=dshadow
+         hjkey(21)=iarsiz
+         hjkey(22)=nseed
+         if(ihjsed.eq.11) hjkey(22)=nseedr
+         hjkey(23)=iseedp
+         hjkey(24)=irngbk
+         if(ibgrp.eq.0) then
+            CLOSE(12)
+            if(ihjsed.eq.11) nseed=nseedr
+            NSEED=2*NSEED+1
+            CALL SRAND(NSEED)
+            CALL RNGINI(irngbk)
+            IHPR2(10)=1
+            CALL ARSIZE(iarsiz, EFRM, FRAME, IAP, IAT)
+            CALL HIJSET(EFRM, FRAME, PROJ, TARG, IAP, IZP, IAT, IZT)
+            ibgrp=1
+            call flush(6)
+            CALL BATCH_FORK(hjkey, 24)
+            goto 10
+         endif
+         CALL BATCH_CHECK(hjkey, 24)
+      endif
 clin-6/2009 ctest off turn on jet triggering:
 c      IHPR2(3)=1
 c     Trigger Pt of high-pt jets in HIJING:
@@ -170,11 +287,11 @@ c
      &10X,'##################################################'/1X,
      &10X,' ')
 c     when ihjsed=11: use environment variable at run time for HIJING nseed:
-      if(ihjsed.eq.11) then
+      if(ihjsed.eq.11.and.ibatch.eq.0) then
          PRINT *,
      1 '# Read in NSEED in HIJING at run time (e.g. 20030819):'
       endif
-      READ (*, *) nseedr
+      if(ibatch.eq.0) READ (*, *) nseedr
       if(ihjsed.eq.11) then
          nseed=nseedr
       endif
@@ -183,11 +300,18 @@ c     when ihjsed=11: use environment variable at run time for HIJING nseed:
          WRITE(12,*) '# Read in NSEED in HIJING at run time:',nseed
       endif
       CLOSE(12)
+c     master seeds of event-indexed seeding (EVTSED):
+      nseedm=nseed
+      isedpm=iseedp
 clin-5/2015 an odd number is needed for the random number generator:
 c      if(mod(NSEED,2).eq.0) NSEED=NSEED+1
       NSEED=2*NSEED+1
 c     9/26/03 random number generator for f77 compiler:
-      CALL SRAND(NSEED)
+c     (in batch mode the generators continue from the group's HIJSET)
+      if(ibatch.eq.0) then
+         CALL SRAND(NSEED)
+         CALL RNGINI(irngbk)
+      endif
 c
 c.....turn on warning messages in nohup.out when an event is repeated:
       IHPR2(10) = 1
@@ -201,6 +325,116 @@ c     smearh is the smearing halfwidth on string production point z0.
       smearh=1.2d0*IAmax**0.3333d0/(dble(EFRM)/2/0.938d0)
       nevent=NEVNT
 c
+c     event range from the command line: "ampt FIRST" runs NEVNT events
+c     from event FIRST on, "ampt FIRST LAST" runs events FIRST to LAST-1:
+c     a leading "-r" resumes the run from its last checkpoint (CKPRST):
+      IEVFST=1
+      IEVLST=NEVNT
+      irest=0
+      iarg0=0
+      if(iargc().ge.1.and.ibatch.eq.0) then
+         call getarg(1,argevt)
+         if(argevt.eq.'-r') then
+            irest=1
+            iarg0=1
+         endif
+      endif
+      if(iargc().ge.iarg0+1.and.ibatch.eq.0) then
+         call getarg(iarg0+1,argevt)
+         read(argevt,*,err=112) IEVFST
+         IEVLST=IEVFST+NEVNT-1
+         if(iargc().ge.iarg0+2) then
+            call getarg(iarg0+2,argevt)
+            read(argevt,*,err=112) IEVLST
+            IEVLST=IEVLST-1
+         endif
+         if(IEVFST.lt.1.or.IEVLST.lt.IEVFST) goto 112
+         nevent=IEVLST-IEVFST+1
+         write(6,*) 'events ',IEVFST,' to ',IEVLST
+         if(iseedev.ne.1) write(6,*) 'warning: iseedev=0, the ',
+     1        'events differ from those of a run from event 1'
+      endif
+c
+c     checkpoint/restart: the state at an event boundary is the event
+c     number only if every event is seeded from its number (EVTSED):
+      if((ickpt.gt.0.or.irest.eq.1).and.iseedev.ne.1) then
+         write(6,*) 'checkpoints (ickpt>0) and restart (-r) need ',
+     1        'event-indexed seeding (iseedev=1)'
+         stop 1
+      endif
+      ickkey(1)=IEVFST
+      ickkey(2)=IEVLST
+      ickkey(3)=nseedm
+      ickkey(4)=isedpm
+      ickkey(5)=irngbk
+      ickkey(6)=isoft
+      JCK=0
+      if(irest.eq.1) CALL CKPRST(ickkey, JCK)
+      if(JCK.gt.0) IEVFST=JCK+1
+c
+c     stage caches after HIJING and after ZPC (stgcache.f), keyed by
+c     every setting that the state at the end of the stage depends on:
+      if(ihcach.lt.0.or.ihcach.gt.2.or.ipcach.lt.0.or.ipcach.gt.2)
+     1     then
+         write(6,*) 'ihcach and ipcach must be 0, 1 or 2'
+         stop 1
+      endif
+      if((ihcach.ne.0.or.ipcach.ne.0).and.isoft.ne.3.and.isoft.ne.4
+     1     .and.isoft.ne.5) then
+         write(6,*) 'the stage caches (ihcach, ipcach) need string ',
+     1        'melting (isoft=3, 4 or 5)'
+         stop 1
+      endif
+      if(ipcach.eq.2.and.ihcach.ne.0) then
+         write(6,*) 'HIJING is not run with ipcach=2, set ihcach=0'
+         stop 1
+      endif
+      stgkey(1)=EFRM
+      stgkey(2)=2
+      if(FRAME.eq.'CMS') stgkey(2)=0
+      if(FRAME.eq.'LAB') stgkey(2)=1
+      stgkey(3)=IAP
+      stgkey(4)=IZP
+      stgkey(5)=IAT
+      stgkey(6)=IZT
+      stgkey(7)=BMIN
+      stgkey(8)=BMAX
+      stgkey(9)=isoft
+      stgkey(10)=PARJ(41)
+      stgkey(11)=PARJ(42)
+      stgkey(12)=ipop
+      stgkey(13)=PARJ(5)
+      stgkey(14)=IHPR2(6)
+      stgkey(15)=IHPR2(4)
+      stgkey(16)=HIPR1(14)
+      stgkey(17)=HIPR1(8)
+      stgkey(18)=nseedm
+      stgkey(19)=isedpm
+      stgkey(20)=irngbk
+      stgkey(21)=iseedev
+      stgkey(22)=pttrig
+      stgkey(23)=maxmiss
+      stgkey(24)=IHPR2(2)
+      stgkey(25)=IHPR2(5)
+      stgkey(26)=iembed
+      stgkey(27)=pxqembd
+      stgkey(28)=pyqembd
+      stgkey(29)=xembd
+      stgkey(30)=yembd
+      stgkey(31)=nsembd
+      stgkey(32)=psembd
+      stgkey(33)=tmaxembd
+      stgkey(34)=ishadow
+      stgkey(35)=dshadow
+      stgkey(36)=iphirp
+      stgkey(37)=xmu
+      stgkey(38)=izpc
+      stgkey(39)=alpha
+      stgkey(40)=ISHLF
+      stgkey(41)=izgrid
+      CALL STCOPN(ihcach, 1, nseedm, isedpm, stgkey, 36)
+      CALL STCOPN(ipcach, 2, nseedm, isedpm, stgkey, 41)
+c
 c     AMPT momentum and space info at freezeout:
       OPEN (16, FILE = 'ana/ampt.dat', STATUS = 'UNKNOWN')
       OPEN (14, FILE = 'ana/zpc.dat', STATUS = 'UNKNOWN')
@@ -214,10 +448,16 @@ c     hadrons before string melting (added 2024):
 ctest off for resonance (phi, K*) studies:
 c      OPEN (17, FILE = 'ana/res-gain.dat', STATUS = 'UNKNOWN')
 c      OPEN (18, FILE = 'ana/res-loss.dat', STATUS = 'UNKNOWN')
-      CALL HIJSET(EFRM, FRAME, PROJ, TARG, IAP, IZP, IAT, IZT)
+c     (in batch mode they were set up before the fork)
+      if(ibatch.eq.0) then
+         CALL ARSIZE(iarsiz, EFRM, FRAME, IAP, IAT)
+         CALL HIJSET(EFRM, FRAME, PROJ, TARG, IAP, IZP, IAT, IZT)
+      endif
       CALL ARTSET
       CALL INIZPC
 c
+c     ROOT outputs of a restart continue from the checkpoint of event JCK
+      call CKPT_ROOT_INIT(JCK)
 c     Initialize online ROOT conversion
       call INIT_ROOT()
       write(6,*) 'ROOT conversion initialized'
@@ -233,6 +473,10 @@ c     Initialize hadron before ART ROOT conversion
 c     Initialize hadron before melting ROOT conversion
       call INIT_HADRON_BEFORE_MELTING_ROOT()
       write(6,*) 'Hadron before melting ROOT conversion initialized'
+c     per-event stage timing (AMPT_TIMING, stage_timer.h), stages
+c     1 HIJING, 2 getnp, 3 ZPC, 4 coalescence, 5 ARINI, 6 ART, 7 writes,
+c     with the work counters NWORK stored next to the multiplicities:
+      call TIMER_INIT()
 c
 clin-5/2009 ctest off:
 c      call flowp(0)
@@ -240,16 +484,25 @@ c      call flowh0(NEVNT,0)
 c      call iniflw(NEVNT,0)
 c      call frztm(NEVNT,0)
 c
-       DO 2000 J = 1, NEVNT
+       DO 2000 J = IEVFST, IEVLST
+c     restart checkpoint after every ickpt-th event:
+          if(ickpt.gt.0.and.J.gt.IEVFST.and.mod(J-1,ickpt).eq.0)
+     1         CALL CKPSAV(J-1, ickkey)
+          call TIMER_EVENT_BEGIN()
+          call WRKCLR
           IAEVT = J
+c     restart the random number generators from (master seed, J):
+          if(iseedev.eq.1) CALL EVTSED(nseedm, isedpm, J)
           DO 1000 K = 1, NUM
              IARUN = K
-             IF (IAEVT .EQ. NEVNT .AND. IARUN .EQ. NUM) THEN
+             IF (IAEVT .EQ. IEVLST .AND. IARUN .EQ. NUM) THEN
                 IOUT = 1
              END IF
              PRINT *, ' EVENT ', J, ', RUN ', K
              imiss=0
- 100         CALL HIJING(FRAME, BMIN, BMAX)
+ 100         call TIMER_BEGIN(1)
+             CALL HIJING(FRAME, BMIN, BMAX)
+             call TIMER_END(1)
              IAINT2(1) = NATT             
 
 clin-6/2009 ctest off
@@ -272,9 +525,11 @@ clin-6/2009 ctest off
            endif
 
 c     evaluate Npart (from primary NN collisions) for both proj and targ:
+             call TIMER_BEGIN(2)
              call getnp
+             call TIMER_END(2)
 c     switch for final parton fragmentation:
-             IF (IHPR2(20) .EQ. 0) GOTO 2000
+             IF (IHPR2(20) .EQ. 0) GOTO 1999
 c     In the unlikely case of no interaction (even after loop of 20 in HIJING),
 c     still repeat the event to get an interaction 
 c     (this may have an additional "trigger" effect):
@@ -285,16 +540,19 @@ c     (this may have an additional "trigger" effect):
                    goto 100
                 else
                    write(6,*) 'missed event: natt=0,j=',j
-                   goto 2000
+                   goto 1999
                 endif
              endif
 c.....ART initialization and run
+             call TIMER_BEGIN(5)
              CALL ARINI
              CALL ARINI2(K)
+             call TIMER_END(5)
  1000     CONTINUE
 c
 clin-2024 save hadrons after ZPC+coalescence, before ART:
           if(isoft.eq.4.or.isoft.eq.5) then
+             call TIMER_BEGIN(7)
 c            Write to dat file (traditional output)
              WRITE(99,*) J, MISS, IAINT2(1), bimp, NELP,NINP,NELT,NINTHJ
 c            Write to ROOT file (online conversion)
@@ -322,14 +580,19 @@ c                  Write to ROOT file
      2                  GXAR(ihad),GYAR(ihad),GZAR(ihad),FTAR(ihad))
                 endif
              enddo
+             call TIMER_END(7)
           endif
           CALL ARTAN1
 clin-9/2012 Analysis is not used:
 c          CALL HJANA3
+          call TIMER_BEGIN(6)
           CALL ARTMN
+          call TIMER_END(6)
 clin-9/2012 Analysis is not used:
 c          CALL HJANA4
           CALL ARTAN2
+c     events left early (no fragmentation, no interaction) end here too:
+ 1999  call TIMER_EVENT_END(J, IAINT2(1), MUL, NWORK)
  2000  CONTINUE
 c
 c       CALL ARTOUT(NEVNT)
@@ -354,8 +617,14 @@ c      Finalize hadron before melting ROOT conversion
 c      Finalize online ROOT conversion
        call FINALIZE_ROOT()
        write(6,*) 'ROOT conversion finalized'
+       call TIMER_FINALIZE()
+c      the run is complete, its checkpoint is no longer needed
+       if(ickpt.gt.0.or.JCK.gt.0) CALL CKPEND
 c
        STOP
+ 112   write(6,*) 'usage: ampt [-r] [FIRST [LAST]], 1 <= FIRST < LAST',
+     1      ' or ampt -b LIST'
+       STOP 1
  210   format(I6,2(1x,f8.3),1x,f10.3,1x,f6.3,4(1x,f8.2))
  211   format(I6,2(1x,f8.3),1x,f10.3,1x,f6.3,4(1x,e8.2))
        END
@@ -0,0 +1,110 @@
+#include "perf_counters.h"
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+const char* const kPerfCounterNames[PERF_NCOUNTERS] = {
+    "cycles", "instructions", "llc_misses", "branch_misses", "dtlb_misses"};
+
+PerfCounters::PerfCounters() : nopen(0) {
+    for (int i = 0; i < PERF_NCOUNTERS; i++) {
+        fds[i] = -1;
+        slot[i] = -1;
+    }
+}
+
+PerfCounters::~PerfCounters() {
+    Close();
+}
+
+#ifdef __linux__
+
+static int OpenCounter(uint32_t type, uint64_t config, int groupFd) {
+    perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = type;
+    attr.config = config;
+    attr.disabled = (groupFd < 0) ? 1 : 0;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED |
+                       PERF_FORMAT_TOTAL_TIME_RUNNING;
+    return (int)syscall(__NR_perf_event_open, &attr, 0, -1, groupFd, 0);
+}
+
+bool PerfCounters::Open(string& why) {
+    Close();
+    const uint64_t dtlbReadMiss = PERF_COUNT_HW_CACHE_DTLB |
+                                  (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                                  (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+    const uint32_t types[PERF_NCOUNTERS] = {PERF_TYPE_HARDWARE, PERF_TYPE_HARDWARE,
+                                            PERF_TYPE_HARDWARE, PERF_TYPE_HARDWARE,
+                                            PERF_TYPE_HW_CACHE};
+    const uint64_t configs[PERF_NCOUNTERS] = {PERF_COUNT_HW_CPU_CYCLES,
+                                              PERF_COUNT_HW_INSTRUCTIONS,
+                                              PERF_COUNT_HW_CACHE_MISSES,
+                                              PERF_COUNT_HW_BRANCH_MISSES, dtlbReadMiss};
+
+    fds[0] = OpenCounter(types[0], configs[0], -1);
+    if (fds[0] < 0) {
+        why = string("perf_event_open(cycles): ") + strerror(errno);
+        return false;
+    }
+    slot[0] = nopen++;
+    for (int i = 1; i < PERF_NCOUNTERS; i++) {
+        fds[i] = OpenCounter(types[i], configs[i], fds[0]);
+        if (fds[i] >= 0) slot[i] = nopen++;
+    }
+    ioctl(fds[0], PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+    ioctl(fds[0], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+    return true;
+}
+
+void PerfCounters::Close() {
+    for (int i = PERF_NCOUNTERS - 1; i >= 0; i--) {
+        if (fds[i] >= 0) close(fds[i]);
+        fds[i] = -1;
+        slot[i] = -1;
+    }
+    nopen = 0;
+}
+
+bool PerfCounters::Read(long long values[PERF_NCOUNTERS]) {
+    for (int i = 0; i < PERF_NCOUNTERS; i++) values[i] = -1;
+    if (fds[0] < 0) return false;
+    // nr, time_enabled, time_running, value[nr]
+    uint64_t buf[3 + PERF_NCOUNTERS];
+    ssize_t n = read(fds[0], buf, sizeof(buf));
+    if (n < (ssize_t)(3 * sizeof(uint64_t)) || (int)buf[0] != nopen) return false;
+    double scale = 1.0;
+    if (buf[2] > 0 && buf[2] < buf[1]) scale = (double)buf[1] / buf[2];
+    for (int i = 0; i < PERF_NCOUNTERS; i++) {
+        if (slot[i] >= 0) values[i] = (long long)(buf[3 + slot[i]] * scale);
+    }
+    return true;
+}
+
+#else  // no perf_event_open
+
+bool PerfCounters::Open(string& why) {
+    why = "perf_event_open is Linux only";
+    return false;
+}
+
+void PerfCounters::Close() {}
+
+bool PerfCounters::Read(long long values[PERF_NCOUNTERS]) {
+    for (int i = 0; i < PERF_NCOUNTERS; i++) values[i] = -1;
+    return false;
+}
+
+#endif
@@ -0,0 +1,43 @@
+#ifndef PERF_COUNTERS_H
+#define PERF_COUNTERS_H
+
+// Hardware counters of the calling thread via perf_event_open (Linux)
+//
+// Backend of the stage timer (stage_timer.h) for AMPT_TIMING=perf: cycles,
+// instructions, last-level cache misses, branch misses and dTLB load misses,
+// opened as one group so that every read covers the same interval.  A
+// counter the CPU, the kernel or the container does not provide (no PMU in
+// the VM, perf_event_paranoid, seccomp) is left out and reads as -1; if not
+// even cycles can be opened the backend is off and Open() says why.  When
+// the kernel multiplexes the group the counts are scaled by the fraction of
+// time it was scheduled.  Only the calling thread is counted, not the
+// OpenMP workers of czcoal.f and artdens.f.
+
+#include <string>
+
+const int PERF_NCOUNTERS = 5;
+
+// Branch names, in the order of the values
+extern const char* const kPerfCounterNames[PERF_NCOUNTERS];
+
+class PerfCounters {
+public:
+    PerfCounters();
+    ~PerfCounters();
+
+    // Open the group; false (with the reason in `why`) if no counter works
+    bool Open(std::string& why);
+    void Close();
+    bool IsOpen() const { return fds[0] >= 0; }
+    bool Has(int counter) const { return fds[counter] >= 0; }
+
+    // Counts since Open, scaled for multiplexing; -1 for missing counters
+    bool Read(long long values[PERF_NCOUNTERS]);
+
+private:
+    int fds[PERF_NCOUNTERS];
+    int slot[PERF_NCOUNTERS];  // position of each counter in the group read
+    int nopen;
+};
+
+#endif // PERF_COUNTERS_H
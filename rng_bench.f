@@ -0,0 +1,67 @@
+c.....rng_bench.f: cost per random number of RANART, RLU and ZPC ran1
+c.....with the original generators (irngbk=0) and the Philox backend
+c.....(irngbk=1), see RNGINI in amptsub.f.  Built as ampt-rng-bench,
+c.....run by bench_rng.sh.  Optional argument: numbers per generator.
+
+      PROGRAM RNGBEN
+
+      implicit double precision (a-h, o-z)
+      character*16 arg
+      character*6 cname(3)
+      COMMON/RNDF77/NSEED
+cc      SAVE /RNDF77/
+      common /rndm3/ iseedp
+cc      SAVE /rndm3/
+      EXTERNAL LUDATA
+      data cname/'RANART', 'RLU', 'ran1'/
+
+      n = 10000000
+      if (iargc() .ge. 1) then
+         call getarg(1, arg)
+         read (arg, *) n
+      end if
+
+      write (6, 101) 'generator', 'irngbk', 'ns/number', 'mean'
+      do 1002 irng = 0, 1
+         NSEED = 2 * 20030819 + 1
+         iseedp = 8
+         call srand(NSEED)
+         call rngini(irng)
+         do 1001 igen = 1, 3
+            sum = 0d0
+            call cpu_time(t0)
+            do 1000 i = 1, n
+               sum = sum + rngone(igen)
+ 1000       continue
+            call cpu_time(t1)
+            write (6, 102) cname(igen), irng, (t1 - t0) / n * 1d9,
+     &           sum / n
+ 1001    continue
+ 1002 continue
+
+ 101  format (a10, a8, a12, a12)
+ 102  format (a10, i8, f12.2, f12.6)
+      stop
+      end
+
+c.....one number from generator igen (1 RANART, 2 RLU, 3 ran1)
+
+      double precision function rngone(igen)
+
+      implicit double precision (a-h, o-z)
+      common /rndm3/ iseedp
+cc      SAVE /rndm3/
+      COMMON/RNDF77/NSEED
+cc      SAVE /RNDF77/
+      SAVE
+
+      if (igen .eq. 1) then
+         rngone = ranart(NSEED)
+      else if (igen .eq. 2) then
+         rngone = rlu(0)
+      else
+         rngone = ran1(iseedp)
+      end if
+
+      return
+      end
@@ -0,0 +1,67 @@
+#include "rng_philox.h"
+
+// Per-stream key and position (in 128-bit blocks)
+struct PhiloxStream {
+    uint32_t key[2];
+    uint64_t block;
+};
+
+static PhiloxStream g_streams[RNG_NSTREAMS];
+
+static PhiloxStream* GetStream(int stream) {
+    if (stream < 1 || stream > RNG_NSTREAMS) stream = 1;
+    return &g_streams[stream - 1];
+}
+
+extern "C" {
+
+void rng_seed_(const int* stream, const int* seed) {
+    PhiloxStream* s = GetStream(*stream);
+    s->key[0] = (uint32_t)*seed;
+    s->key[1] = (uint32_t)*stream;
+    s->block = 0;
+}
+
+void rng_fill_(const int* stream, double* buf, const int* n) {
+    PhiloxStream* s = GetStream(*stream);
+    const double scale = 1.0 / 4294967296.0;  // 2^-32
+    const int L = RNG_LANES;
+    int nblk = *n / 4;
+    // Blocks are independent: counter = (block index, 0, 0).  L blocks go
+    // through the rounds side by side so the loop over lanes vectorizes.
+    for (int i0 = 0; i0 < nblk; i0 += L) {
+        uint32_t c0[L], c1[L], c2[L], c3[L];
+        for (int j = 0; j < L; j++) {
+            uint64_t b = s->block + i0 + j;
+            c0[j] = (uint32_t)b;
+            c1[j] = (uint32_t)(b >> 32);
+            c2[j] = 0u;
+            c3[j] = 0u;
+        }
+        Philox4x32Lanes(c0, c1, c2, c3, s->key);
+        int m = nblk - i0 < L ? nblk - i0 : L;
+        for (int j = 0; j < m; j++) {
+            double* out = buf + 4 * (i0 + j);
+            out[0] = ((double)c0[j] + 0.5) * scale;
+            out[1] = ((double)c1[j] + 0.5) * scale;
+            out[2] = ((double)c2[j] + 0.5) * scale;
+            out[3] = ((double)c3[j] + 0.5) * scale;
+        }
+    }
+    s->block += nblk;
+}
+
+void rng_stgseed_(const int* master, const int* zpcseed, const int* ievt,
+                  const int* stage, int* seeds) {
+    // One block under a key apart from the transport streams
+    uint32_t ctr[4] = {(uint32_t)*ievt, (uint32_t)*stage, 0u, 0x45564E54u};  // "EVNT"
+    uint32_t key[2] = {(uint32_t)*master, (uint32_t)*zpcseed};
+    uint32_t x[4];
+    Philox4x32(ctr, key, x);
+    seeds[0] = (int)(2 * (x[0] & 0x3FFFFFFFu) + 1);
+    seeds[1] = (int)(x[1] % 900000000u);
+    seeds[2] = (int)(1 + x[2] % 100000000u);
+    seeds[3] = (int)(x[3] & 0x7FFFFFFFu);
+}
+
+} // extern "C"
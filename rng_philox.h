@@ -0,0 +1,90 @@
+#ifndef RNG_PHILOX_H
+#define RNG_PHILOX_H
+
+// Counter-based random numbers for the transport (irngbk=1 in input.ampt)
+//
+// The Fortran generators RANART (HIJING/ART), RLU (PYTHIA/JETSET) and ZPC's
+// ran1 each draw from one stream here when the Philox backend is selected.
+// A stream is keyed by (seed, stream number); number k of the stream is a
+// pure function of (key, k), so a whole buffer is generated in one
+// independent-block loop instead of one stateful update per call.
+// RNGINI (amptsub.f) seeds the streams, the Fortran functions take numbers
+// from a per-stream buffer in /RNGBUF/ and call rng_fill_ when it runs dry.
+// rng_stgseed_ hashes (master seed, event index, stage) into the seeds of
+// one stage of an event for STGSED (amptsub.f), with either backend; EVTSED
+// takes stage 0 at the start of the event.
+//
+// Philox4x32-10: Salmon et al., "Parallel random numbers: as easy as
+// 1, 2, 3", SC11.  Each 128-bit block gives four doubles (k+0.5)/2^32,
+// strictly inside (0, 1) and finer than rand() (2^-31) or RLU (2^-24).
+
+#include <cstdint>
+
+const int RNG_NSTREAMS = 3;  // 1 RANART, 2 RLU, 3 ZPC ran1
+
+// One Philox4x32-10 block: ctr[4] -> out[4] under key[2]
+inline void Philox4x32(const uint32_t ctr[4], const uint32_t key[2], uint32_t out[4]) {
+    const uint32_t M0 = 0xD2511F53u, M1 = 0xCD9E8D57u;
+    const uint32_t W0 = 0x9E3779B9u, W1 = 0xBB67AE85u;
+    uint32_t c0 = ctr[0], c1 = ctr[1], c2 = ctr[2], c3 = ctr[3];
+    uint32_t k0 = key[0], k1 = key[1];
+    for (int r = 0; r < 10; r++) {
+        uint64_t p0 = (uint64_t)M0 * c0;
+        uint64_t p1 = (uint64_t)M1 * c2;
+        uint32_t n0 = (uint32_t)(p1 >> 32) ^ c1 ^ k0;
+        uint32_t n2 = (uint32_t)(p0 >> 32) ^ c3 ^ k1;
+        c1 = (uint32_t)p1;
+        c3 = (uint32_t)p0;
+        c0 = n0;
+        c2 = n2;
+        k0 += W0;
+        k1 += W1;
+    }
+    out[0] = c0;
+    out[1] = c1;
+    out[2] = c2;
+    out[3] = c3;
+}
+
+// Philox4x32Lanes: the same on RNG_LANES blocks held in c0..c3, in place
+const int RNG_LANES = 8;
+
+inline void Philox4x32Lanes(uint32_t* c0, uint32_t* c1, uint32_t* c2, uint32_t* c3,
+                            const uint32_t key[2]) {
+    const uint32_t M0 = 0xD2511F53u, M1 = 0xCD9E8D57u;
+    const uint32_t W0 = 0x9E3779B9u, W1 = 0xBB67AE85u;
+    uint32_t k0 = key[0], k1 = key[1];
+    for (int r = 0; r < 10; r++) {
+        for (int j = 0; j < RNG_LANES; j++) {
+            uint64_t p0 = (uint64_t)M0 * c0[j];
+            uint64_t p1 = (uint64_t)M1 * c2[j];
+            uint32_t n0 = (uint32_t)(p1 >> 32) ^ c1[j] ^ k0;
+            uint32_t n2 = (uint32_t)(p0 >> 32) ^ c3[j] ^ k1;
+            c1[j] = (uint32_t)p1;
+            c3[j] = (uint32_t)p0;
+            c0[j] = n0;
+            c2[j] = n2;
+        }
+        k0 += W0;
+        k1 += W1;
+    }
+}
+
+extern "C" {
+// Key stream (1..RNG_NSTREAMS) with a seed and restart it at number 0
+void rng_seed_(const int* stream, const int* seed);
+
+// Next n numbers of the stream (n a multiple of 4) into buf
+void rng_fill_(const int* stream, double* buf, const int* n);
+
+// Seeds of stage `stage` of event ievt (iseedev=1 in input.ampt): 0 at
+// the start of the event, 1 and 2 where the stage caches restart after
+// HIJING and ZPC.  seeds[0] odd NSEED for rand(), seeds[1] MRLU(1) of RLU
+// (< 900000000), seeds[2] iseedp of ZPC ran1 and seeds[3] for
+// random_number, all positive and a pure function of (master, zpcseed,
+// ievt, stage)
+void rng_stgseed_(const int* master, const int* zpcseed, const int* ievt,
+                  const int* stage, int* seeds);
+}
+
+#endif // RNG_PHILOX_H
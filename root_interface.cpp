@@ -1,7 +1,17 @@
 #include "root_interface.h"
 #include <iostream>
 #include <cstring>
+#include <algorithm>
 #include "analysis_core.h"
+#include "event_ring.h"
+#include "event_skim.h"
+#include "event_index.h"
+#include "checkpoint.h"
+#include "stage_timer.h"
+#include <cstdio>
+#include <cstdlib>
+#include "TParameter.h"
+#include "TSystem.h"
 
 // Global variables definition
 TFile* ampt_file = nullptr;
@@ -33,6 +43,207 @@ int particle_count = 0;
 // Additional data for specialized files
 int current_miss = 0;
 
+// Publish the completed event of one stream to its shared-memory ring (if enabled).
+// Only the ampt stream carries runID/npart/phiRP; the other streams carry miss.
+static void publish_event(int stream, int count, bool withNelp) {
+    EventSlotHeader evt;
+    evt.eventID = current_eventID;
+    evt.runID = (stream == RING_AMPT) ? current_runID : 0;
+    evt.nParticles = count;
+    evt.npart1 = (stream == RING_AMPT) ? current_npart1 : 0;
+    evt.npart2 = (stream == RING_AMPT) ? current_npart2 : 0;
+    evt.nelp = withNelp ? current_nelp : 0;
+    evt.ninp = withNelp ? current_ninp : 0;
+    evt.nelt = withNelp ? current_nelt : 0;
+    evt.ninthj = withNelp ? current_ninthj : 0;
+    evt.miss = (stream == RING_AMPT) ? 0 : current_miss;
+    evt.impactParameter = current_impactParameter;
+    evt.phiRP = (stream == RING_AMPT) ? current_phiRP : 0.0;
+    event_ring_publish(stream, evt, count, particle_pid, particle_px, particle_py, particle_pz,
+                       particle_mass, particle_x, particle_y, particle_z, particle_t);
+}
+
+// Restart checkpoint (ickpt, "ampt -r"): event of the checkpoint being restored
+// (0 = new run), event of the newest state file, and the entry counts of each
+// stream's tree and sidecar index at the restored checkpoint (-1 = no index)
+static int g_ckpt_restart = 0;
+static int g_ckpt_last = 0;
+static Long64_t g_ckpt_entries[SKIM_NSTREAMS] = {0};
+static Long64_t g_ckpt_index_entries[SKIM_NSTREAMS] = {0};
+
+// Tree (and state directory) name of each stream, indexed by SkimStream
+static const char* const g_stream_names[SKIM_NSTREAMS] = {
+    "ampt", "zpc", "parton_initial", "hadron_before_art", "hadron_before_melting"};
+
+// Output file and tree of one stream: new, or reopened at the restored checkpoint
+static bool open_stream(int stream, const char* filename, const char* title,
+                        TFile*& file, TTree*& tree) {
+    if (g_ckpt_restart > 0) {
+        tree = RestoreTree(filename, g_stream_names[stream], g_ckpt_entries[stream], file);
+        if (!tree) {
+            std::cerr << "ERROR: Cannot restore " << filename << " from the checkpoint" << std::endl;
+            exit(1);
+        }
+        return true;
+    }
+    file = new TFile(filename, "RECREATE");
+    if (!file || file->IsZombie()) return false;
+    tree = new TTree(g_stream_names[stream], title);
+    return true;
+}
+
+// Sidecar event index of each stream (ana/<stream>.index.root), indexed by SkimStream
+static EventIndexWriter* g_event_index[SKIM_NSTREAMS] = {nullptr};
+
+static void open_event_index(int stream, const char* filename, const char* treeName,
+                             AnalysisCore* analysis) {
+    std::vector<int> codes;
+    std::vector<std::string> names;
+    if (analysis) {
+        codes = analysis->GetSpeciesCodes();
+        names = analysis->GetSpeciesNames();
+    }
+    Long64_t restoreEntries = -1;
+    if (g_ckpt_restart > 0) {
+        if (g_ckpt_index_entries[stream] < 0) return;  // checkpointed run had no index
+        restoreEntries = g_ckpt_index_entries[stream];
+    }
+    g_event_index[stream] = new EventIndexWriter();
+    if (!g_event_index[stream]->Open(filename, treeName, codes, names, restoreEntries)) {
+        delete g_event_index[stream];
+        g_event_index[stream] = nullptr;
+    }
+}
+
+// Add the entry just filled into tree; count is the particle count before skimming
+static void index_event(int stream, TTree* tree, int count, AnalysisCore* analysis) {
+    EventIndexWriter* writer = g_event_index[stream];
+    if (!writer) return;
+    EventIndexEntry row;
+    row.fileID = -1;
+    row.eventID = current_eventID;
+    row.runID = (stream == SKIM_AMPT) ? current_runID : 0;
+    row.entry = tree->GetEntries() - 1;
+    row.impactParameter = current_impactParameter;
+    row.npart1 = (stream == SKIM_AMPT) ? current_npart1 : 0;
+    row.npart2 = (stream == SKIM_AMPT) ? current_npart2 : 0;
+    row.nParticles = count;
+    row.nSpecies = 0;
+    if (analysis && count > 0) {
+        const std::vector<int>& acc = analysis->GetLastAcceptedPerSpecies();
+        row.nSpecies = std::min((int)acc.size(), INDEX_MAX_SPECIES);
+        for (int i = 0; i < row.nSpecies; i++) row.nAccepted[i] = acc[i];
+    }
+    writer->Fill(row);
+}
+
+static void close_event_index(int stream) {
+    if (!g_event_index[stream]) return;
+    g_event_index[stream]->Close();
+    delete g_event_index[stream];
+    g_event_index[stream] = nullptr;
+}
+
+// String info of the parton stream (defined with the parton initial interface)
+extern "C" {
+    extern int parton_istrg0[MAX_PARTICLES];
+    extern double parton_xstrg0[MAX_PARTICLES];
+    extern double parton_ystrg0[MAX_PARTICLES];
+}
+
+// Write-time skim of the completed event (AMPT_SKIM); runs after AnalysisCore so
+// skimmed-out events are still analysed.  On keep, current_nParticles becomes the
+// number of particles that survive the particle filter.
+static bool skim_event(int stream, int count, AnalysisCore* analysis, bool withStrings) {
+    if (!g_event_skim) return true;
+    
+    SkimEventVars evt;
+    evt.impactParameter = current_impactParameter;
+    evt.nParticles = count;
+    evt.npart1 = (stream == SKIM_AMPT) ? current_npart1 : 0;
+    evt.npart2 = (stream == SKIM_AMPT) ? current_npart2 : 0;
+    evt.nAccepted = (analysis && count > 0) ? analysis->GetLastAccepted() : 0;
+    
+    SkimColumns cols = {particle_pid, particle_px, particle_py, particle_pz, particle_mass,
+                        particle_x, particle_y, particle_z, particle_t,
+                        withStrings ? parton_istrg0 : nullptr,
+                        withStrings ? parton_xstrg0 : nullptr,
+                        withStrings ? parton_ystrg0 : nullptr};
+    int kept = count;
+    if (!g_event_skim->Apply(stream, evt, kept, cols)) return false;
+    current_nParticles = kept;
+    return true;
+}
+
+// Skim counters of one stream as a 4-bin histogram
+static void fill_skim_counters(TH1D& h, const SkimCounters& c) {
+    h.SetDirectory(nullptr);
+    h.GetXaxis()->SetBinLabel(1, "events_seen");
+    h.GetXaxis()->SetBinLabel(2, "events_dropped");
+    h.GetXaxis()->SetBinLabel(3, "particles_seen");
+    h.GetXaxis()->SetBinLabel(4, "particles_dropped");
+    h.SetBinContent(1, c.events_seen);
+    h.SetBinContent(2, c.events_dropped);
+    h.SetBinContent(3, c.particles_seen);
+    h.SetBinContent(4, c.particles_dropped);
+}
+
+// Store the skim counters of one stream in its (current) output file
+static void write_skim_counters(int stream) {
+    if (!g_event_skim || !g_event_skim->IsEnabled()) return;
+    TH1D h("skim_counters", "Write-time skim counters", 4, 0, 4);
+    fill_skim_counters(h, g_event_skim->GetCounters(stream));
+    h.Write();
+    TNamed config("skim_config", g_event_skim->GetConfigText().c_str());
+    config.Write();
+}
+
+// Restart: analysis histograms, skim counters and entry counts of the
+// checkpoint being restored, from its state file (see ckpt_root_save_)
+static void load_checkpoint_state() {
+    std::string name = CheckpointStateFile(g_ckpt_restart);
+    TDirectory* saved = gDirectory;
+    TFile* f = TFile::Open(name.c_str(), "READ");
+    if (!f || f->IsZombie()) {
+        std::cerr << "ERROR: Cannot open checkpoint state " << name << std::endl;
+        exit(1);
+    }
+    AnalysisCore* analyses[SKIM_NSTREAMS] = {g_analysis_ampt, g_analysis_zpc, g_analysis_parton,
+                                             g_analysis_hadron_before_art,
+                                             g_analysis_hadron_before_melting};
+    bool ok = true;
+    for (int s = 0; s < SKIM_NSTREAMS; s++) {
+        const char* stream = g_stream_names[s];
+        TParameter<Long64_t>* n = (TParameter<Long64_t>*)f->Get(Form("entries_%s", stream));
+        TParameter<Long64_t>* ni = (TParameter<Long64_t>*)f->Get(Form("index_entries_%s", stream));
+        if (!n || !ni) {
+            ok = false;
+            break;
+        }
+        g_ckpt_entries[s] = n->GetVal();
+        g_ckpt_index_entries[s] = ni->GetVal();
+        TDirectory* dir = f->GetDirectory(stream);
+        if (analyses[s] && !(dir && analyses[s]->LoadState(dir))) ok = false;
+        TH1D* h = (TH1D*)f->Get(Form("skim_counters_%s", stream));
+        if (g_event_skim && h) {
+            SkimCounters c;
+            c.events_seen = (long long)h->GetBinContent(1);
+            c.events_dropped = (long long)h->GetBinContent(2);
+            c.particles_seen = (long long)h->GetBinContent(3);
+            c.particles_dropped = (long long)h->GetBinContent(4);
+            g_event_skim->SetCounters(s, c);
+        }
+    }
+    f->Close();
+    delete f;
+    if (saved) saved->cd();
+    if (!ok) {
+        std::cerr << "ERROR: Incomplete checkpoint state " << name << std::endl;
+        exit(1);
+    }
+    std::cout << "Checkpoint state of event " << g_ckpt_restart << " restored" << std::endl;
+}
+
 extern "C" {
 
 void init_root_() {
@@ -40,43 +251,56 @@ void init_root_() {
     // Initialize real-time analysis
     init_analysis_();
     
-    // Create ROOT file
-    ampt_file = new TFile("ana/ampt.root", "RECREATE");
-    if (!ampt_file || ampt_file->IsZombie()) {
+    // Optional shared-memory rings for out-of-process consumers (AMPT_SHM_RING)
+    event_ring_init();
+    
+    // Optional write-time skim (AMPT_SKIM=<skim file>)
+    const char* skim_file = getenv("AMPT_SKIM");
+    if (skim_file && *skim_file && !g_event_skim) {
+        g_event_skim = new EventSkim();
+        g_event_skim->Load(skim_file);
+    }
+    
+    // Restart: accumulators and entry counts at the checkpoint
+    if (g_ckpt_restart > 0) load_checkpoint_state();
+    
+    // Create ROOT file and tree (reopened at the checkpoint on restart)
+    if (!open_stream(SKIM_AMPT, "ana/ampt.root", "AMPT final hadrons", ampt_file, ampt_tree)) {
         std::cerr << "ERROR: Cannot create ROOT file" << std::endl;
         return;
     }
-    
-    // Create tree
-    ampt_tree = new TTree("ampt", "AMPT final hadrons");
+    bool restored = g_ckpt_restart > 0;
     
     // 关键内存管理设置 - 解决200事件内存累积问题
     ampt_tree->SetAutoFlush(50);              // 每50个事件刷盘，更可预测的内存管理
     ampt_tree->SetAutoSave(200);              // 每200个事件创建恢复点（适合200事件任务）
     
     // Create branches - event header
-    ampt_tree->Branch("eventID", &current_eventID, "eventID/I");
-    ampt_tree->Branch("runID", &current_runID, "runID/I");  
-    ampt_tree->Branch("nParticles", &current_nParticles, "nParticles/I");
-    ampt_tree->Branch("impactParameter", &current_impactParameter, "impactParameter/D");
-    ampt_tree->Branch("npart1", &current_npart1, "npart1/I");
-    ampt_tree->Branch("npart2", &current_npart2, "npart2/I");
-    ampt_tree->Branch("nelp", &current_nelp, "nelp/I");
-    ampt_tree->Branch("ninp", &current_ninp, "ninp/I");
-    ampt_tree->Branch("nelt", &current_nelt, "nelt/I");
-    ampt_tree->Branch("ninthj", &current_ninthj, "ninthj/I");
-    ampt_tree->Branch("phiRP", &current_phiRP, "phiRP/D");
+    BindBranch(ampt_tree, restored, "eventID", &current_eventID, "eventID/I");
+    BindBranch(ampt_tree, restored, "runID", &current_runID, "runID/I");  
+    BindBranch(ampt_tree, restored, "nParticles", &current_nParticles, "nParticles/I");
+    BindBranch(ampt_tree, restored, "impactParameter", &current_impactParameter, "impactParameter/D");
+    BindBranch(ampt_tree, restored, "npart1", &current_npart1, "npart1/I");
+    BindBranch(ampt_tree, restored, "npart2", &current_npart2, "npart2/I");
+    BindBranch(ampt_tree, restored, "nelp", &current_nelp, "nelp/I");
+    BindBranch(ampt_tree, restored, "ninp", &current_ninp, "ninp/I");
+    BindBranch(ampt_tree, restored, "nelt", &current_nelt, "nelt/I");
+    BindBranch(ampt_tree, restored, "ninthj", &current_ninthj, "ninthj/I");
+    BindBranch(ampt_tree, restored, "phiRP", &current_phiRP, "phiRP/D");
     
     // Create branches - particle arrays (using D for double)
-    ampt_tree->Branch("pid", particle_pid, "pid[nParticles]/I");
-    ampt_tree->Branch("px", particle_px, "px[nParticles]/D");
-    ampt_tree->Branch("py", particle_py, "py[nParticles]/D");
-    ampt_tree->Branch("pz", particle_pz, "pz[nParticles]/D");
-    ampt_tree->Branch("mass", particle_mass, "mass[nParticles]/D");
-    ampt_tree->Branch("x", particle_x, "x[nParticles]/D");
-    ampt_tree->Branch("y", particle_y, "y[nParticles]/D");
-    ampt_tree->Branch("z", particle_z, "z[nParticles]/D");
-    ampt_tree->Branch("t", particle_t, "t[nParticles]/D");
+    BindBranch(ampt_tree, restored, "pid", particle_pid, "pid[nParticles]/I");
+    BindBranch(ampt_tree, restored, "px", particle_px, "px[nParticles]/D");
+    BindBranch(ampt_tree, restored, "py", particle_py, "py[nParticles]/D");
+    BindBranch(ampt_tree, restored, "pz", particle_pz, "pz[nParticles]/D");
+    BindBranch(ampt_tree, restored, "mass", particle_mass, "mass[nParticles]/D");
+    BindBranch(ampt_tree, restored, "x", particle_x, "x[nParticles]/D");
+    BindBranch(ampt_tree, restored, "y", particle_y, "y[nParticles]/D");
+    BindBranch(ampt_tree, restored, "z", particle_z, "z[nParticles]/D");
+    BindBranch(ampt_tree, restored, "t", particle_t, "t[nParticles]/D");
+    
+    // Sidecar event index for selective reads
+    open_event_index(SKIM_AMPT, "ana/ampt.index.root", "ampt", g_analysis_ampt);
     
     std::cout << "ROOT interface initialized" << std::endl;
 }
@@ -88,6 +312,8 @@ void finalize_root_() {
         // 强制保存所有数据并刷新basket，确保数据完整性
         ampt_tree->AutoSave("SaveSelf;FlushBaskets");
         ampt_tree->Write();  // Simple write without flags
+        write_skim_counters(SKIM_AMPT);
+        close_event_index(SKIM_AMPT);
         ampt_file->Close();
         delete ampt_file;
         ampt_file = nullptr;
@@ -98,6 +324,15 @@ void finalize_root_() {
     
     // Finalize real-time analysis
     finalize_analysis_();
+    
+    // Close shared-memory rings so that consumers can drain and exit
+    event_ring_finalize();
+    
+    if (g_event_skim) {
+        g_event_skim->PrintSummary();
+        delete g_event_skim;
+        g_event_skim = nullptr;
+    }
 }
 
 void write_ampt_event_header_(int* eventID, int* runID, int* nParticles, double* b,
@@ -115,6 +350,7 @@ void write_ampt_event_header_(int* eventID, int* runID, int* nParticles, double*
     current_nelt = *nelt;
     current_ninthj = *nint;
     current_phiRP = *phiRP;
+    StageTimerSetHadrons(*nParticles);
     
     // Reset particle counter
     particle_count = 0;
@@ -155,12 +391,19 @@ void write_ampt_particle_(int* pid, double* px, double* py, double* pz, double*
     
     // When we have all particles, fill the tree and analyze event
     if (particle_count == current_nParticles) {
-        if (ampt_tree) {
+        // Perform real-time analysis on completed event (before skimming)
+        StageTimerBegin(TIMER_ANALYSIS, SKIM_AMPT);
+        analyze_current_event_();
+        StageTimerEnd();
+        
+        publish_event(RING_AMPT, particle_count, true);
+        
+        StageTimerBegin(TIMER_FILL, SKIM_AMPT);
+        if (ampt_tree && skim_event(SKIM_AMPT, particle_count, g_analysis_ampt, false)) {
             ampt_tree->Fill();
+            index_event(SKIM_AMPT, ampt_tree, particle_count, g_analysis_ampt);
         }
-        
-        // Perform real-time analysis on completed event
-        analyze_current_event_();
+        StageTimerEnd();
     }
 }
 
@@ -171,38 +414,39 @@ int zpc_particle_count = 0;
 
 void init_zpc_root_() {
     
-    zpc_file = new TFile("ana/zpc.root", "RECREATE");
-    if (!zpc_file || zpc_file->IsZombie()) {
+    if (!open_stream(SKIM_ZPC, "ana/zpc.root", "AMPT zero momentum frame partons", zpc_file, zpc_tree)) {
         std::cerr << "ERROR: Cannot create zpc ROOT file" << std::endl;
         return;
     }
-    
-    zpc_tree = new TTree("zpc", "AMPT zero momentum frame partons");
+    bool restored = g_ckpt_restart > 0;
     
     // 内存管理设置
     zpc_tree->SetAutoFlush(50);
     zpc_tree->SetAutoSave(200);
     
     // Create branches - event header (IAEVT, MISS, MUL, bimp, NELP, NINP, NELT, NINTHJ)
-    zpc_tree->Branch("eventID", &current_eventID, "eventID/I");
-    zpc_tree->Branch("miss", &current_miss, "miss/I");
-    zpc_tree->Branch("nParticles", &current_nParticles, "nParticles/I");
-    zpc_tree->Branch("impactParameter", &current_impactParameter, "impactParameter/D");
-    zpc_tree->Branch("nelp", &current_nelp, "nelp/I");
-    zpc_tree->Branch("ninp", &current_ninp, "ninp/I");
-    zpc_tree->Branch("nelt", &current_nelt, "nelt/I");
-    zpc_tree->Branch("ninthj", &current_ninthj, "ninthj/I");
+    BindBranch(zpc_tree, restored, "eventID", &current_eventID, "eventID/I");
+    BindBranch(zpc_tree, restored, "miss", &current_miss, "miss/I");
+    BindBranch(zpc_tree, restored, "nParticles", &current_nParticles, "nParticles/I");
+    BindBranch(zpc_tree, restored, "impactParameter", &current_impactParameter, "impactParameter/D");
+    BindBranch(zpc_tree, restored, "nelp", &current_nelp, "nelp/I");
+    BindBranch(zpc_tree, restored, "ninp", &current_ninp, "ninp/I");
+    BindBranch(zpc_tree, restored, "nelt", &current_nelt, "nelt/I");
+    BindBranch(zpc_tree, restored, "ninthj", &current_ninthj, "ninthj/I");
     
     // Create branches - particle arrays (ITYP5, PX5, PY5, PZ5, XMASS5, GX5, GY5, GZ5, FT5)
-    zpc_tree->Branch("pid", particle_pid, "pid[nParticles]/I");
-    zpc_tree->Branch("px", particle_px, "px[nParticles]/D");
-    zpc_tree->Branch("py", particle_py, "py[nParticles]/D");
-    zpc_tree->Branch("pz", particle_pz, "pz[nParticles]/D");
-    zpc_tree->Branch("mass", particle_mass, "mass[nParticles]/D");
-    zpc_tree->Branch("x", particle_x, "x[nParticles]/D");
-    zpc_tree->Branch("y", particle_y, "y[nParticles]/D");
-    zpc_tree->Branch("z", particle_z, "z[nParticles]/D");
-    zpc_tree->Branch("t", particle_t, "t[nParticles]/D");
+    BindBranch(zpc_tree, restored, "pid", particle_pid, "pid[nParticles]/I");
+    BindBranch(zpc_tree, restored, "px", particle_px, "px[nParticles]/D");
+    BindBranch(zpc_tree, restored, "py", particle_py, "py[nParticles]/D");
+    BindBranch(zpc_tree, restored, "pz", particle_pz, "pz[nParticles]/D");
+    BindBranch(zpc_tree, restored, "mass", particle_mass, "mass[nParticles]/D");
+    BindBranch(zpc_tree, restored, "x", particle_x, "x[nParticles]/D");
+    BindBranch(zpc_tree, restored, "y", particle_y, "y[nParticles]/D");
+    BindBranch(zpc_tree, restored, "z", particle_z, "z[nParticles]/D");
+    BindBranch(zpc_tree, restored, "t", particle_t, "t[nParticles]/D");
+    
+    // Sidecar event index for selective reads
+    open_event_index(SKIM_ZPC, "ana/zpc.index.root", "zpc", g_analysis_zpc);
     
     std::cout << "ZPC ROOT interface initialized" << std::endl;
 }
@@ -213,6 +457,8 @@ void finalize_zpc_root_() {
         zpc_file->cd();
         zpc_tree->AutoSave("SaveSelf;FlushBaskets");
         zpc_tree->Write();
+        write_skim_counters(SKIM_ZPC);
+        close_event_index(SKIM_ZPC);
         zpc_file->Close();
         delete zpc_file;
         zpc_file = nullptr;
@@ -270,12 +516,19 @@ void write_zpc_particle_(int* pid, double* px, double* py, double* pz, double* m
     
     
     if (zpc_particle_count == current_nParticles) {
-        if (zpc_tree) {
+        // Perform real-time analysis on completed ZPC event (before skimming)
+        StageTimerBegin(TIMER_ANALYSIS, SKIM_ZPC);
+        analyze_zpc_event_();
+        StageTimerEnd();
+        
+        publish_event(RING_ZPC, zpc_particle_count, true);
+        
+        StageTimerBegin(TIMER_FILL, SKIM_ZPC);
+        if (zpc_tree && skim_event(SKIM_ZPC, zpc_particle_count, g_analysis_zpc, false)) {
             zpc_tree->Fill();
+            index_event(SKIM_ZPC, zpc_tree, zpc_particle_count, g_analysis_zpc);
         }
-        
-        // Perform real-time analysis on completed ZPC event
-        analyze_zpc_event_();
+        StageTimerEnd();
     }
 }
 
@@ -291,37 +544,38 @@ double parton_ystrg0[MAX_PARTICLES];
 
 void init_parton_initial_root_() {
     
-    parton_file = new TFile("ana/parton-initial.root", "RECREATE");
-    if (!parton_file || parton_file->IsZombie()) {
+    if (!open_stream(SKIM_PARTON_INITIAL, "ana/parton-initial.root", "AMPT initial partons after propagation", parton_file, parton_tree)) {
         std::cerr << "ERROR: Cannot create parton initial ROOT file" << std::endl;
         return;
     }
-    
-    parton_tree = new TTree("parton_initial", "AMPT initial partons after propagation");
+    bool restored = g_ckpt_restart > 0;
     
     // 内存管理设置
     parton_tree->SetAutoFlush(50);
     parton_tree->SetAutoSave(200);
     
     // Create branches - event header (iaevt, miss, mul, bimp)
-    parton_tree->Branch("eventID", &current_eventID, "eventID/I");
-    parton_tree->Branch("miss", &current_miss, "miss/I");
-    parton_tree->Branch("nParticles", &current_nParticles, "nParticles/I");
-    parton_tree->Branch("impactParameter", &current_impactParameter, "impactParameter/D");
+    BindBranch(parton_tree, restored, "eventID", &current_eventID, "eventID/I");
+    BindBranch(parton_tree, restored, "miss", &current_miss, "miss/I");
+    BindBranch(parton_tree, restored, "nParticles", &current_nParticles, "nParticles/I");
+    BindBranch(parton_tree, restored, "impactParameter", &current_impactParameter, "impactParameter/D");
     
     // Create branches - particle arrays (12 fields: ityp, px, py, pz, xmass, gx, gy, gz, ft, istrg0, xstrg0, ystrg0)
-    parton_tree->Branch("pid", particle_pid, "pid[nParticles]/I");
-    parton_tree->Branch("px", particle_px, "px[nParticles]/D");
-    parton_tree->Branch("py", particle_py, "py[nParticles]/D");
-    parton_tree->Branch("pz", particle_pz, "pz[nParticles]/D");
-    parton_tree->Branch("mass", particle_mass, "mass[nParticles]/D");
-    parton_tree->Branch("x", particle_x, "x[nParticles]/D");
-    parton_tree->Branch("y", particle_y, "y[nParticles]/D");
-    parton_tree->Branch("z", particle_z, "z[nParticles]/D");
-    parton_tree->Branch("t", particle_t, "t[nParticles]/D");
-    parton_tree->Branch("istrg0", parton_istrg0, "istrg0[nParticles]/I");
-    parton_tree->Branch("xstrg0", parton_xstrg0, "xstrg0[nParticles]/D");
-    parton_tree->Branch("ystrg0", parton_ystrg0, "ystrg0[nParticles]/D");
+    BindBranch(parton_tree, restored, "pid", particle_pid, "pid[nParticles]/I");
+    BindBranch(parton_tree, restored, "px", particle_px, "px[nParticles]/D");
+    BindBranch(parton_tree, restored, "py", particle_py, "py[nParticles]/D");
+    BindBranch(parton_tree, restored, "pz", particle_pz, "pz[nParticles]/D");
+    BindBranch(parton_tree, restored, "mass", particle_mass, "mass[nParticles]/D");
+    BindBranch(parton_tree, restored, "x", particle_x, "x[nParticles]/D");
+    BindBranch(parton_tree, restored, "y", particle_y, "y[nParticles]/D");
+    BindBranch(parton_tree, restored, "z", particle_z, "z[nParticles]/D");
+    BindBranch(parton_tree, restored, "t", particle_t, "t[nParticles]/D");
+    BindBranch(parton_tree, restored, "istrg0", parton_istrg0, "istrg0[nParticles]/I");
+    BindBranch(parton_tree, restored, "xstrg0", parton_xstrg0, "xstrg0[nParticles]/D");
+    BindBranch(parton_tree, restored, "ystrg0", parton_ystrg0, "ystrg0[nParticles]/D");
+    
+    // Sidecar event index for selective reads
+    open_event_index(SKIM_PARTON_INITIAL, "ana/parton-initial.index.root", "parton_initial", g_analysis_parton);
     
     std::cout << "Parton initial ROOT interface initialized" << std::endl;
 }
@@ -332,6 +586,8 @@ void finalize_parton_initial_root_() {
         parton_file->cd();
         parton_tree->AutoSave("SaveSelf;FlushBaskets");
         parton_tree->Write();
+        write_skim_counters(SKIM_PARTON_INITIAL);
+        close_event_index(SKIM_PARTON_INITIAL);
         parton_file->Close();
         delete parton_file;
         parton_file = nullptr;
@@ -391,12 +647,19 @@ void write_parton_initial_particle_(int* pid, double* px, double* py, double* pz
     
     
     if (parton_particle_count == current_nParticles) {
-        if (parton_tree) {
+        // Perform real-time analysis on completed parton event (before skimming)
+        StageTimerBegin(TIMER_ANALYSIS, SKIM_PARTON_INITIAL);
+        analyze_parton_event_();
+        StageTimerEnd();
+        
+        publish_event(RING_PARTON_INITIAL, parton_particle_count, false);
+        
+        StageTimerBegin(TIMER_FILL, SKIM_PARTON_INITIAL);
+        if (parton_tree && skim_event(SKIM_PARTON_INITIAL, parton_particle_count, g_analysis_parton, true)) {
             parton_tree->Fill();
+            index_event(SKIM_PARTON_INITIAL, parton_tree, parton_particle_count, g_analysis_parton);
         }
-        
-        // Perform real-time analysis on completed parton event
-        analyze_parton_event_();
+        StageTimerEnd();
     }
 }
 
@@ -407,38 +670,39 @@ int hadron_before_art_particle_count = 0;
 
 void init_hadron_before_art_root_() {
     
-    hadron_before_art_file = new TFile("ana/hadron-before-art.root", "RECREATE");
-    if (!hadron_before_art_file || hadron_before_art_file->IsZombie()) {
+    if (!open_stream(SKIM_HADRON_BEFORE_ART, "ana/hadron-before-art.root", "AMPT hadrons before ART cascade", hadron_before_art_file, hadron_before_art_tree)) {
         std::cerr << "ERROR: Cannot create hadron before ART ROOT file" << std::endl;
         return;
     }
-    
-    hadron_before_art_tree = new TTree("hadron_before_art", "AMPT hadrons before ART cascade");
+    bool restored = g_ckpt_restart > 0;
     
     // 内存管理设置
     hadron_before_art_tree->SetAutoFlush(50);
     hadron_before_art_tree->SetAutoSave(200);
     
     // Create branches - event header (J(IAEVT), MISS, IAINT2(1), bimp, NELP, NINP, NELT, NINTHJ)
-    hadron_before_art_tree->Branch("eventID", &current_eventID, "eventID/I");
-    hadron_before_art_tree->Branch("miss", &current_miss, "miss/I");
-    hadron_before_art_tree->Branch("nParticles", &current_nParticles, "nParticles/I");
-    hadron_before_art_tree->Branch("impactParameter", &current_impactParameter, "impactParameter/D");
-    hadron_before_art_tree->Branch("nelp", &current_nelp, "nelp/I");
-    hadron_before_art_tree->Branch("ninp", &current_ninp, "ninp/I");
-    hadron_before_art_tree->Branch("nelt", &current_nelt, "nelt/I");
-    hadron_before_art_tree->Branch("ninthj", &current_ninthj, "ninthj/I");
+    BindBranch(hadron_before_art_tree, restored, "eventID", &current_eventID, "eventID/I");
+    BindBranch(hadron_before_art_tree, restored, "miss", &current_miss, "miss/I");
+    BindBranch(hadron_before_art_tree, restored, "nParticles", &current_nParticles, "nParticles/I");
+    BindBranch(hadron_before_art_tree, restored, "impactParameter", &current_impactParameter, "impactParameter/D");
+    BindBranch(hadron_before_art_tree, restored, "nelp", &current_nelp, "nelp/I");
+    BindBranch(hadron_before_art_tree, restored, "ninp", &current_ninp, "ninp/I");
+    BindBranch(hadron_before_art_tree, restored, "nelt", &current_nelt, "nelt/I");
+    BindBranch(hadron_before_art_tree, restored, "ninthj", &current_ninthj, "ninthj/I");
     
     // Create branches - particle arrays (standard 9 fields)
-    hadron_before_art_tree->Branch("pid", particle_pid, "pid[nParticles]/I");
-    hadron_before_art_tree->Branch("px", particle_px, "px[nParticles]/D");
-    hadron_before_art_tree->Branch("py", particle_py, "py[nParticles]/D");
-    hadron_before_art_tree->Branch("pz", particle_pz, "pz[nParticles]/D");
-    hadron_before_art_tree->Branch("mass", particle_mass, "mass[nParticles]/D");
-    hadron_before_art_tree->Branch("x", particle_x, "x[nParticles]/D");
-    hadron_before_art_tree->Branch("y", particle_y, "y[nParticles]/D");
-    hadron_before_art_tree->Branch("z", particle_z, "z[nParticles]/D");
-    hadron_before_art_tree->Branch("t", particle_t, "t[nParticles]/D");
+    BindBranch(hadron_before_art_tree, restored, "pid", particle_pid, "pid[nParticles]/I");
+    BindBranch(hadron_before_art_tree, restored, "px", particle_px, "px[nParticles]/D");
+    BindBranch(hadron_before_art_tree, restored, "py", particle_py, "py[nParticles]/D");
+    BindBranch(hadron_before_art_tree, restored, "pz", particle_pz, "pz[nParticles]/D");
+    BindBranch(hadron_before_art_tree, restored, "mass", particle_mass, "mass[nParticles]/D");
+    BindBranch(hadron_before_art_tree, restored, "x", particle_x, "x[nParticles]/D");
+    BindBranch(hadron_before_art_tree, restored, "y", particle_y, "y[nParticles]/D");
+    BindBranch(hadron_before_art_tree, restored, "z", particle_z, "z[nParticles]/D");
+    BindBranch(hadron_before_art_tree, restored, "t", particle_t, "t[nParticles]/D");
+    
+    // Sidecar event index for selective reads
+    open_event_index(SKIM_HADRON_BEFORE_ART, "ana/hadron-before-art.index.root", "hadron_before_art", g_analysis_hadron_before_art);
     
     std::cout << "Hadron before ART ROOT interface initialized" << std::endl;
 }
@@ -449,6 +713,8 @@ void finalize_hadron_before_art_root_() {
         hadron_before_art_file->cd();
         hadron_before_art_tree->AutoSave("SaveSelf;FlushBaskets");
         hadron_before_art_tree->Write();
+        write_skim_counters(SKIM_HADRON_BEFORE_ART);
+        close_event_index(SKIM_HADRON_BEFORE_ART);
         hadron_before_art_file->Close();
         delete hadron_before_art_file;
         hadron_before_art_file = nullptr;
@@ -506,12 +772,19 @@ void write_hadron_before_art_particle_(int* pid, double* px, double* py, double*
     
     
     if (hadron_before_art_particle_count == current_nParticles) {
-        if (hadron_before_art_tree) {
+        // Perform real-time analysis on completed hadron-before-art event (before skimming)
+        StageTimerBegin(TIMER_ANALYSIS, SKIM_HADRON_BEFORE_ART);
+        analyze_hadron_before_art_event_();
+        StageTimerEnd();
+        
+        publish_event(RING_HADRON_BEFORE_ART, hadron_before_art_particle_count, true);
+        
+        StageTimerBegin(TIMER_FILL, SKIM_HADRON_BEFORE_ART);
+        if (hadron_before_art_tree && skim_event(SKIM_HADRON_BEFORE_ART, hadron_before_art_particle_count, g_analysis_hadron_before_art, false)) {
             hadron_before_art_tree->Fill();
+            index_event(SKIM_HADRON_BEFORE_ART, hadron_before_art_tree, hadron_before_art_particle_count, g_analysis_hadron_before_art);
         }
-        
-        // Perform real-time analysis on completed hadron-before-art event
-        analyze_hadron_before_art_event_();
+        StageTimerEnd();
     }
 }
 
@@ -522,38 +795,39 @@ int hadron_before_melting_particle_count = 0;
 
 void init_hadron_before_melting_root_() {
     
-    hadron_before_melting_file = new TFile("ana/hadron-before-melting.root", "RECREATE");
-    if (!hadron_before_melting_file || hadron_before_melting_file->IsZombie()) {
+    if (!open_stream(SKIM_HADRON_BEFORE_MELTING, "ana/hadron-before-melting.root", "AMPT hadrons before string melting", hadron_before_melting_file, hadron_before_melting_tree)) {
         std::cerr << "ERROR: Cannot create hadron-before-melting.root file" << std::endl;
         return;
     }
-    
-    hadron_before_melting_tree = new TTree("hadron_before_melting", "AMPT hadrons before string melting");
+    bool restored = g_ckpt_restart > 0;
     
     // 内存管理设置
     hadron_before_melting_tree->SetAutoFlush(50);
     hadron_before_melting_tree->SetAutoSave(200);
     
     // Event header branches
-    hadron_before_melting_tree->Branch("eventID", &current_eventID, "eventID/I");
-    hadron_before_melting_tree->Branch("miss", &current_miss, "miss/I");
-    hadron_before_melting_tree->Branch("nParticles", &current_nParticles, "nParticles/I");
-    hadron_before_melting_tree->Branch("impactParameter", &current_impactParameter, "impactParameter/D");
-    hadron_before_melting_tree->Branch("nelp", &current_nelp, "nelp/I");
-    hadron_before_melting_tree->Branch("ninp", &current_ninp, "ninp/I");
-    hadron_before_melting_tree->Branch("nelt", &current_nelt, "nelt/I");
-    hadron_before_melting_tree->Branch("ninthj", &current_ninthj, "ninthj/I");
+    BindBranch(hadron_before_melting_tree, restored, "eventID", &current_eventID, "eventID/I");
+    BindBranch(hadron_before_melting_tree, restored, "miss", &current_miss, "miss/I");
+    BindBranch(hadron_before_melting_tree, restored, "nParticles", &current_nParticles, "nParticles/I");
+    BindBranch(hadron_before_melting_tree, restored, "impactParameter", &current_impactParameter, "impactParameter/D");
+    BindBranch(hadron_before_melting_tree, restored, "nelp", &current_nelp, "nelp/I");
+    BindBranch(hadron_before_melting_tree, restored, "ninp", &current_ninp, "ninp/I");
+    BindBranch(hadron_before_melting_tree, restored, "nelt", &current_nelt, "nelt/I");
+    BindBranch(hadron_before_melting_tree, restored, "ninthj", &current_ninthj, "ninthj/I");
     
     // Particle data branches
-    hadron_before_melting_tree->Branch("pid", particle_pid, "pid[nParticles]/I");
-    hadron_before_melting_tree->Branch("px", particle_px, "px[nParticles]/D");
-    hadron_before_melting_tree->Branch("py", particle_py, "py[nParticles]/D");
-    hadron_before_melting_tree->Branch("pz", particle_pz, "pz[nParticles]/D");
-    hadron_before_melting_tree->Branch("mass", particle_mass, "mass[nParticles]/D");
-    hadron_before_melting_tree->Branch("x", particle_x, "x[nParticles]/D");
-    hadron_before_melting_tree->Branch("y", particle_y, "y[nParticles]/D");
-    hadron_before_melting_tree->Branch("z", particle_z, "z[nParticles]/D");
-    hadron_before_melting_tree->Branch("t", particle_t, "t[nParticles]/D");
+    BindBranch(hadron_before_melting_tree, restored, "pid", particle_pid, "pid[nParticles]/I");
+    BindBranch(hadron_before_melting_tree, restored, "px", particle_px, "px[nParticles]/D");
+    BindBranch(hadron_before_melting_tree, restored, "py", particle_py, "py[nParticles]/D");
+    BindBranch(hadron_before_melting_tree, restored, "pz", particle_pz, "pz[nParticles]/D");
+    BindBranch(hadron_before_melting_tree, restored, "mass", particle_mass, "mass[nParticles]/D");
+    BindBranch(hadron_before_melting_tree, restored, "x", particle_x, "x[nParticles]/D");
+    BindBranch(hadron_before_melting_tree, restored, "y", particle_y, "y[nParticles]/D");
+    BindBranch(hadron_before_melting_tree, restored, "z", particle_z, "z[nParticles]/D");
+    BindBranch(hadron_before_melting_tree, restored, "t", particle_t, "t[nParticles]/D");
+    
+    // Sidecar event index for selective reads
+    open_event_index(SKIM_HADRON_BEFORE_MELTING, "ana/hadron-before-melting.index.root", "hadron_before_melting", g_analysis_hadron_before_melting);
     
     std::cout << "Hadron before melting ROOT interface initialized" << std::endl;
 }
@@ -564,6 +838,8 @@ void finalize_hadron_before_melting_root_() {
         hadron_before_melting_file->cd();
         hadron_before_melting_tree->AutoSave("SaveSelf;FlushBaskets");
         hadron_before_melting_tree->Write();
+        write_skim_counters(SKIM_HADRON_BEFORE_MELTING);
+        close_event_index(SKIM_HADRON_BEFORE_MELTING);
         hadron_before_melting_file->Close();
         delete hadron_before_melting_file;
         hadron_before_melting_file = nullptr;
@@ -621,12 +897,19 @@ void write_hadron_before_melting_particle_(int* pid, double* px, double* py, dou
     
     
     if (hadron_before_melting_particle_count == current_nParticles) {
-        if (hadron_before_melting_tree) {
+        // Perform real-time analysis on completed hadron-before-melting event (before skimming)
+        StageTimerBegin(TIMER_ANALYSIS, SKIM_HADRON_BEFORE_MELTING);
+        analyze_hadron_before_melting_event_();
+        StageTimerEnd();
+        
+        publish_event(RING_HADRON_BEFORE_MELTING, hadron_before_melting_particle_count, true);
+        
+        StageTimerBegin(TIMER_FILL, SKIM_HADRON_BEFORE_MELTING);
+        if (hadron_before_melting_tree && skim_event(SKIM_HADRON_BEFORE_MELTING, hadron_before_melting_particle_count, g_analysis_hadron_before_melting, false)) {
             hadron_before_melting_tree->Fill();
+            index_event(SKIM_HADRON_BEFORE_MELTING, hadron_before_melting_tree, hadron_before_melting_particle_count, g_analysis_hadron_before_melting);
         }
-        
-        // Perform real-time analysis on completed hadron-before-melting event
-        analyze_hadron_before_melting_event_();
+        StageTimerEnd();
     }
 }
 
@@ -904,4 +1187,77 @@ void analyze_hadron_before_melting_event_() {
     }
 }
 
+// ===== Restart checkpoints (CKPSAV/CKPRST/CKPEND in amptsub.f) =====
+void ckpt_root_init_(int* event) {
+    g_ckpt_restart = *event;
+    g_ckpt_last = *event;
+}
+
+void ckpt_root_save_(int* event, int* status) {
+    *status = 1;
+    TTree* trees[SKIM_NSTREAMS] = {ampt_tree, zpc_tree, parton_tree, hadron_before_art_tree,
+                                   hadron_before_melting_tree};
+    AnalysisCore* analyses[SKIM_NSTREAMS] = {g_analysis_ampt, g_analysis_zpc, g_analysis_parton,
+                                             g_analysis_hadron_before_art,
+                                             g_analysis_hadron_before_melting};
+    for (int s = 0; s < SKIM_NSTREAMS; s++) {
+        CheckpointTree(trees[s]);
+        if (g_event_index[s]) g_event_index[s]->Checkpoint();
+    }
+    
+    // State file under a temporary name until it is complete
+    gSystem->mkdir(CKPT_DIR, kTRUE);
+    std::string name = CheckpointStateFile(*event);
+    std::string tmp = name + ".tmp";
+    TDirectory* saved = gDirectory;
+    TFile* f = new TFile(tmp.c_str(), "RECREATE");
+    if (f->IsZombie()) {
+        std::cerr << "ERROR: Cannot create checkpoint state " << tmp << std::endl;
+        delete f;
+        if (saved) saved->cd();
+        return;
+    }
+    TParameter<Int_t> evt("event", *event);
+    f->WriteTObject(&evt);
+    for (int s = 0; s < SKIM_NSTREAMS; s++) {
+        const char* stream = g_stream_names[s];
+        TParameter<Long64_t> n(Form("entries_%s", stream), trees[s] ? trees[s]->GetEntries() : 0);
+        TParameter<Long64_t> ni(Form("index_entries_%s", stream),
+                                g_event_index[s] ? g_event_index[s]->GetEntries() : -1);
+        f->WriteTObject(&n);
+        f->WriteTObject(&ni);
+        if (g_event_skim) {
+            TH1D h(Form("skim_counters_%s", stream), "Write-time skim counters", 4, 0, 4);
+            fill_skim_counters(h, g_event_skim->GetCounters(s));
+            f->WriteTObject(&h);
+        }
+        if (analyses[s]) analyses[s]->SaveState(f->mkdir(stream));
+    }
+    f->Close();
+    delete f;
+    if (saved) saved->cd();
+    if (rename(tmp.c_str(), name.c_str()) != 0) {
+        std::cerr << "ERROR: Cannot rename " << tmp << " to " << name << std::endl;
+        return;
+    }
+    *status = 0;
+}
+
+// The manifest now names *event: the previous state file is no longer needed
+void ckpt_root_done_(int* event) {
+    if (g_ckpt_last > 0 && g_ckpt_last != *event) {
+        remove(CheckpointStateFile(g_ckpt_last).c_str());
+    }
+    RemoveParkedFiles();
+    g_ckpt_last = *event;
+}
+
+// Run complete: drop the last state file and the (now empty) checkpoint directory
+void ckpt_root_end_() {
+    if (g_ckpt_last > 0) remove(CheckpointStateFile(g_ckpt_last).c_str());
+    g_ckpt_last = 0;
+    RemoveParkedFiles();
+    remove(CKPT_DIR);
+}
+
 } // extern "C"
\ No newline at end of file
@@ -45,7 +45,33 @@ extern "C" {
     void write_ampt_particle_(int* pid, double* px, double* py, double* pz, double* mass,
                             double* x, double* y, double* z, double* t);
     void write_parton_initial_event_header_(int* eventID, int* miss, int* nParticles, double* b);
-    
+    void write_parton_initial_particle_(int* pid, double* px, double* py, double* pz, double* mass,
+                                       double* x, double* y, double* z, double* t,
+                                       int* istrg0, double* xstrg0, double* ystrg0);
+
+    // Writers of the other four streams, opened and closed by main.f after init_root_
+    // and before finalize_root_
+    void init_zpc_root_();
+    void finalize_zpc_root_();
+    void write_zpc_event_header_(int* eventID, int* miss, int* nParticles, double* b,
+                                int* nelp, int* ninp, int* nelt, int* ninthj);
+    void write_zpc_particle_(int* pid, double* px, double* py, double* pz, double* mass,
+                            double* x, double* y, double* z, double* t);
+    void init_parton_initial_root_();
+    void finalize_parton_initial_root_();
+    void init_hadron_before_art_root_();
+    void finalize_hadron_before_art_root_();
+    void write_hadron_before_art_event_header_(int* eventID, int* miss, int* nParticles, double* b,
+                                              int* nelp, int* ninp, int* nelt, int* ninthj);
+    void write_hadron_before_art_particle_(int* pid, double* px, double* py, double* pz, double* mass,
+                                          double* x, double* y, double* z, double* t);
+    void init_hadron_before_melting_root_();
+    void finalize_hadron_before_melting_root_();
+    void write_hadron_before_melting_event_header_(int* eventID, int* miss, int* nParticles, double* b,
+                                                  int* nelp, int* ninp, int* nelt, int* ninthj);
+    void write_hadron_before_melting_particle_(int* pid, double* px, double* py, double* pz, double* mass,
+                                              double* x, double* y, double* z, double* t);
+
     // Real-time analysis interface functions for all 5 data streams
     void init_analysis_();
     void finalize_analysis_();
@@ -54,6 +80,13 @@ extern "C" {
     void analyze_parton_event_();
     void analyze_hadron_before_art_event_();
     void analyze_hadron_before_melting_event_();
+    
+    // Restart checkpoints (ickpt in input.ampt, checkpoint.h): restored event
+    // (0 = new run), save after an event, commit, and cleanup at the end of a run
+    void ckpt_root_init_(int* event);
+    void ckpt_root_save_(int* event, int* status);
+    void ckpt_root_done_(int* event);
+    void ckpt_root_end_();
 }
 
 #endif
\ No newline at end of file
@@ -29,6 +29,15 @@ else
 fi
 WORK_DIR="${LOCAL_DIR}/ampt_job_${SLURM_ARRAY_TASK_ID}"
 
+# 断点续跑: AMPT_CKPT=N 时每 N 个事件写一次检查点 (input.ampt 中的 ickpt)，
+# 工作目录放到网络存储上保留，作业被抢占或重新排队后从最近的检查点继续。
+# 检查点要求逐事件播种 (iseedev=1，下面同时打开)，所以事件与默认 iseedev=0
+# 的运行不同 (种子相同也不同)；中断后续跑的结果与同样设置一次跑完的相同
+if [ -n "$AMPT_CKPT" ]; then
+    WORK_DIR="$PROJECT_DIR/slurm_jobs/outputs/ckpt/ampt_job_${SLURM_ARRAY_TASK_ID}"
+    echo "检查点模式: 每 $AMPT_CKPT 个事件，工作目录保留在网络存储上"
+fi
+
 echo "项目目录: $PROJECT_DIR"
 echo "本地工作目录: $WORK_DIR"
 
@@ -57,6 +66,8 @@ export FC=gfortran
 JOB_ID=$1
 ISHLF=$2
 ICOAL_METHOD=$3
+FIRST_EVENT=$4
+LAST_EVENT=$5
 
 # 固定参数 - ALICE LHC设置
 ENERGY=5020
@@ -65,11 +76,17 @@ BMIN=7.65
 BMAX=8.83
 ISOFT=4
 
+# 事件分段模式: 只运行事件 [FIRST_EVENT, LAST_EVENT)
+if [ -n "$FIRST_EVENT" ] && [ -n "$LAST_EVENT" ]; then
+    NEVNT=$((LAST_EVENT - FIRST_EVENT))
+fi
+
 echo "配置参数:"
 echo "  作业ID    : $JOB_ID"  
 echo "  ZPC前打乱 : $ISHLF (0=不打乱, 1=d夸克, 2=u夸克, 3=s夸克, 4=u+d, 5=u+d+s, 6=全部)"
 echo "  聚合方式  : $ICOAL_METHOD (1=经典, 2=BM竞争, 3=随机)"
 echo "  固定参数  : 能量=${ENERGY}GeV(ALICE LHC), 事件数=${NEVNT}, 撞击参数=${BMIN}-${BMAX}fm(30-40%中心度), 铅-铅碰撞"
+[ -n "$FIRST_EVENT" ] && echo "  事件分段  : ${FIRST_EVENT} - $((LAST_EVENT - 1))"
 
 # ----------------------------
 # 3. 创建本地工作目录
@@ -78,11 +95,25 @@ echo "创建本地工作目录..."
 mkdir -p "$WORK_DIR/ana"
 cd "$WORK_DIR"
 
+# 上次运行留下的检查点: 沿用原来的 input.ampt，用 ampt -r 续跑
+RESUME=""
+if [ -n "$AMPT_CKPT" ] && [ -f "ana/ckpt/ampt.ckpt" ] && [ -f "input.ampt" ]; then
+    RESUME="-r"
+    echo "发现检查点: $(head -1 ana/ckpt/ampt.ckpt | awk '{print $1}') 个事件已完成，续跑"
+fi
+
 # 生成唯一的随机种子 - 确保每个作业都有不同的种子
 # 使用作业ID和数组任务ID确保唯一性和可重现性
 HIJING_SEED=$((13150909 + $SLURM_ARRAY_TASK_ID * 17 + ${SLURM_JOB_ID#*_} % 10000))
 ZPC_SEED=$((1 + $SLURM_ARRAY_TASK_ID * 7 + ${SLURM_JOB_ID#*_} % 99))
 
+# 事件分段模式下所有分段使用同一主种子，每个事件的随机数由
+# (主种子, 事件号) 决定 (iseedev=1)，与分段方式和运行节点无关
+if [ -n "$FIRST_EVENT" ]; then
+    HIJING_SEED=${MASTER_SEED:-13150909}
+    ZPC_SEED=${MASTER_ZPC_SEED:-8}
+fi
+
 echo "随机种子: HIJING=$HIJING_SEED, ZPC=$ZPC_SEED"
 
 # ----------------------------
@@ -103,30 +134,43 @@ cp "$PROJECT_DIR/ampt" .
 TEMPLATE_FILE="$PROJECT_DIR/slurm_jobs/templates/input.ampt.template"
 CONFIG_FILE="input.ampt"
 
-# 检查模板文件是否存在
-if [ ! -f "$TEMPLATE_FILE" ]; then
-    echo "错误: 模板文件不存在: $TEMPLATE_FILE"
-    exit 1
+# 续跑时种子和参数必须与检查点一致，沿用已有配置
+if [ -n "$RESUME" ]; then
+    echo "续跑: 使用已有配置 $CONFIG_FILE"
+else
+    # 检查模板文件是否存在
+    if [ ! -f "$TEMPLATE_FILE" ]; then
+        echo "错误: 模板文件不存在: $TEMPLATE_FILE"
+        exit 1
+    fi
+
+    echo "使用模板文件生成配置: $TEMPLATE_FILE"
+
+    # 使用sed进行模板变量替换
+    sed -e "s/{ENERGY}/$ENERGY/g" \
+        -e "s/{IAP}/208/g" \
+        -e "s/{IZP}/82/g" \
+        -e "s/{IAT}/208/g" \
+        -e "s/{IZT}/82/g" \
+        -e "s/{NEVNT}/$NEVNT/g" \
+        -e "s/{BMIN}/$BMIN/g" \
+        -e "s/{BMAX}/$BMAX/g" \
+        -e "s/{ISOFT}/$ISOFT/g" \
+        -e "s/{ICOAL_METHOD}/$ICOAL_METHOD/g" \
+        -e "s/{HIJING_SEED}/$HIJING_SEED/g" \
+        -e "s/{ZPC_SEED}/$ZPC_SEED/g" \
+        -e "s/{ISHLF}/$ISHLF/g" \
+        "$TEMPLATE_FILE" > "$CONFIG_FILE"
+
+    # 事件分段模式和检查点模式: 打开按事件号播种
+    if [ -n "$FIRST_EVENT" ] || [ -n "$AMPT_CKPT" ]; then
+        sed -i 's/^0\(\t*! event-indexed seeding\)/1\1/' "$CONFIG_FILE"
+    fi
+    if [ -n "$AMPT_CKPT" ]; then
+        sed -i "s/^0\(\t*! restart checkpoint\)/$AMPT_CKPT\1/" "$CONFIG_FILE"
+    fi
 fi
 
-echo "使用模板文件生成配置: $TEMPLATE_FILE"
-
-# 使用sed进行模板变量替换
-sed -e "s/{ENERGY}/$ENERGY/g" \
-    -e "s/{IAP}/208/g" \
-    -e "s/{IZP}/82/g" \
-    -e "s/{IAT}/208/g" \
-    -e "s/{IZT}/82/g" \
-    -e "s/{NEVNT}/$NEVNT/g" \
-    -e "s/{BMIN}/$BMIN/g" \
-    -e "s/{BMAX}/$BMAX/g" \
-    -e "s/{ISOFT}/$ISOFT/g" \
-    -e "s/{ICOAL_METHOD}/$ICOAL_METHOD/g" \
-    -e "s/{HIJING_SEED}/$HIJING_SEED/g" \
-    -e "s/{ZPC_SEED}/$ZPC_SEED/g" \
-    -e "s/{ISHLF}/$ISHLF/g" \
-    "$TEMPLATE_FILE" > "$CONFIG_FILE"
-
 # 验证配置文件生成成功
 if [ ! -f "$CONFIG_FILE" ] || [ ! -s "$CONFIG_FILE" ]; then
     echo "错误: 配置文件生成失败"
@@ -141,12 +185,17 @@ echo "配置文件生成成功: $CONFIG_FILE"
 # ----------------------------
 echo "开始运行AMPT模拟（本地存储）..."
 
+# nbmdom>=2 时 B/M 竞争的各分区以及 ART 平均场密度网格 (DENS) 按分配的 CPU 数开 OpenMP 线程
+export OMP_NUM_THREADS=${OMP_NUM_THREADS:-${SLURM_CPUS_PER_TASK:-1}}
+
 # 运行AMPT程序 (提供随机种子以防配置文件中ihjsed=11)
-echo "$HIJING_SEED" | ./ampt || {
+echo "$HIJING_SEED" | ./ampt $RESUME $FIRST_EVENT $LAST_EVENT || {
     echo "错误: AMPT运行失败"
-    # 清理本地存储
     cd "$ORIG_DIR"
-    rm -rf "$WORK_DIR"
+    # 检查点模式保留工作目录以便续跑，否则清理本地存储
+    if [ -z "$AMPT_CKPT" ]; then
+        rm -rf "$WORK_DIR"
+    fi
     exit 1
 }
 
@@ -171,6 +220,11 @@ if [ -d "ana" ]; then
     done
 fi
 
+# 阶段计时汇总 (AMPT_TIMING)
+if [ -f "ana/timing_summary.json" ]; then
+    cp "ana/timing_summary.json" "$RESULTS_DIR/timing_summary_job${JOB_ID}.json"
+fi
+
 # 复制input配置文件
 if [ -f "input.ampt" ]; then
     cp "input.ampt" "$RESULTS_DIR/input_job${JOB_ID}.ampt"
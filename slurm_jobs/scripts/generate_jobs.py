@@ -35,8 +35,13 @@ def generate_custom_params(ishlf_list, icoal_list, output_file="config/job_param
     print("输出文件: {}".format(output_file))
     return len(ishlf_list)
 
-def generate_params(output_file=None, jobs_per_combo=1):
-    """生成AMPT作业参数组合"""
+def generate_params(output_file=None, jobs_per_combo=1, events_per_job=0):
+    """生成AMPT作业参数组合
+
+    events_per_job > 0 时为事件分段模式: 同一组合的第 r 个任务运行事件
+    [r*events_per_job+1, (r+1)*events_per_job+1)，各任务使用同一主种子
+    (iseedev=1)，合起来等同于一次连续运行，单个事件也可单独重新生成。
+    """
     
     if output_file is None:
         output_file = "config/job_params.txt"
@@ -58,28 +63,43 @@ def generate_params(output_file=None, jobs_per_combo=1):
         job_id = 0
         for ishlf, icoal in params:
             for repeat in range(jobs_per_combo):
-                f.write("{} {}\n".format(ishlf, icoal))
+                if events_per_job > 0:
+                    first = repeat * events_per_job + 1
+                    f.write("{} {} {} {}\n".format(ishlf, icoal, first,
+                                                   first + events_per_job))
+                else:
+                    f.write("{} {}\n".format(ishlf, icoal))
                 job_id += 1
     
     print("生成了 {} 个AMPT作业参数".format(job_id))
+    if events_per_job > 0:
+        print("事件分段: 每个任务 {} 个事件，每个组合事件 1-{}".format(
+            events_per_job, jobs_per_combo * events_per_job))
     print("输出文件: {}".format(output_file))
     return job_id
 
 def main():
     """主函数"""
-    if len(sys.argv) > 2:
+    args = sys.argv[1:]
+    events_per_job = 0
+    if len(args) >= 2 and args[-2] == "--split" and args[-1].isdigit():
+        events_per_job = int(args[-1])
+        args = args[:-2]
+    if len(args) > 1 or (args and not args[0].isdigit()):
         print("用法:")
-        print("  python generate_jobs.py [N]                    # 生成AMPT作业参数，每个组合N个重复 (默认1)")
+        print("  python generate_jobs.py [N] [--split M]        # 生成AMPT作业参数，每个组合N个重复 (默认1)")
+        print("                                                 # --split M: 每个任务运行M个事件的一段 (iseedev=1)")
         print()
         print("示例:")
         print("  python generate_jobs.py                        # 6个参数组合，每个1个重复 = 6个任务 = 1200个事件") 
         print("  python generate_jobs.py 500                    # 6个参数组合，每个500个重复 = 3000个任务 = 600000个事件")
+        print("  python generate_jobs.py 50 --split 100         # 每个组合事件1-5000分成50段，可复现、可单独重算某个事件")
         return
     
-    jobs_per_combo = int(sys.argv[1]) if len(sys.argv) > 1 and sys.argv[1].isdigit() else 1
+    jobs_per_combo = int(args[0]) if args else 1
     
     # 生成AMPT作业参数
-    generate_params(jobs_per_combo=jobs_per_combo)
+    generate_params(jobs_per_combo=jobs_per_combo, events_per_job=events_per_job)
 
 if __name__ == "__main__":
     main()
\ No newline at end of file
@@ -35,7 +35,8 @@ echo -e "${YELLOW}参数预览:${NC}"
 grep -v '^#' "$PARAM_FILE" | grep -v '^[[:space:]]*$' | nl -v0 | while read num params; do
     ishlf=$(echo $params | awk '{print $1}')
     icoal=$(echo $params | awk '{print $2}')
-    echo "  任务$num: ISHLF=$ishlf, ICOAL_METHOD=$icoal"
+    range=$(echo $params | awk 'NF >= 4 {printf ", 事件 %d-%d", $3, $4 - 1}')
+    echo "  任务$num: ISHLF=$ishlf, ICOAL_METHOD=$icoal$range"
 done
 echo
 
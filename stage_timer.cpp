@@ -0,0 +1,449 @@
+#include "stage_timer.h"
+#include "perf_counters.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+#include <vector>
+#include <sys/resource.h>
+#include "TFile.h"
+#include "TNamed.h"
+#include "TTree.h"
+
+using namespace std;
+
+typedef chrono::steady_clock TimerClock;
+
+// Branch names; index 0 is the time of the event outside every stage
+static const char* const kStageNames[TIMER_NSTAGES] = {
+    "other", "hijing", "getnp", "zpc", "coal", "arini", "art", "write", "fill", "analysis"};
+
+// An open stage: time spent in the stages opened inside it is not its own
+struct TimerFrame {
+    int stage;
+    int stream;
+    TimerClock::time_point start;
+    double inner;
+    long long count0[PERF_NCOUNTERS];
+    long long countInner[PERF_NCOUNTERS];
+};
+
+static bool g_timing = false;
+static vector<TimerFrame> g_frames;
+static TimerClock::time_point g_event_start;
+static bool g_mismatch_reported = false;
+
+// Hardware counters (AMPT_TIMING=perf) and their values at the event start
+static PerfCounters g_perf;
+static bool g_use_perf = false;
+static long long g_event_count0[PERF_NCOUNTERS];
+
+// Work counter branches (wrkcnt.f slots) and the stage each belongs to
+static const char* const kWorkNames[TIMER_NWORK] = {
+    "zpc_coll",    "zpc_cell",    "zpc_form",    "coal_cand",      "art_pairs",  "art_range",
+    "art_coll_bb", "art_coll_mb", "art_coll_mm", "art_coll_bbbar", "art_nocoll", "art_decay"};
+static const int kWorkStage[TIMER_NWORK] = {TIMER_ZPC, TIMER_ZPC, TIMER_ZPC, TIMER_COAL,
+                                            TIMER_ART, TIMER_ART, TIMER_ART, TIMER_ART,
+                                            TIMER_ART, TIMER_ART, TIMER_ART, TIMER_ART};
+
+static TFile* g_timing_file = nullptr;
+static TTree* g_timing_tree = nullptr;
+
+// Entry of the timing tree
+static int t_event, t_natt, t_nparton, t_nhadron;
+static double t_total;
+static double t_stage[TIMER_NSTAGES];
+static double t_fill[TIMER_NSTREAMS], t_analysis[TIMER_NSTREAMS];
+static Long64_t t_count[PERF_NCOUNTERS][TIMER_NSTAGES];
+static Long64_t t_work[TIMER_NWORK];
+
+// Per-event samples for the summary: the stages, then the event total
+static vector<double> g_samples[TIMER_NSTAGES + 1];
+// Run totals of the counters per stage (-1: counter missing)
+static long long g_count_sum[PERF_NCOUNTERS][TIMER_NSTAGES];
+// Run totals and per-event maxima of the work counters
+static long long g_work_sum[TIMER_NWORK], g_work_max[TIMER_NWORK];
+// Run totals per stage of the number of times it was entered and of its
+// inclusive time (with the stages inside it)
+static long long g_calls[TIMER_NSTAGES];
+static double g_inclusive[TIMER_NSTAGES];
+
+static double Seconds(TimerClock::duration d) {
+    return chrono::duration<double>(d).count();
+}
+
+static void ClearEvent() {
+    memset(t_stage, 0, sizeof(t_stage));
+    memset(t_fill, 0, sizeof(t_fill));
+    memset(t_analysis, 0, sizeof(t_analysis));
+    memset(t_count, 0, sizeof(t_count));
+    t_nhadron = 0;
+    g_frames.clear();
+}
+
+void StageTimerBegin(int stage, int stream) {
+    if (!g_timing || stage <= 0 || stage >= TIMER_NSTAGES) return;
+    TimerFrame f;
+    f.stage = stage;
+    f.stream = stream;
+    f.inner = 0.0;
+    memset(f.countInner, 0, sizeof(f.countInner));
+    if (g_use_perf) g_perf.Read(f.count0);
+    f.start = TimerClock::now();
+    g_frames.push_back(f);
+}
+
+void StageTimerEnd() {
+    if (!g_timing || g_frames.empty()) return;
+    double dt = Seconds(TimerClock::now() - g_frames.back().start);
+    long long count[PERF_NCOUNTERS];
+    if (g_use_perf) g_perf.Read(count);
+    const TimerFrame& f = g_frames.back();
+    double self = dt - f.inner;
+    t_stage[f.stage] += self;
+    g_calls[f.stage]++;
+    g_inclusive[f.stage] += dt;
+    if (g_use_perf) {
+        for (int c = 0; c < PERF_NCOUNTERS; c++) {
+            count[c] -= f.count0[c];
+            t_count[c][f.stage] += count[c] - f.countInner[c];
+        }
+    }
+    if (f.stream >= 0 && f.stream < TIMER_NSTREAMS) {
+        if (f.stage == TIMER_FILL) t_fill[f.stream] += self;
+        if (f.stage == TIMER_ANALYSIS) t_analysis[f.stream] += self;
+    }
+    g_frames.pop_back();
+    if (g_frames.empty()) return;
+    g_frames.back().inner += dt;
+    if (g_use_perf) {
+        for (int c = 0; c < PERF_NCOUNTERS; c++) g_frames.back().countInner[c] += count[c];
+    }
+}
+
+void StageTimerSetHadrons(int nhadron) {
+    if (g_timing) t_nhadron = nhadron;
+}
+
+// Value at quantile q of the sorted samples (nearest rank)
+static double Quantile(const vector<double>& sorted, double q) {
+    if (sorted.empty()) return 0.0;
+    size_t i = (size_t)(q * (sorted.size() - 1) + 0.5);
+    return sorted[min(i, sorted.size() - 1)];
+}
+
+// One row of the summary: total, share of the run and per-event statistics
+static void SummaryRow(ostringstream& out, const char* name, vector<double> v,
+                       double runTotal) {
+    sort(v.begin(), v.end());
+    double sum = 0;
+    for (double t : v) sum += t;
+    char line[160];
+    snprintf(line, sizeof(line), "%-10s %10.3f %6.1f%% %10.3f %10.3f %10.3f %10.3f %10.3f\n",
+             name, sum, runTotal > 0 ? 100.0 * sum / runTotal : 0.0,
+             v.empty() ? 0.0 : 1e3 * sum / v.size(), 1e3 * Quantile(v, 0.5),
+             1e3 * Quantile(v, 0.9), 1e3 * Quantile(v, 0.99), v.empty() ? 0.0 : 1e3 * v.back());
+    out << line;
+}
+
+// Ratio a/b*scale as text, "n/a" if a counter is missing
+static string Ratio(long long a, long long b, double scale, const char* fmt) {
+    if (a < 0 || b <= 0) return "n/a";
+    char text[32];
+    snprintf(text, sizeof(text), fmt, scale * a / b);
+    return text;
+}
+
+// Counters per stage over the run: share of the cycles, instructions per
+// cycle and misses per 1000 instructions
+static string PerfTable() {
+    long long cycles = 0;
+    for (int s = 0; s < TIMER_NSTAGES; s++) cycles += max(0LL, g_count_sum[0][s]);
+    ostringstream out;
+    char line[160];
+    snprintf(line, sizeof(line), "%-10s %14s %7s %6s %10s %10s %10s\n", "stage", "cycles",
+             "share", "IPC", "LLC/kinst", "br/kinst", "dTLB/kinst");
+    out << "Hardware counters (main thread)\n" << line;
+    for (int k = 1; k <= TIMER_NSTAGES; k++) {
+        int s = k % TIMER_NSTAGES;  // "other" last
+        const long long* c = &g_count_sum[0][0];
+        long long cyc = c[0 * TIMER_NSTAGES + s], ins = c[1 * TIMER_NSTAGES + s];
+        snprintf(line, sizeof(line), "%-10s %14lld %7s %6s %10s %10s %10s\n", kStageNames[s],
+                 cyc, Ratio(cyc, cycles, 100.0, "%.1f%%").c_str(),
+                 Ratio(ins, cyc, 1.0, "%.2f").c_str(),
+                 Ratio(c[2 * TIMER_NSTAGES + s], ins, 1e3, "%.3f").c_str(),
+                 Ratio(c[3 * TIMER_NSTAGES + s], ins, 1e3, "%.3f").c_str(),
+                 Ratio(c[4 * TIMER_NSTAGES + s], ins, 1e3, "%.3f").c_str());
+        out << line;
+    }
+    return out.str();
+}
+
+// Work counters over the run: mean and maximum per event and the time of
+// their stage per unit (the stage time is shared by all its counters)
+static string WorkTable(size_t nevents) {
+    ostringstream out;
+    char line[160];
+    snprintf(line, sizeof(line), "%-15s %14s %12s %12s %9s %12s\n", "counter", "total",
+             "mean", "max", "stage", "ns/unit");
+    out << "Transport work\n" << line;
+    for (int w = 0; w < TIMER_NWORK; w++) {
+        double stageTime = 0;
+        for (double t : g_samples[kWorkStage[w]]) stageTime += t;
+        snprintf(line, sizeof(line), "%-15s %14lld %12.1f %12lld %9s %12s\n", kWorkNames[w],
+                 g_work_sum[w], nevents ? (double)g_work_sum[w] / nevents : 0.0, g_work_max[w],
+                 kStageNames[kWorkStage[w]],
+                 g_work_sum[w] > 0 ? Form("%.1f", 1e9 * stageTime / g_work_sum[w]) : "n/a");
+        out << line;
+    }
+    return out.str();
+}
+
+// Peak resident set size of the process in MB (ru_maxrss is in kB on
+// Linux, in bytes on macOS)
+static double PeakRssMB() {
+    struct rusage ru;
+    if (getrusage(RUSAGE_SELF, &ru) != 0) return 0;
+#ifdef __APPLE__
+    return ru.ru_maxrss / 1048576.0;
+#else
+    return ru.ru_maxrss / 1024.0;
+#endif
+}
+
+static string SummaryTable() {
+    const vector<double>& totals = g_samples[TIMER_NSTAGES];
+    double runTotal = 0;
+    for (double t : totals) runTotal += t;
+    ostringstream out;
+    char line[160];
+    snprintf(line, sizeof(line), "%-10s %10s %7s %10s %10s %10s %10s %10s\n", "stage",
+             "total[s]", "share", "mean[ms]", "p50[ms]", "p90[ms]", "p99[ms]", "max[ms]");
+    out << "Stage timing of " << totals.size() << " events\n" << line;
+    for (int s = 1; s < TIMER_NSTAGES; s++) SummaryRow(out, kStageNames[s], g_samples[s], runTotal);
+    SummaryRow(out, kStageNames[0], g_samples[0], runTotal);
+    SummaryRow(out, "event", totals, runTotal);
+    snprintf(line, sizeof(line), "Peak RSS %.1f MB\n", PeakRssMB());
+    out << line;
+    out << WorkTable(totals.size());
+    if (g_use_perf) out << PerfTable();
+    return out.str();
+}
+
+// One stage (or the event) in ana/timing_summary.json: how often it ran,
+// inclusive and exclusive time over the run and per-event exclusive time
+static void JsonStage(FILE* out, const char* name, long long count, double inclusive,
+                      vector<double> v, const long long* perf) {
+    sort(v.begin(), v.end());
+    double sum = 0;
+    for (double t : v) sum += t;
+    fprintf(out, "    \"%s\": {\"count\": %lld, \"total_s\": %.9g, \"exclusive_s\": %.9g, "
+            "\"mean_ms\": %.6g, \"p50_ms\": %.6g, \"p90_ms\": %.6g, \"p99_ms\": %.6g, "
+            "\"max_ms\": %.6g",
+            name, count, inclusive, sum, v.empty() ? 0.0 : 1e3 * sum / v.size(),
+            1e3 * Quantile(v, 0.5), 1e3 * Quantile(v, 0.9), 1e3 * Quantile(v, 0.99),
+            v.empty() ? 0.0 : 1e3 * v.back());
+    if (perf) {
+        fprintf(out, ", \"perf\": {");
+        for (int c = 0; c < PERF_NCOUNTERS; c++) {
+            const long long n = perf[c * TIMER_NSTAGES];
+            if (n < 0) {
+                fprintf(out, "%s\"%s\": null", c ? ", " : "", kPerfCounterNames[c]);
+            } else {
+                fprintf(out, "%s\"%s\": %lld", c ? ", " : "", kPerfCounterNames[c], n);
+            }
+        }
+        fprintf(out, "}");
+    }
+    fprintf(out, "}");
+}
+
+// The summary table in machine-readable form: per stage (and for the whole
+// event) the count, inclusive and exclusive seconds and the per-event
+// percentiles, the peak RSS, the work counters and, with AMPT_TIMING=perf,
+// the counters per stage (null if missing)
+static void WriteSummaryJson(const char* path) {
+    FILE* out = fopen(path, "w");
+    if (!out) {
+        cerr << "WARNING: Cannot write " << path << endl;
+        return;
+    }
+    const vector<double>& totals = g_samples[TIMER_NSTAGES];
+    double runTotal = 0;
+    for (double t : totals) runTotal += t;
+    fprintf(out, "{\n  \"events\": %zu,\n  \"peak_rss_mb\": %.1f,\n  \"perf\": %s,\n",
+            totals.size(), PeakRssMB(), g_use_perf ? "true" : "false");
+    // "other" is what no stage covers: once per event, nothing inside it
+    double otherTotal = 0;
+    for (double t : g_samples[0]) otherTotal += t;
+    fprintf(out, "  \"stages\": {\n");
+    for (int k = 1; k <= TIMER_NSTAGES; k++) {
+        int s = k % TIMER_NSTAGES;  // "other" last, as in the table
+        JsonStage(out, kStageNames[s], s ? g_calls[s] : (long long)totals.size(),
+                  s ? g_inclusive[s] : otherTotal, g_samples[s],
+                  g_use_perf ? &g_count_sum[0][s] : nullptr);
+        fprintf(out, ",\n");
+    }
+    JsonStage(out, "event", (long long)totals.size(), runTotal, totals, nullptr);
+    fprintf(out, "\n  },\n  \"work\": {\n");
+    for (int w = 0; w < TIMER_NWORK; w++) {
+        fprintf(out, "    \"%s\": {\"stage\": \"%s\", \"total\": %lld, \"mean\": %.6g, "
+                "\"max\": %lld}%s\n",
+                kWorkNames[w], kStageNames[kWorkStage[w]], g_work_sum[w],
+                totals.empty() ? 0.0 : (double)g_work_sum[w] / totals.size(), g_work_max[w],
+                w + 1 < TIMER_NWORK ? "," : "");
+    }
+    fprintf(out, "  }\n}\n");
+    fclose(out);
+}
+
+extern "C" {
+
+void timer_init_() {
+    const char* env = getenv("AMPT_TIMING");
+    if (!env || !*env || strcmp(env, "0") == 0) return;
+    if (strcmp(env, "perf") == 0) {
+        string why;
+        g_use_perf = g_perf.Open(why);
+        if (!g_use_perf) {
+            cout << "Hardware counters unavailable (" << why << "), timing only" << endl;
+        } else {
+            cout << "Hardware counters:";
+            for (int c = 0; c < PERF_NCOUNTERS; c++) {
+                if (g_perf.Has(c)) cout << " " << kPerfCounterNames[c];
+            }
+            cout << endl;
+        }
+    }
+
+    TDirectory* saved = gDirectory;
+    g_timing_file = new TFile("ana/timing.root", "RECREATE");
+    if (g_timing_file->IsZombie()) {
+        cerr << "ERROR: Cannot create ana/timing.root, stage timing off" << endl;
+        delete g_timing_file;
+        g_timing_file = nullptr;
+        if (saved) saved->cd();
+        return;
+    }
+    g_timing_tree = new TTree("timing", "AMPT wall time per event and stage");
+    g_timing_tree->Branch("event", &t_event, "event/I");
+    g_timing_tree->Branch("natt", &t_natt, "natt/I");
+    g_timing_tree->Branch("nparton", &t_nparton, "nparton/I");
+    g_timing_tree->Branch("nhadron", &t_nhadron, "nhadron/I");
+    g_timing_tree->Branch("total", &t_total, "total/D");
+    for (int s = 0; s < TIMER_NSTAGES; s++) {
+        g_timing_tree->Branch(kStageNames[s], &t_stage[s], Form("%s/D", kStageNames[s]));
+    }
+    g_timing_tree->Branch("fill_stream", t_fill, Form("fill_stream[%d]/D", TIMER_NSTREAMS));
+    g_timing_tree->Branch("analysis_stream", t_analysis,
+                          Form("analysis_stream[%d]/D", TIMER_NSTREAMS));
+    for (int w = 0; w < TIMER_NWORK; w++) {
+        g_timing_tree->Branch(kWorkNames[w], &t_work[w], Form("%s/L", kWorkNames[w]));
+    }
+    // counter per stage, indexed like the stage numbers (0 = other)
+    if (g_use_perf) {
+        for (int c = 0; c < PERF_NCOUNTERS; c++) {
+            g_timing_tree->Branch(kPerfCounterNames[c], t_count[c],
+                                  Form("%s[%d]/L", kPerfCounterNames[c], TIMER_NSTAGES));
+        }
+    }
+    if (saved) saved->cd();
+
+    g_timing = true;
+    ClearEvent();
+    memset(g_count_sum, 0, sizeof(g_count_sum));
+    memset(g_work_sum, 0, sizeof(g_work_sum));
+    memset(g_work_max, 0, sizeof(g_work_max));
+    memset(g_calls, 0, sizeof(g_calls));
+    memset(g_inclusive, 0, sizeof(g_inclusive));
+    cout << "Stage timing on (AMPT_TIMING): ana/timing.root, ana/timing_summary.json" << endl;
+}
+
+void timer_event_begin_() {
+    if (!g_timing) return;
+    ClearEvent();
+    if (g_use_perf) g_perf.Read(g_event_count0);
+    g_event_start = TimerClock::now();
+}
+
+void timer_begin_(int* stage) {
+    StageTimerBegin(*stage);
+}
+
+void timer_end_(int* stage) {
+    if (!g_timing || g_frames.empty()) return;
+    if (g_frames.back().stage != *stage && !g_mismatch_reported) {
+        cerr << "WARNING: timer_end_ of stage " << *stage << " inside stage "
+             << g_frames.back().stage << endl;
+        g_mismatch_reported = true;
+    }
+    StageTimerEnd();
+}
+
+int timer_on_() {
+    return g_timing ? 1 : 0;
+}
+
+void timer_event_end_(int* event, int* natt, int* mul, long long* work) {
+    if (!g_timing) return;
+    while (!g_frames.empty()) StageTimerEnd();
+    t_total = Seconds(TimerClock::now() - g_event_start);
+    t_event = *event;
+    t_natt = *natt;
+    t_nparton = *mul;
+    for (int w = 0; w < TIMER_NWORK; w++) {
+        t_work[w] = work[w];
+        g_work_sum[w] += work[w];
+        g_work_max[w] = max(g_work_max[w], (long long)work[w]);
+    }
+    double staged = 0;
+    for (int s = 1; s < TIMER_NSTAGES; s++) staged += t_stage[s];
+    t_stage[0] = t_total - staged;
+    if (g_use_perf) {
+        long long count[PERF_NCOUNTERS];
+        g_perf.Read(count);
+        for (int c = 0; c < PERF_NCOUNTERS; c++) {
+            if (!g_perf.Has(c)) {
+                for (int s = 0; s < TIMER_NSTAGES; s++) t_count[c][s] = g_count_sum[c][s] = -1;
+                continue;
+            }
+            long long staged = 0;
+            for (int s = 1; s < TIMER_NSTAGES; s++) staged += t_count[c][s];
+            t_count[c][0] = count[c] - g_event_count0[c] - staged;
+            for (int s = 0; s < TIMER_NSTAGES; s++) g_count_sum[c][s] += t_count[c][s];
+        }
+    }
+    for (int s = 0; s < TIMER_NSTAGES; s++) g_samples[s].push_back(t_stage[s]);
+    g_samples[TIMER_NSTAGES].push_back(t_total);
+
+    TDirectory* saved = gDirectory;
+    g_timing_file->cd();
+    g_timing_tree->Fill();
+    if (saved) saved->cd();
+}
+
+void timer_finalize_() {
+    if (!g_timing) return;
+    g_timing = false;
+    string table = SummaryTable();
+    cout << table;
+    WriteSummaryJson("ana/timing_summary.json");
+
+    TDirectory* saved = gDirectory;
+    g_timing_file->cd();
+    g_timing_tree->Write();
+    TNamed summary("timing_summary", table.c_str());
+    summary.Write();
+    g_timing_file->Close();
+    delete g_timing_file;
+    g_timing_file = nullptr;
+    g_timing_tree = nullptr;
+    if (saved) saved->cd();
+    g_perf.Close();
+    g_use_perf = false;
+}
+
+}
@@ -0,0 +1,83 @@
+#ifndef STAGE_TIMER_H
+#define STAGE_TIMER_H
+
+// Per-event wall time of the stages of ampt (AMPT_TIMING=1)
+//
+// main.f brackets each event with timer_event_begin_/timer_event_end_ and
+// each stage with timer_begin_/timer_end_ (stage numbers below); the ROOT
+// interface adds the TTree::Fill and AnalysisCore::AnalyzeEvent of every
+// stream.  Stages nest: HIJING contains ZPC, coalescence and the writes,
+// and each stage is charged only the time not spent in the stages inside
+// it, so the stages of an event add up to its wall time less "other".
+// The parton-initial writes (ioscar=2,3) happen inside ZPC and count there,
+// except for their fill and analysis.
+// The clock is std::chrono::steady_clock, a few tens of ns per call.
+//
+// ana/timing.root holds the tree "timing", one entry per event with the
+// stage times (seconds) and the multiplicities (hadrons entering ART,
+// partons of ZPC, final hadrons), and the TNamed "timing_summary", the
+// table of per-stage totals, means and percentiles (and the peak RSS of
+// the process) that is also printed at the end of the run.
+// ana/timing_summary.json has the same summary for scripts: per stage the
+// number of times it was entered, its inclusive and exclusive seconds and
+// the per-event mean, p50/p90/p99 and maximum of its exclusive time, the
+// same for the whole event, the peak RSS, the work counters and, with
+// AMPT_TIMING=perf, the counters of each stage (null if missing).  A
+// restarted run (ampt -r) times only its own events.  Without AMPT_TIMING
+// every call returns at once.
+//
+// AMPT_TIMING=perf also reads the hardware counters of perf_counters.h at
+// every stage boundary and charges them to the stages the same way: the
+// tree gets the branches cycles, instructions, llc_misses, branch_misses
+// and dtlb_misses, each [TIMER_NSTAGES] indexed by stage (0 = other, -1 if
+// the counter is missing), and the summary a table of cycles, IPC and
+// misses per 1000 instructions per stage.  Where perf_event_open is not
+// allowed (containers, perf_event_paranoid) the run says so once and
+// falls back to the wall times.
+//
+// Each entry also has the transport work counters of the event (wrkcnt.f)
+// as branches zpc_coll, zpc_cell, zpc_form, coal_cand, art_pairs,
+// art_range, art_coll_bb, art_coll_mb, art_coll_mm, art_coll_bbbar,
+// art_nocoll and art_decay, so the stage times can be fitted against the
+// work done; the summary adds their means and the stage time per unit.
+
+// Stage numbers used by the Fortran callers
+enum TimerStage {
+    TIMER_HIJING = 1,     // HIJING less the stages below called from it
+    TIMER_GETNP = 2,      // getnp
+    TIMER_ZPC = 3,        // ZPCMN
+    TIMER_COAL = 4,       // ptoh (CZCOAL_MAIN)
+    TIMER_ARINI = 5,      // ARINI, ARINI2
+    TIMER_ART = 6,        // ARTMN less its final-state writes
+    TIMER_WRITE = 7,      // ampt/zpc/hadron .dat writes with their ROOT calls
+    TIMER_FILL = 8,       // skim, TTree::Fill and index of the 5 streams
+    TIMER_ANALYSIS = 9,   // AnalysisCore::AnalyzeEvent of the 5 streams
+    TIMER_NSTAGES = 10
+};
+
+// Streams of the per-stream fill and analysis times (SkimStream order)
+const int TIMER_NSTREAMS = 5;
+// Slots of COMMON /WRKCNT/ NWORK (wrkcnt.f)
+const int TIMER_NWORK = 12;
+
+// C++ side (root_interface.cpp): stream is the SkimStream of a fill or an
+// analysis, -1 otherwise
+void StageTimerBegin(int stage, int stream = -1);
+void StageTimerEnd();
+// Final hadrons of the event (write_ampt_event_header_)
+void StageTimerSetHadrons(int nhadron);
+
+extern "C" {
+    void timer_init_();
+    void timer_event_begin_();
+    void timer_begin_(int* stage);
+    void timer_end_(int* stage);
+    // 1 while the timing is on (ZPCMN adds the ZPC cpu time to zpc.res)
+    int timer_on_();
+    // event number, NATT entering ART, partons (MUL), work counters
+    // NWORK(TIMER_NWORK) (INTEGER*8)
+    void timer_event_end_(int* event, int* natt, int* mul, long long* work);
+    void timer_finalize_();
+}
+
+#endif // STAGE_TIMER_H
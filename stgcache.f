@@ -0,0 +1,378 @@
+c=======================================================================
+c     stgcache.f - Event stage caches for parameter scans
+c
+c     A recording run writes the state of every event at the end of a
+c     stage into a binary cache in ana/; a replaying run reads it back
+c     instead of running the stages before, so a scan over the later
+c     parameters pays for the earlier stages only once.
+c       stage 1 (ihcach): after HIJING, ana/hadron-afterHIJING.cache,
+c                replay runs string melting, ZPC, coalescence and ART;
+c       stage 2 (ipcach): after ZPC, ana/parton-afterZPC.cache, replay
+c                runs coalescence and ART only.
+c     The file is stream access in native byte order: a header with
+c     the stage and the settings KEY the recorded state depends on
+c     (filled in main.f; a replay with other settings stops), then one
+c     record per event
+c       event number, payload length in bytes (INTEGER*8), payload.
+c     The length is written after the payload, so a record cut short
+c     by a crash has length 0 and ends the file for the reader.  An
+c     event repeated by HIJING has several records; the last one is
+c     the event as it was finished.  Records are in event order and
+c     a replay walks them with the lengths, so an event range skips
+c     the records before it without reading them.
+c
+c     Recording and replaying both restart the random numbers at the
+c     end of the stage from (master seeds, event, stage) with STGSED,
+c     so a replay with unchanged settings gives the recording run's
+c     events exactly, and any replay the same later random numbers.
+c=======================================================================
+
+      SUBROUTINE STCOPN(MODE, ISTG, MASTER, MZPC, KEY, NKEY)
+c
+c     Open the cache of stage ISTG for recording (MODE=1) or replay
+c     (MODE=2).  KEY(1:NKEY) are the settings of the stages before:
+c     the first 36 for stage 1, all 41 for stage 2.
+c
+      PARAMETER (MXSKEY=64)
+      INTEGER*8 IPSTC, IPFST, ISTSIZ
+      DOUBLE PRECISION KEY(NKEY), FKEY(MXSKEY)
+      CHARACTER*8 MAGIC
+      CHARACTER*10 KEYNAM(MXSKEY)
+      CHARACTER*32 STCFIL
+      LOGICAL LOPEN
+      COMMON /STGCAC/ ISTCMD(2)
+cc      SAVE /STGCAC/
+      COMMON /STCIO/ IPSTC(2), IPFST(2), ISTSIZ(2), IUSTC(2),
+     &     MSTSED(2), MZPSED(2)
+cc      SAVE /STCIO/
+      COMMON /STCNAM/ STCFIL(2)
+cc      SAVE /STCNAM/
+      SAVE
+c     KEY as main.f fills it, HIJING settings first:
+      DATA (KEYNAM(I), I = 1, 36) /'EFRM', 'FRAME', 'IAP', 'IZP',
+     &     'IAT', 'IZT', 'BMIN', 'BMAX', 'isoft', 'PARJ(41)',
+     &     'PARJ(42)', 'ipop', 'PARJ(5)', 'IHPR2(6)', 'IHPR2(4)',
+     &     'HIPR1(14)', 'HIPR1(8)', 'NSEED', 'iseedp', 'irngbk',
+     &     'iseedev', 'pttrig', 'maxmiss', 'IHPR2(2)', 'IHPR2(5)',
+     &     'iembed', 'pxqembd', 'pyqembd', 'xembd', 'yembd', 'nsembd',
+     &     'psembd', 'tmaxembd', 'ishadow', 'dshadow', 'iphirp'/
+      DATA (KEYNAM(I), I = 37, 41) /'xmu', 'izpc', 'alpha', 'ISHLF',
+     &     'izgrid'/
+
+      ISTCMD(ISTG) = MODE
+      IF (MODE .EQ. 0) RETURN
+      STCFIL(1) = 'ana/hadron-afterHIJING.cache'
+      STCFIL(2) = 'ana/parton-afterZPC.cache'
+      IUSTC(ISTG) = 80 + ISTG
+      IU = IUSTC(ISTG)
+      MSTSED(ISTG) = MASTER
+      MZPSED(ISTG) = MZPC
+c     a restart (CKPRST) has cut the file back and connected the unit
+      INQUIRE (FILE = STCFIL(ISTG), OPENED = LOPEN, NUMBER = IUCK)
+      IF (LOPEN) CLOSE (IUCK)
+
+      IF (MODE .EQ. 1 .AND. .NOT. LOPEN) THEN
+         OPEN (IU, FILE = STCFIL(ISTG), ACCESS = 'STREAM',
+     &        FORM = 'UNFORMATTED', STATUS = 'REPLACE', ERR = 200)
+         WRITE (IU) 'AMPTSTG1', ISTG, NKEY, (KEY(I), I = 1, NKEY)
+         INQUIRE (IU, POS = IPSTC(ISTG))
+         WRITE (6, *) 'recording the stage cache ', TRIM(STCFIL(ISTG))
+         RETURN
+      ENDIF
+
+      IF (MODE .EQ. 1) THEN
+         OPEN (IU, FILE = STCFIL(ISTG), ACCESS = 'STREAM',
+     &        FORM = 'UNFORMATTED', STATUS = 'OLD', ERR = 200)
+      ELSE
+         OPEN (IU, FILE = STCFIL(ISTG), ACCESS = 'STREAM',
+     &        FORM = 'UNFORMATTED', STATUS = 'OLD', ACTION = 'READ',
+     &        ERR = 200)
+      ENDIF
+      READ (IU, ERR = 300, END = 300) MAGIC, JSTG, NFKEY
+      IF (MAGIC .NE. 'AMPTSTG1' .OR. JSTG .NE. ISTG
+     &     .OR. NFKEY .NE. NKEY) GOTO 300
+      READ (IU, ERR = 300, END = 300) (FKEY(I), I = 1, NKEY)
+      DO 1001 I = 1, NKEY
+         IF (FKEY(I) .NE. KEY(I)) THEN
+            WRITE (6, *) TRIM(STCFIL(ISTG)), ' was recorded with ',
+     &           TRIM(KEYNAM(I)), ' = ', FKEY(I), ', not ', KEY(I)
+            STOP 1
+         ENDIF
+ 1001 CONTINUE
+      INQUIRE (IU, POS = IPFST(ISTG), SIZE = ISTSIZ(ISTG))
+      IF (MODE .EQ. 1) THEN
+c     recording continues after the last record of the checkpoint
+         IPSTC(ISTG) = ISTSIZ(ISTG) + 1
+         WRITE (6, *) 'appending to the stage cache ',
+     &        TRIM(STCFIL(ISTG))
+      ELSE
+         IPSTC(ISTG) = IPFST(ISTG)
+         WRITE (6, *) 'replaying events from the stage cache ',
+     &        TRIM(STCFIL(ISTG))
+      ENDIF
+
+      RETURN
+ 200  WRITE (6, *) 'cannot open the stage cache ', TRIM(STCFIL(ISTG))
+      STOP 1
+ 300  WRITE (6, *) TRIM(STCFIL(ISTG)), ' is not a cache of this stage'
+      STOP 1
+      END
+
+c-----------------------------------------------------------------------
+
+      SUBROUTINE STCPUT(ISTG)
+c
+c     Append the record of the current event for stage ISTG and
+c     restart the random numbers for the rest of the event
+c
+      INTEGER*8 IPSTC, IPFST, ISTSIZ, IP0, IP1, IP2, NBYTE
+      COMMON /STCIO/ IPSTC(2), IPFST(2), ISTSIZ(2), IUSTC(2),
+     &     MSTSED(2), MZPSED(2)
+cc      SAVE /STCIO/
+      COMMON /AREVT/ IAEVT, IARUN, MISS
+cc      SAVE /AREVT/
+      SAVE
+
+      IU = IUSTC(ISTG)
+      IP0 = IPSTC(ISTG)
+      NBYTE = 0
+      WRITE (IU, POS = IP0) IAEVT, NBYTE
+      INQUIRE (IU, POS = IP1)
+      IF (ISTG .EQ. 1) THEN
+         CALL STCHJG(IU, 1)
+      ELSE
+         CALL STCZPC(IU, 1)
+      ENDIF
+      INQUIRE (IU, POS = IP2)
+      NBYTE = IP2 - IP1
+      WRITE (IU, POS = IP0) IAEVT, NBYTE
+      IPSTC(ISTG) = IP2
+      CALL STGSED(MSTSED(ISTG), MZPSED(ISTG), IAEVT, ISTG)
+
+      RETURN
+      END
+
+c-----------------------------------------------------------------------
+
+      SUBROUTINE STCGET(ISTG)
+c
+c     Load the record of the current event for stage ISTG and restart
+c     the random numbers as the recording run did
+c
+      INTEGER*8 IPSTC, IPFST, ISTSIZ, IP, IPD, IPFND, NBYTE
+      CHARACTER*32 STCFIL
+      COMMON /STCIO/ IPSTC(2), IPFST(2), ISTSIZ(2), IUSTC(2),
+     &     MSTSED(2), MZPSED(2)
+cc      SAVE /STCIO/
+      COMMON /STCNAM/ STCFIL(2)
+cc      SAVE /STCNAM/
+      COMMON /AREVT/ IAEVT, IARUN, MISS
+cc      SAVE /AREVT/
+      SAVE
+
+      IU = IUSTC(ISTG)
+      IPFND = 0
+      IP = IPSTC(ISTG)
+c     walk the records up to the first one of a later event
+ 100  IF (IP .GT. ISTSIZ(ISTG)) GOTO 200
+      READ (IU, POS = IP, IOSTAT = IOS) IEV, NBYTE
+      IF (IOS .NE. 0 .OR. NBYTE .LE. 0) GOTO 200
+      INQUIRE (IU, POS = IPD)
+      IF (IPD + NBYTE - 1 .GT. ISTSIZ(ISTG) .OR. IEV .GT. IAEVT)
+     &     GOTO 200
+      IF (IEV .EQ. IAEVT) IPFND = IPD
+      IP = IPD + NBYTE
+      GOTO 100
+ 200  IF (IPFND .EQ. 0 .AND. IPSTC(ISTG) .NE. IPFST(ISTG)) THEN
+c     an event before the last one read: start over
+         IPSTC(ISTG) = IPFST(ISTG)
+         IP = IPFST(ISTG)
+         GOTO 100
+      ENDIF
+      IF (IPFND .EQ. 0) THEN
+         WRITE (6, *) 'event ', IAEVT, ' is not in ',
+     &        TRIM(STCFIL(ISTG))
+         STOP 1
+      ENDIF
+      IPSTC(ISTG) = IP
+      READ (IU, POS = IPFND)
+      IF (ISTG .EQ. 1) THEN
+         CALL STCHJG(IU, 2)
+      ELSE
+         CALL STCZPC(IU, 2)
+      ENDIF
+      CALL STGSED(MSTSED(ISTG), MZPSED(ISTG), IAEVT, ISTG)
+
+      RETURN
+      END
+
+c-----------------------------------------------------------------------
+
+      SUBROUTINE STCHJG(IU, IRW)
+c
+c     Write (IRW=1) or read (IRW=2) the state after HIJING at the
+c     current position of unit IU: the hadrons and direct particles
+c     with their string positions, the event header and the nucleons
+c     (positions and status, from which HTOP and GETNP find the
+c     participants).  HIJING goes on from here with the hadrons before
+c     melting and HTOP.
+c
+      PARAMETER (MAXSTR=150001, MAXPTN=400001)
+      DOUBLE PRECISION vxp0, vyp0, vzp0, xstrg0, ystrg0, xstrg, ystrg
+      COMMON /ARPRC/ ITYPAR(MAXSTR),
+     &     GXAR(MAXSTR), GYAR(MAXSTR), GZAR(MAXSTR), FTAR(MAXSTR),
+     &     PXAR(MAXSTR), PYAR(MAXSTR), PZAR(MAXSTR), PEAR(MAXSTR),
+     &     XMAR(MAXSTR)
+cc      SAVE /ARPRC/
+      COMMON/HMAIN1/EATT,JATT,NATT,NT,NP,N0,N01,N10,N11
+cc      SAVE /HMAIN1/
+      COMMON/HMAIN2/KATT(MAXSTR,4),PATT(MAXSTR,4)
+cc      SAVE /HMAIN2/
+      common /precpa/vxp0(MAXPTN),vyp0(MAXPTN),vzp0(MAXPTN),
+     1     xstrg0(MAXPTN),ystrg0(MAXPTN),
+     2     xstrg(MAXPTN),ystrg(MAXPTN),istrg0(MAXPTN),istrg(MAXPTN)
+cc      SAVE /precpa/
+      COMMON /AREVT/ IAEVT, IARUN, MISS
+cc      SAVE /AREVT/
+      common /lastt/itimeh,bimp
+cc      SAVE /lastt/
+      COMMON/HJGLBR/NELT,NINTHJ,NELP,NINP
+cc      SAVE /HJGLBR/
+      COMMON/HPARNT/HIPR1(100),IHPR2(50),HINT1(100),IHNT2(50)
+cc      SAVE /HPARNT/
+      common /phiHJ/iphirp,phiRP
+cc      SAVE /phiHJ/
+      COMMON/hjcrdn/YP(3,300),YT(3,300)
+cc      SAVE /hjcrdn/
+      COMMON/HSTRNG/NFP(300,15),PP(300,15),NFT(300,15),PT(300,15)
+cc      SAVE /HSTRNG/
+      SAVE
+
+      IF (IRW .EQ. 1) THEN
+         WRITE (IU) MISS, NATT, EATT, NELP, NINP, NELT, NINTHJ,
+     &        bimp, HINT1(19), phiRP
+         WRITE (IU) (ITYPAR(I), GXAR(I), GYAR(I), GZAR(I), FTAR(I),
+     &        PXAR(I), PYAR(I), PZAR(I), PEAR(I), XMAR(I),
+     &        (KATT(I, K), K = 1, 4), (PATT(I, K), K = 1, 4),
+     &        xstrg0(I), ystrg0(I), istrg0(I), I = 1, NATT)
+         WRITE (IU) ((YP(K, I), K = 1, 3), (NFP(I, K), K = 3, 5),
+     &        I = 1, IHNT2(1))
+         WRITE (IU) ((YT(K, I), K = 1, 3), (NFT(I, K), K = 3, 5),
+     &        I = 1, IHNT2(3))
+         RETURN
+      ENDIF
+
+      READ (IU) MISS, NATT, EATT, NELP, NINP, NELT, NINTHJ,
+     &     bimp, HINT1(19), phiRP
+      IF (NATT .GT. MAXSTR) THEN
+         WRITE (6, *) 'stage cache record of event ', IAEVT,
+     &        ' does not fit: NATT = ', NATT
+         STOP 1
+      ENDIF
+      READ (IU) (ITYPAR(I), GXAR(I), GYAR(I), GZAR(I), FTAR(I),
+     &     PXAR(I), PYAR(I), PZAR(I), PEAR(I), XMAR(I),
+     &     (KATT(I, K), K = 1, 4), (PATT(I, K), K = 1, 4),
+     &     xstrg0(I), ystrg0(I), istrg0(I), I = 1, NATT)
+      READ (IU) ((YP(K, I), K = 1, 3), (NFP(I, K), K = 3, 5),
+     &     I = 1, IHNT2(1))
+      READ (IU) ((YT(K, I), K = 1, 3), (NFT(I, K), K = 3, 5),
+     &     I = 1, IHNT2(3))
+
+      RETURN
+      END
+
+c-----------------------------------------------------------------------
+
+      SUBROUTINE STCZPC(IU, IRW)
+c
+c     Write (IRW=1) or read (IRW=2) the state after ZPC at the current
+c     position of unit IU: the final partons with their strings, the
+c     strings, the particles kept out of ZPC, the event header and the
+c     nucleon positions of ana/npart-xy.dat.  HIJING goes on from here
+c     with the SOFT record, coalescence (PTOH) and the energy check.
+c
+      PARAMETER (MAXSTR=150001, MAXPTN=400001, MAXIDL=4001)
+      DOUBLE PRECISION GX5, GY5, GZ5, FT5, PX5, PY5, PZ5, E5, XMASS5
+      DOUBLE PRECISION PXSGS, PYSGS, PZSGS, PESGS, PMSGS,
+     &     GXSGS, GYSGS, GZSGS, FTSGS
+      COMMON /prec2/GX5(MAXPTN),GY5(MAXPTN),GZ5(MAXPTN),FT5(MAXPTN),
+     &     PX5(MAXPTN), PY5(MAXPTN), PZ5(MAXPTN), E5(MAXPTN),
+     &     XMASS5(MAXPTN), ITYP5(MAXPTN)
+cc      SAVE /prec2/
+      COMMON /ilist8/ LSTRG1(MAXPTN), LPART1(MAXPTN)
+cc      SAVE /ilist8/
+      COMMON /PARA1/ MUL
+cc      SAVE /PARA1/
+      COMMON/SOFT/PXSGS(MAXSTR,3),PYSGS(MAXSTR,3),PZSGS(MAXSTR,3),
+     &     PESGS(MAXSTR,3),PMSGS(MAXSTR,3),GXSGS(MAXSTR,3),
+     &     GYSGS(MAXSTR,3),GZSGS(MAXSTR,3),FTSGS(MAXSTR,3),
+     &     K1SGS(MAXSTR,3),K2SGS(MAXSTR,3),NJSGS(MAXSTR)
+cc      SAVE /SOFT/
+      COMMON/HJJET2/NSG
+cc      SAVE /HJJET2/
+      COMMON /SREC1/ NSP, NST, NSI
+cc      SAVE /SREC1/
+      COMMON /NOPREC/ NNOZPC, ITYPN(MAXIDL),
+     &     GXN(MAXIDL), GYN(MAXIDL), GZN(MAXIDL), FTN(MAXIDL),
+     &     PXN(MAXIDL), PYN(MAXIDL), PZN(MAXIDL), EEN(MAXIDL),
+     &     XMN(MAXIDL)
+cc      SAVE /NOPREC/
+      COMMON /AREVT/ IAEVT, IARUN, MISS
+cc      SAVE /AREVT/
+      common /lastt/itimeh,bimp
+cc      SAVE /lastt/
+      COMMON/HJGLBR/NELT,NINTHJ,NELP,NINP
+cc      SAVE /HJGLBR/
+      common /para7/ ioscar,nsmbbbar,nsmmeson
+cc      SAVE /para7/
+      COMMON/HPARNT/HIPR1(100),IHPR2(50),HINT1(100),IHNT2(50)
+cc      SAVE /HPARNT/
+      common /phiHJ/iphirp,phiRP
+cc      SAVE /phiHJ/
+      COMMON/hjcrdn/YP(3,300),YT(3,300)
+cc      SAVE /hjcrdn/
+      COMMON/HSTRNG/NFP(300,15),PP(300,15),NFT(300,15),PT(300,15)
+cc      SAVE /HSTRNG/
+      SAVE
+
+      IF (IRW .EQ. 1) THEN
+         WRITE (IU) MISS, NSG, MUL, NNOZPC, NELP, NINP, NELT, NINTHJ,
+     &        nsmbbbar, nsmmeson, bimp, HINT1(19), phiRP
+         WRITE (IU) (NJSGS(I), I = 1, NSG)
+         WRITE (IU) (ITYP5(I), LSTRG1(I), LPART1(I), GX5(I), GY5(I),
+     &        GZ5(I), FT5(I), PX5(I), PY5(I), PZ5(I), E5(I),
+     &        XMASS5(I), I = 1, MUL)
+         WRITE (IU) (ITYPN(I), GXN(I), GYN(I), GZN(I), FTN(I),
+     &        PXN(I), PYN(I), PZN(I), EEN(I), XMN(I), I = 1, NNOZPC)
+         WRITE (IU) ((YP(K, I), K = 1, 3), (NFP(I, K), K = 3, 5),
+     &        I = 1, IHNT2(1))
+         WRITE (IU) ((YT(K, I), K = 1, 3), (NFT(I, K), K = 3, 5),
+     &        I = 1, IHNT2(3))
+         RETURN
+      ENDIF
+
+      READ (IU) MISS, NSG, MUL, NNOZPC, NELP, NINP, NELT, NINTHJ,
+     &     nsmbbbar, nsmmeson, bimp, HINT1(19), phiRP
+      IF (NSG .GT. MAXSTR .OR. MUL .GT. MAXPTN .OR. NNOZPC .GT. MAXIDL)
+     &     THEN
+         WRITE (6, *) 'stage cache record of event ', IAEVT,
+     &        ' does not fit: NSG, MUL, NNOZPC = ', NSG, MUL, NNOZPC
+         STOP 1
+      ENDIF
+      READ (IU) (NJSGS(I), I = 1, NSG)
+      READ (IU) (ITYP5(I), LSTRG1(I), LPART1(I), GX5(I), GY5(I),
+     &     GZ5(I), FT5(I), PX5(I), PY5(I), PZ5(I), E5(I),
+     &     XMASS5(I), I = 1, MUL)
+      READ (IU) (ITYPN(I), GXN(I), GYN(I), GZN(I), FTN(I),
+     &     PXN(I), PYN(I), PZN(I), EEN(I), XMN(I), I = 1, NNOZPC)
+      READ (IU) ((YP(K, I), K = 1, 3), (NFP(I, K), K = 3, 5),
+     &     I = 1, IHNT2(1))
+      READ (IU) ((YT(K, I), K = 1, 3), (NFT(I, K), K = 3, 5),
+     &     I = 1, IHNT2(3))
+c     the strings are the hadrons HTOP melted, none from minijets
+      NSP = 0
+      NST = 0
+      NSI = NSG
+
+      RETURN
+      END
@@ -0,0 +1,208 @@
+#!/bin/bash
+# test_checkpoint_restart.sh - 断点续跑测试：中断后 "ampt -r" 续跑的输出必须与一次跑完的相同
+#
+# 用法: ./test_checkpoint_restart.sh [事件数] [检查点间隔]    (默认 6 个事件，每 2 个一次检查点)
+#
+# 两个目录使用同一个 input.ampt (iseedev=1, ickpt=间隔)：
+#   full/    一次跑完
+#   resume/  第一个检查点写完后 kill -9；"ampt -r" 续跑，恢复完输出后再 kill -9 一次
+#            (测试续跑本身被中断时从 ana/ckpt/ 中保留的旧文件重新恢复)；最后 "ampt -r" 跑完
+# 然后逐个比较 ana/ 下的文件：.dat 逐字节；.root 文件中每个树的条目数和每个叶子的值
+# (输出树和 .index.root 索引树)、每个直方图的各bin (skim_counters 和 *_analysis.root)
+# 以及 TNamed。ana/ckpt/ 在续跑结束后应已删除。
+#
+# 注意：检查点要求 iseedev=1，所以这里的事件与默认 iseedev=0 的运行不同。
+# 设置 AMPT_SKIM=<skim文件> 可同时测试写入时筛选的计数器。
+
+NEVNT=${1:-6}
+CKPT=${2:-2}
+TOP=$(pwd)
+TEST_DIR=${TEST_DIR:-/tmp/ampt_ckpt_test_$$}
+
+# 日志不缓冲，以便在检查点之后立刻中断
+export GFORTRAN_UNBUFFERED_PRECONNECTED=y
+
+echo "=== AMPT 断点续跑测试 ==="
+echo "测试时间: $(date)"
+echo "事件数: $NEVNT  检查点间隔: $CKPT  测试目录: $TEST_DIR"
+
+if [ ! -x "$TOP/ampt" ] || [ ! -f "$TOP/input.ampt" ]; then
+    echo "错误: 请在含 ampt 和 input.ampt 的目录中运行"
+    exit 1
+fi
+if ! command -v root >/dev/null 2>&1; then
+    echo "错误: 找不到 root，无法比较 ROOT 输出"
+    exit 1
+fi
+
+rm -rf "$TEST_DIR"
+for d in full resume; do
+    mkdir -p "$TEST_DIR/$d/ana"
+    cp "$TOP/ampt" "$TEST_DIR/$d/"
+    sed -e "s/^[0-9]*\(\t*! NEVNT\)/$NEVNT\1/" \
+        -e 's/^0\(\t*! event-indexed seeding\)/1\1/' \
+        -e "s/^[0-9]*\(\t*! restart checkpoint\)/$CKPT\1/" \
+        "$TOP/input.ampt" > "$TEST_DIR/$d/input.ampt"
+done
+
+# 等待日志中出现某行，进程提前结束则返回1
+wait_for() {
+    local pid=$1 log=$2 pattern=$3
+    while ! grep -q "$pattern" "$log" 2>/dev/null; do
+        kill -0 $pid 2>/dev/null || return 1
+        sleep 0.2
+    done
+    return 0
+}
+
+# 一次跑完
+echo -e "\n运行完整的参考模拟..."
+(cd "$TEST_DIR/full" && echo 0 | ./ampt > full.log 2>&1)
+
+# 中断与续跑
+echo "运行被中断的模拟..."
+cd "$TEST_DIR/resume"
+echo 0 | ./ampt > run1.log 2>&1 &
+PID=$!
+if wait_for $PID run1.log "checkpoint after event"; then
+    kill -9 $PID 2>/dev/null
+    wait $PID 2>/dev/null
+    echo "第一次运行在检查点之后中断: $(grep 'checkpoint after event' run1.log | tail -1)"
+else
+    echo "警告: 第一次运行在检查点之前已结束，增加事件数"
+fi
+
+echo 0 | ./ampt -r > run2.log 2>&1 &
+PID=$!
+if wait_for $PID run2.log "ROOT interface initialized"; then
+    kill -9 $PID 2>/dev/null
+    wait $PID 2>/dev/null
+    echo "续跑在恢复输出之后中断，ana/ckpt/ 中的文件:"
+    ls ana/ckpt/
+fi
+
+echo 0 | ./ampt -r > run3.log 2>&1
+cd "$TOP"
+
+# ============ 比较输出 ============
+echo -e "\n━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━"
+echo "比较 full/ana 与 resume/ana"
+echo "━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━"
+
+cat > "$TEST_DIR/compare_root.C" << 'EOF'
+#include <set>
+
+// 比较两个目录中的全部对象：树 (条目数和每个叶子的值)、直方图、TNamed；返回差异数
+int compare_dir(TDirectory* a, TDirectory* b, const TString& path) {
+    int ndiff = 0;
+    std::set<std::string> seen;
+    TIter next(a->GetListOfKeys());
+    while (TKey* key = (TKey*)next()) {
+        std::string name = key->GetName();
+        if (!seen.insert(name).second) continue;    // 只比较最新的cycle
+        TObject* oa = a->Get(name.c_str());
+        TObject* ob = b->Get(name.c_str());
+        TString where = path + "/" + name;
+        if (!ob) { printf("  缺少 %s\n", where.Data()); ndiff++; continue; }
+        if (oa->InheritsFrom("TDirectory")) {
+            ndiff += compare_dir((TDirectory*)oa, (TDirectory*)ob, where);
+        } else if (oa->InheritsFrom("TTree")) {
+            TTree* ta = (TTree*)oa;
+            TTree* tb = (TTree*)ob;
+            if (ta->GetEntries() != tb->GetEntries()) {
+                printf("  %s: 条目数 %lld != %lld\n", where.Data(), ta->GetEntries(), tb->GetEntries());
+                ndiff++;
+                continue;
+            }
+            int nleafdiff = 0;
+            TObjArray* leaves = ta->GetListOfLeaves();
+            for (Long64_t i = 0; i < ta->GetEntries(); i++) {
+                ta->GetEntry(i);
+                tb->GetEntry(i);
+                for (int l = 0; l < leaves->GetEntries(); l++) {
+                    TLeaf* la = (TLeaf*)leaves->At(l);
+                    TLeaf* lb = tb->GetLeaf(la->GetName());
+                    if (!lb || la->GetLen() != lb->GetLen()) { nleafdiff++; continue; }
+                    for (int k = 0; k < la->GetLen(); k++)
+                        if (la->GetValue(k) != lb->GetValue(k)) { nleafdiff++; break; }
+                }
+            }
+            printf("  %s: %lld 条目, %s\n", where.Data(), ta->GetEntries(),
+                   nleafdiff ? Form("%d 处叶子值不同", nleafdiff) : "一致");
+            ndiff += nleafdiff;
+        } else if (oa->InheritsFrom("TH1")) {
+            TH1* ha = (TH1*)oa;
+            TH1* hb = (TH1*)ob;
+            bool same = ha->GetNcells() == hb->GetNcells() && ha->GetEntries() == hb->GetEntries();
+            for (int c = 0; same && c < ha->GetNcells(); c++)
+                same = ha->GetBinContent(c) == hb->GetBinContent(c) && ha->GetBinError(c) == hb->GetBinError(c);
+            if (!same) { printf("  %s: 直方图不同\n", where.Data()); ndiff++; }
+        } else if (oa->InheritsFrom("TNamed")) {
+            if (TString(((TNamed*)oa)->GetTitle()) != ((TNamed*)ob)->GetTitle()) {
+                printf("  %s: \"%s\" != \"%s\"\n", where.Data(), ((TNamed*)oa)->GetTitle(), ((TNamed*)ob)->GetTitle());
+                ndiff++;
+            }
+        }
+    }
+    // 续跑文件中多出来的对象
+    TIter nextb(b->GetListOfKeys());
+    while (TKey* key = (TKey*)nextb()) {
+        if (!a->GetKey(key->GetName())) { printf("  多出 %s/%s\n", path.Data(), key->GetName()); ndiff++; }
+    }
+    return ndiff;
+}
+
+void compare_root(const char* fa, const char* fb) {
+    TFile* a = TFile::Open(fa);
+    TFile* b = TFile::Open(fb);
+    if (!a || a->IsZombie() || !b || b->IsZombie()) { printf("RESULT FAIL (无法打开)\n"); return; }
+    int ndiff = compare_dir(a, b, "");
+    printf("RESULT %s\n", ndiff ? "FAIL" : "OK");
+}
+EOF
+
+NFAIL=0
+for f in "$TEST_DIR"/full/ana/*; do
+    name=$(basename "$f")
+    [ -d "$f" ] && continue
+    g="$TEST_DIR/resume/ana/$name"
+    if [ ! -f "$g" ]; then
+        echo "✗ $name: 续跑中没有此文件"
+        NFAIL=$((NFAIL + 1))
+        continue
+    fi
+    case "$name" in
+        *.root)
+            echo "$name:"
+            result=$(root -l -b -q "$TEST_DIR/compare_root.C(\"$f\",\"$g\")" 2>&1)
+            echo "$result" | grep -v "^RESULT\|^Processing"
+            if echo "$result" | grep -q "RESULT OK"; then
+                echo "✓ $name 一致"
+            else
+                echo "✗ $name 不一致"
+                NFAIL=$((NFAIL + 1))
+            fi
+            ;;
+        *)
+            if cmp -s "$f" "$g"; then
+                echo "✓ $name 一致"
+            else
+                echo "✗ $name 不一致"
+                NFAIL=$((NFAIL + 1))
+            fi
+            ;;
+    esac
+done
+
+if [ -e "$TEST_DIR/resume/ana/ckpt" ]; then
+    echo "✗ 续跑结束后 ana/ckpt/ 仍然存在: $(ls "$TEST_DIR/resume/ana/ckpt")"
+    NFAIL=$((NFAIL + 1))
+fi
+
+echo -e "\n━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━"
+if [ $NFAIL -eq 0 ]; then
+    echo "断点续跑测试通过，测试目录: $TEST_DIR"
+    exit 0
+fi
+echo "断点续跑测试失败: $NFAIL 个文件不一致，测试目录: $TEST_DIR"
+exit 1
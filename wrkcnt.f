@@ -0,0 +1,136 @@
+c=======================================================================
+c     wrkcnt.f - Per-event transport work counters
+c
+c     COMMON /WRKCNT/ NWORK(12) counts the work the transport did in
+c     the current event; main.f clears it at the start of every event
+c     and hands it to the stage timer (stage_timer.h), which stores it
+c     next to the multiplicities in ana/timing.root.  Slots:
+c        1 ZPC two-parton collisions (scat)
+c        2 ZPC cell changes at cell walls (cellre)
+c        3 ZPC partons formed (joining the collision heap)
+c        4 coalescence partner candidates examined (czcoal_cands,
+c          czcoal_bmdom_one)
+c        5 ART pairs examined (neighbour candidates of artgnb)
+c        6 ART pairs within interaction range (passing distc0)
+c        7 ART collisions baryon-baryon (resonances, deuterons
+c          and antibaryon-antibaryon included)
+c        8 ART collisions meson-baryon (or antibaryon)
+c        9 ART collisions meson-meson
+c       10 ART collisions baryon-antibaryon
+c       11 ART pairs in range that did not collide: the channel
+c          gave nothing (ART has no Pauli blocking; this is the
+c          closest to the blocked collisions of the old RELCOL
+c          counters, whose LBLOC is always 0)
+c       12 ART resonance decays (resdec, DECAY, DECAY2)
+c     An ART pair collided if either particle changed its momentum,
+c     energy or label: RELCOL has many exits per channel and IBLOCK
+c     is not reset between pairs, so the outcome is read from the
+c     particles themselves (WRKART).  The counters include repeated
+c     HIJING events and cost a few integer adds per operation.
+c=======================================================================
+
+      SUBROUTINE WRKCLR
+c
+c     Clear the counters at the start of an event
+c
+      INTEGER*8 NWORK
+      COMMON /WRKCNT/ NWORK(12)
+cc      SAVE /WRKCNT/
+      COMMON /WRKPR/ IWI1, IWI2, IWPEND
+cc      SAVE /WRKPR/
+      SAVE
+
+      DO 10 I = 1, 12
+         NWORK(I) = 0
+ 10   CONTINUE
+      IWPEND = 0
+
+      RETURN
+      END
+
+c-----------------------------------------------------------------------
+      SUBROUTINE WRKART(MODE, I1, I2)
+c
+c     MODE=0: the ART pair I1, I2 is within interaction range, keep
+c     its state.  MODE=1: at the end of the pair (or of the time step),
+c     count the kept pair as a collision by kind or as a pair that did
+c     nothing.  Both modes count a pair still pending first.
+c
+      PARAMETER (MAXSTR=150001)
+      INTEGER*8 NWORK
+      COMMON /WRKCNT/ NWORK(12)
+cc      SAVE /WRKCNT/
+      COMMON /WRKPR/ IWI1, IWI2, IWPEND
+cc      SAVE /WRKPR/
+      COMMON /BB/ P(3,MAXSTR)
+cc      SAVE /BB/
+      COMMON /CC/ E(MAXSTR)
+cc      SAVE /CC/
+      COMMON /EE/ ID(MAXSTR),LB(MAXSTR)
+cc      SAVE /EE/
+      DIMENSION PSV(3,2), ESV(2), LBSV(2)
+      SAVE
+
+c     count the pending pair first: a pair left with GO TO 600/800 in
+c     RELCOL is counted at the next pair within range
+      IF (IWPEND .EQ. 0) GOTO 20
+      IWPEND = 0
+      J1 = IWI1
+      J2 = IWI2
+      IF (P(1,J1).EQ.PSV(1,1) .AND. P(2,J1).EQ.PSV(2,1)
+     1     .AND. P(3,J1).EQ.PSV(3,1) .AND. E(J1).EQ.ESV(1)
+     2     .AND. LB(J1).EQ.LBSV(1)
+     3     .AND. P(1,J2).EQ.PSV(1,2) .AND. P(2,J2).EQ.PSV(2,2)
+     4     .AND. P(3,J2).EQ.PSV(3,2) .AND. E(J2).EQ.ESV(2)
+     5     .AND. LB(J2).EQ.LBSV(2)) THEN
+         NWORK(11) = NWORK(11) + 1
+         GOTO 20
+      ENDIF
+c     baryon number sign of the incoming pair (0 for mesons):
+      IB1 = IWBARY(LBSV(1))
+      IB2 = IWBARY(LBSV(2))
+      IF (IB1*IB2 .GT. 0) THEN
+         NWORK(7) = NWORK(7) + 1
+      ELSEIF (IB1*IB2 .LT. 0) THEN
+         NWORK(10) = NWORK(10) + 1
+      ELSEIF (IB1 .NE. 0 .OR. IB2 .NE. 0) THEN
+         NWORK(8) = NWORK(8) + 1
+      ELSE
+         NWORK(9) = NWORK(9) + 1
+      ENDIF
+
+ 20   IF (MODE .EQ. 0) THEN
+         IWI1 = I1
+         IWI2 = I2
+         DO 10 K = 1, 3
+            PSV(K,1) = P(K,I1)
+            PSV(K,2) = P(K,I2)
+ 10      CONTINUE
+         ESV(1) = E(I1)
+         ESV(2) = E(I2)
+         LBSV(1) = LB(I1)
+         LBSV(2) = LB(I2)
+         IWPEND = 1
+         NWORK(6) = NWORK(6) + 1
+      ENDIF
+
+      RETURN
+      END
+
+c-----------------------------------------------------------------------
+      INTEGER FUNCTION IWBARY(LBI)
+c
+c     Sign of the baryon number of ART label LBI: nucleons (1,2),
+c     Delta and N* (6-13), Lambda/Sigma (14-17), cascades (40,41),
+c     deuteron (42), Omega (45); negative labels are the antiparticles
+c
+      IA = IABS(LBI)
+      IF ((IA.GE.1 .AND. IA.LE.2) .OR. (IA.GE.6 .AND. IA.LE.17)
+     1     .OR. (IA.GE.40 .AND. IA.LE.42) .OR. IA.EQ.45) THEN
+         IWBARY = ISIGN(1, LBI)
+      ELSE
+         IWBARY = 0
+      ENDIF
+
+      RETURN
+      END
@@ -10,6 +10,8 @@ clin-4/20/01        PARAMETER (NMAXGL = 16000)
         common /para3/ nsevt, nevnt, nsbrun, ievt, isbrun
 cc      SAVE /para3/
         SAVE   
+        integer timer_on
+        external timer_on
 c
 c       loop over events
         do 1000 i = 1, nevnt
@@ -20,6 +22,7 @@ c      loop over many runs of the same event
            do 2000 j = 1, nsbrun
               isbrun = j
 c       initialization for one run of an event
+              call cpu_time(tz0)
               call inirun
 clin-4/2008 not used:
 c             CALL HJAN1A
@@ -30,6 +33,10 @@ c       do one collision
               goto 3000
  4000         continue
               call zpca2
+              call cpu_time(tz1)
+c       the cpu time only with AMPT_TIMING, so that zpc.res is reproducible
+              if (timer_on() .ne. 0)
+     &           WRITE (25, *) '    cpu time in zpc (s) = ', tz1 - tz0
  2000      continue
  1000   continue
         call zpcou
@@ -94,7 +101,9 @@ cc      SAVE /aurec2/
      &     ictype, icsta(MAXPTN),
      &     nic(MAXPTN), icels(MAXPTN)
 cc      SAVE /ilist1/
-        common /ilist2/ icell, icel(10,10,10)
+        parameter (MAXCPL=2*MAXPTN+4004)
+        common /ilist2/ ncbeg(1001), ncnum(1001), nccap(1001), nctop,
+     &     ncpool(MAXCPL)
 cc      SAVE /ilist2/
         common /ilist3/ size1, size2, size3, v1, v2, v3, size
 cc      SAVE /ilist3/
@@ -675,12 +684,71 @@ c       save data for many runs of the same initial condition
 c       sort prec2 according to increasing formation time
         call ftime
         call inirec
+        call zgrid
         call iilist
         call inian2
 
         return
         end
 
+        subroutine zgrid
+c       this subroutine chooses the cell sizes for the current event
+c       when the density-adaptive grid is on (izgrid=1 in input.ampt);
+c       the cell sizes follow the mean distance of the formed partons
+c       from the center in each direction, so that the dense core is
+c       split into small cells while the 10*10*10 cube still covers most
+c       of the partons, but a cell is never smaller than twice the
+c       interaction range sqrt(cutof2) given by xmu and alpha.
+c       with izgrid=0 the fixed sizes from readpa are kept.
+c       input gx(i), gy(i), gz(i), ft(i)
+c       output size1, size2, size3, size in the common /ilist3/
+
+        implicit double precision (a-h, o-z)
+        parameter (MAXPTN=400001)
+        common /para1/ mul
+cc      SAVE /para1/
+        common /para2/ xmp, xmu, alpha, rscut2, cutof2
+cc      SAVE /para2/
+        common /para5/ iconfg, iordsc
+cc      SAVE /para5/
+        common /prec2/gx(MAXPTN),gy(MAXPTN),gz(MAXPTN),ft(MAXPTN),
+     &       px(MAXPTN), py(MAXPTN), pz(MAXPTN), e(MAXPTN),
+     &       xmass(MAXPTN), ityp(MAXPTN)
+cc      SAVE /prec2/
+        common /ilist3/ size1, size2, size3, v1, v2, v3, size
+cc      SAVE /ilist3/
+        common /ilist5/ ct(MAXPTN), ot(MAXPTN), tlarge
+cc      SAVE /ilist5/
+        common /zpcgrd/ izgrid
+cc      SAVE /zpcgrd/
+        SAVE   
+
+        if (izgrid .eq. 0 .or. iconfg .ne. 1) return
+
+        n = 0
+        ax = 0d0
+        ay = 0d0
+        az = 0d0
+        do 1001 i = 1, mul
+           if (ft(i) .ge. tlarge) goto 1001
+           n = n + 1
+           ax = ax + abs(gx(i))
+           ay = ay + abs(gy(i))
+           az = az + abs(gz(i))
+ 1001   continue
+        if (n .eq. 0) return
+
+c       the z distribution has long tails from late formation, so the 
+c       longitudinal cells are taken smaller relative to the mean
+        smin = 2d0 * sqrt(cutof2)
+        size1 = max(smin, 0.4d0 * ax / dble(n))
+        size2 = max(smin, 0.4d0 * ay / dble(n))
+        size3 = max(smin, 0.3d0 * az / dble(n))
+        size = min(size1, size2, size3)
+
+        return
+        end
+
         subroutine ftime
 c       this subroutine generates formation time for the particles
 c       indexing ft(i)
@@ -713,11 +781,25 @@ cc      SAVE /par1/
 cc      SAVE /anim/
         common /rndm3/ iseedp
 cc      SAVE /rndm3/
+        common /ampcap/ nstrcp, nptncp
+cc      SAVE /ampcap/
         SAVE   
 
         iseed=iseedp
+c     grow the active size of the MAXPTN arrays (see ARSIZE) if needed:
+        if (mul .gt. MAXPTN) then
+           write (6, *) 'error: ', mul, ' partons in the event exceed ',
+     &          'the static array size MAXPTN=', MAXPTN,
+     &          '; raise MAXPTN in the sources and rebuild'
+           stop 1
+        end if
+        if (mul .gt. nptncp) then
+           write (6, *) 'active MAXPTN array size grown: ', nptncp,
+     &          min(MAXPTN, 2 * mul)
+           nptncp = min(MAXPTN, 2 * mul)
+        end if
 clin-6/07/02 initialize here to expedite compiling, instead in zpcbdt:
-        do 1001 i = 1, MAXPTN
+        do 1001 i = 1, nptncp
            ct(i)=0d0
            ot(i)=0d0
  1001   continue
@@ -734,7 +816,7 @@ c     5/01/01 different prescription for parton initial formation time:
            else
 c     5/01/01-end
 
-           do 1003 i = 1, MAXPTN
+           do 1003 i = 1, nptncp
               ft0(i) = tlarge
  1003      continue
            do 1004 i = 1, mul
@@ -1022,7 +1104,9 @@ cc      SAVE /para1/
      &     ictype, icsta(MAXPTN),
      &     nic(MAXPTN), icels(MAXPTN)
 cc      SAVE /ilist1/
-        common /ilist2/ icell, icel(10,10,10)
+        parameter (MAXCPL=2*MAXPTN+4004)
+        common /ilist2/ ncbeg(1001), ncnum(1001), nccap(1001), nctop,
+     &     ncpool(MAXCPL)
 cc      SAVE /ilist2/
         common /ilist4/ ifmpt, ichkpt, indx(MAXPTN)
 cc      SAVE /ilist4/
@@ -1043,14 +1127,12 @@ cc      SAVE /ilist6/
            icels(i) = 0
  1001   continue
 
-        icell = 0
-        do 1004 i1 = 1, 10
-           do 1003 i2 = 1, 10
-              do 1002 i3 = 1, 10
-                 icel(i1, i2, i3) = 0
- 1002         continue
- 1003      continue
- 1004   continue
+        nctop = 1
+        do 1002 ic = 1, 1001
+           ncbeg(ic) = 1
+           ncnum(ic) = 0
+           nccap(ic) = 0
+ 1002   continue
 
         ichkpt = 0
         ifmpt = 1
@@ -1059,6 +1141,7 @@ cc      SAVE /ilist6/
            ct(i) = tlarge
            ot(i) = tlarge
  1005   continue
+        call hpini
 
         iopern = 0
         icolln = 0
@@ -1132,6 +1215,9 @@ cc      SAVE /ana1/
         common/anim/nevent,isoft,isflag,izpc
 cc      SAVE /anim/
         COMMON /AREVT/ IAEVT, IARUN, MISS
+        INTEGER*8 NWORK
+        COMMON /WRKCNT/ NWORK(12)
+cc      SAVE /WRKCNT/
         SAVE   
 
 c       save last collision info
@@ -1175,6 +1261,8 @@ c3      update iopern, t
         t = t1
         if (mod(ictype, 2) .eq. 0) then
            icolln = icolln + 1
+c     work counters (wrkcnt.f):
+           NWORK(1) = NWORK(1) + 1
 
 c     4/18/01-ctest off
 c           write (2006, 1233) 'iscat=', iscat, 'jscat=', jscat,
@@ -1314,6 +1402,10 @@ c       old ichkpt and ifmpt are more conveniently used in ulist
      &        .and. ictype .ne. 4) then
               ichkpt = ichkpt + 1
               ifmpt = ifmpt + 1
+              NWORK(3) = NWORK(3) + 1
+c     the newly formed parton joins the collision time heap:
+              ii = ichkpt
+              call hpins(ii)
            end if
         end if
 
@@ -1373,6 +1465,8 @@ cc      SAVE /ilist1/
 cc      SAVE /ilist4/
         common /ilist5/ ct(MAXPTN), ot(MAXPTN), tlarge
 cc      SAVE /ilist5/
+        common /ilist9/ nheap, iheap(MAXPTN), ipos(MAXPTN)
+cc      SAVE /ilist9/
         SAVE   
 
 c       neglect possibility of 2 collisions at the same time
@@ -1383,12 +1477,14 @@ c0       set initial conditions
         jscat = 0
 
 c1      get next collision between particles
-        do 1001 i = 1, ichkpt
+c       the heap top is the first i in 1..ichkpt with the smallest ot(i):
+        if (nheap .gt. 0) then
+           i = iheap(1)
            if (ot(i) .lt. t1) then
               t1 = ot(i)
               iscat = i
            end if
- 1001   continue
+        end if
         if (iscat .ne. 0) jscat = next(iscat)
 
 c2      get ictype
@@ -1417,10 +1513,134 @@ c
         return
         end
 
+c=======================================================================
+c     indexed binary heap of the formed partons 1..ichkpt, ordered by
+c     (ot(i), i) so that ties go to the smaller index as in the former
+c     linear scan of getict; ipos(i) is the heap slot of parton i (0 if
+c     not yet in the heap).  hpupd(i) must follow every change of ot(i).
+        subroutine hpini
+
+        implicit double precision (a-h, o-z)
+        parameter (MAXPTN=400001)
+        common /para1/ mul
+cc      SAVE /para1/
+        common /ilist9/ nheap, iheap(MAXPTN), ipos(MAXPTN)
+cc      SAVE /ilist9/
+        SAVE   
+
+        nheap = 0
+        do 1001 i = 1, mul
+           ipos(i) = 0
+ 1001   continue
+
+        return
+        end
+
+        subroutine hpins(i)
+
+        implicit double precision (a-h, o-z)
+        parameter (MAXPTN=400001)
+        common /ilist9/ nheap, iheap(MAXPTN), ipos(MAXPTN)
+cc      SAVE /ilist9/
+        SAVE   
+
+        if (ipos(i) .ne. 0) return
+        nheap = nheap + 1
+        iheap(nheap) = i
+        ipos(i) = nheap
+        k = nheap
+        call hpup(k)
+
+        return
+        end
+
+        subroutine hpupd(i)
+
+        implicit double precision (a-h, o-z)
+        parameter (MAXPTN=400001)
+        common /ilist9/ nheap, iheap(MAXPTN), ipos(MAXPTN)
+cc      SAVE /ilist9/
+        SAVE   
+
+        if (ipos(i) .eq. 0) return
+        k = ipos(i)
+        call hpup(k)
+        k = ipos(i)
+        call hpdown(k)
+
+        return
+        end
+
+        subroutine hpup(k0)
+c       move the entry in slot k0 towards the root
+
+        implicit double precision (a-h, o-z)
+        parameter (MAXPTN=400001)
+        common /ilist5/ ct(MAXPTN), ot(MAXPTN), tlarge
+cc      SAVE /ilist5/
+        common /ilist9/ nheap, iheap(MAXPTN), ipos(MAXPTN)
+cc      SAVE /ilist9/
+        SAVE   
+
+        k = k0
+        i = iheap(k)
+ 10     if (k .gt. 1) then
+           kp = k / 2
+           j = iheap(kp)
+           if (ot(i) .lt. ot(j) .or.
+     &        (ot(i) .eq. ot(j) .and. i .lt. j)) then
+              iheap(k) = j
+              ipos(j) = k
+              k = kp
+              goto 10
+           end if
+        end if
+        iheap(k) = i
+        ipos(i) = k
+
+        return
+        end
+
+        subroutine hpdown(k0)
+c       move the entry in slot k0 towards the leaves
+
+        implicit double precision (a-h, o-z)
+        parameter (MAXPTN=400001)
+        common /ilist5/ ct(MAXPTN), ot(MAXPTN), tlarge
+cc      SAVE /ilist5/
+        common /ilist9/ nheap, iheap(MAXPTN), ipos(MAXPTN)
+cc      SAVE /ilist9/
+        SAVE   
+
+        k = k0
+        i = iheap(k)
+ 10     kc = 2 * k
+        if (kc .le. nheap) then
+           if (kc .lt. nheap) then
+              j1 = iheap(kc)
+              j2 = iheap(kc + 1)
+              if (ot(j2) .lt. ot(j1) .or.
+     &           (ot(j2) .eq. ot(j1) .and. j2 .lt. j1)) kc = kc + 1
+           end if
+           j = iheap(kc)
+           if (ot(j) .lt. ot(i) .or.
+     &        (ot(j) .eq. ot(i) .and. j .lt. i)) then
+              iheap(k) = j
+              ipos(j) = k
+              k = kc
+              goto 10
+           end if
+        end if
+        iheap(k) = i
+        ipos(i) = k
+
+        return
+        end
+
         subroutine celasn
 c       this subroutine is used to assign a cell for a newly formed particle
 c       output: nic(MAXPTN) icels(MAXPTN) in the common /ilist1/
-c       icell, and icel(10,10,10) in the common /ilist2/
+c       and the cell lists in the common /ilist2/
 
         implicit double precision (a-h, o-z)
         parameter (MAXPTN=400001)
@@ -1439,7 +1659,9 @@ cc      SAVE /prec4/
      &     ictype, icsta(MAXPTN),
      &     nic(MAXPTN), icels(MAXPTN)
 cc      SAVE /ilist1/
-        common /ilist2/ icell, icel(10,10,10)
+        parameter (MAXCPL=2*MAXPTN+4004)
+        common /ilist2/ ncbeg(1001), ncnum(1001), nccap(1001), nctop,
+     &     ncpool(MAXCPL)
 cc      SAVE /ilist2/
         common /ilist3/ size1, size2, size3, v1, v2, v3, size
 cc      SAVE /ilist3/
@@ -1447,7 +1669,7 @@ cc      SAVE /ilist3/
 cc      SAVE /ilist4/
         SAVE   
 
-        external integ
+        external integ, icelid
 
         i = ifmpt
         tt = ft(i)
@@ -1493,14 +1715,10 @@ cc      SAVE /ilist4/
         end if
 
         if (i1 .eq. 11) then
-           j = icell
-           call newcre(i, j)
-           icell = j
+           call newcre(i, 1001)
            icels(i) = 111111
         else
-           j = icel(i1, i2, i3)
-           call newcre(i, j)
-           icel(i1, i2, i3) = j
+           call newcre(i, icelid(i1, i2, i3))
            icels(i) = i1 * 10000 + i2 * 100 + i3
         end if
 
@@ -1546,7 +1764,9 @@ cc      SAVE /aurec2/
      &     ictype, icsta(MAXPTN),
      &     nic(MAXPTN), icels(MAXPTN)
 cc      SAVE /ilist1/
-        common /ilist2/ icell, icel(10,10,10)
+        parameter (MAXCPL=2*MAXPTN+4004)
+        common /ilist2/ ncbeg(1001), ncnum(1001), nccap(1001), nctop,
+     &     ncpool(MAXCPL)
 cc      SAVE /ilist2/
         common /ilist3/ size1, size2, size3, v1, v2, v3, size
 cc      SAVE /ilist3/
@@ -1554,15 +1774,20 @@ cc      SAVE /ilist3/
 cc      SAVE /ilist4/
         common /ilist5/ ct(MAXPTN), ot(MAXPTN), tlarge
 cc      SAVE /ilist5/
+        INTEGER*8 NWORK
+        COMMON /WRKCNT/ NWORK(12)
+cc      SAVE /WRKCNT/
         SAVE   
 
         logical good
 
-        external integ
+        external integ, icelid
 
 c       this happens before update the /prec2/ common; in contrast with 
 c       scat which happens after updating the glue common
 
+c     work counters (wrkcnt.f):
+        NWORK(2) = NWORK(2) + 1
         t0 = t
 
  1000        continue
@@ -1638,9 +1863,6 @@ cc       for particle inside the cube
      &        .and. i2 .ge. 1 .and. i2 .le. 10
      &        .and. i3 .ge. 1 .and. i3 .le. 10) then
 
-c       this assignment takes care of nic(i)=0 automatically
-              if (icel(i1, i2, i3) .eq. i) icel(i1, i2, i3) = nic(i)
-
 c1      rearrange the old cell
 
               call oldcre(i)
@@ -1664,9 +1886,7 @@ c2.1    particle goes out of the cube
               end if
               if (good) then
 
-c                j = icell
-                 call newcre(i, icell)
-c                 icell = j
+                 call newcre(i, 1001)
 
                  icels(i) = 111111
 
@@ -1709,12 +1929,7 @@ c2.2    particle moves inside the cube
                     end if
                  end if
                  
-                 j = icel(i1, i2, i3)
-                 
-                 call newcre(i, j)
-c       in case icel changes
-                 
-                 icel(i1 ,i2, i3) = j
+                 call newcre(i, icelid(i1, i2, i3))
                  
                  icels(i) = i1 * 10000 + i2 * 100 + i3
                  
@@ -1723,8 +1938,6 @@ c       in case icel changes
 cc       for particles outside the cube
            else
               
-              if (icell .eq. i) icell = nic(i)
-              
               call oldcre(i)
               
               k = mod(icsta(i), 10)
@@ -1752,9 +1965,7 @@ cc       for particles outside the cube
               if (k .eq. 5) i3 = 1
               if (k .eq. 6) i3 = 10
 
-              j = icel(i1, i2, i3)
-              call newcre(i, j)
-              icel(i1, i2, i3) = j
+              call newcre(i, icelid(i1, i2, i3))
               
               icels(i) = i1 * 10000 + i2 * 100 + i3
               
@@ -1781,6 +1992,8 @@ cc       for particles outside the cube
         if (icsta(i) / 10 .eq. 11) then
            ot(next(i)) = otmp
            ct(next(i)) = ctmp
+           nn = next(i)
+           call hpupd(nn)
            next(next(i)) = i
            call wallc(i, i1, i2, i3, t0, tmin1)
            if (tmin1 .lt. ct(i)) then
@@ -1794,8 +2007,10 @@ cc       for particles outside the cube
         end
            
         subroutine oldcre(i) 
-c       this subroutine is used to rearrange the old cell nic when a particle 
-c       goes out of the cell
+c       this subroutine is used to take particle i out of its old cell
+c       icels(i) when it goes out of the cell; the particles after i in 
+c       the cell list move up by one, so the list keeps its order
+c       input i, icels(i)
 
         implicit double precision (a-h, o-z)
         parameter (MAXPTN=400001)
@@ -1804,32 +2019,41 @@ c       goes out of the cell
      &     ictype, icsta(MAXPTN),
      &     nic(MAXPTN), icels(MAXPTN)
 cc      SAVE /ilist1/
+        parameter (MAXCPL=2*MAXPTN+4004)
+        common /ilist2/ ncbeg(1001), ncnum(1001), nccap(1001), nctop,
+     &     ncpool(MAXCPL)
+cc      SAVE /ilist2/
         SAVE   
 
-        if (nic(i) .eq. 0) return
+        external icelid
 
-        j = nic(i)
+        if (icels(i) .eq. 0) return
 
-        if (nic(j) .eq. i) then
-           nic(j) = 0
-           return
-        end if
+        icels0 = icels(i)
+        i1 = icels0 / 10000
+        i2 = (icels0 - i1 * 10000) / 100
+        i3 = icels0 - i1 * 10000 - i2 * 100
+        ic = icelid(i1, i2, i3)
 
-        do 10 while (nic(j) .ne. i)
-           j = nic(j)
- 10        continue
-        
-        nic(j) = nic(i)
+        ib = ncbeg(ic) - 1
+        do 1001 k = nic(i), ncnum(ic) - 1
+           j = ncpool(ib + k + 1)
+           ncpool(ib + k) = j
+           nic(j) = k
+ 1001   continue
+        ncnum(ic) = ncnum(ic) - 1
+        nic(i) = 0
 
         return
         end
 
 
-        subroutine newcre(i, k)
-c       this subroutine is used to mk rearrange of the new cell a particle
-c       enters,
-c       input i
-c       output nic(i)
+        subroutine newcre(i, ic)
+c       this subroutine is used to append particle i at the end of the
+c       list of the new cell ic it enters, the cell list is grown 
+c       when it is full
+c       input i, ic
+c       output nic(i), the position of i in the cell list
 
         implicit double precision (a-h, o-z)
         parameter (MAXPTN=400001)
@@ -1838,25 +2062,81 @@ c       output nic(i)
      &     ictype, icsta(MAXPTN),
      &     nic(MAXPTN), icels(MAXPTN)
 cc      SAVE /ilist1/
+        parameter (MAXCPL=2*MAXPTN+4004)
+        common /ilist2/ ncbeg(1001), ncnum(1001), nccap(1001), nctop,
+     &     ncpool(MAXCPL)
+cc      SAVE /ilist2/
         SAVE   
 
-        if (k .eq. 0) then
-           k = i
-           nic(i) = 0
-        else if (nic(k) .eq. 0) then
-           nic(k) = i
-           nic(i) = k
-        else
-           j = k
-           do 10 while (nic(j) .ne. k)
-              j = nic(j)
- 10           continue
+        if (ncnum(ic) .eq. nccap(ic)) call celgrw(ic)
+
+        ncnum(ic) = ncnum(ic) + 1
+        ncpool(ncbeg(ic) + ncnum(ic) - 1) = i
+        nic(i) = ncnum(ic)
+        
+        return
+        end
 
-           nic(j) = i
-           nic(i) = k
+        subroutine celgrw(ic)
+c       this subroutine is used to double the room of the full cell ic;
+c       the list is moved to the free end of ncpool, and when ncpool is 
+c       used up all cell lists are packed again from the start, each with
+c       room for twice its particles, which always fits since the cells
+c       hold at most MAXPTN particles
+c       input ic
+c       output ncbeg, nccap, nctop in the common /ilist2/
 
+        implicit double precision (a-h, o-z)
+        parameter (MAXPTN=400001)
+        parameter (MAXCPL=2*MAXPTN+4004)
+        common /ilist2/ ncbeg(1001), ncnum(1001), nccap(1001), nctop,
+     &     ncpool(MAXCPL)
+cc      SAVE /ilist2/
+        dimension ictmp(MAXCPL)
+        SAVE   
+
+        ncap = max(4, 2 * nccap(ic))
+        if (nctop + ncap - 1 .le. MAXCPL) then
+           do 1001 k = 0, ncnum(ic) - 1
+              ncpool(nctop + k) = ncpool(ncbeg(ic) + k)
+ 1001      continue
+           ncbeg(ic) = nctop
+           nccap(ic) = ncap
+           nctop = nctop + ncap
+           return
         end if
-        
+
+        nctop = 1
+        do 1003 jc = 1, 1001
+           do 1002 k = 0, ncnum(jc) - 1
+              ictmp(nctop + k) = ncpool(ncbeg(jc) + k)
+ 1002      continue
+           ncbeg(jc) = nctop
+           nccap(jc) = max(4, 2 * ncnum(jc))
+           nctop = nctop + nccap(jc)
+ 1003   continue
+        do 1004 k = 1, nctop - 1
+           ncpool(k) = ictmp(k)
+ 1004   continue
+
+        return
+        end
+
+        integer function icelid(i1, i2, i3)
+c       this function is used to get the index of the cell (i1,i2,i3) in 
+c       the cell lists of the common /ilist2/: 1 to 1000 for the cells of
+c       the cube, with i1 running fastest, and 1001 for the particles 
+c       outside the cube (i1=i2=i3=11)
+
+        implicit double precision (a-h, o-z)
+        SAVE   
+
+        if (i1 .eq. 11) then
+           icelid = 1001
+        else
+           icelid = i1 + 10 * (i2 - 1) + 100 * (i3 - 1)
+        end if
+
         return
         end
 
@@ -2981,12 +3261,16 @@ cc      SAVE /para5/
      &     ictype, icsta(MAXPTN),
      &     nic(MAXPTN), icels(MAXPTN)
 cc      SAVE /ilist1/
-        common /ilist2/ icell, icel(10, 10, 10)
+        parameter (MAXCPL=2*MAXPTN+4004)
+        common /ilist2/ ncbeg(1001), ncnum(1001), nccap(1001), nctop,
+     &     ncpool(MAXCPL)
 cc      SAVE /ilist2/
         common /ilist4/ ifmpt, ichkpt, indx(MAXPTN)
 cc      SAVE /ilist4/
         SAVE   
 
+        external icelid
+
         if (iconfg .eq. 3 .or. iconfg .eq. 5) then
            jj = ichkpt
            do 1001 j = 1, jj
@@ -3000,36 +3284,20 @@ c              if (ick .eq. 1) call ud2(j, il, t, tmin, nc)
         end if
 
         if (i1 .eq. 11 .and. i2 .eq. 11 .and. i3 .eq. 11) then
-           l = icell
+           ic = 1001
         else
-           l = icel(i1, i2, i3)
-        end if
-
-c       if there is no particle
-        if (l .eq. 0) then
-           return
+           ic = icelid(i1, i2, i3)
         end if
-        j = nic(l)
-c       if there is only one particle
-        if (j .eq. 0) then
-           call ck(l, ick)
-           if (ick .eq. 1) call ud2(l, il, t, tmin, nc)
-
-c       if there are many particles
-        else
 
 c       we don't worry about the other colliding particle because it's
 c       set in last(), and will be checked in ud2
 
-           call ck(l, ick)
-           if (ick .eq. 1) call ud2(l, il, t, tmin, nc)
-
-           do 10 while(j .ne. l)
-              call ck(j, ick)
-              if (ick .eq. 1) call ud2(j, il, t, tmin, nc)
-              j = nic(j)
- 10           continue
-        end if
+        ib = ncbeg(ic) - 1
+        do 10 k = 1, ncnum(ic)
+           j = ncpool(ib + k)
+           call ck(j, ick)
+           if (ick .eq. 1) call ud2(j, il, t, tmin, nc)
+ 10     continue
 
         return
         end
@@ -3609,36 +3877,33 @@ c       particles in the cell i,j,k if the next collision partener is l
      &     ictype, icsta(MAXPTN),
      &     nic(MAXPTN), icels(MAXPTN)
 cc      SAVE /ilist1/
-        common /ilist2/ icell, icel(10, 10, 10)
+        parameter (MAXCPL=2*MAXPTN+4004)
+        common /ilist2/ ncbeg(1001), ncnum(1001), nccap(1001), nctop,
+     &     ncpool(MAXCPL)
 cc      SAVE /ilist2/
         common /ilist5/ ct(MAXPTN), ot(MAXPTN), tlarge
 cc      SAVE /ilist5/
         SAVE   
 
+        external icelid
+
         if (i .eq. 11 .or. j .eq. 11 .or. k .eq. 11) then
            if ( .not. (i .eq. 11 .and. j .eq. 11 .and.
      &     k .eq. 11)) stop 'cerr'
-           m = icell
+           ic = 1001
         else
-           m = icel(i, j, k)
+           ic = icelid(i, j, k)
         end if
 
-        if (m .eq. 0) return
-        if (next(m) .eq. l) then
-           tm = tlarge
-           last0 = 0
-           call reor(t, tm, m, last0)
-        end if
-        n = nic(m)
-        if (n .eq. 0) return
-        do 10 while(n .ne. m)
+        ib = ncbeg(ic) - 1
+        do 10 m = 1, ncnum(ic)
+           n = ncpool(ib + m)
            if (next(n) .eq. l) then
               tm = tlarge
               last0 = 0
               call reor(t, tm, n, last0)
            end if
-           n = nic(n)
- 10        continue
+ 10     continue
 
         return
         end
@@ -3682,6 +3947,7 @@ cc      SAVE /ilist5/
            ot(l) = tmin1
            next(l) = 0
         end if
+        call hpupd(l)
         
         return
         end
@@ -5868,12 +6134,16 @@ cc      SAVE /para5/
      &     ictype, icsta(MAXPTN),
      &     nic(MAXPTN), icels(MAXPTN)
 cc      SAVE /ilist1/
-        common /ilist2/ icell, icel(10, 10, 10)
+        parameter (MAXCPL=2*MAXPTN+4004)
+        common /ilist2/ ncbeg(1001), ncnum(1001), nccap(1001), nctop,
+     &     ncpool(MAXCPL)
 cc      SAVE /ilist2/
         common /ilist4/ ifmpt, ichkpt, indx(MAXPTN)
 cc      SAVE /ilist4/
         SAVE   
 
+        external icelid
+
         if (iconfg .eq. 3 .or. iconfg .eq. 5) then
            jj = ichkpt
            do 1001 j = 1, jj
@@ -5887,34 +6157,20 @@ c     &          call mintm(il, j, tmin, nc)
            return
         end if
 
-c       set l
+c       set the cell
         if (i1 .eq. 11 .and. i2 .eq. 11 .and. i3 .eq. 11) then
-           l = icell
+           ic = 1001
         else
-           l = icel(i1 ,i2, i3)
+           ic = icelid(i1 ,i2, i3)
         end if
 
-        if (l .eq. 0) return
-        
-        j = nic(l)
-        
-c       if there is only one particle
-        if (j .eq. 0) then
-           
-c       if it's not il or last0,when last is not wall
-           if (l .eq. il .or. l .eq. last0) return
-           call mintm(il, l, tmin, nc)
-           
-c       if there are many particles
-        else
-           if (l .ne. il .and. l .ne. last0)
-     &        call mintm(il, l, tmin, nc)
-           do 10 while(j .ne. l)
-              if (j .ne. il .and. j .ne. last0)
-     &             call mintm(il, j, tmin, nc)
-              j = nic(j)
- 10           continue
-        end if
+c       every particle but il and last0, when last is not wall
+        ib = ncbeg(ic) - 1
+        do 10 k = 1, ncnum(ic)
+           j = ncpool(ib + k)
+           if (j .ne. il .and. j .ne. last0)
+     &          call mintm(il, j, tmin, nc)
+ 10     continue
         
         return
         end
@@ -6145,6 +6401,10 @@ cc      SAVE /para3/
 cc      SAVE /para5/
         common /para7/ ioscar,nsmbbbar,nsmmeson
 cc      SAVE /para7/
+        common /ilist3/ size1, size2, size3, v1, v2, v3, size
+cc      SAVE /ilist3/
+        common /zpcgrd/ izgrid
+cc      SAVE /zpcgrd/
         common /ilist6/ t, iopern, icolln
 cc      SAVE /ilist6/
         common /rndm1/ number
@@ -6184,6 +6444,8 @@ c     &     ',\n\t ending collision iff=', iff
         WRITE (25, *) '    number of collisions between particles = ', 
      &       icolln
         WRITE (25, *) '    freezeout time=', t
+        if (izgrid .eq. 1)
+     &     WRITE (25, *) '    cell sizes (fm) = ', size1, size2, size3
         WRITE (25, *) '    ending at the ', number, 'th random number'
         WRITE (25, *) '    ending collision iff=', iff
 
@@ -6682,12 +6944,29 @@ cc      SAVE /rndm1/
       parameter (m1 = 259200, ia1 = 7141, ic1 = 54773, rm1 = 1d0 / m1)
       parameter (m2 = 134456, ia2 = 8121, ic2 = 28411, rm2 = 1d0 / m2)
       parameter (m3 = 243000, ia3 = 4561, ic3 = 51349)
+      parameter (NRBUF = 1024)
+      common /rngbk/ irngbk
+cc      SAVE /rngbk/
+      common /rngbuf/ rngb(NRBUF, 3), krng(3)
+cc      SAVE /rngbuf/
 clin-6/23/00 save ix1-3:
 clin-10/30/02 r unsaved, causing wrong values for ran1 when compiled with f77:
 cc      SAVE ix1,ix2,ix3,r
       SAVE   
       data iff/0/
 
+c     counter-based backend (see RNGINI in amptsub.f), stream 3:
+      if (irngbk .eq. 1) then
+         if (krng(3) .ge. NRBUF) then
+            call rng_fill(3, rngb(1, 3), NRBUF)
+            krng(3) = 0
+         end if
+         krng(3) = krng(3) + 1
+         ran1 = rngb(krng(3), 3)
+         number = number + 1
+         return
+      end if
+
       if (idum .lt. 0 .or. iff .eq. 0) then
          iff = 1
          ix1 = mod(ic1 - idum, m1)